@@ -0,0 +1,206 @@
+/*
+ * Copyright (C) 2023-2024 Intel Corporation
+ * SPDX-License-Identifier: MIT-0
+ */
+
+#include <hal/RSU_plat_qspi.h>
+#include <hal/RSU_plat_mailbox.h>
+#include <hal/RSU_plat_misc.h>
+#include <hal/RSU_plat_file.h>
+#include <hal/RSU_plat_crc32.h>
+#include <utils/RSU_utils.h>
+#include <libRSU_misc.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <rsu_nor_sim.h>
+#include <rsu_image_gen.h>
+#include "bench_flash.h"
+
+static RSU_OSAL_INT bench_terminate(RSU_OSAL_VOID)
+{
+	return 0;
+}
+
+RSU_OSAL_INT plat_qspi_init(struct qspi_ll_intf *qspi_intf, const struct rsu_config *config)
+{
+	if (!config) {
+		return -EINVAL;
+	}
+
+	return rsu_nor_sim_qspi(qspi_intf);
+}
+
+static RSU_OSAL_INT bench_get_rsu_status(struct mbox_status_info *data)
+{
+	memset(data, 0, sizeof(*data));
+	data->version = 0x0808;
+	return 0;
+}
+
+static RSU_OSAL_INT bench_send_rsu_update(RSU_OSAL_U64 addr)
+{
+	ARG_UNUSED(addr);
+	return 0;
+}
+
+static RSU_OSAL_INT bench_get_spt_addresses(struct mbox_data_rsu_spt_address *data)
+{
+	data->spt0_address = 0;
+	data->spt1_address = RSU_IMAGE_GEN_REGION;
+	return 0;
+}
+
+static RSU_OSAL_INT bench_rsu_notify(RSU_OSAL_U32 notify)
+{
+	ARG_UNUSED(notify);
+	return 0;
+}
+
+RSU_OSAL_INT plat_mbox_init(struct mbox_ll_intf *mbox, const struct rsu_config *config)
+{
+	if (!mbox || !config) {
+		return -EINVAL;
+	}
+
+	mbox->get_rsu_status = bench_get_rsu_status;
+	mbox->send_rsu_update = bench_send_rsu_update;
+	mbox->get_spt_addresses = bench_get_spt_addresses;
+	mbox->rsu_notify = bench_rsu_notify;
+	mbox->terminate = bench_terminate;
+	return 0;
+}
+
+static RSU_OSAL_INT bench_get_dcmf_status(struct rsu_dcmf_status *data)
+{
+	memset(data, 0, sizeof(*data));
+	return 0;
+}
+
+static RSU_OSAL_INT bench_get_max_retry_count(RSU_OSAL_U8 *rsu_max_retry)
+{
+	*rsu_max_retry = 1;
+	return 0;
+}
+
+static RSU_OSAL_INT bench_get_dcmf_version(struct rsu_dcmf_version *version)
+{
+	memset(version, 0, sizeof(*version));
+	return 0;
+}
+
+RSU_OSAL_INT plat_rsu_misc_init(struct rsu_ll_misc *misc_intf, const struct rsu_config *config)
+{
+	if (!misc_intf || !config) {
+		return -EINVAL;
+	}
+
+	misc_intf->rsu_get_dcmf_status = bench_get_dcmf_status;
+	misc_intf->rsu_get_max_retry_count = bench_get_max_retry_count;
+	misc_intf->rsu_get_dcmf_version = bench_get_dcmf_version;
+	misc_intf->terminate = bench_terminate;
+	return 0;
+}
+
+static RSU_OSAL_FILE *bench_file_open(RSU_OSAL_CHAR *filename, RSU_filesys_flags_t flag)
+{
+	const RSU_OSAL_CHAR *mode[] = {"r", "w+", "a+"};
+
+	if (!filename || flag < RSU_FILE_READ || flag > RSU_FILE_APPEND) {
+		return NULL;
+	}
+
+	return fopen(filename, mode[flag - RSU_FILE_READ]);
+}
+
+static RSU_OSAL_INT bench_file_read(RSU_OSAL_VOID *buf, RSU_OSAL_SIZE len, RSU_OSAL_FILE *file)
+{
+	return fread(buf, 1, len, file);
+}
+
+static RSU_OSAL_INT bench_file_write(RSU_OSAL_VOID *buf, RSU_OSAL_SIZE len, RSU_OSAL_FILE *file)
+{
+	return fwrite(buf, 1, len, file);
+}
+
+static RSU_OSAL_INT bench_file_fgets(RSU_OSAL_CHAR *str, RSU_OSAL_SIZE len, RSU_OSAL_FILE *file)
+{
+	return fgets(str, len, file) ? 0 : 1;
+}
+
+static RSU_OSAL_INT bench_file_fseek(RSU_OSAL_OFFSET offset, RSU_filesys_whence_t whence,
+				     RSU_OSAL_FILE *file)
+{
+	if (whence == RSU_SEEK_SET) {
+		return fseek(file, offset, SEEK_SET);
+	} else if (whence == RSU_SEEK_CUR) {
+		return fseek(file, offset, SEEK_CUR);
+	}
+
+	return fseek(file, offset, SEEK_END);
+}
+
+static RSU_OSAL_INT bench_file_ftruncate(RSU_OSAL_OFFSET length, RSU_OSAL_FILE *file)
+{
+	fflush(file);
+	return ftruncate(fileno(file), length);
+}
+
+static RSU_OSAL_INT bench_file_close(RSU_OSAL_FILE *file)
+{
+	return fclose(file);
+}
+
+RSU_OSAL_INT plat_filesys_init(struct filesys_ll_intf *filesys_intf)
+{
+	if (!filesys_intf) {
+		return -EINVAL;
+	}
+
+	filesys_intf->open = bench_file_open;
+	filesys_intf->read = bench_file_read;
+	filesys_intf->write = bench_file_write;
+	filesys_intf->fgets = bench_file_fgets;
+	filesys_intf->fseek = bench_file_fseek;
+	filesys_intf->ftruncate = bench_file_ftruncate;
+	filesys_intf->close = bench_file_close;
+	filesys_intf->terminate = bench_terminate;
+	return 0;
+}
+
+RSU_OSAL_S64 bench_flash_layout(const RSU_OSAL_U32 *sizes, RSU_OSAL_INT count)
+{
+	const struct rsu_nor_geometry geometry = {BENCH_FLASH_SIZE, BENCH_ERASE_SIZE, 256, 0, 0};
+	struct rsu_flash_params params;
+	RSU_OSAL_CHAR names[BENCH_MAX_SLOTS][16];
+	const RSU_OSAL_CHAR *name_ptrs[BENCH_MAX_SLOTS];
+	RSU_OSAL_U64 slot_sizes[BENCH_MAX_SLOTS];
+	RSU_OSAL_INT x;
+	RSU_OSAL_INT ret;
+
+	if (count > BENCH_MAX_SLOTS) {
+		return -EINVAL;
+	}
+
+	ret = rsu_nor_sim_init(&geometry);
+	if (ret) {
+		return ret;
+	}
+
+	for (x = 0; x < count; x++) {
+		snprintf(names[x], sizeof(names[x]), "S%uK", sizes[x] / 1024);
+		name_ptrs[x] = names[x];
+		slot_sizes[x] = sizes[x];
+	}
+
+	/* the slots are left erased and the CPB empty */
+	memset(&params, 0, sizeof(params));
+	params.slot_sizes = slot_sizes;
+	params.slot_names = name_ptrs;
+	params.slots = (RSU_OSAL_U32)count;
+
+	return rsu_image_gen_flash(&params);
+}
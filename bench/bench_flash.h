@@ -0,0 +1,25 @@
+/*
+ * Copyright (C) 2023-2024 Intel Corporation
+ * SPDX-License-Identifier: MIT-0
+ */
+
+#ifndef BENCH_FLASH_H
+#define BENCH_FLASH_H
+
+#include <libRSU_OSAL.h>
+#include <rsu_image_gen.h>
+
+#define BENCH_FLASH_SIZE  (32 * 1024 * 1024)
+#define BENCH_ERASE_SIZE  0x1000
+#define BENCH_MAX_SLOTS   16
+
+/*
+ * bench_flash_layout() - create the simulated flash with a generated SPT and CPB
+ * sizes: sizes of the slots, named S<size in KB>K, the CPB is empty
+ * count: number of slots
+ *
+ * Return: offset of the free space after the slots, or negative on error
+ */
+RSU_OSAL_S64 bench_flash_layout(const RSU_OSAL_U32 *sizes, RSU_OSAL_INT count);
+
+#endif
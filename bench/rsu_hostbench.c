@@ -0,0 +1,461 @@
+/*
+ * Copyright (C) 2023-2024 Intel Corporation
+ * SPDX-License-Identifier: MIT-0
+ */
+
+#include <libRSU.h>
+#include <libRSU_image.h>
+#include <libRSU_misc.h>
+#include <hal/RSU_plat_crc32.h>
+#include <utils/RSU_logging.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench_flash.h"
+
+/* version of the JSON output, changed only when a field changes meaning */
+#define BENCH_FORMAT 1
+
+#define BENCH_MAX_RESULTS 64
+#define BENCH_BUF_SIZE	  (1024 * 1024)
+#define BENCH_NEW_SLOT	  0x10000
+#define BENCH_SECTION	  0x40000 /* one CMF section per 256 KB of image */
+
+static const RSU_OSAL_U32 slot_sizes[] = {256 * 1024, 1024 * 1024, 4 * 1024 * 1024,
+					  16 * 1024 * 1024};
+
+/* ns are per iteration, an iteration is one call or one pass over bytes */
+struct bench_result {
+	char name[32];
+	unsigned long long bytes;
+	unsigned long long iterations;
+	unsigned long long min_ns;
+	unsigned long long total_ns;
+	unsigned long long max_ns;
+};
+
+static struct bench_result results[BENCH_MAX_RESULTS];
+static int result_count;
+
+static struct bench_result *bench_result(const char *name, unsigned long long bytes)
+{
+	struct bench_result *res;
+
+	if (result_count == BENCH_MAX_RESULTS) {
+		fprintf(stderr, "too many results\n");
+		exit(1);
+	}
+
+	res = &results[result_count++];
+	snprintf(res->name, sizeof(res->name), "%s", name);
+	res->bytes = bytes;
+	res->min_ns = ~0ULL;
+	return res;
+}
+
+/* account ns for n iterations timed together */
+static void bench_add(struct bench_result *res, unsigned long long ns, unsigned long long n)
+{
+	res->iterations += n;
+	res->total_ns += ns;
+	if (ns / n < res->min_ns) {
+		res->min_ns = ns / n;
+	}
+	if ((ns + n - 1) / n > res->max_ns) {
+		res->max_ns = (ns + n - 1) / n;
+	}
+}
+
+static void bench_fail(const char *what, int ret)
+{
+	fprintf(stderr, "%s failed: %d\n", what, ret);
+	exit(1);
+}
+
+static struct rsu_image_params bench_image_params(RSU_OSAL_U32 size)
+{
+	struct rsu_image_params params = {size, size / BENCH_SECTION, 0,
+					  RSU_IMAGE_FILL_COUNTER, 0};
+
+	if (params.sections == 0) {
+		params.sections = 1;
+	}
+	return params;
+}
+
+/* synthetic application image, generated the same way for a buffer or a stream */
+static char *bench_image(RSU_OSAL_U32 size)
+{
+	struct rsu_image_params params = bench_image_params(size);
+	char *image;
+	int ret;
+
+	image = malloc(size);
+	if (image == NULL) {
+		bench_fail("malloc", -ENOMEM);
+	}
+
+	ret = rsu_image_gen_buf(&params, image);
+	if (ret) {
+		bench_fail("rsu_image_gen_buf", ret);
+	}
+
+	return image;
+}
+
+static void bench_init(const struct rsu_config *config, int iterations)
+{
+	struct bench_result *res = bench_result("init", 0);
+	RSU_OSAL_U64 start;
+	int ret, x;
+
+	for (x = 0; x < iterations; x++) {
+		start = rsu_time_ns();
+		ret = librsu_init_with_config(config);
+		bench_add(res, rsu_time_ns() - start, 1);
+		if (ret) {
+			bench_fail("librsu_init", ret);
+		}
+		librsu_exit();
+	}
+}
+
+/* erase, program, verify and copy of a whole slot of each size, and program of a stream */
+static void bench_slots(int iterations)
+{
+	struct bench_result *erase, *program, *verify, *copy, *stream;
+	struct rsu_image_params params;
+	unsigned int n = sizeof(slot_sizes) / sizeof(slot_sizes[0]);
+	RSU_OSAL_U32 size;
+	RSU_OSAL_U64 start;
+	char name[32];
+	char *image, *buf;
+	unsigned int x;
+	int slot, ret, y;
+
+	for (x = 0; x < n; x++) {
+		size = slot_sizes[x];
+		snprintf(name, sizeof(name), "S%uK", size / 1024);
+		slot = rsu_slot_by_name(name);
+		if (slot < 0) {
+			bench_fail("rsu_slot_by_name", slot);
+		}
+
+		image = bench_image(size);
+		buf = malloc(size);
+		if (buf == NULL) {
+			bench_fail("malloc", -ENOMEM);
+		}
+
+		snprintf(name, sizeof(name), "erase_%uK", size / 1024);
+		erase = bench_result(name, size);
+		snprintf(name, sizeof(name), "program_%uK", size / 1024);
+		program = bench_result(name, size);
+		snprintf(name, sizeof(name), "verify_%uK", size / 1024);
+		verify = bench_result(name, size);
+		snprintf(name, sizeof(name), "copy_%uK", size / 1024);
+		copy = bench_result(name, size);
+		snprintf(name, sizeof(name), "stream_%uK", size / 1024);
+		stream = bench_result(name, size);
+		params = bench_image_params(size);
+
+		for (y = 0; y < iterations; y++) {
+			start = rsu_time_ns();
+			ret = rsu_slot_erase(slot);
+			bench_add(erase, rsu_time_ns() - start, 1);
+			if (ret) {
+				bench_fail("rsu_slot_erase", ret);
+			}
+
+			start = rsu_time_ns();
+			ret = rsu_slot_program_buf(slot, image, size);
+			bench_add(program, rsu_time_ns() - start, 1);
+			if (ret) {
+				bench_fail("rsu_slot_program_buf", ret);
+			}
+
+			start = rsu_time_ns();
+			ret = rsu_slot_verify_buf(slot, image, size);
+			bench_add(verify, rsu_time_ns() - start, 1);
+			if (ret) {
+				bench_fail("rsu_slot_verify_buf", ret);
+			}
+
+			start = rsu_time_ns();
+			ret = rsu_slot_copy_to_buf(slot, buf, size);
+			bench_add(copy, rsu_time_ns() - start, 1);
+			if (ret) {
+				bench_fail("rsu_slot_copy_to_buf", ret);
+			}
+
+			ret = rsu_slot_erase(slot);
+			if (ret) {
+				bench_fail("rsu_slot_erase", ret);
+			}
+
+			rsu_image_gen_stream_init(&params);
+			start = rsu_time_ns();
+			ret = rsu_slot_program_callback(slot, rsu_image_gen_stream);
+			bench_add(stream, rsu_time_ns() - start, 1);
+			if (ret) {
+				bench_fail("rsu_slot_program_callback", ret);
+			}
+		}
+
+		free(buf);
+		free(image);
+	}
+}
+
+/* SPT and CPB updates: a slot is created in the free space and goes through its life */
+static void bench_metadata(RSU_OSAL_U64 free_offset, int iterations)
+{
+	struct bench_result *create = bench_result("slot_create", 0);
+	struct bench_result *rename = bench_result("slot_rename", 0);
+	struct bench_result *enable = bench_result("slot_enable", 0);
+	struct bench_result *disable = bench_result("slot_disable", 0);
+	struct bench_result *delete = bench_result("slot_delete", 0);
+	char name[] = "BENCH_NEW";
+	char new_name[] = "BENCH_RENAMED";
+	RSU_OSAL_U64 start;
+	int slot, ret, x;
+
+	free_offset = (free_offset + RSU_IMAGE_GEN_SLOT_ALIGN - 1) &
+		      ~(RSU_OSAL_U64)(RSU_IMAGE_GEN_SLOT_ALIGN - 1);
+
+	for (x = 0; x < iterations; x++) {
+		start = rsu_time_ns();
+		ret = rsu_slot_create(name, free_offset, BENCH_NEW_SLOT);
+		bench_add(create, rsu_time_ns() - start, 1);
+		if (ret) {
+			bench_fail("rsu_slot_create", ret);
+		}
+
+		slot = rsu_slot_by_name(name);
+		if (slot < 0) {
+			bench_fail("rsu_slot_by_name", slot);
+		}
+
+		start = rsu_time_ns();
+		ret = rsu_slot_rename(slot, new_name);
+		bench_add(rename, rsu_time_ns() - start, 1);
+		if (ret) {
+			bench_fail("rsu_slot_rename", ret);
+		}
+
+		start = rsu_time_ns();
+		ret = rsu_slot_enable(slot);
+		bench_add(enable, rsu_time_ns() - start, 1);
+		if (ret) {
+			bench_fail("rsu_slot_enable", ret);
+		}
+
+		start = rsu_time_ns();
+		ret = rsu_slot_disable(slot);
+		bench_add(disable, rsu_time_ns() - start, 1);
+		if (ret) {
+			bench_fail("rsu_slot_disable", ret);
+		}
+
+		start = rsu_time_ns();
+		ret = rsu_slot_delete(slot);
+		bench_add(delete, rsu_time_ns() - start, 1);
+		if (ret) {
+			bench_fail("rsu_slot_delete", ret);
+		}
+	}
+}
+
+/* image state machine alone, over a 1 MB image relocated into the 1 MB slot */
+static void bench_image_block(int iterations)
+{
+	struct bench_result *res = bench_result("image_block", IMAGE_BLOCK_SZ);
+	const RSU_OSAL_U32 blocks = BENCH_BUF_SIZE / IMAGE_BLOCK_SZ;
+	struct rsu_image_state state;
+	struct rsu_slot_info info;
+	char name[] = "S1024K";
+	char *image, *work;
+	RSU_OSAL_U64 start;
+	RSU_OSAL_U32 y;
+	int ret, x;
+
+	ret = rsu_slot_get_info(rsu_slot_by_name(name), &info);
+	if (ret) {
+		bench_fail("rsu_slot_get_info", ret);
+	}
+
+	image = bench_image(BENCH_BUF_SIZE);
+	work = malloc(BENCH_BUF_SIZE);
+	if (work == NULL) {
+		bench_fail("malloc", -ENOMEM);
+	}
+
+	for (x = 0; x < iterations; x++) {
+		/* the signature block is relocated in place, start from the original each time */
+		memcpy(work, image, BENCH_BUF_SIZE);
+		librsu_image_block_init(&state);
+
+		start = rsu_time_ns();
+		for (y = 0; y < blocks; y++) {
+			ret = librsu_image_block_process(&state, work + y * IMAGE_BLOCK_SZ, NULL,
+							 &info);
+			if (ret) {
+				bench_fail("librsu_image_block_process", ret);
+			}
+		}
+		bench_add(res, rsu_time_ns() - start, blocks);
+	}
+
+	free(work);
+	free(image);
+}
+
+static void bench_swap_bits(char *buf, int iterations)
+{
+	struct bench_result *res = bench_result("swap_bits", BENCH_BUF_SIZE);
+	RSU_OSAL_U64 start;
+	int x;
+
+	for (x = 0; x < iterations; x++) {
+		start = rsu_time_ns();
+		swap_bits(buf, BENCH_BUF_SIZE);
+		bench_add(res, rsu_time_ns() - start, 1);
+	}
+}
+
+static void bench_crc32(char *buf, int iterations)
+{
+	struct bench_result *res = bench_result("crc32", BENCH_BUF_SIZE);
+	volatile RSU_OSAL_U32 crc = 0;
+	RSU_OSAL_U64 start;
+	int x;
+
+	for (x = 0; x < iterations; x++) {
+		start = rsu_time_ns();
+		crc = rsu_crc32(crc, (RSU_OSAL_U8 *)buf, BENCH_BUF_SIZE);
+		bench_add(res, rsu_time_ns() - start, 1);
+	}
+}
+
+/*
+ * bench_print_json() - print the results as one JSON object
+ *
+ * The fields of a result are always the same and in the same order: bytes
+ * is the data handled by one iteration, 0 for the calls which are not about
+ * data, and mb_s the throughput of an average iteration, 0 when bytes is.
+ */
+static void bench_print_json(FILE *out, int iterations)
+{
+	struct bench_result *res;
+	unsigned long long mean;
+	int x;
+
+	fprintf(out, "{\"format\":%d,\"library\":\"%u.%u\",\"iterations\":%d,\"results\":[",
+		BENCH_FORMAT, rsu_get_version() >> 16, rsu_get_version() & 0xFFFF, iterations);
+	for (x = 0; x < result_count; x++) {
+		res = &results[x];
+		mean = res->total_ns / res->iterations;
+		fprintf(out,
+			"%s{\"name\":\"%s\",\"bytes\":%llu,\"iterations\":%llu,\"min_ns\":%llu,"
+			"\"mean_ns\":%llu,\"max_ns\":%llu,\"mb_s\":%.2f}",
+			x ? "," : "", res->name, res->bytes, res->iterations, res->min_ns, mean,
+			res->max_ns, mean ? res->bytes * 1e3 / mean : 0.0);
+	}
+	fprintf(out, "]}\n");
+}
+
+static void bench_print_table(FILE *out)
+{
+	struct bench_result *res;
+	unsigned long long mean;
+	int x;
+
+	fprintf(out, "%-16s %12s %12s %12s %12s %10s\n", "TEST", "BYTES", "MIN (us)", "MEAN (us)",
+		"MAX (us)", "MB/s");
+	for (x = 0; x < result_count; x++) {
+		res = &results[x];
+		mean = res->total_ns / res->iterations;
+		fprintf(out, "%-16s %12llu %12.3f %12.3f %12.3f %10.2f\n", res->name, res->bytes,
+			res->min_ns / 1e3, mean / 1e3, res->max_ns / 1e3,
+			mean ? res->bytes * 1e3 / mean : 0.0);
+	}
+}
+
+static void bench_usage(void)
+{
+	printf("--- librsu host benchmark usage ---\n");
+	printf("%-32s  %s", "-n|--iterations count", "iterations of each test, 5 by default\n");
+	printf("%-32s  %s", "-t|--table", "also print a table on stderr\n");
+	printf("%-32s  %s", "-h|--help", "show usage message\n");
+}
+
+static const struct option opts[] = {{"iterations", required_argument, NULL, 'n'},
+				     {"table", no_argument, NULL, 't'},
+				     {"help", no_argument, NULL, 'h'},
+				     {NULL, 0, NULL, 0}};
+
+int main(int argc, char *argv[])
+{
+	struct rsu_config config;
+	RSU_OSAL_S64 free_offset;
+	int iterations = 5;
+	int table = 0;
+	int index = 0;
+	char *buf;
+	int c, ret;
+
+	while ((c = getopt_long(argc, argv, "n:th", opts, &index)) != -1) {
+		switch (c) {
+		case 'n':
+			iterations = atoi(optarg);
+			if (iterations <= 0) {
+				printf("ERROR: Invalid iteration count %s\n", optarg);
+				return 1;
+			}
+			break;
+		case 't':
+			table = 1;
+			break;
+		case 'h':
+			bench_usage();
+			return 0;
+		default:
+			printf("ERROR: Invalid argument: try -h for help\n");
+			return 1;
+		}
+	}
+
+	free_offset = bench_flash_layout(slot_sizes, sizeof(slot_sizes) / sizeof(slot_sizes[0]));
+	if (free_offset < 0) {
+		bench_fail("bench_flash_layout", (int)free_offset);
+	}
+
+	librsu_config_defaults(&config);
+	config.log_level = L_LOG_ERR;
+
+	bench_init(&config, iterations);
+
+	ret = librsu_init_with_config(&config);
+	if (ret) {
+		bench_fail("librsu_init", ret);
+	}
+
+	bench_slots(iterations);
+	bench_metadata((RSU_OSAL_U64)free_offset, iterations);
+	bench_image_block(iterations);
+
+	buf = bench_image(BENCH_BUF_SIZE);
+	bench_swap_bits(buf, iterations * 4);
+	bench_crc32(buf, iterations * 4);
+	free(buf);
+
+	librsu_exit();
+
+	if (table) {
+		bench_print_table(stderr);
+	}
+	bench_print_json(stdout, iterations);
+
+	return 0;
+}
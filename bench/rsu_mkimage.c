@@ -0,0 +1,243 @@
+/*
+ * Copyright (C) 2023-2024 Intel Corporation
+ * SPDX-License-Identifier: MIT-0
+ */
+
+#include <libRSU_misc.h>
+#include <rsu_image_gen.h>
+#include <rsu_nor_sim.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#define MKIMAGE_FLASH_SIZE (64 * 1024 * 1024)
+#define MKIMAGE_ERASE_SIZE 0x1000
+#define MKIMAGE_MAX_SLOTS  64
+
+static const char *const fills[] = {"zero", "erased", "counter", "random"};
+
+/* size in bytes, with an optional K, M or G suffix */
+static int mkimage_size(const char *arg, RSU_OSAL_U64 *size)
+{
+	char *end;
+
+	*size = strtoull(arg, &end, 0);
+	switch (*end) {
+	case 'G':
+		*size <<= 10;
+		/* fall through */
+	case 'M':
+		*size <<= 10;
+		/* fall through */
+	case 'K':
+		*size <<= 10;
+		end++;
+		break;
+	}
+
+	return end == arg || *end ? -1 : 0;
+}
+
+static int mkimage_fill(const char *arg, enum rsu_image_fill *fill)
+{
+	unsigned int x;
+
+	for (x = 0; x < sizeof(fills) / sizeof(fills[0]); x++) {
+		if (strcasecmp(arg, fills[x]) == 0) {
+			*fill = (enum rsu_image_fill)x;
+			return 0;
+		}
+	}
+
+	return -1;
+}
+
+/* whole flash: SPT, CPB and slots created in the simulator and written out */
+static int mkimage_layout(const char *filename, RSU_OSAL_U64 size, RSU_OSAL_U32 slots,
+			  RSU_OSAL_U64 slot_size, const struct rsu_flash_params *params,
+			  int swap)
+{
+	const struct rsu_nor_geometry geometry = {size, MKIMAGE_ERASE_SIZE, 256, 0, 0};
+	RSU_OSAL_U64 slot_sizes[MKIMAGE_MAX_SLOTS];
+	struct rsu_flash_params layout = *params;
+	RSU_OSAL_U8 block[MKIMAGE_ERASE_SIZE];
+	RSU_OSAL_S64 used;
+	RSU_OSAL_U64 x;
+	FILE *file;
+	int ret;
+
+	if (slots > MKIMAGE_MAX_SLOTS) {
+		printf("ERROR: At most %d slots\n", MKIMAGE_MAX_SLOTS);
+		return 1;
+	}
+
+	ret = rsu_nor_sim_init(&geometry);
+	if (ret) {
+		printf("ERROR: Invalid flash size 0x%llx\n", (unsigned long long)size);
+		return 1;
+	}
+
+	for (x = 0; x < slots; x++) {
+		slot_sizes[x] = slot_size;
+	}
+	layout.slot_sizes = slot_sizes;
+	layout.slots = slots;
+
+	used = rsu_image_gen_flash(&layout);
+	if (used < 0) {
+		printf("ERROR: Layout does not fit the flash: %d\n", (int)used);
+		return 1;
+	}
+
+	file = fopen(filename, "wb");
+	if (!file) {
+		printf("ERROR: Cannot create %s\n", filename);
+		return 1;
+	}
+
+	for (x = 0; x < size; x += sizeof(block)) {
+		memcpy(block, rsu_nor_sim_data() + x, sizeof(block));
+		if (swap) {
+			swap_bits((RSU_OSAL_CHAR *)block, sizeof(block));
+		}
+		if (fwrite(block, 1, sizeof(block), file) != sizeof(block)) {
+			printf("ERROR: Cannot write %s\n", filename);
+			fclose(file);
+			return 1;
+		}
+	}
+
+	rsu_nor_sim_exit();
+	return fclose(file) ? 1 : 0;
+}
+
+static void mkimage_usage(void)
+{
+	printf("--- synthetic application image and flash layout generator usage ---\n");
+	printf("rsu_mkimage [options] <output file>\n");
+	printf("%-32s  %s", "-s|--size bytes",
+	       "image size, or flash size with -L, with K, M or G suffix\n");
+	printf("%-32s  %s", "-n|--sections count", "CMF sections of the image, 1 by default\n");
+	printf("%-32s  %s", "-a|--absolute base", "absolute image for the slot at base\n");
+	printf("%-32s  %s", "-f|--fill pattern", "zero, erased, counter (default) or random\n");
+	printf("%-32s  %s", "-S|--seed value", "seed of the random fill\n");
+	printf("%-32s  %s", "-r|--rpd", "reverse the bits of every byte, as .rpd files\n");
+	printf("%-32s  %s", "-L|--layout slots", "flash with an SPT, a CPB and that many slots\n");
+	printf("%-32s  %s", "-z|--slot-size bytes", "size of each slot of the layout\n");
+	printf("%-32s  %s", "-p|--program", "program an image in every slot of the layout\n");
+	printf("%-32s  %s", "-c|--cpb", "also add the programmed slots to the CPB\n");
+	printf("%-32s  %s", "-h|--help", "show usage message\n");
+}
+
+static const struct option opts[] = {{"size", required_argument, NULL, 's'},
+				     {"sections", required_argument, NULL, 'n'},
+				     {"absolute", required_argument, NULL, 'a'},
+				     {"fill", required_argument, NULL, 'f'},
+				     {"seed", required_argument, NULL, 'S'},
+				     {"rpd", no_argument, NULL, 'r'},
+				     {"layout", required_argument, NULL, 'L'},
+				     {"slot-size", required_argument, NULL, 'z'},
+				     {"program", no_argument, NULL, 'p'},
+				     {"cpb", no_argument, NULL, 'c'},
+				     {"help", no_argument, NULL, 'h'},
+				     {NULL, 0, NULL, 0}};
+
+int main(int argc, char *argv[])
+{
+	struct rsu_image_params params = {0, 1, 0, RSU_IMAGE_FILL_COUNTER, 0};
+	struct rsu_flash_params layout;
+	RSU_OSAL_U64 slot_size = 0x100000;
+	RSU_OSAL_U64 val;
+	long slots = -1;
+	char *end;
+	int program = 0;
+	int swap = 0;
+	int index = 0;
+	int c, ret;
+
+	memset(&layout, 0, sizeof(layout));
+
+	while ((c = getopt_long(argc, argv, "s:n:a:f:S:rL:z:pch", opts, &index)) != -1) {
+		switch (c) {
+		case 's':
+			if (mkimage_size(optarg, &params.size)) {
+				printf("ERROR: Invalid size %s\n", optarg);
+				return 1;
+			}
+			break;
+		case 'n':
+			val = strtoull(optarg, &end, 0);
+			if (end == optarg || *end || val == 0 || val > 0xFFFFFFFFULL) {
+				printf("ERROR: Invalid section count %s\n", optarg);
+				return 1;
+			}
+			params.sections = (RSU_OSAL_U32)val;
+			break;
+		case 'a':
+			if (mkimage_size(optarg, &params.base)) {
+				printf("ERROR: Invalid base %s\n", optarg);
+				return 1;
+			}
+			break;
+		case 'f':
+			if (mkimage_fill(optarg, &params.fill)) {
+				printf("ERROR: Invalid fill %s\n", optarg);
+				return 1;
+			}
+			break;
+		case 'S':
+			params.seed = (RSU_OSAL_U32)strtoul(optarg, NULL, 0);
+			break;
+		case 'r':
+			swap = 1;
+			break;
+		case 'L':
+			slots = strtol(optarg, &end, 0);
+			if (end == optarg || *end || slots < 0) {
+				printf("ERROR: Invalid slot count %s\n", optarg);
+				return 1;
+			}
+			break;
+		case 'z':
+			if (mkimage_size(optarg, &slot_size)) {
+				printf("ERROR: Invalid slot size %s\n", optarg);
+				return 1;
+			}
+			break;
+		case 'p':
+			program = 1;
+			break;
+		case 'c':
+			layout.cpb = 1;
+			break;
+		case 'h':
+			mkimage_usage();
+			return 0;
+		default:
+			printf("ERROR: Invalid argument: try -h for help\n");
+			return 1;
+		}
+	}
+
+	if (optind != argc - 1) {
+		printf("ERROR: One output file is needed: try -h for help\n");
+		return 1;
+	}
+
+	if (slots >= 0) {
+		layout.sections = program ? params.sections : 0;
+		layout.fill = params.fill;
+		return mkimage_layout(argv[optind], params.size ? params.size : MKIMAGE_FLASH_SIZE,
+				      (RSU_OSAL_U32)slots, slot_size, &layout, swap);
+	}
+
+	ret = rsu_image_gen_file(&params, argv[optind], swap);
+	if (ret) {
+		printf("ERROR: Cannot generate %s: %d\n", argv[optind], ret);
+		return 1;
+	}
+
+	return 0;
+}
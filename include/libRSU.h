@@ -13,6 +13,7 @@
 #define LIBRSU_H
 
 #include <libRSU_OSAL.h>
+#include <libRSU_config.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -50,6 +51,8 @@ extern "C" {
 #define ECORRUPTED_CPB 15
 /** corrupted SPT */
 #define ECORRUPTED_SPT 16
+/** no digest recorded for the slot */
+#define ENODIGEST      17
 
 
 /** RSU_VERSION_CRT_DCMF_IDX */
@@ -111,15 +114,55 @@ struct rsu_status_info {
  */
 RSU_OSAL_U32 rsu_get_version(RSU_OSAL_VOID);
 
+/**
+ * @brief use application provided functions for all heap allocations of the library
+ *
+ * @note Must be called before librsu_init(). Passing NULL for both functions restores the
+ * platform allocator. Buffers used while accessing flash are lent from a scratch arena allocated
+ * once by librsu_init(), so programming and verifying a slot make no heap calls per block.
+ *
+ * @param[in] alloc allocation function
+ * @param[in] release release function
+ * @return 0 on success, or Error Code
+ */
+RSU_OSAL_INT librsu_set_allocator(rsu_malloc_hook alloc, rsu_free_hook release);
+
 /**
  * @brief Load the configuration file and initialize internal data
  *
+ * @note With 'metadata-cache <file>' in the configuration file, the SPT and CPB are saved to that
+ * file after a clean load, and later calls in the same boot take them from there once the crcs of
+ * the SPT0 and CPB pages in flash are confirmed. Any difference falls back to the full load.
+ *
+ * @note With 'read-only 1' the flash is opened read-only and the SPT and CPB are only loaded by
+ * the first call which needs them, so status calls such as rsu_status_log() and rsu_dcmf_status()
+ * never access the flash. A bad SPT or CPB copy is not repaired, and calls which would write the
+ * flash fail.
+ *
  * @param[in] filename configuration file to load (if Null or empty string, the default string will
  * be /etc/librsu.rc)
  * @return 0 on success, or Error Code
  */
 RSU_OSAL_INT librsu_init(RSU_OSAL_CHAR *filename);
 
+/**
+ * @brief fill a configuration with the values used when a keyword is not in the configuration file
+ *
+ * @param[out] config configuration to fill
+ */
+RSU_OSAL_VOID librsu_config_defaults(struct rsu_config *config);
+
+/**
+ * @brief initialize internal data from an application provided configuration
+ *
+ * @note Same as librsu_init(), without reading a configuration file. Start from
+ * librsu_config_defaults() and change the fields which are needed.
+ *
+ * @param[in] config configuration to use, copied by the library
+ * @return 0 on success, or Error Code
+ */
+RSU_OSAL_INT librsu_init_with_config(const struct rsu_config *config);
+
 /**
  * @brief cleanup internal data and release librsu
  * @return Nil
@@ -142,6 +185,36 @@ RSU_OSAL_INT rsu_notify(RSU_OSAL_INT value);
  */
 RSU_OSAL_INT rsu_status_log(struct rsu_status_info *info);
 
+/**
+ * @brief wait for the SDM status log to change
+ *
+ * Blocks until the status differs from the one passed in @p info, then
+ * updates @p info. Passing the result of rsu_status_log() or of a previous
+ * call means no change is missed between calls. Any number of threads can
+ * wait at the same time, they share one internal poller.
+ *
+ * @note The poller sleeps in the platform status notification when there is one, and otherwise
+ * sweeps the status every 'status-poll-interval' milliseconds of the configuration file, 100 by
+ * default.
+ *
+ * @param[in] timeout time period to wait in milliseconds, or RSU_TIME_FOREVER
+ * @param[in,out] info last seen status on input, new status on output
+ * @return 0 on change, -ETIMEDOUT when time expired, or Error Code
+ */
+RSU_OSAL_INT rsu_status_wait(RSU_OSAL_U32 timeout, struct rsu_status_info *info);
+
+/**
+ * @brief rewrite a bad SPT or CPB copy from the good one
+ *
+ * @note librsu_init() only needs one good copy of each table. A bad copy is rewritten by a worker
+ * thread started by the init, or with 'metadata-repair manual' in the configuration file, by this
+ * call or before the next write to flash, whichever comes first. 'metadata-repair inline' keeps
+ * the rewrite inside librsu_init().
+ *
+ * @return 0 on success or when nothing needs a repair, or Error Code
+ */
+RSU_OSAL_INT rsu_repair_metadata(RSU_OSAL_VOID);
+
 /**
  * @brief clear errors from the current status log
  *
@@ -249,6 +322,9 @@ RSU_OSAL_INT rsu_slot_program_factory_update_buf(RSU_OSAL_INT slot, RSU_OSAL_VOI
 /**
  * @brief program a slot using FPGA config data from a file and enter slot into CPB
  *
+ * @note filename may also be an archive created by rsu_slot_copy_to_file_compressed(),
+ * or a gzip/zlib compressed image, which is decompressed while programming.
+ *
  * @param[in] slot slot number
  * @param[in] filename input data file
  * @return 0 on success, or Error Code
@@ -283,6 +359,32 @@ RSU_OSAL_INT rsu_slot_program_buf_raw(RSU_OSAL_INT slot, RSU_OSAL_VOID *buf, RSU
  */
 RSU_OSAL_INT rsu_slot_program_file_raw(RSU_OSAL_INT slot, RSU_OSAL_CHAR *filename);
 
+/**
+ * @brief check FPGA config data in a buffer before programming it into a slot
+ *
+ * @note The image is processed exactly as when programming, relocated for the offset and size of
+ * the slot, but nothing is written to flash. Bad signature block CRCs, pointers outside the slot,
+ * too many sections and images larger than the slot are reported. With 'program-preflight 1' in
+ * the configuration file, rsu_slot_program_buf() and rsu_slot_program_file() do this check first.
+ *
+ * @param[in] slot slot number
+ * @param[in] buf pointer to data buffer
+ * @param[in] size bytes to read from buffer
+ * @return 0 on success, or Error Code
+ */
+RSU_OSAL_INT rsu_image_validate_buf(RSU_OSAL_INT slot, RSU_OSAL_VOID *buf, RSU_OSAL_INT size);
+
+/**
+ * @brief check FPGA config data in a file before programming it into a slot
+ *
+ * @note See rsu_image_validate_buf(). Compressed files are accepted as for rsu_slot_program_file().
+ *
+ * @param[in] slot slot number
+ * @param[in] filename input data file
+ * @return 0 on success, or Error Code
+ */
+RSU_OSAL_INT rsu_image_validate_file(RSU_OSAL_INT slot, RSU_OSAL_CHAR *filename);
+
 /**
  * @brief verify FPGA config data in a slot against a buffer
  *
@@ -296,6 +398,8 @@ RSU_OSAL_INT rsu_slot_verify_buf(RSU_OSAL_INT slot, RSU_OSAL_VOID *buf, RSU_OSAL
 /**
  * @brief verify FPGA config data in a slot against a file
  *
+ * @note a gzip/zlib compressed file is decompressed while verifying.
+ *
  * @param[in] slot slot number
  * @param[in] filename input data file
  * @return  0 on success, or Error Code
@@ -330,6 +434,29 @@ RSU_OSAL_INT rsu_slot_verify_file_raw(RSU_OSAL_INT slot, RSU_OSAL_CHAR *filename
  */
 typedef RSU_OSAL_INT (*rsu_data_callback)(RSU_OSAL_VOID *buf, RSU_OSAL_INT size);
 
+/**
+ * @brief function pointer type for callback function for reporting progress.
+ *
+ * @param[in] arg argument given to rsu_set_progress_callback().
+ * @param[in] done number of bytes of the slot handled so far.
+ * @param[in] total size of the slot, the upper bound of done.
+ */
+typedef RSU_OSAL_VOID (*rsu_progress_callback)(RSU_OSAL_VOID *arg, RSU_OSAL_U32 done,
+					       RSU_OSAL_U32 total);
+
+/**
+ * @brief report the progress of slot program and verify operations to a callback function
+ *
+ * @note The callback runs in the thread doing the operation, with the library locked, after each
+ * block, so it must not call back into the library. It applies to the program and verify calls
+ * of all threads until replaced.
+ *
+ * @param[in] progress callback function, or NULL to stop reporting
+ * @param[in] arg argument passed to the callback function
+ * @return 0 on success, or Error Code
+ */
+RSU_OSAL_INT rsu_set_progress_callback(rsu_progress_callback progress, RSU_OSAL_VOID *arg);
+
 /**
  * @brief program and verify a slot using FPGA config data provided by a callback function. Enter
  * the slot into the CPB
@@ -377,6 +504,252 @@ RSU_OSAL_INT rsu_slot_verify_callback_raw(RSU_OSAL_INT slot, rsu_data_callback c
  */
 RSU_OSAL_INT rsu_slot_copy_to_file(RSU_OSAL_INT slot, RSU_OSAL_CHAR *filename);
 
+/**
+ * @brief read the data in a slot and write it to a compressed archive file
+ *
+ * @note The archive is split in chunks, each with its own CRC. Fully erased
+ * chunks and the erased tail of each chunk take no space, erased runs inside a
+ * chunk are run length encoded and the rest is deflate compressed when the
+ * platform provides zlib. The archive can be given to
+ * rsu_slot_program_file() and the other file based APIs, which decompress it
+ * on the fly.
+ *
+ * @param[in] slot slot number
+ * @param[in] filename output archive file
+ * @return 0 on success, or Error Code
+ */
+RSU_OSAL_INT rsu_slot_copy_to_file_compressed(RSU_OSAL_INT slot, RSU_OSAL_CHAR *filename);
+
+/**
+ * @brief size of the chunks handed to a @ref rsu_sink_callback by rsu_slot_read_callback().
+ */
+#define RSU_SLOT_READ_CHUNK_SIZE (0x10000)
+
+/**
+ * @brief read part of a slot into a buffer
+ *
+ * @param[in] slot slot number
+ * @param[in] offset offset in bytes from the start of the slot
+ * @param[in] len number of bytes to read, offset + len must not exceed the slot size
+ * @param[out] buf buffer of at least len bytes
+ * @return 0 on success, or Error Code
+ */
+RSU_OSAL_INT rsu_slot_read(RSU_OSAL_INT slot, RSU_OSAL_U32 offset, RSU_OSAL_U32 len,
+			   RSU_OSAL_VOID *buf);
+
+/**
+ * @brief function pointer type for callback function for consuming slot data.
+ *
+ * @param[in] arg argument given to rsu_slot_read_callback().
+ * @param[in] buf slot data, valid only during the call.
+ * @param[in] size number of bytes in buf.
+ * @return 0 to continue, non zero to stop reading.
+ */
+typedef RSU_OSAL_INT (*rsu_sink_callback)(RSU_OSAL_VOID *arg, const RSU_OSAL_VOID *buf,
+					  RSU_OSAL_INT size);
+
+/**
+ * @brief stream the contents of a slot to a callback function
+ *
+ * @note The slot is read in order, in chunks of at most @ref RSU_SLOT_READ_CHUNK_SIZE bytes,
+ * so only one chunk is held in memory at a time.
+ *
+ * @param[in] slot slot number
+ * @param[in] sink callback function consuming the data
+ * @param[in] arg argument passed to the callback function
+ * @return 0 on success, or Error Code
+ */
+RSU_OSAL_INT rsu_slot_read_callback(RSU_OSAL_INT slot, rsu_sink_callback sink, RSU_OSAL_VOID *arg);
+
+/** SHA-256 slot digest */
+#define RSU_DIGEST_SHA256	    1
+/** SHA-384 slot digest */
+#define RSU_DIGEST_SHA384	    2
+/** mask for the algorithm part of the alg argument of rsu_slot_digest() */
+#define RSU_DIGEST_ALG_MASK	    0xFF
+/** flag for rsu_slot_digest(): stop at the last non-erased 4KB block of the slot */
+#define RSU_DIGEST_TRIM_ERASED	    0x100
+/** size in bytes of a SHA-256 digest */
+#define RSU_DIGEST_SHA256_SIZE	    32
+/** size in bytes of a SHA-384 digest */
+#define RSU_DIGEST_SHA384_SIZE	    48
+
+/**
+ * @brief compute a cryptographic digest of the contents of a slot
+ *
+ * @note With @ref RSU_DIGEST_TRIM_ERASED the erased blocks at the end of the slot are left out,
+ * which gives the same digest as hashing the output of rsu_slot_copy_to_file().
+ *
+ * @param[in] slot slot number
+ * @param[in] alg @ref RSU_DIGEST_SHA256 or @ref RSU_DIGEST_SHA384, optionally or'ed with
+ * @ref RSU_DIGEST_TRIM_ERASED
+ * @param[out] out buffer for the digest, @ref RSU_DIGEST_SHA256_SIZE or
+ * @ref RSU_DIGEST_SHA384_SIZE bytes
+ * @return 0 on success, or Error Code
+ */
+RSU_OSAL_INT rsu_slot_digest(RSU_OSAL_INT slot, RSU_OSAL_INT alg, RSU_OSAL_U8 *out);
+
+/** flag for rsu_slot_matches_digest(): read the slot back when no digest is recorded for it */
+#define RSU_MATCH_FALLBACK_VERIFY 0x1
+
+/**
+ * @brief check whether a slot holds the contents with the given digest
+ *
+ * @note When a digest manifest is configured with the 'digest-manifest' keyword of the
+ * configuration file, the digest of every slot which is successfully programmed or verified is
+ * recorded there, and erasing or programming the slot drops it. The check is then a lookup in
+ * the manifest, without reading the slot. An entry made for another algorithm, or before the
+ * slot table changed, is not used.
+ *
+ * @param[in] slot slot number
+ * @param[in] alg digest algorithm, as for rsu_slot_digest()
+ * @param[in] digest expected digest of the slot contents, as returned by rsu_slot_digest()
+ * @param[in] flags 0 or @ref RSU_MATCH_FALLBACK_VERIFY
+ * @return 1 when the slot matches, 0 when it does not, -ENODIGEST when no digest is recorded
+ * for the slot and no fallback was requested, or Error Code
+ */
+RSU_OSAL_INT rsu_slot_matches_digest(RSU_OSAL_INT slot, RSU_OSAL_INT alg,
+				     const RSU_OSAL_U8 *digest, RSU_OSAL_INT flags);
+
+/** size of each read of the random read test of rsu_bench() */
+#define RSU_BENCH_READ_SIZE    0x1000
+/** number of reads of the random read test of rsu_bench() */
+#define RSU_BENCH_RANDOM_READS 256
+/** erase block size of the erase test of rsu_bench() */
+#define RSU_BENCH_ERASE_SIZE   0x10000
+/** size of each write of the program test of rsu_bench() */
+#define RSU_BENCH_PAGE_SIZE    256
+/** most bytes at the start of the scratch slot used by the erase and program tests */
+#define RSU_BENCH_REGION_SIZE  0x100000
+
+/**
+ * @brief results of rsu_bench(), all times in nanoseconds
+ */
+struct rsu_bench {
+	/** bytes read by the sequential read test */
+	RSU_OSAL_U64 seq_read_bytes;
+	/** time taken by the sequential read test */
+	RSU_OSAL_U64 seq_read_ns;
+	/** number of reads done by the random read test */
+	RSU_OSAL_U32 rand_reads;
+	/** bytes read by the random read test */
+	RSU_OSAL_U64 rand_read_bytes;
+	/** time taken by the random read test */
+	RSU_OSAL_U64 rand_read_ns;
+	/** number of blocks erased by the erase test, 0 when it did not run */
+	RSU_OSAL_U32 erase_blocks;
+	/** shortest erase of one block */
+	RSU_OSAL_U64 erase_min_ns;
+	/** longest erase of one block */
+	RSU_OSAL_U64 erase_max_ns;
+	/** time taken by all the block erases */
+	RSU_OSAL_U64 erase_ns;
+	/** bytes written by the program test, 0 when it did not run */
+	RSU_OSAL_U64 program_bytes;
+	/** time taken by the program test */
+	RSU_OSAL_U64 program_ns;
+};
+
+/**
+ * @brief measure the flash below the library: read, erase and program throughput
+ *
+ * The sequential read test reads every partition of the SPT once, and the random read test reads
+ * @ref RSU_BENCH_RANDOM_READS blocks at pseudo random places of them. The flash is accessed
+ * through the platform layer directly, without the checks and copies of the slot functions.
+ *
+ * When a scratch slot is given, the erase test erases the start of it block by block and the
+ * program test writes it back page by page. The contents are saved before and written back
+ * afterwards.
+ *
+ * @param[in] scratch slot the erase and program tests may use, or -1 to skip them. It must not
+ * be in the CPB
+ * @param[out] result measured values
+ * @return 0 on success, or Error Code
+ */
+RSU_OSAL_INT rsu_bench(RSU_OSAL_INT scratch, struct rsu_bench *result);
+
+/** number of latency histogram buckets in @ref rsu_stats_counter */
+#define RSU_STATS_BUCKETS 32
+
+/**
+ * @brief operations counted by rsu_get_stats()
+ */
+enum rsu_stats_op {
+	/** flash reads of the platform layer */
+	RSU_STATS_FLASH_READ,
+	/** flash writes of the platform layer */
+	RSU_STATS_FLASH_WRITE,
+	/** flash erases of the platform layer */
+	RSU_STATS_FLASH_ERASE,
+	/** mailbox commands sent to the SDM, waits for a status change are not counted */
+	RSU_STATS_MAILBOX,
+	/** DCMF version, DCMF status and max retry queries */
+	RSU_STATS_MISC,
+	/** file reads */
+	RSU_STATS_FILE_READ,
+	/** file writes */
+	RSU_STATS_FILE_WRITE,
+	/** time the library lock was held by a public API call */
+	RSU_STATS_API,
+	/** time a public API call waited for the library lock */
+	RSU_STATS_LOCK_WAIT,
+	/** number of counted operations */
+	RSU_STATS_OPS
+};
+
+/**
+ * @brief counters of one operation of @ref rsu_stats
+ */
+struct rsu_stats_counter {
+	/** number of calls */
+	RSU_OSAL_U64 count;
+	/** number of calls which failed */
+	RSU_OSAL_U64 errors;
+	/** bytes read, written or erased by the successful calls */
+	RSU_OSAL_U64 bytes;
+	/** time taken by all the calls, in nanoseconds */
+	RSU_OSAL_U64 ns;
+	/** calls per latency, bucket n counts the calls taking 2^n to 2^(n+1) - 1 nanoseconds,
+	 *  the last bucket also counts the longer ones
+	 */
+	RSU_OSAL_U64 hist[RSU_STATS_BUCKETS];
+};
+
+/**
+ * @brief snapshot of the library statistics, indexed by @ref rsu_stats_op
+ */
+struct rsu_stats {
+	/** counters of each operation */
+	struct rsu_stats_counter op[RSU_STATS_OPS];
+};
+
+/**
+ * @brief read the statistics of the library
+ *
+ * The platform calls and the public API calls are counted from the load of the library or the
+ * last rsu_reset_stats(), by all threads. The counters are updated without locking, so a
+ * snapshot taken while other threads run is not exact across counters.
+ *
+ * @param[out] stats statistics
+ * @return 0 on success, or Error Code
+ */
+RSU_OSAL_INT rsu_get_stats(struct rsu_stats *stats);
+
+/**
+ * @brief clear the statistics of the library
+ *
+ * @return 0 on success, or Error Code
+ */
+RSU_OSAL_INT rsu_reset_stats(RSU_OSAL_VOID);
+
+/**
+ * @brief name of an operation of @ref rsu_stats
+ *
+ * @param[in] op operation, see @ref rsu_stats_op
+ * @return name of the operation, or NULL for an unknown one
+ */
+const RSU_OSAL_CHAR *rsu_stats_name(RSU_OSAL_INT op);
+
 /**
  * @brief Set the selected slot as the highest priority. It will be the first slot tried after a
  * power-on reset
@@ -29,6 +29,25 @@ extern "C" {
  */
 #define RSU_TIME_NOWAIT (0UL)
 
+/**
+ * @brief function pointer type for a heap allocation function, see rsu_set_allocator()
+ */
+typedef RSU_OSAL_VOID *(*rsu_malloc_hook)(RSU_OSAL_SIZE size);
+
+/**
+ * @brief function pointer type for a heap release function, see rsu_set_allocator()
+ */
+typedef RSU_OSAL_VOID (*rsu_free_hook)(RSU_OSAL_VOID *ptr);
+
+/**
+ * @brief route rsu_malloc() and rsu_free() to application provided functions
+ *
+ * @param[in] alloc allocation function, NULL for the platform default.
+ * @param[in] release release function, NULL for the platform default.
+ * @return Nil
+ */
+RSU_OSAL_VOID rsu_set_allocator(rsu_malloc_hook alloc, rsu_free_hook release);
+
 /**
  * @brief allocate a buffer in heap memory
  *
@@ -100,6 +119,187 @@ RSU_OSAL_INT rsu_mutex_unlock(RSU_OSAL_MUTEX *mutex);
  */
 RSU_OSAL_INT rsu_mutex_destroy(RSU_OSAL_MUTEX *mutex);
 
+/**
+ * @brief function pointer type for a thread entry point, see rsu_thread_create()
+ */
+typedef RSU_OSAL_VOID *(*rsu_thread_entry)(RSU_OSAL_VOID *arg);
+
+/**
+ * @brief Start a new thread
+ *
+ * @param[out] thread pointer to a thread object of type RSU_OSAL_THREAD.
+ * @param[in] entry function the new thread runs.
+ * @param[in] arg argument passed to entry.
+ * @return 0 on success, negative number on error.
+ */
+RSU_OSAL_INT rsu_thread_create(RSU_OSAL_THREAD *thread, rsu_thread_entry entry,
+			       RSU_OSAL_VOID *arg);
+
+/**
+ * @brief Wait for a thread to finish
+ *
+ * @param[in] thread pointer to a thread object started by rsu_thread_create().
+ * @param[out] ret value returned by the thread entry, can be NULL.
+ * @return 0 on success, negative number on error.
+ */
+RSU_OSAL_INT rsu_thread_join(RSU_OSAL_THREAD *thread, RSU_OSAL_VOID **ret);
+
+/**
+ * @brief Initialize a condition variable
+ *
+ * @param[in] cond pointer to a condition variable object of type RSU_OSAL_COND.
+ * @return 0 on success, negative number on error.
+ */
+RSU_OSAL_INT rsu_cond_init(RSU_OSAL_COND *cond);
+
+/**
+ * @brief Wait on a condition variable within a time period
+ *
+ * The mutex must be locked by the caller, it is released while waiting and
+ * locked again before returning.
+ *
+ * @note time can also be @ref RSU_TIME_FOREVER.
+ *
+ * @param[in] cond pointer to a condition variable object of type RSU_OSAL_COND.
+ * @param[in] mutex pointer to the mutex protecting the condition.
+ * @param[in] time time period to wait for a signal. time is in milliseconds.
+ * @return 0 on success, -ETIMEDOUT when time expired, negative number on error.
+ */
+RSU_OSAL_INT rsu_cond_timedwait(RSU_OSAL_COND *cond, RSU_OSAL_MUTEX *mutex,
+				RSU_OSAL_U32 const time);
+
+/**
+ * @brief Wake up one thread waiting on a condition variable
+ *
+ * @param[in] cond pointer to a condition variable object of type RSU_OSAL_COND.
+ * @return 0 on success, negative number on error.
+ */
+RSU_OSAL_INT rsu_cond_signal(RSU_OSAL_COND *cond);
+
+/**
+ * @brief Wake up all threads waiting on a condition variable
+ *
+ * @param[in] cond pointer to a condition variable object of type RSU_OSAL_COND.
+ * @return 0 on success, negative number on error.
+ */
+RSU_OSAL_INT rsu_cond_broadcast(RSU_OSAL_COND *cond);
+
+/**
+ * @brief destroy a condition variable object and free up resources.
+ *
+ * @param[in] cond pointer to a condition variable object of type RSU_OSAL_COND.
+ * @return 0 on success, negative number on error.
+ */
+RSU_OSAL_INT rsu_cond_destroy(RSU_OSAL_COND *cond);
+
+/**
+ * @brief Initialize a reader/writer lock
+ *
+ * @param[in] lock pointer to a lock object of type RSU_OSAL_RWLOCK.
+ * @return 0 on success, negative number on error.
+ */
+RSU_OSAL_INT rsu_rwlock_init(RSU_OSAL_RWLOCK *lock);
+
+/**
+ * @brief Take a reader/writer lock for reading, several readers can hold it
+ *
+ * @param[in] lock pointer to a lock object of type RSU_OSAL_RWLOCK.
+ * @return 0 on success, negative number on error.
+ */
+RSU_OSAL_INT rsu_rwlock_rdlock(RSU_OSAL_RWLOCK *lock);
+
+/**
+ * @brief Take a reader/writer lock for writing
+ *
+ * @param[in] lock pointer to a lock object of type RSU_OSAL_RWLOCK.
+ * @return 0 on success, negative number on error.
+ */
+RSU_OSAL_INT rsu_rwlock_wrlock(RSU_OSAL_RWLOCK *lock);
+
+/**
+ * @brief Release a reader/writer lock taken for reading or writing
+ *
+ * @param[in] lock pointer to a lock object of type RSU_OSAL_RWLOCK.
+ * @return 0 on success, negative number on error.
+ */
+RSU_OSAL_INT rsu_rwlock_unlock(RSU_OSAL_RWLOCK *lock);
+
+/**
+ * @brief destroy a reader/writer lock object and free up resources.
+ *
+ * @param[in] lock pointer to a lock object of type RSU_OSAL_RWLOCK.
+ * @return 0 on success, negative number on error.
+ */
+RSU_OSAL_INT rsu_rwlock_destroy(RSU_OSAL_RWLOCK *lock);
+
+/**
+ * @brief Atomically read an integer
+ *
+ * @param[in] atomic pointer to an object of type RSU_OSAL_ATOMIC.
+ * @return current value.
+ */
+RSU_OSAL_INT rsu_atomic_load(RSU_OSAL_ATOMIC *atomic);
+
+/**
+ * @brief Atomically write an integer
+ *
+ * @param[in] atomic pointer to an object of type RSU_OSAL_ATOMIC.
+ * @param[in] val value to store.
+ */
+RSU_OSAL_VOID rsu_atomic_store(RSU_OSAL_ATOMIC *atomic, RSU_OSAL_INT val);
+
+/**
+ * @brief Atomically add to an integer
+ *
+ * @param[in] atomic pointer to an object of type RSU_OSAL_ATOMIC.
+ * @param[in] val value to add, can be negative.
+ * @return value after the addition.
+ */
+RSU_OSAL_INT rsu_atomic_add(RSU_OSAL_ATOMIC *atomic, RSU_OSAL_INT val);
+
+/**
+ * @brief Atomically replace an integer if it holds an expected value
+ *
+ * @param[in] atomic pointer to an object of type RSU_OSAL_ATOMIC.
+ * @param[in] expected value the object must hold.
+ * @param[in] val value to store.
+ * @return true if the value was replaced, false otherwise.
+ */
+RSU_OSAL_BOOL rsu_atomic_cas(RSU_OSAL_ATOMIC *atomic, RSU_OSAL_INT expected, RSU_OSAL_INT val);
+
+/**
+ * @brief Atomically read a 64 bit counter
+ *
+ * @note the 64 bit atomics do not order other memory accesses, they are meant for statistics.
+ *
+ * @param[in] atomic pointer to an object of type RSU_OSAL_ATOMIC64.
+ * @return current value.
+ */
+RSU_OSAL_U64 rsu_atomic64_load(RSU_OSAL_ATOMIC64 *atomic);
+
+/**
+ * @brief Atomically write a 64 bit counter
+ *
+ * @param[in] atomic pointer to an object of type RSU_OSAL_ATOMIC64.
+ * @param[in] val value to store.
+ */
+RSU_OSAL_VOID rsu_atomic64_store(RSU_OSAL_ATOMIC64 *atomic, RSU_OSAL_U64 val);
+
+/**
+ * @brief Atomically add to a 64 bit counter
+ *
+ * @param[in] atomic pointer to an object of type RSU_OSAL_ATOMIC64.
+ * @param[in] val value to add.
+ */
+RSU_OSAL_VOID rsu_atomic64_add(RSU_OSAL_ATOMIC64 *atomic, RSU_OSAL_U64 val);
+
+/**
+ * @brief Read a monotonic clock, not affected by changes of the wall clock time
+ *
+ * @return time in nanoseconds since an unspecified starting point.
+ */
+RSU_OSAL_U64 rsu_time_ns(RSU_OSAL_VOID);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2023-2024 Intel Corporation
+ * SPDX-License-Identifier: MIT-0
+ */
+
+/**
+ *
+ * @file libRSU_config.h
+ * @brief libRSU configuration, as read from the configuration file or provided by the application.
+ */
+
+#ifndef LIBRSU_CONFIG_H
+#define LIBRSU_CONFIG_H
+
+#include <libRSU_OSAL.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * @brief maximum length of the paths in @ref rsu_config, including the terminating zero.
+ */
+#define RSU_CONFIG_PATH_LEN (128U)
+
+/**
+ * @brief log_level value which keeps the default log level of the platform.
+ */
+#define RSU_CONFIG_LOG_DEFAULT (-1)
+
+/**
+ * @brief metadata_repair values, rewrite a bad SPT or CPB copy from a worker thread started by
+ * the init, during the init, or only on rsu_repair_metadata() and before the next flash write.
+ */
+#define RSU_REPAIR_BACKGROUND (0)
+#define RSU_REPAIR_INLINE     (1)
+#define RSU_REPAIR_MANUAL     (2)
+
+/**
+ * @brief libRSU configuration.
+ *
+ * The configuration file is parsed once into this structure, which is then handed to every
+ * platform init function. Applications can fill it themselves and call
+ * librsu_init_with_config(), starting from the values set by librsu_config_defaults().
+ */
+struct rsu_config {
+	/** log level, 0 (off) to 4 (debug), or RSU_CONFIG_LOG_DEFAULT. 'log' keyword */
+	RSU_OSAL_INT log_level;
+	/** file the log is written to, empty for stderr. 'log' keyword */
+	RSU_OSAL_CHAR log_file[RSU_CONFIG_PATH_LEN];
+	/** QSPI device, empty for the platform default. 'root qspi' keyword */
+	RSU_OSAL_CHAR qspi_dev[RSU_CONFIG_PATH_LEN];
+	/** RSU device, empty for the platform default. 'rsu-dev' keyword */
+	RSU_OSAL_CHAR rsu_dev[RSU_CONFIG_PATH_LEN];
+	/** bit mask of the write protected slots, first 32 slots only. 'write-protect' keyword */
+	RSU_OSAL_U32 writeprotect;
+	/** check the SPT checksum, enabled by default. 'rsu-spt-checksum' keyword */
+	RSU_OSAL_U32 spt_checksum_enabled;
+	/** validate images before programming. 'program-preflight' keyword */
+	RSU_OSAL_U32 program_preflight;
+	/** status poller period in milliseconds, 0 for the default. 'status-poll-interval' keyword */
+	RSU_OSAL_U32 status_poll_interval;
+	/** digest manifest file, empty for none. 'digest-manifest' keyword */
+	RSU_OSAL_CHAR digest_manifest[RSU_CONFIG_PATH_LEN];
+	/** digest algorithm and flags of the manifest. 'digest-manifest' keyword */
+	RSU_OSAL_INT digest_manifest_alg;
+	/** metadata snapshot file for a fast init, empty for none. 'metadata-cache' keyword */
+	RSU_OSAL_CHAR metadata_cache[RSU_CONFIG_PATH_LEN];
+	/** open the flash read-only, load the SPT and CPB on first use. 'read-only' keyword */
+	RSU_OSAL_U32 read_only;
+	/** when a bad SPT or CPB copy is rewritten, RSU_REPAIR_*. 'metadata-repair' keyword */
+	RSU_OSAL_INT metadata_repair;
+	/** file every platform call is traced to, empty for none. 'hal-trace' keyword */
+	RSU_OSAL_CHAR hal_trace[RSU_CONFIG_PATH_LEN];
+	/** also trace the data read and written, needed for a replay. 'hal-trace' keyword */
+	RSU_OSAL_U32 hal_trace_data;
+	/** trace served instead of the flash, mailbox and misc platform. 'hal-replay' keyword */
+	RSU_OSAL_CHAR hal_replay[RSU_CONFIG_PATH_LEN];
+	/** make each replayed call last as long as when it was traced. 'hal-replay' keyword */
+	RSU_OSAL_U32 hal_replay_timing;
+};
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif
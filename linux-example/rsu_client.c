@@ -1,11 +1,22 @@
 
+#include "rsud_proto.h"
+#include <ctype.h>
 #include <getopt.h>
 #include <libRSU.h>
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
 
-#define MAX_SLOT_NAME 15
+#define MAX_SLOT_NAME  15
+#define MAX_BATCH_ARGS 32
+
+/* connection to rsud when the commands go through the daemon, -1 otherwise */
+static int rsud_fd = -1;
+static int librsu_ready;
+static int progress_shown;
 
 /*
  * enum rsu_clinet_command_code - supporting RSU client commands
@@ -28,6 +39,7 @@ enum rsu_clinet_command_code {
 	COMMAND_VERIFY_IMAGE,
 	COMMAND_VERIFY_RAW_IMAGE,
 	COMMAND_COPY_TO_FILE,
+	COMMAND_COPY_TO_FILE_COMPRESSED,
 	COMMAND_STATUS_LOG,
 	COMMAND_NOTIFY,
 	COMMAND_CLEAR_ERROR_STATUS,
@@ -42,7 +54,8 @@ enum rsu_clinet_command_code {
 	COMMAND_CREATE_EMPTY_CPB,
 	COMMAND_RESTORE_CPB,
 	COMMAND_SAVE_CPB,
-	COMMAND_CHECK_RUNNING_FACTORY
+	COMMAND_CHECK_RUNNING_FACTORY,
+	COMMAND_BENCH
 };
 
 static const struct option opts[] = {{"count", no_argument, NULL, 'c'},
@@ -62,6 +75,7 @@ static const struct option opts[] = {{"count", no_argument, NULL, 'c'},
 				     {"verify", required_argument, NULL, 'v'},
 				     {"verify-raw", required_argument, NULL, 'V'},
 				     {"copy", required_argument, NULL, 'f'},
+				     {"copy-compressed", required_argument, NULL, 'F'},
 				     {"request", required_argument, NULL, 'r'},
 				     {"notify", required_argument, NULL, 'n'},
 				     {"clear-error-status", no_argument, NULL, 'C'},
@@ -79,6 +93,12 @@ static const struct option opts[] = {{"count", no_argument, NULL, 'c'},
 				     {"restore-cpb", required_argument, NULL, 'B'},
 				     {"save-cpb", required_argument, NULL, 'P'},
 				     {"check-running-factory", no_argument, NULL, 'k'},
+				     {"daemon", required_argument, NULL, 'w'},
+				     {"batch", required_argument, NULL, 'i'},
+				     {"keep-going", no_argument, NULL, 'K'},
+				     {"bench", no_argument, NULL, 'j'},
+				     {"bench-slot", required_argument, NULL, 'J'},
+				     {"stats", no_argument, NULL, 'M'},
 				     {NULL, 0, NULL, 0}};
 
 /*
@@ -114,6 +134,8 @@ static void rsu_client_usage(void)
 	       "verify raw image on the selected slot\n");
 	printf("%-32s  %s", "-f|--copy file_name -s|--slot slot_num",
 	       "read the data in a selected slot then write to a file\n");
+	printf("%-32s  %s", "-F|--copy-compressed file_name -s|--slot slot_num",
+	       "read the data in a selected slot then write to a compressed file\n");
 	printf("%-32s  %s", "-g|--log", "print the status log\n");
 	printf("%-32s  %s", "-n|--notify value", "report software state\n");
 	printf("%-32s  %s", "-C|--clear-error-status", "clear errors from the log\n");
@@ -133,9 +155,100 @@ static void rsu_client_usage(void)
 	printf("%-32s  %s", "-P|--save-cpb file_name", "save cpb to a file\n");
 	printf("%-32s  %s", "-k|--check-running-factory",
 	       "check if currently running the factory image\n");
+	printf("%-32s  %s", "-j|--bench [-J|--bench-slot slot_name]",
+	       "measure flash and library throughput, erase and program on the named slot only\n");
+	printf("%-32s  %s", "-w|--daemon socket_path",
+	       "run the command in rsud instead of this process\n");
+	printf("%-32s  %s", "-i|--batch file_name",
+	       "run the commands listed in a file, or in the standard input for -\n");
+	printf("%-32s  %s", "-K|--keep-going", "continue a batch after a failed command\n");
+	printf("%-32s  %s", "-M|--stats", "print the library statistics at the end\n");
 	printf("%-32s  %s", "-h|--help", "show usage message\n");
 }
 
+/*
+ * rsu_client_progress() - show the progress of a command running in rsud
+ * arg: unused
+ * progress: progress message of the daemon
+ *
+ * This function doesn't have return.
+ */
+static void rsu_client_progress(void *arg, const struct rsud_progress *progress)
+{
+	(void)arg;
+
+	if (progress->queued) {
+		printf("waiting for %u request(s) to finish\n", progress->queued);
+		return;
+	}
+
+	if (progress->total) {
+		printf("\r%u of %u bytes", progress->done, progress->total);
+		fflush(stdout);
+		progress_shown = 1;
+	}
+}
+
+/*
+ * rsu_client_remote() - run a command in rsud
+ * command: RSUD_CMD_ command code
+ * slot_num: the selected slot, or -1
+ * value: notify value or slot address
+ * text: slot name or absolute file name, or NULL
+ * data: buffer for the data of the command
+ * len: size of data
+ *
+ * Return: return value of the command, or negative value on error
+ */
+static int rsu_client_remote(int command, int slot_num, unsigned long long value,
+			     unsigned long long size, const char *text, void *data,
+			     unsigned int len)
+{
+	struct rsud_request req;
+	int ret;
+
+	memset(&req, 0, sizeof(req));
+	req.command = command;
+	req.slot = slot_num;
+	req.value = value;
+	req.size = size;
+
+	ret = rsud_call(rsud_fd, &req, text, data, len, rsu_client_progress, NULL);
+	if (progress_shown) {
+		printf("\n");
+		progress_shown = 0;
+	}
+
+	return ret;
+}
+
+/*
+ * rsu_client_remote_file() - run a command on a file in rsud
+ * command: RSUD_CMD_ command code
+ * slot_num: the selected slot, or -1
+ * file_name: file name, relative to the current directory of the client
+ *
+ * Return: return value of the command, or negative value on error
+ */
+static int rsu_client_remote_file(int command, int slot_num, char *file_name)
+{
+	char path[PATH_MAX];
+
+	if (file_name[0] == '/') {
+		return rsu_client_remote(command, slot_num, 0, 0, file_name, NULL, 0);
+	}
+
+	if (!getcwd(path, sizeof(path)) ||
+	    strlen(path) + strlen(file_name) + 2 > sizeof(path)) {
+		return -1;
+	}
+
+	strcat(path, "/");
+	strcat(path, file_name);
+
+	return rsu_client_remote(command, slot_num, 0, 0, path, NULL, 0);
+}
+
 /*
  * rsu_client_slot_count() - get the number of predefined slot
  *
@@ -143,6 +256,10 @@ static void rsu_client_usage(void)
  */
 static int rsu_client_get_slot_count(void)
 {
+	if (rsud_fd >= 0) {
+		return rsu_client_remote(RSUD_CMD_SLOT_COUNT, -1, 0, 0, NULL, NULL, 0);
+	}
+
 	return rsu_slot_count();
 }
 
@@ -164,7 +281,13 @@ static int rsu_client_copy_status_log(void)
 		return rtn;
 	}
 
-	if (!rsu_status_log(info)) {
+	if (rsud_fd >= 0) {
+		rtn = rsu_client_remote(RSUD_CMD_STATUS_LOG, -1, 0, 0, NULL, info, sizeof(*info));
+	} else {
+		rtn = rsu_status_log(info);
+	}
+
+	if (!rtn) {
 		rtn = 0;
 		printf("      VERSION: 0x%08X\n", (int)info->version);
 		printf("        STATE: 0x%08X\n", (int)info->state);
@@ -194,6 +317,10 @@ static int rsu_client_copy_status_log(void)
  */
 static int rsu_client_request_slot_be_loaded(int slot_num)
 {
+	if (rsud_fd >= 0) {
+		return rsu_client_remote(RSUD_CMD_SLOT_LOAD, slot_num, 0, 0, NULL, NULL, 0);
+	}
+
 	return rsu_slot_load_after_reboot(slot_num);
 }
 
@@ -204,6 +331,10 @@ static int rsu_client_request_slot_be_loaded(int slot_num)
  */
 static int rsu_client_request_factory_be_loaded(void)
 {
+	if (rsud_fd >= 0) {
+		return rsu_client_remote(RSUD_CMD_FACTORY_LOAD, -1, 0, 0, NULL, NULL, 0);
+	}
+
 	return rsu_slot_load_factory_after_reboot();
 }
 
@@ -227,8 +358,14 @@ static int rsu_client_list_slot_attribute(int slot_num)
 		return rtn;
 	}
 
-	if (!rsu_slot_get_info(slot_num, info)) {
-		rtn = 0;
+	if (rsud_fd >= 0) {
+		rtn = rsu_client_remote(RSUD_CMD_SLOT_INFO, slot_num, 0, 0, NULL, info,
+					sizeof(*info));
+	} else {
+		rtn = rsu_slot_get_info(slot_num, info);
+	}
+
+	if (!rtn) {
 		printf("      NAME: %s\n", info->name);
 		printf("    OFFSET: 0x%016llX\n", info->offset);
 		printf("      SIZE: 0x%08X\n", info->size);
@@ -253,6 +390,10 @@ static int rsu_client_list_slot_attribute(int slot_num)
  */
 static int rsu_client_get_slot_size(int slot_num)
 {
+	if (rsud_fd >= 0) {
+		return rsu_client_remote(RSUD_CMD_SLOT_SIZE, slot_num, 0, 0, NULL, NULL, 0);
+	}
+
 	return rsu_slot_size(slot_num);
 }
 
@@ -264,6 +405,10 @@ static int rsu_client_get_slot_size(int slot_num)
  */
 static int rsu_client_get_priority(int slot_num)
 {
+	if (rsud_fd >= 0) {
+		return rsu_client_remote(RSUD_CMD_SLOT_PRIORITY, slot_num, 0, 0, NULL, NULL, 0);
+	}
+
 	return rsu_slot_priority(slot_num);
 }
 
@@ -277,6 +422,12 @@ static int rsu_client_get_priority(int slot_num)
  */
 static int rsu_client_add_app_image(char *image_name, int slot_num, int raw)
 {
+	if (rsud_fd >= 0) {
+		return rsu_client_remote_file(raw ? RSUD_CMD_PROGRAM_FILE_RAW :
+						    RSUD_CMD_PROGRAM_FILE,
+					      slot_num, image_name);
+	}
+
 	if (raw) {
 		return rsu_slot_program_file_raw(slot_num, image_name);
 	}
@@ -294,6 +445,11 @@ static int rsu_client_add_app_image(char *image_name, int slot_num, int raw)
  */
 static int rsu_client_add_factory_update_image(char *image_name, int slot_num)
 {
+	if (rsud_fd >= 0) {
+		return rsu_client_remote_file(RSUD_CMD_PROGRAM_FACTORY_UPDATE, slot_num,
+					      image_name);
+	}
+
 	return rsu_slot_program_factory_update_file(slot_num, image_name);
 }
 
@@ -305,6 +461,10 @@ static int rsu_client_add_factory_update_image(char *image_name, int slot_num)
  */
 static int rsu_client_erase_image(int slot_num)
 {
+	if (rsud_fd >= 0) {
+		return rsu_client_remote(RSUD_CMD_SLOT_ERASE, slot_num, 0, 0, NULL, NULL, 0);
+	}
+
 	return rsu_slot_erase(slot_num);
 }
 
@@ -318,6 +478,11 @@ static int rsu_client_erase_image(int slot_num)
  */
 static int rsu_client_verify_data(char *file_name, int slot_num, int raw)
 {
+	if (rsud_fd >= 0) {
+		return rsu_client_remote_file(raw ? RSUD_CMD_VERIFY_FILE_RAW : RSUD_CMD_VERIFY_FILE,
+					      slot_num, file_name);
+	}
+
 	if (raw) {
 		return rsu_slot_verify_file_raw(slot_num, file_name);
 	}
@@ -334,9 +499,31 @@ static int rsu_client_verify_data(char *file_name, int slot_num, int raw)
  */
 static int rsu_client_copy_to_file(char *file_name, int slot_num)
 {
+	if (rsud_fd >= 0) {
+		return rsu_client_remote_file(RSUD_CMD_COPY_TO_FILE, slot_num, file_name);
+	}
+
 	return rsu_slot_copy_to_file(slot_num, file_name);
 }
 
+/*
+ * rsu_client_copy_to_file_compressed() - read the data from a slot then write
+ *					  to a compressed archive file
+ * file_name: number of file which store the data
+ * slot_num: the selected slot
+ *
+ * Return: 0 on success, or negative on error
+ */
+static int rsu_client_copy_to_file_compressed(char *file_name, int slot_num)
+{
+	if (rsud_fd >= 0) {
+		return rsu_client_remote_file(RSUD_CMD_COPY_TO_FILE_COMPRESSED, slot_num,
+					      file_name);
+	}
+
+	return rsu_slot_copy_to_file_compressed(slot_num, file_name);
+}
+
 /*
  * rsu_client_display_dcmf_version() - display the version of each of the four
  *				       DCMF copies in flash
@@ -348,7 +535,12 @@ static int rsu_client_display_dcmf_version(void)
 	__u32 versions[4];
 	int i, ret;
 
-	ret = rsu_dcmf_version(versions);
+	if (rsud_fd >= 0) {
+		ret = rsu_client_remote(RSUD_CMD_DCMF_VERSION, -1, 0, 0, NULL, versions,
+					sizeof(versions));
+	} else {
+		ret = rsu_dcmf_version(versions);
+	}
 	if (ret) {
 		return ret;
 	}
@@ -371,7 +563,12 @@ static int rsu_client_display_dcmf_status(void)
 	int status[4];
 	int i, ret;
 
-	ret = rsu_dcmf_status(status);
+	if (rsud_fd >= 0) {
+		ret = rsu_client_remote(RSUD_CMD_DCMF_STATUS, -1, 0, 0, NULL, status,
+					sizeof(status));
+	} else {
+		ret = rsu_dcmf_status(status);
+	}
 	if (ret) {
 		return ret;
 	}
@@ -393,7 +590,11 @@ static int rsu_client_display_max_retry(void)
 	__u8 value;
 	int ret;
 
-	ret = rsu_max_retry(&value);
+	if (rsud_fd >= 0) {
+		ret = rsu_client_remote(RSUD_CMD_MAX_RETRY, -1, 0, 0, NULL, &value, sizeof(value));
+	} else {
+		ret = rsu_max_retry(&value);
+	}
 	if (ret) {
 		return ret;
 	}
@@ -412,7 +613,12 @@ static int rsu_client_check_running_factory(void)
 	int factory;
 	int ret;
 
-	ret = rsu_running_factory(&factory);
+	if (rsud_fd >= 0) {
+		ret = rsu_client_remote(RSUD_CMD_RUNNING_FACTORY, -1, 0, 0, NULL, &factory,
+					sizeof(factory));
+	} else {
+		ret = rsu_running_factory(&factory);
+	}
 	if (ret) {
 		return ret;
 	}
@@ -421,528 +627,1226 @@ static int rsu_client_check_running_factory(void)
 	return 0;
 }
 
-static void error_exit(char *msg)
+/*
+ * rsu_client_simple() - run a command that only takes a slot number and a
+ *			 value, either in rsud or in this process
+ * command: RSUD_CMD_ command code
+ * slot_num: the selected slot, or -1
+ * value: notify value
+ *
+ * Return: 0 on success, or negative on error
+ */
+static int rsu_client_simple(int command, int slot_num, int value)
 {
-	printf("ERROR: %s\n", msg);
-	librsu_exit();
-	exit(1);
+	if (rsud_fd >= 0) {
+		return rsu_client_remote(command, slot_num, value, 0, NULL, NULL, 0);
+	}
+
+	switch (command) {
+	case RSUD_CMD_SLOT_ENABLE:
+		return rsu_slot_enable(slot_num);
+	case RSUD_CMD_SLOT_DISABLE:
+		return rsu_slot_disable(slot_num);
+	case RSUD_CMD_NOTIFY:
+		return rsu_notify(value);
+	case RSUD_CMD_CLEAR_ERROR_STATUS:
+		return rsu_clear_error_status();
+	case RSUD_CMD_RESET_RETRY_COUNTER:
+		return rsu_reset_retry_counter();
+	case RSUD_CMD_SLOT_DELETE:
+		return rsu_slot_delete(slot_num);
+	case RSUD_CMD_CREATE_EMPTY_CPB:
+		return rsu_create_empty_cpb();
+	default:
+		return -1;
+	}
 }
 
-int main(int argc, char *argv[])
+/*
+ * rsu_client_file() - run an SPT or CPB command on a file, either in rsud or
+ *		       in this process
+ * command: RSUD_CMD_ command code
+ * file_name: file name
+ *
+ * Return: 0 on success, or negative on error
+ */
+static int rsu_client_file(int command, char *file_name)
 {
-	int c;
-	int index = 0;
+	if (rsud_fd >= 0) {
+		return rsu_client_remote_file(command, -1, file_name);
+	}
+
+	switch (command) {
+	case RSUD_CMD_RESTORE_SPT:
+		return rsu_restore_spt(file_name);
+	case RSUD_CMD_SAVE_SPT:
+		return rsu_save_spt(file_name);
+	case RSUD_CMD_RESTORE_CPB:
+		return rsu_restore_cpb(file_name);
+	case RSUD_CMD_SAVE_CPB:
+		return rsu_save_cpb(file_name);
+	default:
+		return -1;
+	}
+}
+
+/*
+ * rsu_client_create_slot() - create a new slot
+ * slot_name: name of the new slot
+ * slot_address: address of the new slot
+ * slot_size: size of the new slot
+ *
+ * Return: 0 on success, or negative on error
+ */
+static int rsu_client_create_slot(char *slot_name, int slot_address, int slot_size)
+{
+	if (rsud_fd >= 0) {
+		return rsu_client_remote(RSUD_CMD_SLOT_CREATE, -1, slot_address, slot_size,
+					 slot_name, NULL, 0);
+	}
+
+	return rsu_slot_create(slot_name, slot_address, slot_size);
+}
+
+/*
+ * struct rsu_client_timing - one measured library call
+ */
+struct rsu_client_timing {
+	unsigned long long bytes;
+	unsigned long long ns;
+};
+
+static unsigned long long rsu_client_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int rsu_client_discard(void *arg, const void *buf, int size)
+{
+	(void)arg;
+	(void)buf;
+	(void)size;
+	return 0;
+}
+
+static void rsu_client_bench_row(const char *name, unsigned long long bytes,
+				 unsigned long long ns)
+{
+	printf("%-24s %12llu %12.3f %10.2f\n", name, bytes, ns / 1e6,
+	       ns ? bytes * 1e3 / ns : 0.0);
+}
+
+static void rsu_client_bench_json(const char *name, unsigned long long bytes,
+				  unsigned long long ns, int last)
+{
+	printf("\"%s\":{\"bytes\":%llu,\"ns\":%llu}%s", name, bytes, ns, last ? "" : ",");
+}
+
+/*
+ * rsu_client_bench_library() - time the library program, verify and erase
+ *				paths on a scratch slot
+ * slot_num: scratch slot, not in the CPB
+ * erase, program, verify: measured calls
+ *
+ * The slot is programmed with its own contents, so it ends up as it was. An
+ * empty slot is programmed with a pattern and erased again.
+ *
+ * Return: 0 on success, or negative on error
+ */
+static int rsu_client_bench_library(int slot_num, struct rsu_client_timing *erase,
+				    struct rsu_client_timing *program,
+				    struct rsu_client_timing *verify)
+{
+	unsigned long long start;
+	unsigned char *data;
+	int size, len, x;
+	int empty = 0;
+	int ret;
+
+	size = rsu_slot_size(slot_num);
+	if (size <= 0) {
+		return size ? size : -1;
+	}
+
+	data = malloc(size);
+	if (!data) {
+		return -1;
+	}
+
+	ret = rsu_slot_copy_to_buf(slot_num, data, size);
+	if (ret) {
+		free(data);
+		return ret;
+	}
+
+	for (len = size; len > 0 && data[len - 1] == 0xFF; len--) {
+		;
+	}
+
+	if (len == 0) {
+		empty = 1;
+		len = size < RSU_BENCH_REGION_SIZE ? size : RSU_BENCH_REGION_SIZE;
+		for (x = 0; x < len; x++) {
+			data[x] = (unsigned char)(x * 31);
+		}
+	}
+
+	start = rsu_client_ns();
+	ret = rsu_slot_erase(slot_num);
+	erase->ns = rsu_client_ns() - start;
+	erase->bytes = size;
+
+	if (!ret) {
+		start = rsu_client_ns();
+		ret = rsu_slot_program_buf_raw(slot_num, data, len);
+		program->ns = rsu_client_ns() - start;
+		program->bytes = len;
+	}
+
+	if (!ret) {
+		start = rsu_client_ns();
+		ret = rsu_slot_verify_buf_raw(slot_num, data, len);
+		verify->ns = rsu_client_ns() - start;
+		verify->bytes = len;
+	}
+
+	/* the slot was empty, the pattern goes again */
+	if (!ret && empty) {
+		ret = rsu_slot_erase(slot_num);
+	}
+
+	free(data);
+	return ret;
+}
+
+/*
+ * rsu_client_bench() - measure the flash and the library
+ * slot_name: name of the scratch slot, or NULL for the read tests only
+ *
+ * The flash figures come from rsu_bench(), which works below the slot
+ * functions. The library figures time the public slot calls on the same
+ * flash, so the two can be compared. A table is printed first, then the same
+ * values as one JSON object on a line of its own.
+ *
+ * Return: 0 on success, or negative on error
+ */
+static int rsu_client_bench(char *slot_name)
+{
+	struct rsu_client_timing copy = {0, 0};
+	struct rsu_client_timing erase = {0, 0};
+	struct rsu_client_timing program = {0, 0};
+	struct rsu_client_timing verify = {0, 0};
+	struct rsu_bench bench;
+	unsigned long long start;
 	int slot_num = -1;
-	int slot_address = -1;
-	int slot_size = -1;
-	char slot_name[MAX_SLOT_NAME + 1] = "";
-	char *endptr;
-	int notify_value = -1;
-	enum rsu_clinet_command_code command = COMMAND_NONE;
-	char *filename = NULL;
+	int count, x;
 	int ret;
 
-	if (argc == 1) {
-		rsu_client_usage();
-		exit(1);
+	if (slot_name) {
+		slot_num = rsu_slot_by_name(slot_name);
+		if (slot_num < 0) {
+			printf("No slot named %s\n", slot_name);
+			return slot_num;
+		}
 	}
 
-	ret = librsu_init("");
+	ret = rsu_bench(slot_num, &bench);
 	if (ret) {
-		printf("librsu_init return %d\n", ret);
 		return ret;
 	}
 
+	count = rsu_slot_count();
+	start = rsu_client_ns();
+	for (x = 0; x < count; x++) {
+		ret = rsu_slot_read_callback(x, rsu_client_discard, NULL);
+		if (ret) {
+			return ret;
+		}
+		copy.bytes += rsu_slot_size(x);
+	}
+	copy.ns = rsu_client_ns() - start;
+
+	if (slot_num >= 0) {
+		ret = rsu_client_bench_library(slot_num, &erase, &program, &verify);
+		if (ret) {
+			return ret;
+		}
+	}
+
+	printf("%-24s %12s %12s %10s\n", "TEST", "BYTES", "TIME (ms)", "MB/s");
+	rsu_client_bench_row("flash sequential read", bench.seq_read_bytes, bench.seq_read_ns);
+	rsu_client_bench_row("flash random read", bench.rand_read_bytes, bench.rand_read_ns);
+	if (bench.erase_blocks) {
+		rsu_client_bench_row("flash block erase", bench.erase_blocks * RSU_BENCH_ERASE_SIZE,
+				     bench.erase_ns);
+		rsu_client_bench_row("flash page program", bench.program_bytes, bench.program_ns);
+	}
+	rsu_client_bench_row("library slot copy", copy.bytes, copy.ns);
+	if (slot_num >= 0) {
+		rsu_client_bench_row("library slot erase", erase.bytes, erase.ns);
+		rsu_client_bench_row("library slot program", program.bytes, program.ns);
+		rsu_client_bench_row("library slot verify", verify.bytes, verify.ns);
+	}
+	if (bench.erase_blocks) {
+		printf("erase of one %u byte block: min %.3f ms, avg %.3f ms, max %.3f ms\n",
+		       RSU_BENCH_ERASE_SIZE, bench.erase_min_ns / 1e6,
+		       bench.erase_ns / 1e6 / bench.erase_blocks, bench.erase_max_ns / 1e6);
+	}
+
+	printf("{\"flash\":{");
+	rsu_client_bench_json("seq_read", bench.seq_read_bytes, bench.seq_read_ns, 0);
+	printf("\"random_read\":{\"reads\":%u,\"bytes\":%llu,\"ns\":%llu},", bench.rand_reads,
+	       bench.rand_read_bytes, bench.rand_read_ns);
+	printf("\"erase\":{\"blocks\":%u,\"block_size\":%u,\"min_ns\":%llu,\"max_ns\":%llu,"
+	       "\"ns\":%llu},",
+	       bench.erase_blocks, RSU_BENCH_ERASE_SIZE, bench.erase_min_ns, bench.erase_max_ns,
+	       bench.erase_ns);
+	printf("\"program\":{\"page_size\":%u,\"bytes\":%llu,\"ns\":%llu}},\"library\":{",
+	       RSU_BENCH_PAGE_SIZE, bench.program_bytes, bench.program_ns);
+	rsu_client_bench_json("copy", copy.bytes, copy.ns, 0);
+	rsu_client_bench_json("erase", erase.bytes, erase.ns, 0);
+	rsu_client_bench_json("program", program.bytes, program.ns, 0);
+	rsu_client_bench_json("verify", verify.bytes, verify.ns, 1);
+	printf("}}\n");
+
+	return 0;
+}
+
+/*
+ * rsu_client_stats_us() - latency below which a share of the calls finished
+ * counter: statistics of one operation
+ * share: share of the calls, in percent
+ *
+ * Return: upper bound of the histogram bucket, in microseconds
+ */
+static double rsu_client_stats_us(const struct rsu_stats_counter *counter, unsigned int share)
+{
+	unsigned long long want = (counter->count * share + 99) / 100;
+	unsigned long long seen = 0;
+	int x;
+
+	for (x = 0; x < RSU_STATS_BUCKETS - 1; x++) {
+		seen += counter->hist[x];
+		if (seen >= want) {
+			break;
+		}
+	}
+
+	return (double)(2ULL << x) / 1e3;
+}
+
+/*
+ * rsu_client_stats() - print the library statistics
+ *
+ * Only the operations which ran are listed. The percentiles are the upper
+ * bounds of the latency histogram buckets.
+ *
+ * Return: 0 on success, or negative on error
+ */
+static int rsu_client_stats(void)
+{
+	struct rsu_stats stats;
+	struct rsu_stats_counter *counter;
+	int ret;
+	int x;
+
+	ret = rsu_get_stats(&stats);
+	if (ret) {
+		return ret;
+	}
+
+	printf("%-12s %10s %8s %14s %12s %10s %10s %10s\n", "op", "count", "errors", "bytes",
+	       "total_ms", "mean_us", "p50_us", "p99_us");
+	for (x = 0; x < RSU_STATS_OPS; x++) {
+		counter = &stats.op[x];
+		if (!counter->count) {
+			continue;
+		}
+		printf("%-12s %10llu %8llu %14llu %12.3f %10.1f %10.1f %10.1f\n", rsu_stats_name(x),
+		       counter->count, counter->errors, counter->bytes, counter->ns / 1e6,
+		       counter->ns / 1e3 / counter->count, rsu_client_stats_us(counter, 50),
+		       rsu_client_stats_us(counter, 99));
+	}
+
+	return 0;
+}
+
+/*
+ * struct rsu_client_args - one parsed command line
+ */
+struct rsu_client_args {
+	enum rsu_clinet_command_code command;
+	int slot_num;
+	int slot_address;
+	int slot_size;
+	char slot_name[MAX_SLOT_NAME + 1];
+	int notify_value;
+	char *filename;
+	char *bench_slot;
+	char *socket_path;
+	char *batch;
+	int keep_going;
+	int stats;
+	int help;
+};
+
+/*
+ * rsu_client_parse() - parse a command line
+ * argc: number of arguments
+ * argv: arguments, argv[0] is skipped
+ * args: parsed command
+ *
+ * Return: NULL on success, or error message
+ */
+static const char *rsu_client_parse(int argc, char *argv[], struct rsu_client_args *args)
+{
+	int c;
+	int index = 0;
+	char *endptr;
+
+	memset(args, 0, sizeof(*args));
+	args->command = COMMAND_NONE;
+	args->slot_num = -1;
+	args->slot_address = -1;
+	args->slot_size = -1;
+	args->notify_value = -1;
+
+	/* getopt is used once per batch line, 0 restarts it from scratch */
+	optind = 0;
+
 	while ((c = getopt_long(argc, argv,
-				"cghRl:z:p:t:a:u:A:s:e:v:V:f:r:E:D:n:CZmyxd:W:X:bB:P:S:L:k", opts,
+				"cghRl:z:p:t:a:u:A:s:e:v:V:f:F:r:E:D:n:CZmyxd:W:X:bB:P:S:L:kw:i:KjJ:M", opts,
 				&index)) != -1) {
 		switch (c) {
 		case 'c':
-			if (command != COMMAND_NONE) {
-				error_exit("Only one command allowed");
+			if (args->command != COMMAND_NONE) {
+				return "Only one command allowed";
 			}
-			command = COMMAND_SLOT_COUNT;
+			args->command = COMMAND_SLOT_COUNT;
 			break;
 		case 'l':
-			if (command != COMMAND_NONE) {
-				error_exit("Only one command allowed");
+			if (args->command != COMMAND_NONE) {
+				return "Only one command allowed";
 			}
-			if (slot_num >= 0) {
-				error_exit("Slot number already set");
+			if (args->slot_num >= 0) {
+				return "Slot number already set";
 			}
-			command = COMMAND_SLOT_ATTR;
-			slot_num = atoi(optarg);
+			args->command = COMMAND_SLOT_ATTR;
+			args->slot_num = atoi(optarg);
 			break;
 		case 'z':
-			if (command != COMMAND_NONE) {
-				error_exit("Only one command allowed");
+			if (args->command != COMMAND_NONE) {
+				return "Only one command allowed";
 			}
-			if (slot_num >= 0) {
-				error_exit("Slot number already set");
+			if (args->slot_num >= 0) {
+				return "Slot number already set";
 			}
-			command = COMMAND_SLOT_SIZE;
-			slot_num = atoi(optarg);
+			args->command = COMMAND_SLOT_SIZE;
+			args->slot_num = atoi(optarg);
 			break;
 		case 'p':
-			if (command != COMMAND_NONE) {
-				error_exit("Only one command allowed");
+			if (args->command != COMMAND_NONE) {
+				return "Only one command allowed";
 			}
-			if (slot_num >= 0) {
-				error_exit("Slot number already set");
+			if (args->slot_num >= 0) {
+				return "Slot number already set";
 			}
-			command = COMMAND_SLOT_PRIORITY;
-			slot_num = atoi(optarg);
+			args->command = COMMAND_SLOT_PRIORITY;
+			args->slot_num = atoi(optarg);
 			break;
 		case 'E':
-			if (command != COMMAND_NONE) {
-				error_exit("Only one command allowed");
+			if (args->command != COMMAND_NONE) {
+				return "Only one command allowed";
 			}
-			if (slot_num >= 0) {
-				error_exit("Slot number already set");
+			if (args->slot_num >= 0) {
+				return "Slot number already set";
 			}
-			command = COMMAND_SLOT_ENABLE;
-			slot_num = atoi(optarg);
+			args->command = COMMAND_SLOT_ENABLE;
+			args->slot_num = atoi(optarg);
 			break;
 		case 'D':
-			if (command != COMMAND_NONE) {
-				error_exit("Only one command allowed");
+			if (args->command != COMMAND_NONE) {
+				return "Only one command allowed";
 			}
-			if (slot_num >= 0) {
-				error_exit("Slot number already set");
+			if (args->slot_num >= 0) {
+				return "Slot number already set";
 			}
-			command = COMMAND_SLOT_DISABLE;
-			slot_num = atoi(optarg);
+			args->command = COMMAND_SLOT_DISABLE;
+			args->slot_num = atoi(optarg);
 			break;
 		case 'r':
-			if (command != COMMAND_NONE) {
-				error_exit("Only one command allowed");
+			if (args->command != COMMAND_NONE) {
+				return "Only one command allowed";
 			}
-			if (slot_num >= 0) {
-				error_exit("Slot number already set");
+			if (args->slot_num >= 0) {
+				return "Slot number already set";
 			}
-			command = COMMAND_SLOT_LOAD;
-			slot_num = atoi(optarg);
+			args->command = COMMAND_SLOT_LOAD;
+			args->slot_num = atoi(optarg);
 			break;
 		case 'R':
-			if (command != COMMAND_NONE) {
-				error_exit("Only one command allowed");
+			if (args->command != COMMAND_NONE) {
+				return "Only one command allowed";
 			}
-			command = COMMAND_FACTORY_LOAD;
+			args->command = COMMAND_FACTORY_LOAD;
 			break;
 		case 'e':
-			if (command != COMMAND_NONE) {
-				error_exit("Only one command allowed");
+			if (args->command != COMMAND_NONE) {
+				return "Only one command allowed";
 			}
-			if (slot_num >= 0) {
-				error_exit("Slot number already set");
+			if (args->slot_num >= 0) {
+				return "Slot number already set";
 			}
-			command = COMMAND_SLOT_ERASE;
-			slot_num = atoi(optarg);
+			args->command = COMMAND_SLOT_ERASE;
+			args->slot_num = atoi(optarg);
 			break;
 		case 's':
-			if (slot_num >= 0) {
-				error_exit("Slot number already set");
+			if (args->slot_num >= 0) {
+				return "Slot number already set";
 			}
-			slot_num = atoi(optarg);
+			args->slot_num = atoi(optarg);
 			break;
 		case 'a':
-			if (command != COMMAND_NONE) {
-				error_exit("Only one command allowed");
+			if (args->command != COMMAND_NONE) {
+				return "Only one command allowed";
 			}
-			command = COMMAND_ADD_IMAGE;
-			filename = optarg;
+			args->command = COMMAND_ADD_IMAGE;
+			args->filename = optarg;
 			break;
 		case 'u':
-			if (command != COMMAND_NONE) {
-				error_exit("Only one command allowed");
+			if (args->command != COMMAND_NONE) {
+				return "Only one command allowed";
 			}
-			command = COMMAND_ADD_FACTORY_UPDATE_IMAGE;
-			filename = optarg;
+			args->command = COMMAND_ADD_FACTORY_UPDATE_IMAGE;
+			args->filename = optarg;
 			break;
 		case 'A':
-			if (command != COMMAND_NONE) {
-				error_exit("Only one command allowed");
+			if (args->command != COMMAND_NONE) {
+				return "Only one command allowed";
 			}
-			command = COMMAND_ADD_RAW_IMAGE;
-			filename = optarg;
+			args->command = COMMAND_ADD_RAW_IMAGE;
+			args->filename = optarg;
 			break;
 		case 'v':
-			if (command != COMMAND_NONE) {
-				error_exit("Only one command allowed");
+			if (args->command != COMMAND_NONE) {
+				return "Only one command allowed";
 			}
-			command = COMMAND_VERIFY_IMAGE;
-			filename = optarg;
+			args->command = COMMAND_VERIFY_IMAGE;
+			args->filename = optarg;
 			break;
 		case 'V':
-			if (command != COMMAND_NONE) {
-				error_exit("Only one command allowed");
+			if (args->command != COMMAND_NONE) {
+				return "Only one command allowed";
 			}
-			command = COMMAND_VERIFY_RAW_IMAGE;
-			filename = optarg;
+			args->command = COMMAND_VERIFY_RAW_IMAGE;
+			args->filename = optarg;
 			break;
 		case 'f':
-			if (command != COMMAND_NONE) {
-				error_exit("Only one command allowed");
+			if (args->command != COMMAND_NONE) {
+				return "Only one command allowed";
+			}
+			args->command = COMMAND_COPY_TO_FILE;
+			args->filename = optarg;
+			break;
+		case 'F':
+			if (args->command != COMMAND_NONE) {
+				return "Only one command allowed";
 			}
-			command = COMMAND_COPY_TO_FILE;
-			filename = optarg;
+			args->command = COMMAND_COPY_TO_FILE_COMPRESSED;
+			args->filename = optarg;
 			break;
 		case 'g':
-			if (command != COMMAND_NONE) {
-				error_exit("Only one command allowed");
+			if (args->command != COMMAND_NONE) {
+				return "Only one command allowed";
 			}
-			command = COMMAND_STATUS_LOG;
+			args->command = COMMAND_STATUS_LOG;
 			break;
 		case 'n':
-			if (command != COMMAND_NONE) {
-				error_exit("Only one command allowed");
+			if (args->command != COMMAND_NONE) {
+				return "Only one command allowed";
 			}
-			command = COMMAND_NOTIFY;
-			notify_value = strtol(optarg, NULL, 0);
+			args->command = COMMAND_NOTIFY;
+			args->notify_value = strtol(optarg, NULL, 0);
 			break;
 		case 'C':
-			if (command != COMMAND_NONE) {
-				error_exit("Only one command allowed");
+			if (args->command != COMMAND_NONE) {
+				return "Only one command allowed";
 			}
-			command = COMMAND_CLEAR_ERROR_STATUS;
+			args->command = COMMAND_CLEAR_ERROR_STATUS;
 			break;
 		case 'Z':
-			if (command != COMMAND_NONE) {
-				error_exit("Only one command allowed");
+			if (args->command != COMMAND_NONE) {
+				return "Only one command allowed";
 			}
-			command = COMMAND_RESET_RETRY_COUNTER;
+			args->command = COMMAND_RESET_RETRY_COUNTER;
 			break;
 		case 'm':
-			if (command != COMMAND_NONE) {
-				error_exit("Only one command allowed");
+			if (args->command != COMMAND_NONE) {
+				return "Only one command allowed";
 			}
-			command = COMMAND_DISPLAY_DCMF_VERSION;
+			args->command = COMMAND_DISPLAY_DCMF_VERSION;
 			break;
 		case 'y':
-			if (command != COMMAND_NONE) {
-				error_exit("Only one command allowed");
+			if (args->command != COMMAND_NONE) {
+				return "Only one command allowed";
 			}
-			command = COMMAND_DISPLAY_DCMF_STATUS;
+			args->command = COMMAND_DISPLAY_DCMF_STATUS;
 			break;
 		case 'x':
-			if (command != COMMAND_NONE) {
-				error_exit("Only one command allowed");
+			if (args->command != COMMAND_NONE) {
+				return "Only one command allowed";
 			}
-			command = COMMAND_DISPLAY_MAX_RETRY;
+			args->command = COMMAND_DISPLAY_MAX_RETRY;
 			break;
 		case 't':
-			if (command != COMMAND_NONE) {
-				error_exit("Only one command allowed");
+			if (args->command != COMMAND_NONE) {
+				return "Only one command allowed";
 			}
-			command = COMMAND_SLOT_CREATE;
-			strncpy(slot_name, optarg, MAX_SLOT_NAME);
-			slot_name[MAX_SLOT_NAME] = '\0';
+			args->command = COMMAND_SLOT_CREATE;
+			strncpy(args->slot_name, optarg, MAX_SLOT_NAME);
+			args->slot_name[MAX_SLOT_NAME] = '\0';
 			break;
 		case 'd':
-			if (command != COMMAND_NONE) {
-				error_exit("Only one command allowed");
+			if (args->command != COMMAND_NONE) {
+				return "Only one command allowed";
 			}
-			if (slot_num >= 0) {
-				error_exit("Slot number already set");
+			if (args->slot_num >= 0) {
+				return "Slot number already set";
 			}
-			command = COMMAND_SLOT_DELETE;
-			slot_num = strtol(optarg, &endptr, 0);
+			args->command = COMMAND_SLOT_DELETE;
+			args->slot_num = strtol(optarg, &endptr, 0);
 			if (*endptr) {
-				error_exit("Invalid slot number");
+				return "Invalid slot number";
 			}
 			break;
 		case 'S':
-			if (slot_address >= 0) {
-				error_exit("Slot address already set");
+			if (args->slot_address >= 0) {
+				return "Slot address already set";
 			}
-			slot_address = strtol(optarg, &endptr, 0);
+			args->slot_address = strtol(optarg, &endptr, 0);
 			if (*endptr) {
-				error_exit("Invalid slot address");
+				return "Invalid slot address";
 			}
 			break;
 		case 'L':
-			if (slot_size >= 0) {
-				error_exit("Slot size already set");
+			if (args->slot_size >= 0) {
+				return "Slot size already set";
 			}
-			slot_size = strtol(optarg, &endptr, 0);
+			args->slot_size = strtol(optarg, &endptr, 0);
 			if (*endptr) {
-				error_exit("Invalid slot size");
+				return "Invalid slot size";
 			}
 			break;
 		case 'W':
-			if (command != COMMAND_NONE) {
-				error_exit("Only one command allowed");
+			if (args->command != COMMAND_NONE) {
+				return "Only one command allowed";
 			}
-			command = COMMAND_RESTORE_SPT;
-			filename = optarg;
+			args->command = COMMAND_RESTORE_SPT;
+			args->filename = optarg;
 			break;
 		case 'X':
-			if (command != COMMAND_NONE) {
-				error_exit("Only one command allowed");
+			if (args->command != COMMAND_NONE) {
+				return "Only one command allowed";
 			}
-			command = COMMAND_SAVE_SPT;
-			filename = optarg;
+			args->command = COMMAND_SAVE_SPT;
+			args->filename = optarg;
 			break;
 		case 'b':
-			if (command != COMMAND_NONE) {
-				error_exit("Only one command allowed");
+			if (args->command != COMMAND_NONE) {
+				return "Only one command allowed";
 			}
-			command = COMMAND_CREATE_EMPTY_CPB;
+			args->command = COMMAND_CREATE_EMPTY_CPB;
 			break;
 		case 'B':
-			if (command != COMMAND_NONE) {
-				error_exit("Only one command allowed");
+			if (args->command != COMMAND_NONE) {
+				return "Only one command allowed";
 			}
-			command = COMMAND_RESTORE_CPB;
-			filename = optarg;
+			args->command = COMMAND_RESTORE_CPB;
+			args->filename = optarg;
 			break;
 		case 'P':
-			if (command != COMMAND_NONE) {
-				error_exit("Only one command allowed");
+			if (args->command != COMMAND_NONE) {
+				return "Only one command allowed";
 			}
-			command = COMMAND_SAVE_CPB;
-			filename = optarg;
+			args->command = COMMAND_SAVE_CPB;
+			args->filename = optarg;
 			break;
 		case 'k':
-			if (command != COMMAND_NONE) {
-				error_exit("Only one command allowed");
+			if (args->command != COMMAND_NONE) {
+				return "Only one command allowed";
 			}
-			command = COMMAND_CHECK_RUNNING_FACTORY;
+			args->command = COMMAND_CHECK_RUNNING_FACTORY;
+			break;
+		case 'j':
+			if (args->command != COMMAND_NONE) {
+				return "Only one command allowed";
+			}
+			args->command = COMMAND_BENCH;
+			break;
+		case 'J':
+			args->bench_slot = optarg;
+			break;
+		case 'w':
+			args->socket_path = optarg;
+			break;
+		case 'i':
+			args->batch = optarg;
+			break;
+		case 'K':
+			args->keep_going = 1;
+			break;
+		case 'M':
+			args->stats = 1;
 			break;
 		case 'h':
-			rsu_client_usage();
-			librsu_exit();
-			exit(0);
+			args->help = 1;
+			break;
 
 		default:
-			error_exit("Invalid argument: try -h for help");
+			return "Invalid argument: try -h for help";
 		}
 	}
 
-	switch (command) {
+	return NULL;
+
+}
+
+static int rsu_client_error(const char **err, const char *msg, int ret)
+{
+	*err = msg;
+	return ret ? ret : -1;
+}
+
+/*
+ * rsu_client_run() - run a parsed command
+ * args: parsed command
+ * err: error message on error
+ *
+ * Return: 0 on success, or negative value on error
+ */
+static int rsu_client_run(struct rsu_client_args *args, const char **err)
+{
+	int ret = 0;
+
+	switch (args->command) {
 	case COMMAND_SLOT_COUNT:
-		if (slot_num >= 0) {
-			error_exit("Slot number should not be set");
+		if (args->slot_num >= 0) {
+			return rsu_client_error(err, "Slot number should not be set", ret);
 		}
 		ret = rsu_client_get_slot_count();
 		if (ret < 0) {
-			error_exit("Failed to get number of slots");
+			return rsu_client_error(err, "Failed to get number of slots", ret);
 		}
 		printf("number of slots is %d\n", ret);
+		ret = 0;
 		break;
 	case COMMAND_SLOT_ATTR:
-		ret = rsu_client_list_slot_attribute(slot_num);
+		ret = rsu_client_list_slot_attribute(args->slot_num);
 		if (ret) {
-			error_exit("Failed to get slot attributes");
+			return rsu_client_error(err, "Failed to get slot attributes", ret);
 		}
 		break;
 	case COMMAND_SLOT_SIZE:
-		ret = rsu_client_get_slot_size(slot_num);
+		ret = rsu_client_get_slot_size(args->slot_num);
 		if (ret < 0) {
-			error_exit("Failed to get slot size");
+			return rsu_client_error(err, "Failed to get slot size", ret);
 		}
-		printf("size of slot %d is %d\n", slot_num, ret);
+		printf("size of slot %d is %d\n", args->slot_num, ret);
+		ret = 0;
 		break;
 	case COMMAND_SLOT_PRIORITY:
-		ret = rsu_client_get_priority(slot_num);
+		ret = rsu_client_get_priority(args->slot_num);
 		if (ret < 0) {
-			error_exit("Failed to get slot priority");
+			return rsu_client_error(err, "Failed to get slot priority", ret);
 		}
-		printf("priority of slot %d is %d\n", slot_num, ret);
+		printf("priority of slot %d is %d\n", args->slot_num, ret);
+		ret = 0;
 		break;
 	case COMMAND_SLOT_ENABLE:
-		if (rsu_slot_enable(slot_num)) {
-			error_exit("Failed to enable slot");
+		ret = rsu_client_simple(RSUD_CMD_SLOT_ENABLE, args->slot_num, 0);
+		if (ret) {
+			return rsu_client_error(err, "Failed to enable slot", ret);
 		}
 		break;
 	case COMMAND_SLOT_DISABLE:
-		if (rsu_slot_disable(slot_num)) {
-			error_exit("Failed to disable slot");
+		ret = rsu_client_simple(RSUD_CMD_SLOT_DISABLE, args->slot_num, 0);
+		if (ret) {
+			return rsu_client_error(err, "Failed to disable slot", ret);
 		}
 		break;
 	case COMMAND_SLOT_LOAD:
-		ret = rsu_client_request_slot_be_loaded(slot_num);
+		ret = rsu_client_request_slot_be_loaded(args->slot_num);
 		if (ret) {
-			error_exit("Failed to request slot loaded");
+			return rsu_client_error(err, "Failed to request slot loaded", ret);
 		}
 		break;
 	case COMMAND_FACTORY_LOAD:
-		if (slot_num >= 0) {
-			error_exit("Slot number should not be set");
+		if (args->slot_num >= 0) {
+			return rsu_client_error(err, "Slot number should not be set", ret);
 		}
 		ret = rsu_client_request_factory_be_loaded();
 		if (ret) {
-			error_exit("Failed to request factory image load");
+			return rsu_client_error(err, "Failed to request factory image load", ret);
 		}
 		break;
 	case COMMAND_SLOT_ERASE:
-		ret = rsu_client_erase_image(slot_num);
+		ret = rsu_client_erase_image(args->slot_num);
 		if (ret) {
-			error_exit("Failed to erase slot");
+			return rsu_client_error(err, "Failed to erase slot", ret);
 		}
 		break;
 	case COMMAND_ADD_IMAGE:
-		if (slot_num < 0) {
-			error_exit("Slot number must be set");
+		if (args->slot_num < 0) {
+			return rsu_client_error(err, "Slot number must be set", ret);
 		}
-		ret = rsu_client_add_app_image(filename, slot_num, 0);
+		ret = rsu_client_add_app_image(args->filename, args->slot_num, 0);
 		if (ret < 0) {
-			error_exit("Failed to add application image");
+			return rsu_client_error(err, "Failed to add application image", ret);
 		}
 		break;
 	case COMMAND_ADD_FACTORY_UPDATE_IMAGE:
-		if (slot_num < 0) {
-			error_exit("Slot number must be set");
+		if (args->slot_num < 0) {
+			return rsu_client_error(err, "Slot number must be set", ret);
 		}
-		ret = rsu_client_add_factory_update_image(filename, slot_num);
+		ret = rsu_client_add_factory_update_image(args->filename, args->slot_num);
 		if (ret < 0) {
-			error_exit("Failed to add factory update image");
+			return rsu_client_error(err, "Failed to add factory update image", ret);
 		}
 		break;
 	case COMMAND_ADD_RAW_IMAGE:
-		if (slot_num < 0) {
-			error_exit("Slot number must be set");
+		if (args->slot_num < 0) {
+			return rsu_client_error(err, "Slot number must be set", ret);
 		}
-		ret = rsu_client_add_app_image(filename, slot_num, 1);
+		ret = rsu_client_add_app_image(args->filename, args->slot_num, 1);
 		if (ret < 0) {
-			error_exit("Failed to add application image");
+			return rsu_client_error(err, "Failed to add application image", ret);
 		}
 		break;
 	case COMMAND_VERIFY_IMAGE:
-		if (slot_num < 0) {
-			error_exit("Slot number must be set");
+		if (args->slot_num < 0) {
+			return rsu_client_error(err, "Slot number must be set", ret);
 		}
-		ret = rsu_client_verify_data(filename, slot_num, 0);
+		ret = rsu_client_verify_data(args->filename, args->slot_num, 0);
 		if (ret < 0) {
-			error_exit("Failed to verify application image");
+			return rsu_client_error(err, "Failed to verify application image", ret);
 		}
 		break;
 	case COMMAND_VERIFY_RAW_IMAGE:
-		if (slot_num < 0) {
-			error_exit("Slot number must be set");
+		if (args->slot_num < 0) {
+			return rsu_client_error(err, "Slot number must be set", ret);
 		}
-		ret = rsu_client_verify_data(filename, slot_num, 1);
+		ret = rsu_client_verify_data(args->filename, args->slot_num, 1);
 		if (ret < 0) {
-			error_exit("Failed to verify application image");
+			return rsu_client_error(err, "Failed to verify application image", ret);
 		}
 		break;
 	case COMMAND_COPY_TO_FILE:
-		if (slot_num < 0) {
-			error_exit("Slot number must be set");
+		if (args->slot_num < 0) {
+			return rsu_client_error(err, "Slot number must be set", ret);
+		}
+		ret = rsu_client_copy_to_file(args->filename, args->slot_num);
+		if (ret < 0) {
+			return rsu_client_error(err, "Failed to copy app image to file", ret);
+		}
+		break;
+	case COMMAND_COPY_TO_FILE_COMPRESSED:
+		if (args->slot_num < 0) {
+			return rsu_client_error(err, "Slot number must be set", ret);
 		}
-		ret = rsu_client_copy_to_file(filename, slot_num);
+		ret = rsu_client_copy_to_file_compressed(args->filename, args->slot_num);
 		if (ret < 0) {
-			error_exit("Failed to copy app image to file");
+			return rsu_client_error(err, "Failed to copy app image to compressed file", ret);
 		}
 		break;
 	case COMMAND_STATUS_LOG:
-		if (slot_num >= 0) {
-			error_exit("Slot number should not be set");
+		if (args->slot_num >= 0) {
+			return rsu_client_error(err, "Slot number should not be set", ret);
 		}
 		ret = rsu_client_copy_status_log();
 		if (ret) {
-			error_exit("Failed to read status log");
+			return rsu_client_error(err, "Failed to read status log", ret);
 		}
 		break;
 	case COMMAND_NOTIFY:
-		if (notify_value < 0) {
-			error_exit("Notify value must be set");
+		if (args->notify_value < 0) {
+			return rsu_client_error(err, "Notify value must be set", ret);
 		}
-		ret = rsu_notify(notify_value);
+		ret = rsu_client_simple(RSUD_CMD_NOTIFY, -1, args->notify_value);
 		if (ret < 0) {
-			error_exit("Failed to notify");
+			return rsu_client_error(err, "Failed to notify", ret);
 		}
 		break;
 	case COMMAND_CLEAR_ERROR_STATUS:
-		ret = rsu_clear_error_status();
+		ret = rsu_client_simple(RSUD_CMD_CLEAR_ERROR_STATUS, -1, 0);
 		if (ret) {
-			error_exit("Failed to clear the error status");
+			return rsu_client_error(err, "Failed to clear the error status", ret);
 		}
 		break;
 	case COMMAND_RESET_RETRY_COUNTER:
-		ret = rsu_reset_retry_counter();
+		ret = rsu_client_simple(RSUD_CMD_RESET_RETRY_COUNTER, -1, 0);
 		if (ret) {
-			error_exit("Failed to reset the retry counter");
+			return rsu_client_error(err, "Failed to reset the retry counter", ret);
 		}
 		break;
 	case COMMAND_DISPLAY_DCMF_VERSION:
 		ret = rsu_client_display_dcmf_version();
 		if (ret) {
-			error_exit("Failed to display the dcmf version");
+			return rsu_client_error(err, "Failed to display the dcmf version", ret);
 		}
 		break;
 	case COMMAND_DISPLAY_DCMF_STATUS:
 		ret = rsu_client_display_dcmf_status();
 		if (ret) {
-			error_exit("Failed to display the dcmf status");
+			return rsu_client_error(err, "Failed to display the dcmf status", ret);
 		}
 		break;
 	case COMMAND_DISPLAY_MAX_RETRY:
 		ret = rsu_client_display_max_retry();
 		if (ret) {
-			error_exit("Failed to display the max_retry parameter");
+			return rsu_client_error(err, "Failed to display the max_retry parameter", ret);
 		}
 		break;
 	case COMMAND_SLOT_CREATE:
-		if (slot_address < 0) {
-			error_exit("Slot address value must be set");
+		if (args->slot_address < 0) {
+			return rsu_client_error(err, "Slot address value must be set", ret);
 		}
-		if (slot_size < 0) {
-			error_exit("Slot size value must be set");
+		if (args->slot_size < 0) {
+			return rsu_client_error(err, "Slot size value must be set", ret);
 		}
-		ret = rsu_slot_create(slot_name, slot_address, slot_size);
+		ret = rsu_client_create_slot(args->slot_name, args->slot_address, args->slot_size);
 		if (ret) {
-			error_exit("Failed to create the slot");
+			return rsu_client_error(err, "Failed to create the slot", ret);
 		}
 		break;
 	case COMMAND_SLOT_DELETE:
-		ret = rsu_slot_delete(slot_num);
+		ret = rsu_client_simple(RSUD_CMD_SLOT_DELETE, args->slot_num, 0);
 		if (ret) {
-			error_exit("Failed to delete the slot");
+			return rsu_client_error(err, "Failed to delete the slot", ret);
 		}
 		break;
 	case COMMAND_RESTORE_SPT:
-		ret = rsu_restore_spt(filename);
+		ret = rsu_client_file(RSUD_CMD_RESTORE_SPT, args->filename);
 		if (ret) {
-			error_exit("Failed to restore spt from a file");
+			return rsu_client_error(err, "Failed to restore spt from a file", ret);
 		}
 		break;
 	case COMMAND_SAVE_SPT:
-		ret = rsu_save_spt(filename);
+		ret = rsu_client_file(RSUD_CMD_SAVE_SPT, args->filename);
 		if (ret) {
-			error_exit("Failed to save spt to a file");
+			return rsu_client_error(err, "Failed to save spt to a file", ret);
 		}
 		break;
 	case COMMAND_CREATE_EMPTY_CPB:
-		ret = rsu_create_empty_cpb();
+		ret = rsu_client_simple(RSUD_CMD_CREATE_EMPTY_CPB, -1, 0);
 		if (ret) {
-			error_exit("Failed to create a empty cpb");
+			return rsu_client_error(err, "Failed to create a empty cpb", ret);
 		}
 		break;
 	case COMMAND_RESTORE_CPB:
-		ret = rsu_restore_cpb(filename);
+		ret = rsu_client_file(RSUD_CMD_RESTORE_CPB, args->filename);
 		if (ret) {
-			error_exit("Failed to restore cpb");
+			return rsu_client_error(err, "Failed to restore cpb", ret);
 		}
 		break;
 	case COMMAND_SAVE_CPB:
-		ret = rsu_save_cpb(filename);
+		ret = rsu_client_file(RSUD_CMD_SAVE_CPB, args->filename);
 		if (ret) {
-			error_exit("Failed to save cpb");
+			return rsu_client_error(err, "Failed to save cpb", ret);
 		}
 		break;
 	case COMMAND_CHECK_RUNNING_FACTORY:
 		ret = rsu_client_check_running_factory();
 		if (ret) {
-			error_exit("Failed to check if running factory image");
+			return rsu_client_error(err, "Failed to check if running factory image", ret);
+		}
+		break;
+	case COMMAND_BENCH:
+		if (rsud_fd >= 0) {
+			return rsu_client_error(err, "Benchmark is not available through rsud", ret);
+		}
+		ret = rsu_client_bench(args->bench_slot);
+		if (ret) {
+			return rsu_client_error(err, "Failed to run the benchmark", ret);
 		}
 		break;
 	default:
-		error_exit("No command: try -h for help");
+		return rsu_client_error(err, "No command: try -h for help", ret);
+	}
+
+	return 0;
+}
+
+static void rsu_client_exit(void)
+{
+	if (rsud_fd >= 0) {
+		close(rsud_fd);
+	}
+
+	if (librsu_ready) {
+		librsu_exit();
+	}
+}
+
+static void error_exit(char *msg)
+{
+	printf("ERROR: %s\n", msg);
+	rsu_client_exit();
+	exit(1);
+}
+
+/*
+ * rsu_client_usec() - read the monotonic clock
+ *
+ * Return: time in microseconds
+ */
+static unsigned long long rsu_client_usec(void)
+{
+	return rsu_client_ns() / 1000;
+}
+
+/*
+ * rsu_client_split() - split a batch line into arguments
+ * line: batch line, modified in place
+ * argv: arguments, argv[0] is the program name
+ * max: size of argv, less one for the terminating NULL
+ *
+ * Arguments are separated by white space, single or double quotes keep white
+ * space inside an argument, and '#' outside an argument starts a comment.
+ *
+ * Return: number of arguments, or -1 on error
+ */
+static int rsu_client_split(char *line, char *argv[], int max)
+{
+	char *src = line;
+	char *dst;
+	char quote;
+	int argc = 1;
+
+	argv[0] = "rsu_client";
+
+	for (;;) {
+		while (isspace((unsigned char)*src)) {
+			src++;
+		}
+
+		if (*src == '\0' || *src == '#') {
+			break;
+		}
+
+		if (argc == max) {
+			return -1;
+		}
+
+		dst = src;
+		argv[argc++] = dst;
+		quote = 0;
+
+		while (*src && (quote || !isspace((unsigned char)*src))) {
+			if (quote && *src == quote) {
+				quote = 0;
+				src++;
+			} else if (!quote && (*src == '"' || *src == '\'')) {
+				quote = *src++;
+			} else {
+				*dst++ = *src++;
+			}
+		}
+
+		if (quote) {
+			return -1;
+		}
+
+		if (*src) {
+			src++;
+		}
+		*dst = '\0';
+	}
+
+	argv[argc] = NULL;
+	return argc;
+}
+
+/*
+ * rsu_client_json_string() - print a string as a JSON string
+ * str: string to print
+ *
+ * This function doesn't have return.
+ */
+static void rsu_client_json_string(const char *str)
+{
+	putchar('"');
+	for (; *str; str++) {
+		if (*str == '"' || *str == '\\') {
+			printf("\\%c", *str);
+		} else if ((unsigned char)*str < 0x20) {
+			printf("\\u%04x", *str);
+		} else {
+			putchar(*str);
+		}
+	}
+	putchar('"');
+}
+
+/*
+ * rsu_client_batch() - run the commands of a batch file
+ * name: batch file name, or "-" for the standard input
+ * keep_going: run the remaining commands after a failed one
+ *
+ * Every line holds the options of one command, as given on the command line.
+ * After each command one JSON object with its line number, result and run
+ * time is printed on a line of its own, and one with the totals at the end.
+ *
+ * Return: 0 when every command succeeded, or -1 on error
+ */
+static int rsu_client_batch(char *name, int keep_going)
+{
+	struct rsu_client_args args;
+	char *argv[MAX_BATCH_ARGS + 1];
+	unsigned long long begin, start;
+	char *line = NULL;
+	char *text = NULL;
+	size_t size = 0;
+	const char *err;
+	int lineno = 0;
+	int count = 0;
+	int failed = 0;
+	int argc, ret;
+	FILE *fp;
+
+	fp = strcmp(name, "-") ? fopen(name, "r") : stdin;
+	if (!fp) {
+		printf("ERROR: Unable to open batch file %s\n", name);
+		return -1;
+	}
+
+	begin = rsu_client_usec();
+
+	while (getline(&line, &size, fp) > 0) {
+		lineno++;
+		line[strcspn(line, "\r\n")] = '\0';
+
+		free(text);
+		text = strdup(line);
+
+		argc = rsu_client_split(line, argv, MAX_BATCH_ARGS);
+		if (argc == 1) {
+			continue;
+		}
+
+		count++;
+		start = rsu_client_usec();
+		ret = -1;
+
+		if (argc < 0) {
+			err = "Unable to split the line";
+		} else {
+			err = rsu_client_parse(argc, argv, &args);
+			if (!err && (args.socket_path || args.batch || args.keep_going || args.stats ||
+				     args.help)) {
+				err = "Option not allowed in a batch";
+			}
+			if (!err) {
+				ret = rsu_client_run(&args, &err);
+			}
+		}
+
+		printf("{\"line\":%d,\"command\":", lineno);
+		rsu_client_json_string(text ? text : "");
+		printf(",\"result\":%d,\"error\":", ret);
+		if (ret) {
+			rsu_client_json_string(err);
+		} else {
+			printf("null");
+		}
+		printf(",\"time_us\":%llu}\n", rsu_client_usec() - start);
+		fflush(stdout);
+
+		if (ret) {
+			failed++;
+			if (!keep_going) {
+				break;
+			}
+		}
+	}
+
+	printf("{\"commands\":%d,\"failed\":%d,\"time_us\":%llu}\n", count, failed,
+	       rsu_client_usec() - begin);
+
+	free(text);
+	free(line);
+	if (fp != stdin) {
+		fclose(fp);
+	}
+
+	return failed ? -1 : 0;
+}
+
+int main(int argc, char *argv[])
+{
+	struct rsu_client_args args;
+	const char *err;
+	int ret;
+
+	if (argc == 1) {
+		rsu_client_usage();
+		exit(1);
+	}
+
+	err = rsu_client_parse(argc, argv, &args);
+	if (err) {
+		error_exit((char *)err);
+	}
+
+	if (args.help) {
+		rsu_client_usage();
+		exit(0);
+	}
+
+	if (args.batch && args.command != COMMAND_NONE) {
+		error_exit("No command allowed with a batch");
+	}
+
+	if (args.stats && args.socket_path) {
+		error_exit("Statistics are not available through rsud");
+	}
+
+	if (args.socket_path) {
+		rsud_fd = rsud_connect(args.socket_path);
+		if (rsud_fd < 0) {
+			error_exit("Unable to connect to rsud");
+		}
+	} else {
+		ret = librsu_init("");
+		if (ret) {
+			printf("librsu_init return %d\n", ret);
+			return ret;
+		}
+		librsu_ready = 1;
+	}
+
+	if (args.batch) {
+		ret = rsu_client_batch(args.batch, args.keep_going);
+		if (args.stats) {
+			rsu_client_stats();
+		}
+		rsu_client_exit();
+		return ret ? 1 : 0;
+	}
+
+	ret = rsu_client_run(&args, &err);
+	if (ret) {
+		error_exit((char *)err);
 	}
 
 	printf("Operation completed\n");
 
-	librsu_exit();
+	if (args.stats) {
+		rsu_client_stats();
+	}
+
+	rsu_client_exit();
 	return 0;
 }
@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2023-2024 Intel Corporation
+ * SPDX-License-Identifier: MIT-0
+ */
+
+#include "rsud_proto.h"
+#include "rsud_server.h"
+#include <getopt.h>
+#include <libRSU.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static const struct option opts[] = {{"socket", required_argument, NULL, 's'},
+				     {"config", required_argument, NULL, 'c'},
+				     {"foreground", no_argument, NULL, 'f'},
+				     {"help", no_argument, NULL, 'h'},
+				     {NULL, 0, NULL, 0}};
+
+/*
+ * rsud_usage() - show the usage of the daemon
+ *
+ * This function doesn't have return.
+ */
+static void rsud_usage(void)
+{
+	printf("--- RSU daemon usage ---\n");
+	printf("%-32s  %s", "-s|--socket path", "socket to listen on, " RSUD_SOCKET_PATH
+	       " by default\n");
+	printf("%-32s  %s", "-c|--config file_name", "library configuration file\n");
+	printf("%-32s  %s", "-f|--foreground", "do not detach from the terminal\n");
+	printf("%-32s  %s", "-h|--help", "show usage message\n");
+}
+
+int main(int argc, char *argv[])
+{
+	char *socket_path = RSUD_SOCKET_PATH;
+	char *config = "";
+	int foreground = 0;
+	int index = 0;
+	sigset_t set;
+	int c, sig;
+	int ret;
+
+	while ((c = getopt_long(argc, argv, "s:c:fh", opts, &index)) != -1) {
+		switch (c) {
+		case 's':
+			socket_path = optarg;
+			break;
+		case 'c':
+			config = optarg;
+			break;
+		case 'f':
+			foreground = 1;
+			break;
+		case 'h':
+			rsud_usage();
+			exit(0);
+		default:
+			printf("ERROR: Invalid argument: try -h for help\n");
+			exit(1);
+		}
+	}
+
+	/* before any thread exists, the library starts some of its own */
+	if (!foreground && daemon(0, 0)) {
+		perror("daemon");
+		return 1;
+	}
+
+	sigemptyset(&set);
+	sigaddset(&set, SIGINT);
+	sigaddset(&set, SIGTERM);
+	sigaddset(&set, SIGHUP);
+	pthread_sigmask(SIG_BLOCK, &set, NULL);
+
+	ret = librsu_init(config);
+	if (ret) {
+		printf("librsu_init return %d\n", ret);
+		return ret;
+	}
+
+	ret = rsud_server_start(socket_path);
+	if (ret) {
+		printf("ERROR: Unable to listen on %s: %s\n", socket_path, strerror(-ret));
+		librsu_exit();
+		return 1;
+	}
+
+	sigwait(&set, &sig);
+
+	rsud_server_stop();
+	librsu_exit();
+	return 0;
+}
@@ -0,0 +1,190 @@
+/*
+ * Copyright (C) 2023-2024 Intel Corporation
+ * SPDX-License-Identifier: MIT-0
+ */
+
+#include "rsud_proto.h"
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/*
+ * rsud_send() - send one message
+ * fd: connected socket
+ * type: message type
+ * msg, len: fixed part of the payload
+ * extra, extra_len: variable part of the payload, may be empty
+ * flags: send flags, MSG_NOSIGNAL is always added
+ *
+ * Return: 0 on success, or negative errno on error
+ */
+int rsud_send(int fd, uint16_t type, const void *msg, uint32_t len, const void *extra,
+	      uint32_t extra_len, int flags)
+{
+	struct rsud_hdr hdr;
+	struct iovec iov[3];
+	struct msghdr mh;
+
+	hdr.magic = RSUD_MAGIC;
+	hdr.version = RSUD_VERSION;
+	hdr.type = type;
+	hdr.len = len + extra_len;
+
+	iov[0].iov_base = &hdr;
+	iov[0].iov_len = sizeof(hdr);
+	iov[1].iov_base = (void *)msg;
+	iov[1].iov_len = len;
+	iov[2].iov_base = (void *)extra;
+	iov[2].iov_len = extra_len;
+
+	memset(&mh, 0, sizeof(mh));
+	mh.msg_iov = iov;
+	mh.msg_iovlen = 3;
+
+	if (sendmsg(fd, &mh, flags | MSG_NOSIGNAL) < 0) {
+		return -errno;
+	}
+
+	return 0;
+}
+
+/*
+ * rsud_recv() - receive one message
+ * fd: connected socket
+ * hdr: header of the message
+ * payload, max: buffer for the payload
+ *
+ * Return: payload length, -ECONNRESET when the peer is gone, -EPROTO on a
+ * malformed message, or negative errno on error
+ */
+int rsud_recv(int fd, struct rsud_hdr *hdr, void *payload, uint32_t max)
+{
+	struct iovec iov[2];
+	struct msghdr mh;
+	ssize_t n;
+
+	iov[0].iov_base = hdr;
+	iov[0].iov_len = sizeof(*hdr);
+	iov[1].iov_base = payload;
+	iov[1].iov_len = max;
+
+	memset(&mh, 0, sizeof(mh));
+	mh.msg_iov = iov;
+	mh.msg_iovlen = 2;
+
+	do {
+		n = recvmsg(fd, &mh, 0);
+	} while (n < 0 && errno == EINTR);
+
+	if (n < 0) {
+		return -errno;
+	}
+
+	if (n == 0) {
+		return -ECONNRESET;
+	}
+
+	if ((size_t)n < sizeof(*hdr) || (mh.msg_flags & MSG_TRUNC) || hdr->magic != RSUD_MAGIC ||
+	    hdr->version != RSUD_VERSION || hdr->len != (size_t)n - sizeof(*hdr)) {
+		return -EPROTO;
+	}
+
+	return (int)hdr->len;
+}
+
+/*
+ * rsud_connect() - connect to the daemon
+ * path: socket path
+ *
+ * Return: socket on success, or negative errno on error
+ */
+int rsud_connect(const char *path)
+{
+	struct sockaddr_un addr;
+	int fd, ret;
+
+	if (strlen(path) >= sizeof(addr.sun_path)) {
+		return -ENAMETOOLONG;
+	}
+
+	fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+	if (fd < 0) {
+		return -errno;
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, path);
+
+	if (connect(fd, (struct sockaddr *)&addr, sizeof(addr))) {
+		ret = -errno;
+		close(fd);
+		return ret;
+	}
+
+	return fd;
+}
+
+/*
+ * rsud_call() - run a request in the daemon and wait for its result
+ * fd: socket from rsud_connect()
+ * req: request
+ * text: path or slot name, or NULL
+ * data, len: buffer for the data of the result, may be empty
+ * progress: called for each progress message, or NULL
+ * arg: argument of progress
+ *
+ * Return: return value of the command in the daemon, or negative errno when
+ * talking to the daemon failed
+ */
+int rsud_call(int fd, const struct rsud_request *req, const char *text, void *data,
+	      uint32_t len, rsud_progress_fn progress, void *arg)
+{
+	uint8_t buf[sizeof(struct rsud_result) + RSUD_MAX_DATA];
+	struct rsud_progress prog;
+	struct rsud_result res;
+	struct rsud_hdr hdr;
+	uint32_t text_len = text ? strlen(text) : 0;
+	int ret;
+
+	if (text_len > RSUD_MAX_TEXT) {
+		return -ENAMETOOLONG;
+	}
+
+	ret = rsud_send(fd, RSUD_MSG_REQUEST, req, sizeof(*req), text, text_len, 0);
+	if (ret) {
+		return ret;
+	}
+
+	for (;;) {
+		ret = rsud_recv(fd, &hdr, buf, sizeof(buf));
+		if (ret < 0) {
+			return ret;
+		}
+
+		if (hdr.type == RSUD_MSG_PROGRESS && hdr.len == sizeof(prog)) {
+			memcpy(&prog, buf, sizeof(prog));
+			if (progress) {
+				progress(arg, &prog);
+			}
+			continue;
+		}
+
+		if (hdr.type != RSUD_MSG_RESULT || hdr.len < sizeof(res)) {
+			return -EPROTO;
+		}
+
+		memcpy(&res, buf, sizeof(res));
+		if (len > hdr.len - sizeof(res)) {
+			len = hdr.len - sizeof(res);
+		}
+		if (len) {
+			memcpy(data, buf + sizeof(res), len);
+		}
+
+		return res.ret;
+	}
+}
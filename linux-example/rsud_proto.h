@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2023-2024 Intel Corporation
+ * SPDX-License-Identifier: MIT-0
+ */
+
+#ifndef __RSUD_PROTO_H__
+#define __RSUD_PROTO_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define RSUD_SOCKET_PATH "/run/rsud.sock"
+
+#define RSUD_MAGIC	   0x44555352 /* "RSUD" */
+#define RSUD_VERSION	   1
+#define RSUD_MAX_TEXT	   4096
+#define RSUD_MAX_DATA	   256
+#define RSUD_MAX_PAYLOAD   (sizeof(struct rsud_request) + RSUD_MAX_TEXT)
+
+/*
+ * The socket is a SOCK_SEQPACKET one, so every message arrives whole: a header
+ * followed by len bytes of payload. A client sends one request at a time and
+ * gets any number of progress messages back, then exactly one result.
+ */
+struct rsud_hdr {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t type;
+	uint32_t len;
+} __attribute__((__packed__));
+
+enum rsud_msg_type {
+	RSUD_MSG_REQUEST = 1, /* struct rsud_request, then the path or slot name */
+	RSUD_MSG_PROGRESS,    /* struct rsud_progress */
+	RSUD_MSG_RESULT,      /* struct rsud_result, then the data of the command */
+};
+
+/*
+ * Commands up to RSUD_CMD_RUNNING_FACTORY are queries and are answered right
+ * away, the others touch flash, the SDM or files and are run one at a time in
+ * the order they arrived.
+ */
+enum rsud_command {
+	RSUD_CMD_SLOT_COUNT = 1,
+	RSUD_CMD_SLOT_INFO,
+	RSUD_CMD_SLOT_SIZE,
+	RSUD_CMD_SLOT_PRIORITY,
+	RSUD_CMD_STATUS_LOG,
+	RSUD_CMD_DCMF_VERSION,
+	RSUD_CMD_DCMF_STATUS,
+	RSUD_CMD_MAX_RETRY,
+	RSUD_CMD_RUNNING_FACTORY,
+	RSUD_CMD_SLOT_ENABLE,
+	RSUD_CMD_SLOT_DISABLE,
+	RSUD_CMD_SLOT_LOAD,
+	RSUD_CMD_FACTORY_LOAD,
+	RSUD_CMD_SLOT_ERASE,
+	RSUD_CMD_PROGRAM_FILE,
+	RSUD_CMD_PROGRAM_FILE_RAW,
+	RSUD_CMD_PROGRAM_FACTORY_UPDATE,
+	RSUD_CMD_VERIFY_FILE,
+	RSUD_CMD_VERIFY_FILE_RAW,
+	RSUD_CMD_COPY_TO_FILE,
+	RSUD_CMD_COPY_TO_FILE_COMPRESSED,
+	RSUD_CMD_NOTIFY,
+	RSUD_CMD_CLEAR_ERROR_STATUS,
+	RSUD_CMD_RESET_RETRY_COUNTER,
+	RSUD_CMD_SLOT_CREATE,
+	RSUD_CMD_SLOT_DELETE,
+	RSUD_CMD_RESTORE_SPT,
+	RSUD_CMD_SAVE_SPT,
+	RSUD_CMD_CREATE_EMPTY_CPB,
+	RSUD_CMD_RESTORE_CPB,
+	RSUD_CMD_SAVE_CPB,
+};
+
+#define RSUD_CMD_QUEUED(cmd) ((cmd) > RSUD_CMD_RUNNING_FACTORY)
+
+/* value is the notify value or the slot address, size the size of a new slot */
+struct rsud_request {
+	uint32_t command;
+	int32_t slot;
+	uint64_t value;
+	uint64_t size;
+} __attribute__((__packed__));
+
+/* queued is the number of requests ahead, done and total count slot bytes */
+struct rsud_progress {
+	uint32_t queued;
+	uint32_t done;
+	uint32_t total;
+} __attribute__((__packed__));
+
+struct rsud_result {
+	int32_t ret;
+} __attribute__((__packed__));
+
+typedef void (*rsud_progress_fn)(void *arg, const struct rsud_progress *progress);
+
+int rsud_send(int fd, uint16_t type, const void *msg, uint32_t len, const void *extra,
+	      uint32_t extra_len, int flags);
+int rsud_recv(int fd, struct rsud_hdr *hdr, void *payload, uint32_t max);
+
+int rsud_connect(const char *path);
+int rsud_call(int fd, const struct rsud_request *req, const char *text, void *data,
+	      uint32_t len, rsud_progress_fn progress, void *arg);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif
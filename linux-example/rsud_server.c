@@ -0,0 +1,616 @@
+/*
+ * Copyright (C) 2023-2024 Intel Corporation
+ * SPDX-License-Identifier: MIT-0
+ */
+
+#define _GNU_SOURCE
+#include "rsud_server.h"
+#include "rsud_proto.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <libRSU.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/*
+ * A job is one request of one client. Queries are run by the thread of the
+ * client, the other jobs go through the queue to the worker thread, which
+ * runs them one at a time. A client waits for its job before sending the
+ * next one, so every client gets its turn in the order the jobs arrived.
+ */
+struct rsud_job {
+	struct rsud_request req;
+	char text[RSUD_MAX_TEXT + 1];
+	int fd;
+	int ret;
+	uint64_t data[RSUD_MAX_DATA / sizeof(uint64_t)];
+	uint32_t len;
+	int done;
+	struct rsud_job *next;
+};
+
+/*
+ * Slot layout and SDM state as last read from the library, so queries are
+ * answered without waiting for the library lock a long program or erase
+ * holds. Only the queued jobs change them, so the worker reads them again
+ * after each one.
+ */
+struct rsud_cache {
+	int count;
+	int info_ret[RSUD_MAX_SLOTS];
+	struct rsu_slot_info info[RSUD_MAX_SLOTS];
+	int status_ret;
+	struct rsu_status_info status;
+	int dcmf_version_ret;
+	RSU_OSAL_U32 dcmf_version[4];
+	int dcmf_status_ret;
+	RSU_OSAL_INT dcmf_status[4];
+	int max_retry_ret;
+	RSU_OSAL_U8 max_retry;
+	int factory_ret;
+	RSU_OSAL_INT factory;
+};
+
+static struct {
+	int listen_fd;
+	int wake[2];
+	char path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+	pthread_t accept_thread;
+	pthread_t worker_thread;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	struct rsud_job *head;
+	struct rsud_job *tail;
+	struct rsud_job *current;
+	unsigned int queued;
+	int clients[RSUD_MAX_CLIENTS];
+	int nclients;
+	int stopping;
+	uint32_t percent;
+	struct rsud_cache cache;
+} server = {.listen_fd = -1, .wake = {-1, -1}};
+
+static void rsud_cache_refresh(void)
+{
+	struct rsud_cache *cache;
+	int i;
+
+	cache = malloc(sizeof(*cache));
+	if (!cache) {
+		return;
+	}
+
+	memset(cache, 0, sizeof(*cache));
+	cache->count = rsu_slot_count();
+	for (i = 0; i < cache->count && i < RSUD_MAX_SLOTS; i++) {
+		cache->info_ret[i] = rsu_slot_get_info(i, &cache->info[i]);
+	}
+	cache->status_ret = rsu_status_log(&cache->status);
+	cache->dcmf_version_ret = rsu_dcmf_version(cache->dcmf_version);
+	cache->dcmf_status_ret = rsu_dcmf_status(cache->dcmf_status);
+	cache->max_retry_ret = rsu_max_retry(&cache->max_retry);
+	cache->factory_ret = rsu_running_factory(&cache->factory);
+
+	pthread_mutex_lock(&server.lock);
+	memcpy(&server.cache, cache, sizeof(*cache));
+	pthread_mutex_unlock(&server.lock);
+
+	free(cache);
+}
+
+/* copies a cached value into the result of the job */
+static int rsud_cache_value(struct rsud_job *job, int ret, const void *value, uint32_t len)
+{
+	memcpy(job->data, value, len);
+	job->len = len;
+	return ret;
+}
+
+static int rsud_cache_slot(struct rsud_job *job)
+{
+	int slot = job->req.slot;
+
+	if (job->req.command == RSUD_CMD_SLOT_COUNT) {
+		return server.cache.count;
+	}
+
+	if (slot < 0 || slot >= server.cache.count || slot >= RSUD_MAX_SLOTS) {
+		return -ESLOTNUM;
+	}
+
+	if (server.cache.info_ret[slot]) {
+		return server.cache.info_ret[slot];
+	}
+
+	switch (job->req.command) {
+	case RSUD_CMD_SLOT_SIZE:
+		return server.cache.info[slot].size;
+	case RSUD_CMD_SLOT_PRIORITY:
+		return server.cache.info[slot].priority;
+	default:
+		return rsud_cache_value(job, 0, &server.cache.info[slot],
+					sizeof(struct rsu_slot_info));
+	}
+}
+
+static int rsud_cache_query(struct rsud_job *job)
+{
+	struct rsud_cache *cache = &server.cache;
+	int ret;
+
+	pthread_mutex_lock(&server.lock);
+
+	switch (job->req.command) {
+	case RSUD_CMD_STATUS_LOG:
+		ret = rsud_cache_value(job, cache->status_ret, &cache->status,
+				       sizeof(cache->status));
+		break;
+	case RSUD_CMD_DCMF_VERSION:
+		ret = rsud_cache_value(job, cache->dcmf_version_ret, cache->dcmf_version,
+				       sizeof(cache->dcmf_version));
+		break;
+	case RSUD_CMD_DCMF_STATUS:
+		ret = rsud_cache_value(job, cache->dcmf_status_ret, cache->dcmf_status,
+				       sizeof(cache->dcmf_status));
+		break;
+	case RSUD_CMD_MAX_RETRY:
+		ret = rsud_cache_value(job, cache->max_retry_ret, &cache->max_retry,
+				       sizeof(cache->max_retry));
+		break;
+	case RSUD_CMD_RUNNING_FACTORY:
+		ret = rsud_cache_value(job, cache->factory_ret, &cache->factory,
+				       sizeof(cache->factory));
+		break;
+	default:
+		ret = rsud_cache_slot(job);
+		break;
+	}
+
+	pthread_mutex_unlock(&server.lock);
+	return ret;
+}
+
+static int rsud_execute(struct rsud_job *job)
+{
+	int slot = job->req.slot;
+	char *text = job->text;
+
+	switch (job->req.command) {
+	case RSUD_CMD_SLOT_COUNT:
+	case RSUD_CMD_SLOT_INFO:
+	case RSUD_CMD_SLOT_SIZE:
+	case RSUD_CMD_SLOT_PRIORITY:
+	case RSUD_CMD_STATUS_LOG:
+	case RSUD_CMD_DCMF_VERSION:
+	case RSUD_CMD_DCMF_STATUS:
+	case RSUD_CMD_MAX_RETRY:
+	case RSUD_CMD_RUNNING_FACTORY:
+		return rsud_cache_query(job);
+	case RSUD_CMD_SLOT_ENABLE:
+		return rsu_slot_enable(slot);
+	case RSUD_CMD_SLOT_DISABLE:
+		return rsu_slot_disable(slot);
+	case RSUD_CMD_SLOT_LOAD:
+		return rsu_slot_load_after_reboot(slot);
+	case RSUD_CMD_FACTORY_LOAD:
+		return rsu_slot_load_factory_after_reboot();
+	case RSUD_CMD_SLOT_ERASE:
+		return rsu_slot_erase(slot);
+	case RSUD_CMD_PROGRAM_FILE:
+		return rsu_slot_program_file(slot, text);
+	case RSUD_CMD_PROGRAM_FILE_RAW:
+		return rsu_slot_program_file_raw(slot, text);
+	case RSUD_CMD_PROGRAM_FACTORY_UPDATE:
+		return rsu_slot_program_factory_update_file(slot, text);
+	case RSUD_CMD_VERIFY_FILE:
+		return rsu_slot_verify_file(slot, text);
+	case RSUD_CMD_VERIFY_FILE_RAW:
+		return rsu_slot_verify_file_raw(slot, text);
+	case RSUD_CMD_COPY_TO_FILE:
+		return rsu_slot_copy_to_file(slot, text);
+	case RSUD_CMD_COPY_TO_FILE_COMPRESSED:
+		return rsu_slot_copy_to_file_compressed(slot, text);
+	case RSUD_CMD_NOTIFY:
+		return rsu_notify((RSU_OSAL_INT)job->req.value);
+	case RSUD_CMD_CLEAR_ERROR_STATUS:
+		return rsu_clear_error_status();
+	case RSUD_CMD_RESET_RETRY_COUNTER:
+		return rsu_reset_retry_counter();
+	case RSUD_CMD_SLOT_CREATE:
+		return rsu_slot_create(text, job->req.value, (RSU_OSAL_U32)job->req.size);
+	case RSUD_CMD_SLOT_DELETE:
+		return rsu_slot_delete(slot);
+	case RSUD_CMD_RESTORE_SPT:
+		return rsu_restore_spt(text);
+	case RSUD_CMD_SAVE_SPT:
+		return rsu_save_spt(text);
+	case RSUD_CMD_CREATE_EMPTY_CPB:
+		return rsu_create_empty_cpb();
+	case RSUD_CMD_RESTORE_CPB:
+		return rsu_restore_cpb(text);
+	case RSUD_CMD_SAVE_CPB:
+		return rsu_save_cpb(text);
+	default:
+		return -EARGS;
+	}
+}
+
+/* runs with the library locked, a client that stopped reading loses messages */
+static void rsud_progress(void *arg, RSU_OSAL_U32 done, RSU_OSAL_U32 total)
+{
+	struct rsud_progress prog;
+	uint32_t percent;
+
+	(void)arg;
+
+	if (!server.current || !total) {
+		return;
+	}
+
+	percent = (uint32_t)((uint64_t)done * 100 / total);
+	if (percent == server.percent) {
+		return;
+	}
+	server.percent = percent;
+
+	prog.queued = 0;
+	prog.done = done;
+	prog.total = total;
+	rsud_send(server.current->fd, RSUD_MSG_PROGRESS, &prog, sizeof(prog), NULL, 0,
+		  MSG_DONTWAIT);
+}
+
+static void *rsud_worker(void *arg)
+{
+	struct rsud_job *job;
+	int ret;
+
+	(void)arg;
+
+	pthread_mutex_lock(&server.lock);
+
+	for (;;) {
+		while (!server.head && !server.stopping) {
+			pthread_cond_wait(&server.cond, &server.lock);
+		}
+
+		job = server.head;
+		if (!job) {
+			break;
+		}
+
+		server.head = job->next;
+		if (!server.head) {
+			server.tail = NULL;
+		}
+
+		if (server.stopping) {
+			job->ret = -ECANCELED;
+		} else {
+			server.current = job;
+			server.percent = UINT32_MAX;
+			pthread_mutex_unlock(&server.lock);
+
+			ret = rsud_execute(job);
+			rsud_cache_refresh();
+
+			pthread_mutex_lock(&server.lock);
+			server.current = NULL;
+			job->ret = ret;
+		}
+
+		server.queued--;
+		job->done = 1;
+		pthread_cond_broadcast(&server.cond);
+	}
+
+	pthread_mutex_unlock(&server.lock);
+	return NULL;
+}
+
+static int rsud_queue(struct rsud_job *job)
+{
+	struct rsud_progress prog;
+
+	pthread_mutex_lock(&server.lock);
+
+	if (server.stopping) {
+		pthread_mutex_unlock(&server.lock);
+		return -ECANCELED;
+	}
+
+	/* sent before the job is visible, so it cannot race the worker's messages */
+	prog.queued = server.queued;
+	prog.done = 0;
+	prog.total = 0;
+	rsud_send(job->fd, RSUD_MSG_PROGRESS, &prog, sizeof(prog), NULL, 0, MSG_DONTWAIT);
+
+	job->next = NULL;
+	if (server.tail) {
+		server.tail->next = job;
+	} else {
+		server.head = job;
+	}
+	server.tail = job;
+	server.queued++;
+	pthread_cond_broadcast(&server.cond);
+
+	while (!job->done) {
+		pthread_cond_wait(&server.cond, &server.lock);
+	}
+
+	pthread_mutex_unlock(&server.lock);
+	return job->ret;
+}
+
+static void *rsud_client(void *arg)
+{
+	uint8_t buf[RSUD_MAX_PAYLOAD];
+	int slot = (int)(intptr_t)arg;
+	struct rsud_result res;
+	struct rsud_job *job;
+	struct rsud_hdr hdr;
+	uint32_t text_len;
+	int fd = server.clients[slot];
+	int len;
+
+	job = malloc(sizeof(*job));
+
+	while (job) {
+		len = rsud_recv(fd, &hdr, buf, sizeof(buf));
+		if (len < 0 || hdr.type != RSUD_MSG_REQUEST ||
+		    (uint32_t)len < sizeof(struct rsud_request)) {
+			break;
+		}
+
+		memset(job, 0, sizeof(*job));
+		memcpy(&job->req, buf, sizeof(job->req));
+		text_len = len - sizeof(job->req);
+		memcpy(job->text, buf + sizeof(job->req), text_len);
+		job->text[text_len] = '\0';
+		job->fd = fd;
+
+		if (RSUD_CMD_QUEUED(job->req.command)) {
+			res.ret = rsud_queue(job);
+		} else {
+			res.ret = rsud_execute(job);
+		}
+
+		if (rsud_send(fd, RSUD_MSG_RESULT, &res, sizeof(res), job->data, job->len, 0)) {
+			break;
+		}
+	}
+
+	free(job);
+
+	pthread_mutex_lock(&server.lock);
+	close(fd);
+	server.clients[slot] = -1;
+	server.nclients--;
+	pthread_cond_broadcast(&server.cond);
+	pthread_mutex_unlock(&server.lock);
+
+	return NULL;
+}
+
+/* the daemon runs flash and file operations as its own user, so only that user and root */
+static int rsud_peer_allowed(int fd)
+{
+	struct ucred cred;
+	socklen_t len = sizeof(cred);
+
+	if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len)) {
+		return 0;
+	}
+
+	return cred.uid == 0 || cred.uid == geteuid();
+}
+
+static void rsud_accept_client(int fd)
+{
+	pthread_attr_t attr;
+	pthread_t thread;
+	int slot;
+
+	if (!rsud_peer_allowed(fd)) {
+		close(fd);
+		return;
+	}
+
+	pthread_mutex_lock(&server.lock);
+
+	for (slot = 0; slot < RSUD_MAX_CLIENTS; slot++) {
+		if (server.clients[slot] < 0) {
+			break;
+		}
+	}
+
+	if (slot == RSUD_MAX_CLIENTS) {
+		pthread_mutex_unlock(&server.lock);
+		close(fd);
+		return;
+	}
+
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+
+	server.clients[slot] = fd;
+	if (pthread_create(&thread, &attr, rsud_client, (void *)(intptr_t)slot)) {
+		server.clients[slot] = -1;
+		close(fd);
+	} else {
+		server.nclients++;
+	}
+
+	pthread_attr_destroy(&attr);
+	pthread_mutex_unlock(&server.lock);
+}
+
+static void *rsud_accept(void *arg)
+{
+	struct pollfd fds[2];
+	int fd;
+
+	(void)arg;
+
+	fds[0].fd = server.listen_fd;
+	fds[0].events = POLLIN;
+	fds[1].fd = server.wake[0];
+	fds[1].events = POLLIN;
+
+	for (;;) {
+		if (poll(fds, 2, -1) < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			break;
+		}
+
+		if (fds[1].revents) {
+			break;
+		}
+
+		if (fds[0].revents & POLLIN) {
+			fd = accept4(server.listen_fd, NULL, NULL, SOCK_CLOEXEC);
+			if (fd >= 0) {
+				rsud_accept_client(fd);
+			}
+		}
+	}
+
+	return NULL;
+}
+
+static void rsud_cleanup(void)
+{
+	if (server.listen_fd >= 0) {
+		close(server.listen_fd);
+		unlink(server.path);
+		server.listen_fd = -1;
+	}
+
+	if (server.wake[0] >= 0) {
+		close(server.wake[0]);
+		close(server.wake[1]);
+		server.wake[0] = -1;
+		server.wake[1] = -1;
+	}
+}
+
+int rsud_server_start(const char *path)
+{
+	struct sockaddr_un addr;
+	int ret, i;
+
+	if (strlen(path) >= sizeof(addr.sun_path)) {
+		return -ENAMETOOLONG;
+	}
+
+	pthread_mutex_init(&server.lock, NULL);
+	pthread_cond_init(&server.cond, NULL);
+	server.head = NULL;
+	server.tail = NULL;
+	server.current = NULL;
+	server.queued = 0;
+	server.nclients = 0;
+	server.stopping = 0;
+	for (i = 0; i < RSUD_MAX_CLIENTS; i++) {
+		server.clients[i] = -1;
+	}
+	strcpy(server.path, path);
+
+	if (pipe2(server.wake, O_CLOEXEC)) {
+		ret = -errno;
+		goto fail;
+	}
+
+	server.listen_fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+	if (server.listen_fd < 0) {
+		ret = -errno;
+		goto fail;
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, path);
+
+	unlink(path);
+	if (bind(server.listen_fd, (struct sockaddr *)&addr, sizeof(addr)) ||
+	    chmod(path, S_IRUSR | S_IWUSR) || listen(server.listen_fd, RSUD_MAX_CLIENTS)) {
+		ret = -errno;
+		goto fail;
+	}
+
+	ret = rsu_set_progress_callback(rsud_progress, NULL);
+	if (ret) {
+		goto fail;
+	}
+
+	rsud_cache_refresh();
+
+	if (pthread_create(&server.worker_thread, NULL, rsud_worker, NULL)) {
+		ret = -EAGAIN;
+		goto fail_progress;
+	}
+
+	if (pthread_create(&server.accept_thread, NULL, rsud_accept, NULL)) {
+		pthread_mutex_lock(&server.lock);
+		server.stopping = 1;
+		pthread_cond_broadcast(&server.cond);
+		pthread_mutex_unlock(&server.lock);
+		pthread_join(server.worker_thread, NULL);
+		ret = -EAGAIN;
+		goto fail_progress;
+	}
+
+	return 0;
+
+fail_progress:
+	rsu_set_progress_callback(NULL, NULL);
+fail:
+	rsud_cleanup();
+	pthread_cond_destroy(&server.cond);
+	pthread_mutex_destroy(&server.lock);
+	return ret;
+}
+
+void rsud_server_stop(void)
+{
+	char c = 0;
+	int i;
+
+	if (write(server.wake[1], &c, 1) != 1) {
+		return;
+	}
+	pthread_join(server.accept_thread, NULL);
+
+	pthread_mutex_lock(&server.lock);
+	server.stopping = 1;
+	pthread_cond_broadcast(&server.cond);
+
+	/* wakes up the clients waiting for their next request */
+	for (i = 0; i < RSUD_MAX_CLIENTS; i++) {
+		if (server.clients[i] >= 0) {
+			shutdown(server.clients[i], SHUT_RDWR);
+		}
+	}
+
+	while (server.nclients) {
+		pthread_cond_wait(&server.cond, &server.lock);
+	}
+	pthread_mutex_unlock(&server.lock);
+
+	pthread_join(server.worker_thread, NULL);
+
+	rsu_set_progress_callback(NULL, NULL);
+	rsud_cleanup();
+	pthread_cond_destroy(&server.cond);
+	pthread_mutex_destroy(&server.lock);
+}
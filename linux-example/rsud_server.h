@@ -0,0 +1,35 @@
+/*
+ * Copyright (C) 2023-2024 Intel Corporation
+ * SPDX-License-Identifier: MIT-0
+ */
+
+#ifndef __RSUD_SERVER_H__
+#define __RSUD_SERVER_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define RSUD_MAX_CLIENTS 16
+#define RSUD_MAX_SLOTS	 128
+
+/*
+ * rsud_server_start() - serve the initialized library on a UNIX socket
+ * path: socket path, a stale socket there is replaced
+ *
+ * Return: 0 on success, or negative errno on error
+ */
+int rsud_server_start(const char *path);
+
+/*
+ * rsud_server_stop() - stop serving and wait for the running request
+ *
+ * Requests still waiting in the queue fail with -ECANCELED.
+ */
+void rsud_server_stop(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif
@@ -0,0 +1,349 @@
+/*
+ * Copyright (C) 2023-2024 Intel Corporation
+ * SPDX-License-Identifier: MIT-0
+ */
+
+#include <rsu_image_gen.h>
+#include <rsu_nor_sim.h>
+#include <libRSU.h>
+#include <libRSU_image.h>
+#include <libRSU_misc.h>
+#include <hal/RSU_plat_crc32.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#if RSU_IMAGE_GEN_BLOCK != IMAGE_BLOCK_SZ
+#error "RSU_IMAGE_GEN_BLOCK must match the image block size of the library"
+#endif
+
+#define GEN_CPB_PTR_OFFSET 32
+#define GEN_CPB_PTR_SLOTS  ((CPB_BLOCK_SIZE - GEN_CPB_PTR_OFFSET) / sizeof(RSU_OSAL_U64))
+
+/* image being provided by rsu_image_gen_stream() */
+static struct {
+	struct rsu_image_params params;
+	RSU_OSAL_U64 offset;
+	RSU_OSAL_U8 block[IMAGE_BLOCK_SZ];
+} stream;
+
+/* distance between sections in blocks */
+static RSU_OSAL_U64 gen_stride(const struct rsu_image_params *params)
+{
+	return params->size / IMAGE_BLOCK_SZ / params->sections;
+}
+
+/* well mixed 32 bit value of a 64 bit one, to seed each block independently */
+static RSU_OSAL_U32 gen_mix(RSU_OSAL_U64 val)
+{
+	val ^= val >> 33;
+	val *= 0xFF51AFD7ED558CCDULL;
+	val ^= val >> 33;
+	val *= 0xC4CEB9FE1A85EC53ULL;
+	val ^= val >> 33;
+	return (RSU_OSAL_U32)val;
+}
+
+static RSU_OSAL_VOID gen_fill(const struct rsu_image_params *params, RSU_OSAL_U64 offset,
+			      RSU_OSAL_U32 *words)
+{
+	RSU_OSAL_U32 state;
+	RSU_OSAL_U32 x;
+
+	switch (params->fill) {
+	case RSU_IMAGE_FILL_ZERO:
+		memset(words, 0, IMAGE_BLOCK_SZ);
+		break;
+	case RSU_IMAGE_FILL_ERASED:
+		memset(words, 0xFF, IMAGE_BLOCK_SZ);
+		break;
+	case RSU_IMAGE_FILL_COUNTER:
+		for (x = 0; x < IMAGE_BLOCK_SZ / 4; x++) {
+			words[x] = (RSU_OSAL_U32)offset + x * 4;
+		}
+		break;
+	case RSU_IMAGE_FILL_RANDOM:
+		state = gen_mix(((RSU_OSAL_U64)params->seed << 32) ^ offset) | 1;
+		for (x = 0; x < IMAGE_BLOCK_SZ / 4; x++) {
+			state ^= state << 13;
+			state ^= state >> 17;
+			state ^= state << 5;
+			words[x] = state;
+		}
+		break;
+	}
+}
+
+/* signature block CRC, computed the way the bitstream tools do over the bit-swapped block */
+static RSU_OSAL_VOID gen_sig_block_crc(RSU_OSAL_U8 *block)
+{
+	RSU_OSAL_U8 swapped[IMAGE_BLOCK_SZ];
+	RSU_OSAL_U32 field;
+
+	memcpy(swapped, block, SIG_BLOCK_CRC_OFFS);
+	swap_bits((RSU_OSAL_CHAR *)swapped, SIG_BLOCK_CRC_OFFS);
+	field = swap_endian32(rsu_crc32(0, swapped, SIG_BLOCK_CRC_OFFS));
+	swap_bits((RSU_OSAL_CHAR *)&field, sizeof(field));
+	memcpy(block + SIG_BLOCK_CRC_OFFS, &field, sizeof(field));
+}
+
+RSU_OSAL_INT rsu_image_gen_check(const struct rsu_image_params *params)
+{
+	if (!params || params->size == 0 || params->size % IMAGE_BLOCK_SZ ||
+	    params->sections == 0 || params->fill > RSU_IMAGE_FILL_RANDOM ||
+	    gen_stride(params) < 2) {
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+RSU_OSAL_INT rsu_image_gen_block(const struct rsu_image_params *params, RSU_OSAL_U64 offset,
+				 RSU_OSAL_VOID *block)
+{
+	RSU_OSAL_U8 *data = block;
+	RSU_OSAL_U64 stride, index, section, ptr;
+	RSU_OSAL_U32 magic = CMF_MAGIC;
+	RSU_OSAL_INT x;
+
+	if (!block || rsu_image_gen_check(params) || offset % IMAGE_BLOCK_SZ ||
+	    offset >= params->size) {
+		return -EINVAL;
+	}
+
+	gen_fill(params, offset, block);
+
+	stride = gen_stride(params);
+	index = offset / IMAGE_BLOCK_SZ;
+	section = index / stride;
+	if (section >= params->sections || index - section * stride > 1) {
+		return 0;
+	}
+
+	if (index == section * stride) {
+		memcpy(data, &magic, sizeof(magic));
+		return 0;
+	}
+
+	/* the pointer block of a signature block points to the next sections */
+	memset(data + SIG_BLOCK_PTR_OFFS, 0, IMAGE_BLOCK_SZ - SIG_BLOCK_PTR_OFFS);
+	for (x = 0; x < 4 && section + 1 + x < params->sections; x++) {
+		ptr = params->base + (section + 1 + x) * stride * IMAGE_BLOCK_SZ;
+		memcpy(data + SIG_BLOCK_PTR_OFFS + 8 + x * sizeof(ptr), &ptr, sizeof(ptr));
+	}
+	gen_sig_block_crc(data);
+
+	return 0;
+}
+
+RSU_OSAL_INT rsu_image_gen_buf(const struct rsu_image_params *params, RSU_OSAL_VOID *buf)
+{
+	RSU_OSAL_U64 offset;
+	RSU_OSAL_INT ret;
+
+	if (!buf || rsu_image_gen_check(params)) {
+		return -EINVAL;
+	}
+
+	for (offset = 0; offset < params->size; offset += IMAGE_BLOCK_SZ) {
+		ret = rsu_image_gen_block(params, offset, (RSU_OSAL_U8 *)buf + offset);
+		if (ret) {
+			return ret;
+		}
+	}
+
+	return 0;
+}
+
+RSU_OSAL_INT rsu_image_gen_file(const struct rsu_image_params *params,
+				const RSU_OSAL_CHAR *filename, RSU_OSAL_BOOL swap)
+{
+	RSU_OSAL_U8 block[IMAGE_BLOCK_SZ];
+	RSU_OSAL_U64 offset;
+	RSU_OSAL_INT ret = 0;
+	FILE *file;
+
+	if (!filename || rsu_image_gen_check(params)) {
+		return -EINVAL;
+	}
+
+	file = fopen(filename, "wb");
+	if (!file) {
+		return -errno;
+	}
+
+	for (offset = 0; offset < params->size && !ret; offset += IMAGE_BLOCK_SZ) {
+		ret = rsu_image_gen_block(params, offset, block);
+		if (!ret && swap) {
+			swap_bits((RSU_OSAL_CHAR *)block, IMAGE_BLOCK_SZ);
+		}
+		if (!ret && fwrite(block, 1, IMAGE_BLOCK_SZ, file) != IMAGE_BLOCK_SZ) {
+			ret = -EIO;
+		}
+	}
+
+	if (fclose(file) && !ret) {
+		ret = -EIO;
+	}
+
+	return ret;
+}
+
+RSU_OSAL_INT rsu_image_gen_stream_init(const struct rsu_image_params *params)
+{
+	if (rsu_image_gen_check(params)) {
+		return -EINVAL;
+	}
+
+	stream.params = *params;
+	stream.offset = 0;
+	return 0;
+}
+
+RSU_OSAL_INT rsu_image_gen_stream(RSU_OSAL_VOID *buf, RSU_OSAL_INT size)
+{
+	RSU_OSAL_U8 *dst = buf;
+	RSU_OSAL_U64 pos, cnt;
+	RSU_OSAL_INT done = 0;
+	RSU_OSAL_INT ret;
+
+	if (!buf || size < 0 || rsu_image_gen_check(&stream.params)) {
+		return -EINVAL;
+	}
+
+	while (done < size && stream.offset < stream.params.size) {
+		pos = stream.offset % IMAGE_BLOCK_SZ;
+		if (pos == 0) {
+			ret = rsu_image_gen_block(&stream.params, stream.offset, stream.block);
+			if (ret) {
+				return ret;
+			}
+		}
+
+		cnt = IMAGE_BLOCK_SZ - pos;
+		if (cnt > (RSU_OSAL_U64)(size - done)) {
+			cnt = size - done;
+		}
+		memcpy(dst + done, stream.block + pos, cnt);
+		stream.offset += cnt;
+		done += (RSU_OSAL_INT)cnt;
+	}
+
+	return done;
+}
+
+static RSU_OSAL_VOID gen_spt_add(struct SUB_PARTITION_TABLE *spt, const RSU_OSAL_CHAR *name,
+				 RSU_OSAL_U64 offset, RSU_OSAL_U32 length)
+{
+	snprintf(spt->partition[spt->partitions].name, SPT_PARTITION_NAME_LENGTH, "%s", name);
+	spt->partition[spt->partitions].offset = offset;
+	spt->partition[spt->partitions].length = length;
+	spt->partition[spt->partitions].flags = 0;
+	spt->partitions++;
+}
+
+/* program an image into a slot, already relocated the way the library leaves it in flash */
+static RSU_OSAL_INT gen_flash_slot(const struct rsu_flash_params *params, RSU_OSAL_U32 slot,
+				   RSU_OSAL_U64 offset)
+{
+	struct rsu_image_params image = {params->slot_sizes[slot], params->sections, offset,
+					 params->fill, slot};
+	RSU_OSAL_U8 block[IMAGE_BLOCK_SZ];
+	RSU_OSAL_U64 x;
+	RSU_OSAL_INT ret;
+
+	for (x = 0; x < image.size; x += IMAGE_BLOCK_SZ) {
+		ret = rsu_image_gen_block(&image, x, block);
+		if (ret) {
+			return ret;
+		}
+
+		ret = rsu_nor_sim_load(offset + x, block, IMAGE_BLOCK_SZ);
+		if (ret) {
+			return ret;
+		}
+	}
+
+	return 0;
+}
+
+RSU_OSAL_S64 rsu_image_gen_flash(const struct rsu_flash_params *params)
+{
+	struct SUB_PARTITION_TABLE spt, swapped;
+	union CMF_POINTER_BLOCK cpb;
+	RSU_OSAL_U64 *image_ptr = (RSU_OSAL_U64 *)&cpb.data[GEN_CPB_PTR_OFFSET];
+	RSU_OSAL_U64 offset = 4 * RSU_IMAGE_GEN_REGION;
+	RSU_OSAL_CHAR name[SPT_PARTITION_NAME_LENGTH];
+	RSU_OSAL_U32 x;
+	RSU_OSAL_INT ret;
+
+	if (!params || !params->slot_sizes || !rsu_nor_sim_data() ||
+	    params->slots > SPT_MAX_PARTITIONS - 4 || params->slots > GEN_CPB_PTR_SLOTS) {
+		return -EINVAL;
+	}
+
+	memset(&spt, 0, sizeof(spt));
+	spt.magic_number = SPT_MAGIC_NUMBER;
+	spt.version = 1;
+	gen_spt_add(&spt, "SPT0", 0, RSU_IMAGE_GEN_REGION);
+	gen_spt_add(&spt, "SPT1", RSU_IMAGE_GEN_REGION, RSU_IMAGE_GEN_REGION);
+	gen_spt_add(&spt, "CPB0", 2 * RSU_IMAGE_GEN_REGION, RSU_IMAGE_GEN_REGION);
+	gen_spt_add(&spt, "CPB1", 3 * RSU_IMAGE_GEN_REGION, RSU_IMAGE_GEN_REGION);
+
+	memset(&cpb, 0xFF, sizeof(cpb));
+	cpb.header.magic_number = CPB_MAGIC_NUMBER;
+	cpb.header.header_size = CPB_HEADER_SIZE;
+	cpb.header.cpb_size = CPB_BLOCK_SIZE;
+	cpb.header.cpb_reserved = 0;
+	cpb.header.image_ptr_offset = GEN_CPB_PTR_OFFSET;
+	cpb.header.image_ptr_slots = GEN_CPB_PTR_SLOTS;
+
+	for (x = 0; x < params->slots; x++) {
+		offset = (offset + RSU_IMAGE_GEN_SLOT_ALIGN - 1) &
+			 ~(RSU_OSAL_U64)(RSU_IMAGE_GEN_SLOT_ALIGN - 1);
+		if (params->slot_sizes[x] == 0 || params->slot_sizes[x] > 0xFFFFFFFFULL) {
+			return -EINVAL;
+		}
+
+		if (params->slot_names) {
+			snprintf(name, sizeof(name), "%s", params->slot_names[x]);
+		} else {
+			snprintf(name, sizeof(name), "P%u", x + 1);
+		}
+		gen_spt_add(&spt, name, offset, (RSU_OSAL_U32)params->slot_sizes[x]);
+
+		if (params->sections) {
+			ret = gen_flash_slot(params, x, offset);
+			if (ret) {
+				return ret;
+			}
+
+			/* the last entry written has the highest priority */
+			if (params->cpb) {
+				image_ptr[params->slots - 1 - x] = offset;
+			}
+		}
+
+		offset += params->slot_sizes[x];
+	}
+
+	memcpy(&swapped, &spt, sizeof(spt));
+	swap_bits((RSU_OSAL_CHAR *)&swapped, sizeof(swapped));
+	spt.checksum = swap_endian32(rsu_crc32(0, (RSU_OSAL_U8 *)&swapped, sizeof(swapped)));
+
+	ret = rsu_nor_sim_load(0, &spt, sizeof(spt));
+	if (!ret) {
+		ret = rsu_nor_sim_load(RSU_IMAGE_GEN_REGION, &spt, sizeof(spt));
+	}
+	if (!ret) {
+		ret = rsu_nor_sim_load(2 * RSU_IMAGE_GEN_REGION, &cpb, sizeof(cpb));
+	}
+	if (!ret) {
+		ret = rsu_nor_sim_load(3 * RSU_IMAGE_GEN_REGION, &cpb, sizeof(cpb));
+	}
+	if (ret) {
+		return ret;
+	}
+
+	return (RSU_OSAL_S64)offset;
+}
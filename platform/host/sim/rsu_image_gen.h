@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2023-2024 Intel Corporation
+ * SPDX-License-Identifier: MIT-0
+ */
+
+/**
+ * @file rsu_image_gen.h
+ * @brief synthetic application images and flash layouts for host tests and benchmarks
+ */
+
+#ifndef RSU_IMAGE_GEN_H
+#define RSU_IMAGE_GEN_H
+
+#include <libRSU_OSAL.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/** size of an image block, the unit of the generated images */
+#define RSU_IMAGE_GEN_BLOCK 0x1000
+
+/** size of each SPT and CPB copy of a generated flash layout */
+#define RSU_IMAGE_GEN_REGION 0x8000
+
+/** alignment of the slots of a generated flash layout */
+#define RSU_IMAGE_GEN_SLOT_ALIGN 0x10000
+
+/**
+ * @brief contents of the blocks that are not section or signature headers
+ */
+enum rsu_image_fill {
+	/** all 0x00 */
+	RSU_IMAGE_FILL_ZERO = 0,
+	/** all 0xFF, like erased flash */
+	RSU_IMAGE_FILL_ERASED,
+	/** the image offset of every 32 bit word */
+	RSU_IMAGE_FILL_COUNTER,
+	/** pseudo random bytes from the seed */
+	RSU_IMAGE_FILL_RANDOM,
+};
+
+/**
+ * @brief parameters of a generated image
+ *
+ * @note The image is made of CMF sections spread evenly over it, the first one at offset 0. Each
+ * section is a main descriptor block starting with the CMF magic, followed by a signature block
+ * whose pointer block points to the next sections, up to four, and carries a valid CRC.
+ *
+ * A relative image has pointers from the start of the image. An absolute image has pointers from
+ * the start of the flash, for the slot at the given base; the library only recognizes it as such
+ * when one pointer of the first signature block is beyond the size of the slot.
+ */
+struct rsu_image_params {
+	/** image size in bytes, a multiple of RSU_IMAGE_GEN_BLOCK */
+	RSU_OSAL_U64 size;
+	/** number of CMF sections, each needs at least two blocks */
+	RSU_OSAL_U32 sections;
+	/** 0 for a relative image, else the flash offset of the slot of an absolute image */
+	RSU_OSAL_U64 base;
+	/** contents of the other blocks */
+	enum rsu_image_fill fill;
+	/** seed of RSU_IMAGE_FILL_RANDOM */
+	RSU_OSAL_U32 seed;
+};
+
+/**
+ * @brief parameters of a generated flash layout
+ *
+ * @note The layout starts with the SPT0, SPT1, CPB0 and CPB1 copies, each RSU_IMAGE_GEN_REGION
+ * bytes, followed by the slots aligned to RSU_IMAGE_GEN_SLOT_ALIGN. Programmed slots hold an
+ * image of the slot size as the library leaves it in flash, with pointers from the start of the
+ * flash, so both a relative and an absolute image of the slot verify against it.
+ */
+struct rsu_flash_params {
+	/** size of each slot in bytes */
+	const RSU_OSAL_U64 *slot_sizes;
+	/** names of the slots, NULL for P1, P2, ... */
+	const RSU_OSAL_CHAR *const *slot_names;
+	/** number of slots */
+	RSU_OSAL_U32 slots;
+	/** sections of the image programmed into every slot, 0 leaves the slots erased */
+	RSU_OSAL_U32 sections;
+	/** contents of the images */
+	enum rsu_image_fill fill;
+	/** add the programmed slots to the CPB, the first slot with the highest priority */
+	RSU_OSAL_BOOL cpb;
+};
+
+/**
+ * @brief check image parameters
+ *
+ * @param params image parameters
+ * @return 0 when an image can be generated, negative number otherwise.
+ */
+RSU_OSAL_INT rsu_image_gen_check(const struct rsu_image_params *params);
+
+/**
+ * @brief generate one block of an image
+ *
+ * @note Blocks do not depend on each other, so an image of any size can be generated a block at
+ * a time.
+ *
+ * @param params image parameters
+ * @param offset offset of the block in the image, a multiple of RSU_IMAGE_GEN_BLOCK
+ * @param[out] block RSU_IMAGE_GEN_BLOCK bytes of image
+ * @return 0 on success, negative number on error.
+ */
+RSU_OSAL_INT rsu_image_gen_block(const struct rsu_image_params *params, RSU_OSAL_U64 offset,
+				 RSU_OSAL_VOID *block);
+
+/**
+ * @brief generate a whole image into a buffer
+ *
+ * @param params image parameters
+ * @param[out] buf buffer of params->size bytes
+ * @return 0 on success, negative number on error.
+ */
+RSU_OSAL_INT rsu_image_gen_buf(const struct rsu_image_params *params, RSU_OSAL_VOID *buf);
+
+/**
+ * @brief generate an image into a file
+ *
+ * @param params image parameters
+ * @param filename file to create
+ * @param swap reverse the bits of every byte, as .rpd files of a flash store them
+ * @return 0 on success, negative number on error.
+ */
+RSU_OSAL_INT rsu_image_gen_file(const struct rsu_image_params *params,
+				const RSU_OSAL_CHAR *filename, RSU_OSAL_BOOL swap);
+
+/**
+ * @brief start streaming an image through rsu_image_gen_stream()
+ *
+ * @param params image parameters, copied
+ * @return 0 on success, negative number on error.
+ */
+RSU_OSAL_INT rsu_image_gen_stream_init(const struct rsu_image_params *params);
+
+/**
+ * @brief rsu_data_callback that provides the image of rsu_image_gen_stream_init()
+ *
+ * @note It lets rsu_slot_program_callback() and rsu_slot_verify_callback() run on images of any
+ * size without holding them in memory.
+ *
+ * @param[out] buf buffer to fill
+ * @param size size of buf in bytes
+ * @return number of bytes provided, 0 at the end of the image, negative number on error.
+ */
+RSU_OSAL_INT rsu_image_gen_stream(RSU_OSAL_VOID *buf, RSU_OSAL_INT size);
+
+/**
+ * @brief write an SPT, a CPB and slots into the NOR flash simulator
+ *
+ * @note The simulator must have been created with rsu_nor_sim_init() and be large enough for the
+ * layout; its erase size must divide RSU_IMAGE_GEN_REGION. The rest of the flash is left as it
+ * is.
+ *
+ * @param params layout parameters
+ * @return offset of the free space after the slots, or negative number on error.
+ */
+RSU_OSAL_S64 rsu_image_gen_flash(const struct rsu_flash_params *params);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif
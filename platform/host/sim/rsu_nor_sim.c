@@ -0,0 +1,238 @@
+/*
+ * Copyright (C) 2023-2024 Intel Corporation
+ * SPDX-License-Identifier: MIT-0
+ */
+
+#include <rsu_nor_sim.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static struct {
+	struct rsu_nor_geometry geometry;
+	RSU_OSAL_U8 *data;
+	RSU_OSAL_U32 *erase_counts;
+	struct rsu_nor_counters counters;
+} nor;
+
+static RSU_OSAL_BOOL nor_is_pow2(RSU_OSAL_U32 val)
+{
+	return val && !(val & (val - 1));
+}
+
+static RSU_OSAL_BOOL nor_in_range(RSU_OSAL_OFFSET offset, RSU_OSAL_SIZE len)
+{
+	return nor.data && offset >= 0 && (RSU_OSAL_U64)offset <= nor.geometry.size &&
+	       len <= nor.geometry.size - (RSU_OSAL_U64)offset;
+}
+
+static RSU_OSAL_VOID nor_delay(RSU_OSAL_U32 us)
+{
+	struct timespec ts;
+
+	if (us == 0) {
+		return;
+	}
+
+	ts.tv_sec = us / 1000000;
+	ts.tv_nsec = (long)(us % 1000000) * 1000;
+	while (nanosleep(&ts, &ts) && errno == EINTR) {
+	}
+}
+
+static RSU_OSAL_U8 nor_reverse(RSU_OSAL_U8 val)
+{
+	val = (RSU_OSAL_U8)((val & 0xF0) >> 4 | (val & 0x0F) << 4);
+	val = (RSU_OSAL_U8)((val & 0xCC) >> 2 | (val & 0x33) << 2);
+	return (RSU_OSAL_U8)((val & 0xAA) >> 1 | (val & 0x55) << 1);
+}
+
+static RSU_OSAL_INT nor_read(RSU_OSAL_OFFSET offset, RSU_OSAL_VOID *data, RSU_OSAL_SIZE len)
+{
+	if (!nor_in_range(offset, len)) {
+		nor.counters.errors++;
+		return -EINVAL;
+	}
+
+	memcpy(data, nor.data + offset, len);
+	nor.counters.reads++;
+	return 0;
+}
+
+static RSU_OSAL_INT nor_write(RSU_OSAL_OFFSET offset, const RSU_OSAL_VOID *data,
+			      RSU_OSAL_SIZE len)
+{
+	const RSU_OSAL_U8 *src = data;
+	RSU_OSAL_U8 *dst;
+	RSU_OSAL_SIZE cnt, x;
+
+	if (!nor_in_range(offset, len)) {
+		nor.counters.errors++;
+		return -EINVAL;
+	}
+
+	dst = nor.data + offset;
+	while (len) {
+		/* one page program, up to the end of the page */
+		cnt = nor.geometry.page_size - (RSU_OSAL_SIZE)(offset & (nor.geometry.page_size - 1));
+		if (cnt > len) {
+			cnt = len;
+		}
+
+		for (x = 0; x < cnt; x++) {
+			if (src[x] & ~dst[x]) {
+				nor.counters.conflicts++;
+			}
+			dst[x] &= src[x];
+		}
+		nor.counters.pages++;
+		nor_delay(nor.geometry.page_program_us);
+
+		offset += cnt;
+		src += cnt;
+		dst += cnt;
+		len -= cnt;
+	}
+
+	return 0;
+}
+
+static RSU_OSAL_INT nor_erase(RSU_OSAL_OFFSET offset, RSU_OSAL_SIZE len)
+{
+	RSU_OSAL_U32 block;
+
+	if (!nor_in_range(offset, len) || (offset & (nor.geometry.erase_size - 1)) ||
+	    (len & (nor.geometry.erase_size - 1))) {
+		nor.counters.errors++;
+		return -EINVAL;
+	}
+
+	memset(nor.data + offset, 0xFF, len);
+	for (block = offset / nor.geometry.erase_size; len; block++) {
+		nor.erase_counts[block]++;
+		nor.counters.erases++;
+		nor_delay(nor.geometry.block_erase_us);
+		len -= nor.geometry.erase_size;
+	}
+
+	return 0;
+}
+
+static RSU_OSAL_INT nor_terminate(RSU_OSAL_VOID)
+{
+	return 0;
+}
+
+RSU_OSAL_INT rsu_nor_sim_init(const struct rsu_nor_geometry *geometry)
+{
+	if (!geometry || !nor_is_pow2(geometry->erase_size) || !nor_is_pow2(geometry->page_size) ||
+	    geometry->page_size > geometry->erase_size || geometry->size == 0 ||
+	    geometry->size % geometry->erase_size) {
+		return -EINVAL;
+	}
+
+	rsu_nor_sim_exit();
+
+	nor.data = malloc(geometry->size);
+	nor.erase_counts = calloc(geometry->size / geometry->erase_size, sizeof(RSU_OSAL_U32));
+	if (!nor.data || !nor.erase_counts) {
+		rsu_nor_sim_exit();
+		return -ENOMEM;
+	}
+
+	nor.geometry = *geometry;
+	memset(nor.data, 0xFF, geometry->size);
+	memset(&nor.counters, 0, sizeof(nor.counters));
+	return 0;
+}
+
+RSU_OSAL_VOID rsu_nor_sim_exit(RSU_OSAL_VOID)
+{
+	free(nor.data);
+	free(nor.erase_counts);
+	memset(&nor, 0, sizeof(nor));
+}
+
+RSU_OSAL_INT rsu_nor_sim_load(RSU_OSAL_OFFSET offset, const RSU_OSAL_VOID *data,
+			      RSU_OSAL_SIZE len)
+{
+	if (!data || !nor_in_range(offset, len)) {
+		return -EINVAL;
+	}
+
+	memcpy(nor.data + offset, data, len);
+	return 0;
+}
+
+RSU_OSAL_INT rsu_nor_sim_load_file(const RSU_OSAL_CHAR *filename, RSU_OSAL_OFFSET offset,
+				   RSU_OSAL_BOOL swap)
+{
+	RSU_OSAL_U8 *dst;
+	FILE *file;
+	long len;
+	long x;
+
+	if (!filename || !nor.data) {
+		return -EINVAL;
+	}
+
+	file = fopen(filename, "rb");
+	if (!file) {
+		return -ENOENT;
+	}
+
+	if (fseek(file, 0, SEEK_END) || (len = ftell(file)) < 0 || fseek(file, 0, SEEK_SET) ||
+	    !nor_in_range(offset, (RSU_OSAL_SIZE)len)) {
+		fclose(file);
+		return -EINVAL;
+	}
+
+	dst = nor.data + offset;
+	if (fread(dst, 1, len, file) != (size_t)len) {
+		fclose(file);
+		return -EIO;
+	}
+	fclose(file);
+
+	for (x = 0; swap && x < len; x++) {
+		dst[x] = nor_reverse(dst[x]);
+	}
+
+	return 0;
+}
+
+RSU_OSAL_U8 *rsu_nor_sim_data(RSU_OSAL_VOID)
+{
+	return nor.data;
+}
+
+RSU_OSAL_U32 rsu_nor_sim_erase_count(RSU_OSAL_U32 block)
+{
+	if (!nor.data || block >= nor.geometry.size / nor.geometry.erase_size) {
+		return 0;
+	}
+
+	return nor.erase_counts[block];
+}
+
+RSU_OSAL_VOID rsu_nor_sim_counters(struct rsu_nor_counters *counters)
+{
+	if (counters) {
+		*counters = nor.counters;
+	}
+}
+
+RSU_OSAL_INT rsu_nor_sim_qspi(struct qspi_ll_intf *qspi_intf)
+{
+	if (!qspi_intf) {
+		return -EINVAL;
+	}
+
+	qspi_intf->read = nor_read;
+	qspi_intf->write = nor_write;
+	qspi_intf->erase = nor_erase;
+	qspi_intf->terminate = nor_terminate;
+	return 0;
+}
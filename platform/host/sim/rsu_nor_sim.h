@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2023-2024 Intel Corporation
+ * SPDX-License-Identifier: MIT-0
+ */
+
+/**
+ * @file rsu_nor_sim.h
+ * @brief in-memory NOR flash simulator for the qspi platform interface of host builds
+ */
+
+#ifndef RSU_NOR_SIM_H
+#define RSU_NOR_SIM_H
+
+#include <libRSU_OSAL.h>
+#include <hal/RSU_plat_qspi.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * @brief geometry and timing of the simulated flash
+ *
+ * @note Erases must cover whole erase blocks. Writes are split into page programs, which like on
+ * a NOR flash can only clear bits: programming a 1 over a 0 leaves the 0 and is counted as a
+ * conflict. The latencies are spent in every page program and block erase when not 0.
+ */
+struct rsu_nor_geometry {
+	/** size of the flash in bytes, a multiple of erase_size */
+	RSU_OSAL_U64 size;
+	/** erase block size in bytes, a power of 2 */
+	RSU_OSAL_U32 erase_size;
+	/** program page size in bytes, a power of 2 */
+	RSU_OSAL_U32 page_size;
+	/** time of a page program in us */
+	RSU_OSAL_U32 page_program_us;
+	/** time of a block erase in us */
+	RSU_OSAL_U32 block_erase_us;
+};
+
+/**
+ * @brief operations counted by the simulator
+ */
+struct rsu_nor_counters {
+	/** read calls */
+	RSU_OSAL_U64 reads;
+	/** pages programmed */
+	RSU_OSAL_U64 pages;
+	/** blocks erased */
+	RSU_OSAL_U64 erases;
+	/** bytes with a 1 programmed over a 0 */
+	RSU_OSAL_U64 conflicts;
+	/** calls refused for bad alignment or range */
+	RSU_OSAL_U64 errors;
+};
+
+/** 64 MB, 64 KB erase blocks, 256 byte pages, no latency */
+#define RSU_NOR_GEOMETRY_DEFAULT {64 * 1024 * 1024, 64 * 1024, 256, 0, 0}
+
+/**
+ * @brief create the simulated flash, fully erased
+ *
+ * @param geometry geometry and timing, a previous flash is freed
+ * @return 0 on success, negative number on error.
+ */
+RSU_OSAL_INT rsu_nor_sim_init(const struct rsu_nor_geometry *geometry);
+
+/**
+ * @brief free the simulated flash
+ */
+RSU_OSAL_VOID rsu_nor_sim_exit(RSU_OSAL_VOID);
+
+/**
+ * @brief set flash contents directly, without the NOR rules, timing or counters
+ *
+ * @param offset flash offset
+ * @param data new contents
+ * @param len length of data in bytes
+ * @return 0 on success, negative number on error.
+ */
+RSU_OSAL_INT rsu_nor_sim_load(RSU_OSAL_OFFSET offset, const RSU_OSAL_VOID *data,
+			      RSU_OSAL_SIZE len);
+
+/**
+ * @brief set flash contents from a file, without the NOR rules, timing or counters
+ *
+ * @param filename file to load, e.g. a .rpd image of the flash
+ * @param offset flash offset of the start of the file
+ * @param swap reverse the bits of every byte, as .rpd files store them
+ * @return 0 on success, negative number on error.
+ */
+RSU_OSAL_INT rsu_nor_sim_load_file(const RSU_OSAL_CHAR *filename, RSU_OSAL_OFFSET offset,
+				   RSU_OSAL_BOOL swap);
+
+/**
+ * @brief flash contents, for checks by the caller
+ *
+ * @return start of the flash, NULL when it is not created
+ */
+RSU_OSAL_U8 *rsu_nor_sim_data(RSU_OSAL_VOID);
+
+/**
+ * @brief number of erases of an erase block since rsu_nor_sim_init()
+ *
+ * @param block erase block number
+ * @return erase count, 0 for a block outside the flash
+ */
+RSU_OSAL_U32 rsu_nor_sim_erase_count(RSU_OSAL_U32 block);
+
+/**
+ * @brief operation counters since rsu_nor_sim_init()
+ *
+ * @param[out] counters counters
+ */
+RSU_OSAL_VOID rsu_nor_sim_counters(struct rsu_nor_counters *counters);
+
+/**
+ * @brief fill a qspi interface with the simulator operations
+ *
+ * @note The flash is not freed by the terminate operation, so it keeps its contents across
+ * librsu_exit() and librsu_init() like a real one.
+ *
+ * @param qspi_intf qspi interface
+ * @return 0 on success, negative number on error.
+ */
+RSU_OSAL_INT rsu_nor_sim_qspi(struct qspi_ll_intf *qspi_intf);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif
@@ -8,18 +8,261 @@
 #include <utils/RSU_utils.h>
 #include <string.h>
 #include <stdarg.h>
+#include <sched.h>
+#include <stdio.h>
+#include <unistd.h>
 
 typedef enum {
 	RSU_STDERR,
 	RSU_FILE
 } rsu_log_type_t;
 
-rsu_loglevel_t rsu_curr_loglevel = L_LOG_LVL;
+rsu_loglevel_t rsu_curr_loglevel = L_LOG_DEFAULT;
 rsu_log_type_t rsu_log_type = RSU_STDERR;
 RSU_OSAL_FILE *RSU_log_file = NULL;
 
-#define NUM_ARGS		(16U)
-#define RSU_DEV_BUF_SIZE	(128U)
+/*
+ * Messages are formatted by the caller into a record of a bounded ring and
+ * written out by a background thread, one write() per record. The ring is a
+ * multi producer, single consumer queue: each record has a sequence number
+ * telling whether it is free for the producer at that position (seq == pos)
+ * or holds a message for the consumer (seq == pos + 1). Producers never block,
+ * when the ring is full the message is counted and dropped.
+ *
+ * Producers are counted in writers while they use the ring, and synchronous
+ * writes in sync_writers while they use the log file, so stopping the ring
+ * and closing the file can wait for the calls that still use them. A call
+ * that comes too late backs out right away, so the waits always end.
+ */
+#define RSU_LOG_RING_SIZE   256
+#define RSU_LOG_RECORD_SIZE 256
+#define RSU_LOG_IDLE_MS	    100
+
+struct rsu_log_record {
+	RSU_OSAL_ATOMIC seq;
+	RSU_OSAL_U32 len;
+	RSU_OSAL_CHAR text[RSU_LOG_RECORD_SIZE];
+};
+
+static struct {
+	struct rsu_log_record ring[RSU_LOG_RING_SIZE];
+	RSU_OSAL_ATOMIC head;
+	RSU_OSAL_U32 tail;
+	RSU_OSAL_ATOMIC dropped;
+	RSU_OSAL_ATOMIC sleeping;
+	RSU_OSAL_ATOMIC stop;
+	RSU_OSAL_ATOMIC running;
+	RSU_OSAL_ATOMIC writers;
+	RSU_OSAL_ATOMIC sync_writers;
+	RSU_OSAL_ATOMIC closing;
+	RSU_OSAL_MUTEX lock;
+	RSU_OSAL_COND wake;
+	RSU_OSAL_THREAD thread;
+	RSU_OSAL_INT fd;
+} rsu_log;
+
+static const RSU_OSAL_CHAR *l_log[] = {"", "err:", "low:", "med:", "high:"};
+
+static RSU_OSAL_U32 rsu_log_format(RSU_OSAL_CHAR *buf, rsu_loglevel_t level,
+				   const RSU_OSAL_CHAR *format, va_list arg)
+{
+	RSU_OSAL_U32 max = RSU_LOG_RECORD_SIZE - 1;
+	RSU_OSAL_INT len;
+
+	len = snprintf(buf, max, "\n[%s]", l_log[level]);
+	len += vsnprintf(buf + len, max - len, format, arg);
+	if (len > (RSU_OSAL_INT)max - 1) {
+		/* truncated, keep the line ending */
+		len = max - 1;
+		memcpy(buf + len - 3, "...", 3);
+	}
+	buf[len++] = '\n';
+	buf[len] = '\0';
+
+	return len;
+}
+
+static RSU_OSAL_VOID rsu_log_write(RSU_OSAL_INT fd, const RSU_OSAL_CHAR *buf, RSU_OSAL_U32 len)
+{
+	ssize_t ret;
+
+	while (len) {
+		ret = write(fd, buf, len);
+		if (ret < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return;
+		}
+		buf += ret;
+		len -= ret;
+	}
+}
+
+static RSU_OSAL_INT rsu_log_fd(RSU_OSAL_VOID)
+{
+	/* the log file is being closed, drop the message */
+	if (rsu_atomic_load(&rsu_log.closing)) {
+		return -1;
+	}
+
+	if (rsu_log_type == RSU_FILE) {
+		return RSU_log_file ? fileno(RSU_log_file) : -1;
+	}
+
+	return STDERR_FILENO;
+}
+
+/*
+ * rsu_log_drain() - write out every published record
+ *
+ * Return: number of records written
+ */
+static RSU_OSAL_U32 rsu_log_drain(RSU_OSAL_VOID)
+{
+	RSU_OSAL_CHAR buf[64];
+	struct rsu_log_record *rec;
+	RSU_OSAL_U32 cnt = 0;
+	RSU_OSAL_INT dropped;
+
+	for (;;) {
+		rec = &rsu_log.ring[rsu_log.tail % RSU_LOG_RING_SIZE];
+		if ((RSU_OSAL_U32)rsu_atomic_load(&rec->seq) != rsu_log.tail + 1) {
+			break;
+		}
+
+		rsu_log_write(rsu_log.fd, rec->text, rec->len);
+		rsu_atomic_store(&rec->seq, (RSU_OSAL_INT)(rsu_log.tail + RSU_LOG_RING_SIZE));
+		rsu_log.tail++;
+		cnt++;
+	}
+
+	dropped = rsu_atomic_load(&rsu_log.dropped);
+	if (dropped) {
+		rsu_atomic_add(&rsu_log.dropped, -dropped);
+		rsu_log_write(rsu_log.fd, buf,
+			      snprintf(buf, sizeof(buf), "\n[%s]%d log messages dropped\n",
+				       l_log[L_LOG_ERR], dropped));
+	}
+
+	return cnt;
+}
+
+static RSU_OSAL_VOID *rsu_log_thread(RSU_OSAL_VOID *arg)
+{
+	struct rsu_log_record *rec;
+
+	ARG_UNUSED(arg);
+
+	for (;;) {
+		if (rsu_log_drain()) {
+			continue;
+		}
+
+		if (rsu_atomic_load(&rsu_log.stop)) {
+			break;
+		}
+
+		/*
+		 * Producers only take the lock to signal when they see the
+		 * consumer asleep, so announce it before checking the ring a
+		 * last time. The timeout covers a wakeup that still slips by.
+		 */
+		rsu_mutex_timedlock(&rsu_log.lock, RSU_TIME_FOREVER);
+		rsu_atomic_store(&rsu_log.sleeping, 1);
+		rec = &rsu_log.ring[rsu_log.tail % RSU_LOG_RING_SIZE];
+		if ((RSU_OSAL_U32)rsu_atomic_load(&rec->seq) != rsu_log.tail + 1 &&
+		    !rsu_atomic_load(&rsu_log.stop)) {
+			rsu_cond_timedwait(&rsu_log.wake, &rsu_log.lock, RSU_LOG_IDLE_MS);
+		}
+		rsu_atomic_store(&rsu_log.sleeping, 0);
+		rsu_mutex_unlock(&rsu_log.lock);
+	}
+
+	return NULL;
+}
+
+/* wait for the calls counted in users to be done */
+static RSU_OSAL_VOID rsu_log_quiesce(RSU_OSAL_ATOMIC *users)
+{
+	while (rsu_atomic_load(users)) {
+		sched_yield();
+	}
+}
+
+static RSU_OSAL_VOID rsu_log_wake(RSU_OSAL_VOID)
+{
+	rsu_mutex_timedlock(&rsu_log.lock, RSU_TIME_FOREVER);
+	rsu_cond_signal(&rsu_log.wake);
+	rsu_mutex_unlock(&rsu_log.lock);
+}
+
+static RSU_OSAL_INT rsu_log_start(RSU_OSAL_VOID)
+{
+	RSU_OSAL_U32 x;
+	RSU_OSAL_INT ret;
+
+	rsu_log.fd = rsu_log_fd();
+	if (rsu_log.fd < 0 || rsu_atomic_load(&rsu_log.running)) {
+		return 0;
+	}
+
+	for (x = 0; x < RSU_LOG_RING_SIZE; x++) {
+		rsu_atomic_store(&rsu_log.ring[x].seq, (RSU_OSAL_INT)x);
+	}
+	rsu_atomic_store(&rsu_log.head, 0);
+	rsu_log.tail = 0;
+	rsu_atomic_store(&rsu_log.dropped, 0);
+	rsu_atomic_store(&rsu_log.sleeping, 0);
+	rsu_atomic_store(&rsu_log.stop, 0);
+
+	ret = rsu_mutex_init(&rsu_log.lock);
+	if (ret) {
+		return ret;
+	}
+
+	ret = rsu_cond_init(&rsu_log.wake);
+	if (ret) {
+		rsu_mutex_destroy(&rsu_log.lock);
+		return ret;
+	}
+
+	ret = rsu_thread_create(&rsu_log.thread, rsu_log_thread, NULL);
+	if (ret) {
+		rsu_cond_destroy(&rsu_log.wake);
+		rsu_mutex_destroy(&rsu_log.lock);
+		return ret;
+	}
+
+	rsu_atomic_store(&rsu_log.running, 1);
+	return 0;
+}
+
+static RSU_OSAL_VOID rsu_log_stop(RSU_OSAL_VOID)
+{
+	if (!rsu_atomic_load(&rsu_log.running)) {
+		return;
+	}
+
+	/*
+	 * New messages are written synchronously from here on. A producer that
+	 * still saw the ring running has claimed its record and publishes it
+	 * before it returns, so once no call is in progress every claimed
+	 * record is published and the final drain leaves head == tail.
+	 */
+	rsu_atomic_store(&rsu_log.running, 0);
+	rsu_log_quiesce(&rsu_log.writers);
+
+	rsu_atomic_store(&rsu_log.stop, 1);
+	rsu_log_wake();
+	rsu_thread_join(&rsu_log.thread, NULL);
+
+	/* messages published after the last look of the thread */
+	rsu_log_drain();
+
+	rsu_cond_destroy(&rsu_log.wake);
+	rsu_mutex_destroy(&rsu_log.lock);
+}
 
 RSU_OSAL_INT RSU_set_logging(rsu_loglevel_t level)
 {
@@ -31,111 +274,122 @@ RSU_OSAL_INT RSU_set_logging(rsu_loglevel_t level)
 	return 0;
 }
 
-RSU_OSAL_INT RSU_logging_init(RSU_OSAL_CHAR *cfg_file)
+RSU_OSAL_INT RSU_logging_init(const struct rsu_config *config)
 {
-	if (cfg_file == NULL) {
+	if (config == NULL) {
 		return -EINVAL;
 	}
 
-	RSU_OSAL_FILE *file;
-	RSU_OSAL_CHAR line[RSU_DEV_BUF_SIZE] = {0}, *argv[NUM_ARGS] = {0};
-	RSU_OSAL_INT argc;
-	RSU_OSAL_U32 linenum;
+	if (config->log_level == RSU_CONFIG_LOG_DEFAULT) {
+		return rsu_log_start();
+	}
 
-	file = fopen(cfg_file, "r");
-	if (!file) {
-		return -ENOENT;
+	if (config->log_level < L_LOG_OFF || config->log_level >= L_LOG_MAX) {
+		RSU_LOG_ERR("wrong log level provided : %d", config->log_level);
+		return -EINVAL;
 	}
 
-	linenum = 0;
-	while (fgets(line, RSU_DEV_BUF_SIZE, file) != NULL) {
-		linenum++;
-		argc = split_line(line, argv, NUM_ARGS);
-		if (argc != 3) {
-			continue;
-		}
-		/*TODO:check if we need to check the return from RSU_set_logging()*/
-		if (strcmp(argv[0], "log") == 0) {
-			if (strcmp(argv[1], "off") == 0) {
-				RSU_set_logging(L_LOG_OFF);
-				fclose(file);
-				return 0;
-			} else if (strcmp(argv[1], "err") == 0) {
-				RSU_set_logging(L_LOG_ERR);
-			} else if (strcmp(argv[1], "low") == 0) {
-				RSU_set_logging(L_LOG_WRN);
-			} else if (strcmp(argv[1], "med") == 0) {
-				RSU_set_logging(L_LOG_INF);
-			} else if (strcmp(argv[1], "high") == 0) {
-				RSU_set_logging(L_LOG_DBG);
-			} else {
-				RSU_LOG_ERR("Error in getting logging configuration at line number "
-					    "%u\n",
-					    linenum);
-				RSU_LOG_ERR("Setting log level to med and output as stderr\n");
-				RSU_set_logging(L_LOG_INF);
-				rsu_log_type = RSU_STDERR;
-				fclose(file);
-				return 0;
-			}
+	RSU_set_logging((rsu_loglevel_t)config->log_level);
+	if (config->log_level == L_LOG_OFF || config->log_file[0] == '\0') {
+		rsu_log_type = RSU_STDERR;
+		return rsu_log_start();
+	}
 
-			if (strcmp(argv[2], "stderr") == 0) {
-				rsu_log_type = RSU_STDERR;
-			} else {
-				RSU_OSAL_FILE *tfile = fopen(argv[2], "w");
-				if (tfile == NULL) {
-					RSU_LOG_ERR("Error in opening logfile, defined ar %u",
-						    linenum);
-					fclose(file);
-					return -EINVAL;
-				}
-				rsu_log_type = RSU_FILE;
-				RSU_log_file = tfile;
-			}
-			fclose(file);
-			return 0;
-		}
+	RSU_OSAL_FILE *tfile = fopen(config->log_file, "w");
+	if (tfile == NULL) {
+		RSU_LOG_ERR("Error in opening logfile '%s'", config->log_file);
+		return -EINVAL;
 	}
-	fclose(file);
-	return 0;
+	rsu_log_type = RSU_FILE;
+	RSU_log_file = tfile;
+	return rsu_log_start();
 }
 
 RSU_OSAL_VOID RSU_logging_exit(RSU_OSAL_VOID)
 {
+	rsu_log_stop();
+
 	if (rsu_log_type == RSU_FILE) {
-		fflush(RSU_log_file);
+		/* synchronous writers that already took the file finish with it first */
+		rsu_atomic_store(&rsu_log.closing, 1);
+		rsu_log_quiesce(&rsu_log.sync_writers);
 		fclose(RSU_log_file);
 		RSU_log_file = NULL;
+		rsu_log_type = RSU_STDERR;
+		rsu_atomic_store(&rsu_log.closing, 0);
+	}
+}
+
+/* before init or after exit, write the message right away */
+static RSU_OSAL_VOID rsu_log_sync(rsu_loglevel_t level, const RSU_OSAL_CHAR *format, va_list arg)
+{
+	RSU_OSAL_CHAR buf[RSU_LOG_RECORD_SIZE];
+	RSU_OSAL_U32 len;
+	RSU_OSAL_INT fd;
+
+	rsu_atomic_add(&rsu_log.sync_writers, 1);
+	fd = rsu_log_fd();
+	if (fd >= 0) {
+		len = rsu_log_format(buf, level, format, arg);
+		rsu_log_write(fd, buf, len);
+	}
+	rsu_atomic_add(&rsu_log.sync_writers, -1);
+}
+
+/* queue the message for the thread, false when the ring is stopped */
+static RSU_OSAL_BOOL rsu_log_post(rsu_loglevel_t level, const RSU_OSAL_CHAR *format, va_list arg)
+{
+	struct rsu_log_record *rec;
+	RSU_OSAL_U32 pos;
+	RSU_OSAL_INT dif;
+
+	/* counted before running is checked, see rsu_log_stop() */
+	rsu_atomic_add(&rsu_log.writers, 1);
+	if (!rsu_atomic_load(&rsu_log.running)) {
+		rsu_atomic_add(&rsu_log.writers, -1);
+		return false;
+	}
+
+	/* claim the record at head */
+	pos = (RSU_OSAL_U32)rsu_atomic_load(&rsu_log.head);
+	for (;;) {
+		rec = &rsu_log.ring[pos % RSU_LOG_RING_SIZE];
+		dif = (RSU_OSAL_INT)((RSU_OSAL_U32)rsu_atomic_load(&rec->seq) - pos);
+		if (dif == 0) {
+			if (rsu_atomic_cas(&rsu_log.head, (RSU_OSAL_INT)pos,
+					   (RSU_OSAL_INT)(pos + 1))) {
+				break;
+			}
+		} else if (dif < 0) {
+			rsu_atomic_add(&rsu_log.dropped, 1);
+			rsu_atomic_add(&rsu_log.writers, -1);
+			return true;
+		}
+		pos = (RSU_OSAL_U32)rsu_atomic_load(&rsu_log.head);
+	}
+
+	rec->len = rsu_log_format(rec->text, level, format, arg);
+	rsu_atomic_store(&rec->seq, (RSU_OSAL_INT)(pos + 1));
+
+	if (rsu_atomic_load(&rsu_log.sleeping)) {
+		rsu_log_wake();
 	}
+
+	rsu_atomic_add(&rsu_log.writers, -1);
+	return true;
 }
 
 RSU_OSAL_VOID RSU_logger(rsu_loglevel_t level, const RSU_OSAL_CHAR *format, ...)
 {
-	const RSU_OSAL_CHAR *l_log[] = {"", "err:", "low:", "med:", "high:"};
 	va_list arg;
 
 	if (level == L_LOG_OFF || level > rsu_curr_loglevel) {
 		return;
 	}
 
-	if (rsu_log_type == RSU_STDERR) {
-		fprintf(stderr, "\n[%s]", l_log[level]);
-		fflush(stderr);
-		va_start(arg, format);
-		vfprintf(stderr, format, arg);
-		va_end(arg);
-		fprintf(stderr, "\n");
-		fflush(stderr);
-	} else if (rsu_log_type == RSU_FILE) {
-		if (!RSU_log_file) {
-			return;
-		}
-		fprintf(RSU_log_file, "\n[%s]", l_log[level]);
-		fflush(RSU_log_file);
-		va_start(arg, format);
-		vfprintf(RSU_log_file, format, arg);
-		va_end(arg);
-		fprintf(RSU_log_file, "\n");
-		fflush(RSU_log_file);
+	va_start(arg, format);
+	if (!rsu_log_post(level, format, arg)) {
+		rsu_log_sync(level, format, arg);
 	}
+	va_end(arg);
 }
@@ -59,6 +59,16 @@ typedef size_t RSU_OSAL_SIZE;
 
 /** mutex object type*/
 typedef pthread_mutex_t RSU_OSAL_MUTEX;
+/** thread object type*/
+typedef pthread_t RSU_OSAL_THREAD;
+/** condition variable object type*/
+typedef pthread_cond_t RSU_OSAL_COND;
+/** reader/writer lock object type*/
+typedef pthread_rwlock_t RSU_OSAL_RWLOCK;
+/** atomic integer type*/
+typedef RSU_OSAL_INT RSU_OSAL_ATOMIC;
+/** atomic 64 bit counter type */
+typedef RSU_OSAL_U64 RSU_OSAL_ATOMIC64;
 /** file object type*/
 typedef FILE RSU_OSAL_FILE;
 
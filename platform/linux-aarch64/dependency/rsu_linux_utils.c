@@ -1,53 +1,135 @@
 #include "rsu_linux_utils.h"
 #include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
 
-RSU_OSAL_INT get_devattr(const RSU_OSAL_CHAR *rsu_dev, const RSU_OSAL_CHAR *attr, RSU_OSAL_U64 *const value)
+/*
+ * Attribute files stay open once used and are re-read with pread() at offset 0,
+ * which makes sysfs regenerate the value. Attributes read through
+ * get_devattr_cached() keep their value for the lifetime of the process.
+ */
+struct devattr {
+	RSU_OSAL_CHAR path[RSU_FILE_OP_BUF_SIZE];
+	RSU_OSAL_INT fd;
+	RSU_OSAL_BOOL cached;
+	RSU_OSAL_U64 value;
+};
+
+static struct devattr devattrs[RSU_DEVATTR_MAX];
+static RSU_OSAL_U32 devattr_count;
+
+static RSU_OSAL_VOID devattr_path(RSU_OSAL_CHAR *buf, const RSU_OSAL_CHAR *rsu_dev,
+				  const RSU_OSAL_CHAR *attr)
 {
-	RSU_OSAL_FILE *attr_file;
-	RSU_OSAL_CHAR *buf;
-	RSU_OSAL_INT size = RSU_FILE_OP_BUF_SIZE;
+	snprintf(buf, RSU_FILE_OP_BUF_SIZE, "%s/%s", rsu_dev, attr);
+}
 
-	buf = (RSU_OSAL_CHAR *)malloc(size);
-	if (!buf) {
-		RSU_LOG_ERR("error: failed to alloc buf\n");
-		return -ENOMEM;
+static struct devattr *devattr_lookup(const RSU_OSAL_CHAR *path)
+{
+	RSU_OSAL_U32 x;
+
+	for (x = 0; x < devattr_count; x++) {
+		if (strcmp(devattrs[x].path, path) == 0) {
+			return &devattrs[x];
+		}
 	}
 
-	strncpy(buf, rsu_dev, size - strlen(rsu_dev) - 1);
-	strncat(buf, "/", size - strlen(rsu_dev) - 1);
-	strncat(buf, attr, size - strlen(rsu_dev) - 1);
+	if (devattr_count >= RSU_DEVATTR_MAX) {
+		return NULL;
+	}
 
-	attr_file = fopen(buf, "r");
-	if (!attr_file) {
-		RSU_LOG_ERR("error: Unable to open device attribute file '%s'", buf);
-		free(buf);
-		return -EBADF;
+	snprintf(devattrs[devattr_count].path, RSU_FILE_OP_BUF_SIZE, "%s", path);
+	devattrs[devattr_count].fd = -1;
+	devattrs[devattr_count].cached = false;
+	return &devattrs[devattr_count++];
+}
+
+static RSU_OSAL_INT devattr_read(RSU_OSAL_INT fd, RSU_OSAL_U64 *const value)
+{
+	RSU_OSAL_CHAR buf[RSU_FILE_OP_BUF_SIZE];
+	ssize_t len;
+
+	len = pread(fd, buf, sizeof(buf) - 1, 0);
+	if (len <= 0) {
+		return -EACCES;
 	}
 
-	if (fgets(buf, size, attr_file)) {
-		*value = strtol(buf, NULL, 0);
-		fclose(attr_file);
-		free(buf);
+	buf[len] = '\0';
+	*value = strtoull(buf, NULL, 0);
+	return 0;
+}
+
+static RSU_OSAL_INT devattr_get(const RSU_OSAL_CHAR *rsu_dev, const RSU_OSAL_CHAR *attr,
+				RSU_OSAL_U64 *const value, RSU_OSAL_BOOL cache)
+{
+	RSU_OSAL_CHAR path[RSU_FILE_OP_BUF_SIZE];
+	struct devattr *entry;
+	RSU_OSAL_INT fd;
+	RSU_OSAL_INT ret;
+
+	devattr_path(path, rsu_dev, attr);
+	entry = devattr_lookup(path);
+	if (entry && entry->cached) {
+		*value = entry->value;
 		return 0;
 	}
 
-	fclose(attr_file);
-	free(buf);
-	return -EACCES;
+	fd = entry ? entry->fd : -1;
+	if (fd < 0) {
+		fd = open(path, O_RDONLY | O_CLOEXEC);
+		if (fd < 0) {
+			RSU_LOG_ERR("error: Unable to open device attribute file '%s'", path);
+			return -EBADF;
+		}
+	}
+
+	ret = devattr_read(fd, value);
+	if (ret != 0 || !entry) {
+		close(fd);
+		if (entry) {
+			entry->fd = -1;
+		}
+		return ret;
+	}
+
+	entry->fd = fd;
+	if (cache) {
+		entry->value = *value;
+		entry->cached = true;
+	}
+
+	return 0;
+}
+
+RSU_OSAL_INT get_devattr(const RSU_OSAL_CHAR *rsu_dev, const RSU_OSAL_CHAR *attr, RSU_OSAL_U64 *const value)
+{
+	return devattr_get(rsu_dev, attr, value, false);
+}
+
+RSU_OSAL_INT get_devattr_cached(const RSU_OSAL_CHAR *rsu_dev, const RSU_OSAL_CHAR *attr,
+				RSU_OSAL_U64 *const value)
+{
+	return devattr_get(rsu_dev, attr, value, true);
+}
+
+RSU_OSAL_VOID close_devattrs(RSU_OSAL_VOID)
+{
+	RSU_OSAL_U32 x;
+
+	for (x = 0; x < devattr_count; x++) {
+		if (devattrs[x].fd >= 0) {
+			close(devattrs[x].fd);
+			devattrs[x].fd = -1;
+		}
+	}
 }
 
 RSU_OSAL_INT put_devattr(const RSU_OSAL_CHAR *rsu_dev, const RSU_OSAL_CHAR *attr, RSU_OSAL_U64 value)
 {
 	RSU_OSAL_FILE *attr_file;
-	RSU_OSAL_CHAR *buf;
+	RSU_OSAL_CHAR buf[RSU_FILE_OP_BUF_SIZE];
 	RSU_OSAL_INT size = RSU_FILE_OP_BUF_SIZE;
 
-	buf = (RSU_OSAL_CHAR *)malloc(size);
-	if (!buf) {
-		RSU_LOG_ERR("error: failed to alloc buf\n");
-		return -ENOMEM;
-	}
-
 	strncpy(buf, DEFAULT_RSU_DEV, size - strlen(rsu_dev) - 1);
 	strncat(buf, "/", size - strlen(rsu_dev) - 1);
 	strncat(buf, attr, size - strlen(rsu_dev) - 1);
@@ -55,7 +137,6 @@ RSU_OSAL_INT put_devattr(const RSU_OSAL_CHAR *rsu_dev, const RSU_OSAL_CHAR *attr
 	attr_file = fopen(buf, "w");
 	if (!attr_file) {
 		RSU_LOG_ERR("error: Unable to open device attribute file '%s'", buf);
-		free(buf);
 		return -EBADF;
 	}
 
@@ -63,11 +144,9 @@ RSU_OSAL_INT put_devattr(const RSU_OSAL_CHAR *rsu_dev, const RSU_OSAL_CHAR *attr
 
 	if (fputs(buf, attr_file) > 0) {
 		fclose(attr_file);
-		free(buf);
 		return 0;
 	}
 
 	fclose(attr_file);
-	free(buf);
 	return -EACCES;
 }
@@ -26,9 +26,14 @@ extern "C" {
 
 #define RSU_DEV_BUF_SIZE	(128U)
 #define RSU_FILE_OP_BUF_SIZE	(256U)
-#define NUM_ARGS		(16U)
+#define RSU_DEVATTR_MAX		(32U)
 
 RSU_OSAL_INT get_devattr(const RSU_OSAL_CHAR *rsu_dev, const RSU_OSAL_CHAR *attr, RSU_OSAL_U64 *const value);
+/* like get_devattr(), for attributes that do not change until reboot */
+RSU_OSAL_INT get_devattr_cached(const RSU_OSAL_CHAR *rsu_dev, const RSU_OSAL_CHAR *attr,
+				RSU_OSAL_U64 *const value);
+/* close the attribute files kept open by get_devattr(), cached values are kept */
+RSU_OSAL_VOID close_devattrs(RSU_OSAL_VOID);
 RSU_OSAL_INT put_devattr(const RSU_OSAL_CHAR *rsu_dev, const RSU_OSAL_CHAR *attr, RSU_OSAL_U64 value);
 
 #ifdef __cplusplus
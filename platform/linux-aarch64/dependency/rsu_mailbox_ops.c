@@ -11,9 +11,21 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
 
 static RSU_OSAL_CHAR rsu_dev_local[RSU_DEV_BUF_SIZE + 1] = DEFAULT_RSU_DEV;
 
+/* status attributes watched for sysfs_notify(), see plat_mbox_wait_rsu_status */
+static const RSU_OSAL_CHAR *const status_attrs[] = {
+	"state", "current_image", "fail_image", "error_location", "error_details", "retry_counter",
+};
+
+#define NUM_STATUS_ATTRS (sizeof(status_attrs) / sizeof(status_attrs[0]))
+
+static RSU_OSAL_INT status_fds[NUM_STATUS_ATTRS] = {-1, -1, -1, -1, -1, -1};
+
 
 static RSU_OSAL_INT plat_mbox_get_rsu_status(struct mbox_status_info *data)
 {
@@ -62,6 +74,77 @@ static RSU_OSAL_INT plat_mbox_get_rsu_status(struct mbox_status_info *data)
 }
 
 
+static RSU_OSAL_VOID close_status_fds(RSU_OSAL_VOID)
+{
+	RSU_OSAL_U32 x;
+
+	for (x = 0; x < NUM_STATUS_ATTRS; x++) {
+		if (status_fds[x] >= 0) {
+			close(status_fds[x]);
+			status_fds[x] = -1;
+		}
+	}
+}
+
+/*
+ * Wait for the driver to sysfs_notify() one of the status attributes. The
+ * descriptors are private to the waiting thread and are read after each
+ * notification, which re-arms POLLPRI for that attribute. A driver that never
+ * notifies just makes every call time out.
+ */
+static RSU_OSAL_INT plat_mbox_wait_rsu_status(RSU_OSAL_U32 timeout)
+{
+	struct pollfd fds[NUM_STATUS_ATTRS];
+	RSU_OSAL_CHAR buf[RSU_FILE_OP_BUF_SIZE];
+	RSU_OSAL_U32 x;
+	RSU_OSAL_INT ret;
+
+	for (x = 0; x < NUM_STATUS_ATTRS; x++) {
+		if (status_fds[x] < 0) {
+			snprintf(buf, sizeof(buf), "%s/%s", rsu_dev_local, status_attrs[x]);
+			status_fds[x] = open(buf, O_RDONLY | O_CLOEXEC);
+			if (status_fds[x] < 0) {
+				close_status_fds();
+				return -ENOTSUP;
+			}
+			/* the first read sets the baseline for change events */
+			if (pread(status_fds[x], buf, sizeof(buf), 0) < 0) {
+				close_status_fds();
+				return -ENOTSUP;
+			}
+		}
+
+		fds[x].fd = status_fds[x];
+		fds[x].events = POLLPRI;
+		fds[x].revents = 0;
+	}
+
+	ret = poll(fds, NUM_STATUS_ATTRS,
+		   timeout == RSU_TIME_FOREVER ? -1 : (RSU_OSAL_INT)timeout);
+	if (ret < 0) {
+		return (errno == EINTR) ? 0 : -errno;
+	}
+
+	if (ret == 0) {
+		return -ETIMEDOUT;
+	}
+
+	for (x = 0; x < NUM_STATUS_ATTRS; x++) {
+		if (fds[x].revents & POLLNVAL) {
+			close_status_fds();
+			return -ENOTSUP;
+		}
+		if (fds[x].revents & (POLLPRI | POLLERR)) {
+			if (pread(status_fds[x], buf, sizeof(buf), 0) < 0) {
+				close_status_fds();
+				return -EIO;
+			}
+		}
+	}
+
+	return 0;
+}
+
 static RSU_OSAL_INT plat_mbox_send_rsu_update(RSU_OSAL_U64 addr)
 {
 	RSU_OSAL_INT ret = 0;
@@ -81,12 +164,12 @@ static RSU_OSAL_INT plat_mbox_get_spt_addresses(struct mbox_data_rsu_spt_address
 
 	RSU_OSAL_INT ret = 0;
 
-	ret = get_devattr(rsu_dev_local, "spt0_address", &(data->spt0_address));
+	ret = get_devattr_cached(rsu_dev_local, "spt0_address", &(data->spt0_address));
 	if(ret != 0) {
 		return ret;
 	}
 
-	ret = get_devattr(rsu_dev_local, "spt1_address", &(data->spt1_address));
+	ret = get_devattr_cached(rsu_dev_local, "spt1_address", &(data->spt1_address));
 	if(ret != 0) {
 		return ret;
 	}
@@ -112,47 +195,29 @@ static RSU_OSAL_INT plat_mbox_rsu_notify(RSU_OSAL_U32 notify)
 
 static RSU_OSAL_INT plat_mbox_terminate(RSU_OSAL_VOID)
 {
+	close_status_fds();
+	close_devattrs();
 	strncpy(rsu_dev_local, DEFAULT_RSU_DEV, RSU_DEV_BUF_SIZE);
 	return 0;
 }
 
-RSU_OSAL_INT plat_mbox_init(struct mbox_ll_intf *mbox, RSU_OSAL_CHAR *config_file)
+RSU_OSAL_INT plat_mbox_init(struct mbox_ll_intf *mbox, const struct rsu_config *config)
 {
-	if (!mbox || !config_file) {
+	if (!mbox || !config) {
 		return -EINVAL;
 	}
 
-	RSU_OSAL_FILE *file;
-	RSU_OSAL_CHAR line[RSU_DEV_BUF_SIZE] = {0}, *argv[NUM_ARGS] = {0};
-	RSU_OSAL_INT argc;
-	RSU_OSAL_U32 linenum;
-
-	file = fopen(config_file, "r");
-	if (!file) {
-		return -ENOENT;
-	}
-
-	linenum = 0;
-	while (fgets(line, RSU_DEV_BUF_SIZE, file) != NULL) {
-		linenum++;
-		argc = split_line(line, argv, NUM_ARGS);
-		if (argc != 2) {
-			continue;
-		}
-
-		if (strncmp(argv[0], "rsu-dev", RSU_DEV_BUF_SIZE) == 0) {
-			strncpy(rsu_dev_local, argv[1], RSU_DEV_BUF_SIZE);
-			break;
-		}
+	if (config->rsu_dev[0] != '\0') {
+		strncpy(rsu_dev_local, config->rsu_dev, RSU_DEV_BUF_SIZE);
 	}
 
 	RSU_LOG_DBG("rsu-dev is %.*s for mailbox operations\n", RSU_DEV_BUF_SIZE, rsu_dev_local);
-	fclose(file);
 
 	mbox->get_rsu_status = plat_mbox_get_rsu_status;
 	mbox->send_rsu_update = plat_mbox_send_rsu_update;
 	mbox->get_spt_addresses = plat_mbox_get_spt_addresses;
 	mbox->rsu_notify = plat_mbox_rsu_notify;
 	mbox->terminate = plat_mbox_terminate;
+	mbox->wait_rsu_status = plat_mbox_wait_rsu_status;
 	return 0;
 }
@@ -61,7 +61,7 @@ static RSU_OSAL_INT rsu_get_max_retry_count(RSU_OSAL_U8 *rsu_max_retry)
 	RSU_OSAL_INT ret = 0;
 	RSU_OSAL_U64 max_retry;
 
-	ret = get_devattr(rsu_dev_local, "max_retry", &max_retry);
+	ret = get_devattr_cached(rsu_dev_local, "max_retry", &max_retry);
 	if (ret != 0) {
 		return ret;
 	}
@@ -84,28 +84,28 @@ static RSU_OSAL_INT rsu_get_dcmf_version(struct rsu_dcmf_version *version)
 	RSU_OSAL_INT ret = 0;
 	RSU_OSAL_U64 value;
 
-	ret = get_devattr(rsu_dev_local, "dcmf0", &value);
+	ret = get_devattr_cached(rsu_dev_local, "dcmf0", &value);
 	if (ret != 0) {
 		return ret;
 	} else {
 		version->dcmf[0] = (RSU_OSAL_U32)value;
 	}
 
-	ret = get_devattr(rsu_dev_local, "dcmf1", &value);
+	ret = get_devattr_cached(rsu_dev_local, "dcmf1", &value);
 	if (ret != 0) {
 		return ret;
 	} else {
 		version->dcmf[1] = (RSU_OSAL_U32)value;
 	}
 
-	ret = get_devattr(rsu_dev_local, "dcmf2", &value);
+	ret = get_devattr_cached(rsu_dev_local, "dcmf2", &value);
 	if (ret != 0) {
 		return ret;
 	} else {
 		version->dcmf[2] = (RSU_OSAL_U32)value;
 	}
 
-	ret = get_devattr(rsu_dev_local, "dcmf3", &value);
+	ret = get_devattr_cached(rsu_dev_local, "dcmf3", &value);
 	if (ret != 0) {
 		return ret;
 	} else {
@@ -117,41 +117,21 @@ static RSU_OSAL_INT rsu_get_dcmf_version(struct rsu_dcmf_version *version)
 
 static RSU_OSAL_INT terminate(RSU_OSAL_VOID)
 {
+	close_devattrs();
 	strncpy(rsu_dev_local, DEFAULT_RSU_DEV, RSU_DEV_BUF_SIZE);
 	return 0;
 }
 
-RSU_OSAL_INT plat_rsu_misc_init(struct rsu_ll_misc *misc_intf, RSU_OSAL_CHAR *config_file)
+RSU_OSAL_INT plat_rsu_misc_init(struct rsu_ll_misc *misc_intf, const struct rsu_config *config)
 {
-	if (!misc_intf || !config_file) {
+	if (!misc_intf || !config) {
 		return -EINVAL;
 	}
 
-	RSU_OSAL_FILE *file;
-	RSU_OSAL_CHAR line[RSU_DEV_BUF_SIZE] = {0}, *argv[NUM_ARGS] = {0};
-	RSU_OSAL_INT argc;
-	RSU_OSAL_U32 linenum;
-
-	file = fopen(config_file, "r");
-	if (!file) {
-		return -ENOENT;
-	}
-
-	linenum = 0;
-	while (fgets(line, RSU_DEV_BUF_SIZE, file) != NULL) {
-		linenum++;
-		argc = split_line(line, argv, NUM_ARGS);
-		if (argc != 2) {
-			continue;
-		}
-
-		if (strncmp(argv[0], "rsu-dev", RSU_DEV_BUF_SIZE) == 0) {
-			strncpy(rsu_dev_local, argv[1], RSU_DEV_BUF_SIZE);
-			break;
-		}
+	if (config->rsu_dev[0] != '\0') {
+		strncpy(rsu_dev_local, config->rsu_dev, RSU_DEV_BUF_SIZE);
 	}
 	RSU_LOG_DBG("rsu-dev is %.*s for misc operations\n", RSU_DEV_BUF_SIZE, rsu_dev_local);
-	fclose(file);
 
 	misc_intf->rsu_get_dcmf_status = rsu_get_dcmf_status;
 	misc_intf->rsu_get_dcmf_version = rsu_get_dcmf_version;
@@ -20,9 +20,12 @@
 #define DEVICE "/dev/mtd0"
 
 static int dev_file = -1;
+static int dev_read_only;
 static struct mtd_info_user dev_info;
 static char qspi_file[RSU_DEV_BUF_SIZE + 1] = DEVICE;
 
+static RSU_OSAL_INT plat_qspi_open(RSU_OSAL_VOID);
+
 static RSU_OSAL_INT plat_qspi_read(RSU_OSAL_OFFSET offset, RSU_OSAL_VOID *data, RSU_OSAL_SIZE len)
 {
 	RSU_LOG_DBG("received read qspi at offset 0x08%jx having %lu length\n", offset, len);
@@ -30,6 +33,11 @@ static RSU_OSAL_INT plat_qspi_read(RSU_OSAL_OFFSET offset, RSU_OSAL_VOID *data,
 	char *ptr = data;
 	int rtn;
 
+	/* a read-only device is opened by the first read */
+	if (dev_file < 0 && dev_read_only && plat_qspi_open()) {
+		return -ENODEV;
+	}
+
 	if (dev_file < 0) {
 		return -EINVAL;
 	}
@@ -61,6 +69,10 @@ static RSU_OSAL_INT plat_qspi_write(RSU_OSAL_OFFSET offset, const RSU_OSAL_VOID
 	const char *ptr = data;
 	int rtn;
 
+	if (dev_read_only) {
+		return -EROFS;
+	}
+
 	if (dev_file < 0) {
 		return -EINVAL;
 	}
@@ -90,6 +102,10 @@ static RSU_OSAL_INT plat_qspi_erase(RSU_OSAL_OFFSET offset, RSU_OSAL_SIZE len)
 
 	RSU_LOG_DBG("received erase at offset 0x08%jx having %lu length\n", offset, len);
 
+	if (dev_read_only) {
+		return -EROFS;
+	}
+
 	if (dev_file < 0) {
 		return -EIO;
 	}
@@ -119,56 +135,25 @@ static RSU_OSAL_INT plat_qspi_erase(RSU_OSAL_OFFSET offset, RSU_OSAL_SIZE len)
 
 static RSU_OSAL_INT plat_qspi_terminate(RSU_OSAL_VOID)
 {
-	close(dev_file);
+	if (dev_file >= 0) {
+		close(dev_file);
+	}
 	dev_file = -1;
 	RSU_LOG_DBG("qspi terminated");
 	return 0;
 }
 
-/* Init plat_qspi */
-RSU_OSAL_INT plat_qspi_init(struct qspi_ll_intf *qspi_intf, RSU_OSAL_CHAR *config_file)
+static RSU_OSAL_INT plat_qspi_open(RSU_OSAL_VOID)
 {
-	if (qspi_intf == NULL || config_file == NULL) {
-		return -EINVAL;
-	}
-
+	int flags = dev_read_only ? O_RDONLY : O_RDWR | O_SYNC;
 	RSU_OSAL_CHAR *type_str;
-	RSU_OSAL_FILE *file;
-	RSU_OSAL_CHAR line[RSU_DEV_BUF_SIZE] = {0}, *argv[NUM_ARGS] = {0};
-	RSU_OSAL_INT argc;
-	RSU_OSAL_U32 linenum;
-
-	file = fopen(config_file, "r");
-	if (!file) {
-		return -ENOENT;
-	}
-
-	linenum = 0;
-	while (fgets(line, RSU_DEV_BUF_SIZE, file) != NULL) {
-		linenum++;
-		argc = split_line(line, argv, NUM_ARGS);
-		if (argc != 3) {
-			continue;
-		}
-
-		if (strcmp(argv[0], "root") == 0) {
-			if (strncmp(argv[1], "qspi", RSU_DEV_BUF_SIZE) == 0) {
-				strncpy(qspi_file, argv[2], RSU_DEV_BUF_SIZE);
-			} else {
-				RSU_LOG_ERR("root device not qspi at linenum %d\n", linenum);
-			}
-			break;
-		}
-	}
-
-	fclose(file);
 
-	dev_file = open(qspi_file, O_RDWR | O_SYNC);
+	dev_file = open(qspi_file, flags);
 	if (dev_file < 0) {
 		RSU_LOG_ERR("Unable to open '%s'\n", qspi_file);
 		strncpy(qspi_file, DEVICE, RSU_DEV_BUF_SIZE);
 		RSU_LOG_ERR("Trying to open '%s'\n", qspi_file);
-		dev_file = open(qspi_file, O_RDWR | O_SYNC);
+		dev_file = open(qspi_file, flags);
 		if (dev_file < 0) {
 			RSU_LOG_ERR("Unable to open '%s'\n", qspi_file);
 			return -ENODEV;
@@ -179,6 +164,7 @@ RSU_OSAL_INT plat_qspi_init(struct qspi_ll_intf *qspi_intf, RSU_OSAL_CHAR *confi
 	if (ioctl(dev_file, MEMGETINFO, &dev_info)) {
 		RSU_LOG_ERR("error: Unable to find mtd info for '%s'\n", DEVICE);
 		close(dev_file);
+		dev_file = -1;
 		return -EACCES;
 	}
 
@@ -227,6 +213,31 @@ RSU_OSAL_INT plat_qspi_init(struct qspi_ll_intf *qspi_intf, RSU_OSAL_CHAR *confi
 		RSU_LOG_DBG("MTD flash is MTD_POWERUP_LOCK");
 	}
 
+	return 0;
+}
+
+/* Init plat_qspi */
+RSU_OSAL_INT plat_qspi_init(struct qspi_ll_intf *qspi_intf, const struct rsu_config *config)
+{
+	if (qspi_intf == NULL || config == NULL) {
+		return -EINVAL;
+	}
+
+	RSU_OSAL_INT ret;
+
+	if (config->qspi_dev[0] != '\0') {
+		strncpy(qspi_file, config->qspi_dev, RSU_DEV_BUF_SIZE);
+	}
+
+	/* in read-only mode status only callers never open the device */
+	dev_read_only = config->read_only ? 1 : 0;
+	if (!dev_read_only) {
+		ret = plat_qspi_open();
+		if (ret) {
+			return ret;
+		}
+	}
+
 	qspi_intf->read = plat_qspi_read;
 	qspi_intf->write = plat_qspi_write;
 	qspi_intf->erase = plat_qspi_erase;
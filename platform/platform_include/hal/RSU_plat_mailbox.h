@@ -12,6 +12,7 @@
 #define RSU_PLAT_MAILBOX_H
 
 #include <libRSU_OSAL.h>
+#include <libRSU_config.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -89,6 +90,17 @@ typedef RSU_OSAL_INT (*mbox_get_spt_addresses_t)(struct mbox_data_rsu_spt_addres
  */
 typedef RSU_OSAL_INT (*mbox_rsu_notify_t)(RSU_OSAL_U32 notify);
 
+/**
+ * @brief typedef wait_rsu_status function which blocks until SDM reports that the RSU status may
+ * have changed.
+ * @note Optional, platforms without change notification leave it NULL and the library polls
+ * get_rsu_status instead. Spurious returns are allowed, the library compares the status itself.
+ * @param[in] timeout time period to wait for a notification. time is in milliseconds.
+ * @return 0 on notification, -ETIMEDOUT when time expired, other negative number if
+ * notifications are not available.
+ */
+typedef RSU_OSAL_INT (*mbox_wait_rsu_status_t)(RSU_OSAL_U32 timeout);
+
 /**
  * @brief typedef terminate function which closes the channel to SDM and free up resources.
  *
@@ -111,17 +123,18 @@ struct mbox_ll_intf {
 	mbox_rsu_notify_t rsu_notify;
 	/** terminate interface function pointer*/
 	mbox_terminate_t terminate;
+	/** optional function pointer to wait for a RSU status change notification, can be NULL*/
+	mbox_wait_rsu_status_t wait_rsu_status;
 };
 
 /**
  * @brief mailbox init function which is called by library to initialize the SDM mailbox interface.
  *
  * @param[out] mbox_intf pointer to struct mbox_ll_intf object which needs to be filled by the function
- * @param[in] config_file config file name which can be used to pass configuration parameters to init
- * function.
+ * @param[in] config configuration parsed by the library, see @ref rsu_config.
  * @return 0 on success, negative number on error.
  */
-RSU_OSAL_INT plat_mbox_init(struct mbox_ll_intf *mbox_intf, RSU_OSAL_CHAR *config_file);
+RSU_OSAL_INT plat_mbox_init(struct mbox_ll_intf *mbox_intf, const struct rsu_config *config);
 
 #ifdef __cplusplus
 }
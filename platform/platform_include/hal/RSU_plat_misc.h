@@ -14,6 +14,7 @@
 #define RSU_PLAT_MISC_H
 
 #include <libRSU_OSAL.h>
+#include <libRSU_config.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -92,11 +93,10 @@ struct rsu_ll_misc {
  * different in different platforms.
  *
  * @param[out] misc_intf pointer to struct rsu_ll_misc which needs to be populated by the function
- * @param[in] config_file config file name which can be used to pass configuration parameters to init
- * function.
+ * @param[in] config configuration parsed by the library, see @ref rsu_config.
  * @return 0 on success, negative number on error.
  */
-RSU_OSAL_INT plat_rsu_misc_init(struct rsu_ll_misc *misc_intf, RSU_OSAL_CHAR *config_file);
+RSU_OSAL_INT plat_rsu_misc_init(struct rsu_ll_misc *misc_intf, const struct rsu_config *config);
 
 #ifdef __cplusplus
 }
@@ -13,6 +13,7 @@
 #define RSU_PLAT_QSPI_H
 
 #include <libRSU_OSAL.h>
+#include <libRSU_config.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -75,11 +76,10 @@ struct qspi_ll_intf {
  *
  * @param[out] qspi_intf pointer to struct qspi_ll_intf object needs to be populated by @ref
  * plat_qspi_init().
- * @param[in] config_file config file name which can be used to pass configuration parameters to
- * init function.
+ * @param[in] config configuration parsed by the library, see @ref rsu_config.
  * @return 0 on success, negative number on error.
  */
-RSU_OSAL_INT plat_qspi_init(struct qspi_ll_intf *qspi_intf, RSU_OSAL_CHAR *config_file);
+RSU_OSAL_INT plat_qspi_init(struct qspi_ll_intf *qspi_intf, const struct rsu_config *config);
 
 #ifdef __cplusplus
 }
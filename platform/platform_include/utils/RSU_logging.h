@@ -13,6 +13,7 @@
 #define RSU_LOGGING_H
 
 #include <libRSU_OSAL.h>
+#include <libRSU_config.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -32,21 +33,75 @@ typedef enum {
 } rsu_loglevel_t;
 
 /**
- * @brief default log level
+ * @brief highest log level built into the library
  *
+ * Log calls above this level are compiled out, their arguments are not even
+ * evaluated.
  */
 #ifndef L_LOG_LVL
-#define L_LOG_LVL L_LOG_INF
+#define L_LOG_LVL L_LOG_DBG
 #endif
 
+/**
+ * @brief default log level
+ *
+ */
+#define L_LOG_DEFAULT (L_LOG_LVL < L_LOG_INF ? L_LOG_LVL : L_LOG_INF)
+
+/** current log level, see RSU_set_logging() */
+extern rsu_loglevel_t rsu_curr_loglevel;
+
+/** true if a log call at level would produce output */
+#define RSU_LOG_ENABLED(level) ((level) <= L_LOG_LVL && (level) <= rsu_curr_loglevel)
+
+/** log API, checks the level before evaluating the arguments */
+#define RSU_LOG(level, format, ...)                                                                \
+	do {                                                                                       \
+		if (RSU_LOG_ENABLED(level)) {                                                      \
+			RSU_logger(level, format, ##__VA_ARGS__);                                  \
+		}                                                                                  \
+	} while (0)
+
 /** debug log API */
-#define RSU_LOG_DBG(format, ...) RSU_logger(L_LOG_DBG, format, ##__VA_ARGS__)
+#define RSU_LOG_DBG(format, ...) RSU_LOG(L_LOG_DBG, format, ##__VA_ARGS__)
 /** info log API */
-#define RSU_LOG_INF(format, ...) RSU_logger(L_LOG_INF, format, ##__VA_ARGS__)
+#define RSU_LOG_INF(format, ...) RSU_LOG(L_LOG_INF, format, ##__VA_ARGS__)
 /** warn log API */
-#define RSU_LOG_WRN(format, ...) RSU_logger(L_LOG_WRN, format, ##__VA_ARGS__)
+#define RSU_LOG_WRN(format, ...) RSU_LOG(L_LOG_WRN, format, ##__VA_ARGS__)
 /** error log API */
-#define RSU_LOG_ERR(format, ...) RSU_logger(L_LOG_ERR, format, ##__VA_ARGS__)
+#define RSU_LOG_ERR(format, ...) RSU_LOG(L_LOG_ERR, format, ##__VA_ARGS__)
+
+/** minimum time between two messages of a rate limited log call */
+#define RSU_LOG_RATELIMIT_MS 1000
+
+/**
+ * @brief rate limited log API, for messages in per block loops
+ *
+ * Each call site logs at most one message every RSU_LOG_RATELIMIT_MS, the
+ * messages in between are dropped.
+ */
+#define RSU_LOG_RATELIMITED(level, log, format, ...)                                               \
+	do {                                                                                       \
+		static RSU_OSAL_U64 rsu_log_next;                                                  \
+		if (RSU_LOG_ENABLED(level) && RSU_log_ratelimit(&rsu_log_next)) {                  \
+			log(format, ##__VA_ARGS__);                                                \
+		}                                                                                  \
+	} while (0)
+
+/** rate limited debug log API */
+#define RSU_LOG_DBG_RATELIMITED(format, ...)                                                       \
+	RSU_LOG_RATELIMITED(L_LOG_DBG, RSU_LOG_DBG, format, ##__VA_ARGS__)
+/** rate limited info log API */
+#define RSU_LOG_INF_RATELIMITED(format, ...)                                                       \
+	RSU_LOG_RATELIMITED(L_LOG_INF, RSU_LOG_INF, format, ##__VA_ARGS__)
+
+/**
+ * @brief check and advance the deadline of a rate limited log call
+ *
+ * @param next time in nanoseconds before which the call site stays quiet
+ * @return true if the message should be logged.
+ */
+RSU_OSAL_BOOL RSU_log_ratelimit(RSU_OSAL_U64 *next);
 
 /**
  * @brief set logging level of logger system
@@ -63,10 +118,10 @@ RSU_OSAL_INT RSU_set_logging(rsu_loglevel_t level);
  *
  * @note for zephyr, the logging system is integrated with zephyr, so this function is redundant.
  *
- * @param cfg_file file to configuration file which provides parameters during initialization.
+ * @param config configuration parsed by the library, see @ref rsu_config.
  * @return 0 on success, negative number on error.
  */
-RSU_OSAL_INT RSU_logging_init(RSU_OSAL_CHAR *cfg_file);
+RSU_OSAL_INT RSU_logging_init(const struct rsu_config *config);
 
 /**
  * @brief exit logging
@@ -79,6 +134,9 @@ RSU_OSAL_VOID RSU_logging_exit(RSU_OSAL_VOID);
 /**
  * @brief logging function each platform needs to define
  *
+ * @note On Linux each message is formatted into a record of 256 bytes with its level prefix. A
+ * longer message is cut and ends with "..." to show it.
+ *
  * @param level logging level
  * @param format format string
  *
@@ -107,6 +165,9 @@ LOG_MODULE_DECLARE(uniLibRSU, CONFIG_UNILIBRSU_LOG_LEVEL);
 
 #undef RSU_LOG_ERR
 #define RSU_LOG_ERR(format, ...) LOG_ERR(format, ##__VA_ARGS__)
+
+#undef RSU_LOG_ENABLED
+#define RSU_LOG_ENABLED(level) ((level) <= L_LOG_LVL)
 #endif
 
 #ifdef __cplusplus
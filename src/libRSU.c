@@ -13,6 +13,14 @@
 #include <libRSU_cfg.h>
 #include <libRSU_misc.h>
 #include <libRSU_cb.h>
+#include <libRSU_archive.h>
+#include <libRSU_bench.h>
+#include <libRSU_digest.h>
+#include <libRSU_manifest.h>
+#include <libRSU_scratch.h>
+#include <libRSU_probe.h>
+#include <libRSU_stats.h>
+#include <libRSU_status.h>
 
 #include <version.h>
 #include <string.h>
@@ -24,6 +32,9 @@
 
 #define RSU_BUFFER_CHUNK_SIZE (0x1000)
 
+/* alignment of the caller buffer that rsu_slot_read() reads into directly */
+#define RSU_SLOT_READ_ALIGN (4)
+
 #ifndef DEFAULT_CFG_FILENAME
 #define DEFAULT_CFG_FILENAME "/etc/librsu.rc"
 #endif
@@ -31,17 +42,60 @@
 static struct rsu_context ctx;
 static struct librsu_hl_intf *intf = NULL;
 
-#define MUTEX_LOCK()   rsu_mutex_timedlock(&(ctx.mutex), RSU_TIME_FOREVER)
-#define MUTEX_UNLOCK() rsu_mutex_unlock(&(ctx.mutex))
+/* the wait for the library lock and the time it is held are counted in the statistics */
+#define MUTEX_LOCK()                                                                               \
+	do {                                                                                       \
+		RSU_OSAL_U64 lock_start = rsu_time_ns();                                           \
+		RSU_PROBE1(api__entry, __func__);                                                  \
+		rsu_mutex_timedlock(&(ctx.mutex), RSU_TIME_FOREVER);                               \
+		ctx.locked_at = rsu_time_ns();                                                     \
+		librsu_stats_add(RSU_STATS_LOCK_WAIT, ctx.locked_at - lock_start, 0, 0);           \
+	} while (0)
+#define MUTEX_UNLOCK()                                                                             \
+	do {                                                                                       \
+		RSU_OSAL_U64 locked = rsu_time_ns() - ctx.locked_at;                               \
+		librsu_stats_add(RSU_STATS_API, locked, 0, 0);                                     \
+		rsu_mutex_unlock(&(ctx.mutex));                                                    \
+		RSU_PROBE2(api__return, __func__, locked);                                         \
+	} while (0)
 
 RSU_OSAL_U32 rsu_get_version(RSU_OSAL_VOID)
 {
 	return ((rsu_poc_verion_major & 0xFFFF) << 16) | ((rsu_poc_verion_minor & 0xFFFF));
 }
 
-RSU_OSAL_INT librsu_init(RSU_OSAL_CHAR *filename)
+RSU_OSAL_INT librsu_set_allocator(rsu_malloc_hook alloc, rsu_free_hook release)
+{
+	if (ctx.state != un_initialized) {
+		RSU_LOG_ERR("Allocator can only be changed before librsu_init()");
+		return -ELIB;
+	}
+
+	if ((alloc == NULL) != (release == NULL)) {
+		RSU_LOG_ERR("Both allocation and release functions are needed");
+		return -EARGS;
+	}
+
+	rsu_set_allocator(alloc, release);
+
+	return 0;
+}
+
+static RSU_OSAL_VOID *repair_worker(RSU_OSAL_VOID *arg)
+{
+	(RSU_OSAL_VOID)arg;
+
+	MUTEX_LOCK();
+	if (intf->repair_ops.run()) {
+		RSU_LOG_ERR("Background repair of SPT/CPB failed");
+	}
+	MUTEX_UNLOCK();
+
+	return NULL;
+}
+
+static RSU_OSAL_INT librsu_init_common(RSU_OSAL_CHAR *filename, const struct rsu_config *config)
 {
-	RSU_OSAL_CHAR *cfg_filename = NULL;
 	RSU_OSAL_INT ret = 0;
 
 	if (ctx.state != un_initialized) {
@@ -51,12 +105,6 @@ RSU_OSAL_INT librsu_init(RSU_OSAL_CHAR *filename)
 
 	ctx.state = in_progress;
 
-	if (!filename || filename[0] == '\0') {
-		cfg_filename = DEFAULT_CFG_FILENAME;
-	} else {
-		cfg_filename = filename;
-	}
-
 	ret = rsu_mutex_init(&(ctx.mutex));
 	if (ret < 0) {
 		ctx.state = un_initialized;
@@ -64,19 +112,66 @@ RSU_OSAL_INT librsu_init(RSU_OSAL_CHAR *filename)
 		return -ECFG;
 	}
 
-	ret = librsu_cfg_parse(cfg_filename, &intf);
+	ret = librsu_scratch_init();
 	if (ret) {
+		ctx.state = un_initialized;
+		RSU_LOG_ERR("Error in allocating scratch buffers %d", ret);
+		return -ECFG;
+	}
+
+	ret = librsu_cfg_parse(filename, config, &intf);
+	if (ret) {
+		librsu_scratch_exit();
 		ctx.state = un_initialized;
 		RSU_LOG_ERR("error in configuring libRSU %d", ret);
 		return -ECFG;
 	}
 
+	ret = librsu_status_watch_init();
+	if (ret) {
+		intf->close();
+		intf = NULL;
+		librsu_cfg_reset();
+		librsu_scratch_exit();
+		ctx.state = un_initialized;
+		RSU_LOG_ERR("Error in initializing status watch %d", ret);
+		return -ECFG;
+	}
+
+	if (intf->repair_ops.pending() && librsu_cfg_metadata_repair() == RSU_REPAIR_BACKGROUND) {
+		ret = rsu_thread_create(&ctx.repair_thread, repair_worker, NULL);
+		if (ret) {
+			RSU_LOG_WRN("Unable to start the repair worker %d, repairing on next write",
+				    ret);
+		} else {
+			ctx.repair_started = true;
+		}
+	}
+
 	ctx.state = initialized;
 	RSU_LOG_DBG("libRSU initialization completed \n");
 
 	return 0;
 }
 
+RSU_OSAL_INT librsu_init(RSU_OSAL_CHAR *filename)
+{
+	if (!filename || filename[0] == '\0') {
+		filename = DEFAULT_CFG_FILENAME;
+	}
+
+	return librsu_init_common(filename, NULL);
+}
+
+RSU_OSAL_INT librsu_init_with_config(const struct rsu_config *config)
+{
+	if (!config) {
+		return -EARGS;
+	}
+
+	return librsu_init_common(NULL, config);
+}
+
 RSU_OSAL_VOID librsu_exit(RSU_OSAL_VOID)
 {
 	if (ctx.state != initialized) {
@@ -86,11 +181,17 @@ RSU_OSAL_VOID librsu_exit(RSU_OSAL_VOID)
 
 	ctx.state = in_progress;
 	RSU_LOG_DBG("libRSU exit started");
+	librsu_status_watch_exit();
+	if (ctx.repair_started) {
+		rsu_thread_join(&ctx.repair_thread, NULL);
+		ctx.repair_started = false;
+	}
 	rsu_mutex_destroy(&(ctx.mutex));
 
 	intf->close();
 	intf = NULL;
 	librsu_cfg_reset();
+	librsu_scratch_exit();
 
 	ctx.state = un_initialized;
 	RSU_LOG_DBG("libRSU exit completed");
@@ -155,6 +256,39 @@ RSU_OSAL_INT rsu_status_log(struct rsu_status_info *info)
 	return 0;
 }
 
+RSU_OSAL_INT rsu_status_wait(RSU_OSAL_U32 timeout, struct rsu_status_info *info)
+{
+	if (ctx.state != initialized) {
+		RSU_LOG_ERR("Library not initialized");
+		return -ELIB;
+	}
+
+	if (!info) {
+		return -EARGS;
+	}
+
+	return librsu_status_wait(timeout, info);
+}
+
+RSU_OSAL_INT rsu_repair_metadata(RSU_OSAL_VOID)
+{
+	if (ctx.state != initialized) {
+		RSU_LOG_ERR("Library not initialized");
+		return -ELIB;
+	}
+
+	MUTEX_LOCK();
+
+	if (intf->repair_ops.run()) {
+		RSU_LOG_ERR("Unable to repair SPT/CPB");
+		MUTEX_UNLOCK();
+		return -ELOWLEVEL;
+	}
+
+	MUTEX_UNLOCK();
+	return 0;
+}
+
 RSU_OSAL_INT rsu_clear_error_status(RSU_OSAL_VOID)
 {
 	if (ctx.state != initialized) {
@@ -440,6 +574,12 @@ RSU_OSAL_INT rsu_slot_erase(RSU_OSAL_INT slot)
 		return -ELOWLEVEL;
 	}
 
+	if (librsu_manifest_invalidate(intf, part_num)) {
+		RSU_LOG_ERR("Unable to update the digest manifest");
+		MUTEX_UNLOCK();
+		return -EFILEIO;
+	}
+
 	if (intf->data.erase(part_num)) {
 		MUTEX_UNLOCK();
 		return -ELOWLEVEL;
@@ -449,6 +589,87 @@ RSU_OSAL_INT rsu_slot_erase(RSU_OSAL_INT slot)
 	return 0;
 }
 
+RSU_OSAL_INT rsu_bench(RSU_OSAL_INT scratch, struct rsu_bench *result)
+{
+	RSU_OSAL_INT part_num = -1;
+	RSU_OSAL_INT rtn;
+
+	if (ctx.state != initialized) {
+		RSU_LOG_ERR("Library not initialized");
+		return -ELIB;
+	}
+
+	if (result == NULL) {
+		RSU_LOG_ERR("result is NULL");
+		return -EARGS;
+	}
+
+	MUTEX_LOCK();
+
+	if (intf->spt_ops.corrupted()) {
+		RSU_LOG_ERR("corrupted SPT");
+		MUTEX_UNLOCK();
+		return -ECORRUPTED_SPT;
+	}
+
+	if (scratch >= 0) {
+		if (intf->cpb_ops.corrupted()) {
+			RSU_LOG_ERR("corrupted CPB");
+			MUTEX_UNLOCK();
+			return -ECORRUPTED_CPB;
+		}
+
+		if (librsu_cfg_writeprotected(scratch)) {
+			RSU_LOG_ERR("Trying to use a write protected slot as scratch");
+			MUTEX_UNLOCK();
+			return -EWRPROT;
+		}
+
+		part_num = librsu_misc_slot2part(intf, scratch);
+		if (part_num < 0) {
+			MUTEX_UNLOCK();
+			return -ESLOTNUM;
+		}
+
+		if (intf->priority.get(part_num) > 0) {
+			RSU_LOG_ERR("Trying to use a slot in use as scratch");
+			MUTEX_UNLOCK();
+			return -EPROGRAM;
+		}
+	}
+
+	rtn = librsu_bench_run(intf, part_num, result);
+
+	MUTEX_UNLOCK();
+	return rtn;
+}
+
+RSU_OSAL_INT rsu_get_stats(struct rsu_stats *stats)
+{
+	if (stats == NULL) {
+		RSU_LOG_ERR("stats is NULL");
+		return -EARGS;
+	}
+
+	librsu_stats_get(stats);
+	return 0;
+}
+
+RSU_OSAL_INT rsu_reset_stats(RSU_OSAL_VOID)
+{
+	librsu_stats_reset();
+	return 0;
+}
+
+const RSU_OSAL_CHAR *rsu_stats_name(RSU_OSAL_INT op)
+{
+	if (op < 0 || op >= RSU_STATS_OPS) {
+		return NULL;
+	}
+
+	return librsu_stats_name((enum rsu_stats_op)op);
+}
+
 RSU_OSAL_INT rsu_slot_program_buf(RSU_OSAL_INT slot, RSU_OSAL_VOID *buf, RSU_OSAL_INT size)
 {
 	RSU_OSAL_INT rtn;
@@ -478,6 +699,16 @@ RSU_OSAL_INT rsu_slot_program_buf(RSU_OSAL_INT slot, RSU_OSAL_VOID *buf, RSU_OSA
 		return -EARGS;
 	}
 
+	if (librsu_cfg_program_preflight()) {
+		rtn = librsu_cb_validate_common(intf, slot, librsu_cb_buf);
+		if (rtn) {
+			librsu_cb_buf_cleanup();
+			MUTEX_UNLOCK();
+			return rtn;
+		}
+		librsu_cb_buf_init(buf, size);
+	}
+
 	rtn = librsu_cb_program_common(intf, slot, librsu_cb_buf, 0);
 
 	librsu_cb_buf_cleanup();
@@ -529,12 +760,25 @@ RSU_OSAL_INT rsu_slot_program_file(RSU_OSAL_INT slot, RSU_OSAL_CHAR *filename)
 		return -ECORRUPTED_CPB;
 	}
 
-	if (librsu_cb_file_init(filename)) {
+	if (librsu_cb_file_init(filename, 0)) {
 		RSU_LOG_ERR("Unable to open file '%s'", filename);
 		MUTEX_UNLOCK();
 		return -EFILEIO;
 	}
 
+	if (librsu_cfg_program_preflight()) {
+		rtn = librsu_cb_validate_common(intf, slot, librsu_cb_file);
+		if (rtn == 0 && librsu_cb_file_init(filename, 0)) {
+			RSU_LOG_ERR("Unable to reopen file '%s'", filename);
+			rtn = -EFILEIO;
+		}
+		if (rtn) {
+			librsu_cb_file_cleanup();
+			MUTEX_UNLOCK();
+			return rtn;
+		}
+	}
+
 	rtn = librsu_cb_program_common(intf, slot, librsu_cb_file, 0);
 
 	librsu_cb_file_cleanup();
@@ -612,7 +856,7 @@ RSU_OSAL_INT rsu_slot_program_file_raw(RSU_OSAL_INT slot, RSU_OSAL_CHAR *filenam
 		return -ECORRUPTED_SPT;
 	}
 
-	if (librsu_cb_file_init(filename)) {
+	if (librsu_cb_file_init(filename, 1)) {
 		RSU_LOG_ERR("Unable to open file '%s'", filename);
 		MUTEX_UNLOCK();
 		return -EFILEIO;
@@ -626,6 +870,68 @@ RSU_OSAL_INT rsu_slot_program_file_raw(RSU_OSAL_INT slot, RSU_OSAL_CHAR *filenam
 	return rtn;
 }
 
+RSU_OSAL_INT rsu_image_validate_buf(RSU_OSAL_INT slot, RSU_OSAL_VOID *buf, RSU_OSAL_INT size)
+{
+	RSU_OSAL_INT rtn;
+
+	if (ctx.state != initialized) {
+		RSU_LOG_ERR("Library not initialized");
+		return -ELIB;
+	}
+
+	MUTEX_LOCK();
+
+	if (intf->spt_ops.corrupted()) {
+		RSU_LOG_ERR("corrupted SPT");
+		MUTEX_UNLOCK();
+		return -ECORRUPTED_SPT;
+	}
+
+	if (librsu_cb_buf_init(buf, size)) {
+		RSU_LOG_ERR("Bad buf/size arguments");
+		MUTEX_UNLOCK();
+		return -EARGS;
+	}
+
+	rtn = librsu_cb_validate_common(intf, slot, librsu_cb_buf);
+
+	librsu_cb_buf_cleanup();
+
+	MUTEX_UNLOCK();
+	return rtn;
+}
+
+RSU_OSAL_INT rsu_image_validate_file(RSU_OSAL_INT slot, RSU_OSAL_CHAR *filename)
+{
+	RSU_OSAL_INT rtn;
+
+	if (ctx.state != initialized) {
+		RSU_LOG_ERR("Library not initialized");
+		return -ELIB;
+	}
+
+	MUTEX_LOCK();
+
+	if (intf->spt_ops.corrupted()) {
+		RSU_LOG_ERR("corrupted SPT");
+		MUTEX_UNLOCK();
+		return -ECORRUPTED_SPT;
+	}
+
+	if (librsu_cb_file_init(filename, 0)) {
+		RSU_LOG_ERR("Unable to open file '%s'", filename);
+		MUTEX_UNLOCK();
+		return -EFILEIO;
+	}
+
+	rtn = librsu_cb_validate_common(intf, slot, librsu_cb_file);
+
+	librsu_cb_file_cleanup();
+
+	MUTEX_UNLOCK();
+	return rtn;
+}
+
 RSU_OSAL_INT rsu_slot_verify_buf(RSU_OSAL_INT slot, RSU_OSAL_VOID *buf, RSU_OSAL_INT size)
 {
 	RSU_OSAL_INT rtn;
@@ -687,7 +993,7 @@ RSU_OSAL_INT rsu_slot_verify_file(RSU_OSAL_INT slot, RSU_OSAL_CHAR *filename)
 		return -ECORRUPTED_CPB;
 	}
 
-	if (librsu_cb_file_init(filename)) {
+	if (librsu_cb_file_init(filename, 0)) {
 		RSU_LOG_ERR("Unable to open file '%s'", filename);
 		MUTEX_UNLOCK();
 		return -EFILEIO;
@@ -751,7 +1057,7 @@ RSU_OSAL_INT rsu_slot_verify_file_raw(RSU_OSAL_INT slot, RSU_OSAL_CHAR *filename
 		return -ECORRUPTED_SPT;
 	}
 
-	if (librsu_cb_file_init(filename)) {
+	if (librsu_cb_file_init(filename, 1)) {
 		RSU_LOG_ERR("Unable to open file '%s'", filename);
 		MUTEX_UNLOCK();
 		return -EFILEIO;
@@ -766,6 +1072,22 @@ RSU_OSAL_INT rsu_slot_verify_file_raw(RSU_OSAL_INT slot, RSU_OSAL_CHAR *filename
 	return rtn;
 }
 
+RSU_OSAL_INT rsu_set_progress_callback(rsu_progress_callback progress, RSU_OSAL_VOID *arg)
+{
+	if (ctx.state != initialized) {
+		RSU_LOG_ERR("Library not initialized");
+		return -ELIB;
+	}
+
+	MUTEX_LOCK();
+
+	librsu_cb_progress_set(progress, arg);
+
+	MUTEX_UNLOCK();
+
+	return 0;
+}
+
 RSU_OSAL_INT rsu_slot_program_callback(RSU_OSAL_INT slot, rsu_data_callback callback)
 {
 	RSU_OSAL_INT rtn;
@@ -854,23 +1176,23 @@ RSU_OSAL_INT rsu_slot_copy_to_file(RSU_OSAL_INT slot, RSU_OSAL_CHAR *filename)
 
 	MUTEX_LOCK();
 
-	buf = rsu_malloc(RSU_BUFFER_CHUNK_SIZE);
+	buf = librsu_scratch_get(RSU_BUFFER_CHUNK_SIZE);
 	if (buf == NULL) {
 		MUTEX_UNLOCK();
 		return -ENOMEM;
 	}
 
-	fill = rsu_malloc(RSU_BUFFER_CHUNK_SIZE);
+	fill = librsu_scratch_get(RSU_BUFFER_CHUNK_SIZE);
 	if (fill == NULL) {
-		rsu_free(buf);
+		librsu_scratch_put(buf);
 		MUTEX_UNLOCK();
 		return -ENOMEM;
 	}
 
 	if (filename == NULL) {
 		RSU_LOG_ERR("filename is NULL");
-		rsu_free(buf);
-		rsu_free(fill);
+		librsu_scratch_put(buf);
+		librsu_scratch_put(fill);
 		MUTEX_UNLOCK();
 		return -EARGS;
 	}
@@ -878,32 +1200,32 @@ RSU_OSAL_INT rsu_slot_copy_to_file(RSU_OSAL_INT slot, RSU_OSAL_CHAR *filename)
 	part_num = librsu_misc_slot2part(intf, slot);
 	if (part_num < 0) {
 		RSU_LOG_ERR("slot is not usable");
-		rsu_free(buf);
-		rsu_free(fill);
+		librsu_scratch_put(buf);
+		librsu_scratch_put(fill);
 		MUTEX_UNLOCK();
 		return -ESLOTNUM;
 	}
 
 	if (intf->spt_ops.corrupted()) {
 		RSU_LOG_ERR("corrupted SPT");
-		rsu_free(buf);
-		rsu_free(fill);
+		librsu_scratch_put(buf);
+		librsu_scratch_put(fill);
 		MUTEX_UNLOCK();
 		return -ECORRUPTED_SPT;
 	}
 
 	if (intf->cpb_ops.corrupted()) {
 		RSU_LOG_ERR("corrupted CPB");
-		rsu_free(buf);
-		rsu_free(fill);
+		librsu_scratch_put(buf);
+		librsu_scratch_put(fill);
 		MUTEX_UNLOCK();
 		return -ECORRUPTED_CPB;
 	}
 
 	if (intf->priority.get(part_num) <= 0) {
 		RSU_LOG_ERR("Trying to read an erased slot");
-		rsu_free(buf);
-		rsu_free(fill);
+		librsu_scratch_put(buf);
+		librsu_scratch_put(fill);
 		MUTEX_UNLOCK();
 		return -EERASE;
 	}
@@ -911,8 +1233,8 @@ RSU_OSAL_INT rsu_slot_copy_to_file(RSU_OSAL_INT slot, RSU_OSAL_CHAR *filename)
 	df = intf->file.open(filename, RSU_FILE_WRITE);
 	if (df == NULL) {
 		RSU_LOG_ERR("Unable to open output file '%s'", filename);
-		rsu_free(buf);
-		rsu_free(fill);
+		librsu_scratch_put(buf);
+		librsu_scratch_put(fill);
 		MUTEX_UNLOCK();
 		return -EFILEIO;
 	}
@@ -920,8 +1242,8 @@ RSU_OSAL_INT rsu_slot_copy_to_file(RSU_OSAL_INT slot, RSU_OSAL_CHAR *filename)
 	if (intf->file.ftruncate(0, df) < 0) {
 		RSU_LOG_ERR("Unable to truncate file '%s' to length zero", filename);
 		intf->file.close(df);
-		rsu_free(buf);
-		rsu_free(fill);
+		librsu_scratch_put(buf);
+		librsu_scratch_put(fill);
 		MUTEX_UNLOCK();
 		return -EFILEIO;
 	}
@@ -938,8 +1260,8 @@ RSU_OSAL_INT rsu_slot_copy_to_file(RSU_OSAL_INT slot, RSU_OSAL_CHAR *filename)
 			RSU_LOG_ERR("Unable to rd slot %i, offs 0x%08x, cnt %i", slot,
 				    (RSU_OSAL_U32)offset, RSU_BUFFER_CHUNK_SIZE);
 			intf->file.close(df);
-			rsu_free(buf);
-			rsu_free(fill);
+			librsu_scratch_put(buf);
+			librsu_scratch_put(fill);
 			MUTEX_UNLOCK();
 			return -ELOWLEVEL;
 		}
@@ -960,8 +1282,8 @@ RSU_OSAL_INT rsu_slot_copy_to_file(RSU_OSAL_INT slot, RSU_OSAL_CHAR *filename)
 				    RSU_BUFFER_CHUNK_SIZE) {
 					RSU_LOG_ERR("Unable to wr to '%s'", filename);
 					intf->file.close(df);
-					rsu_free(buf);
-					rsu_free(fill);
+					librsu_scratch_put(buf);
+					librsu_scratch_put(fill);
 					MUTEX_UNLOCK();
 					return -EFILEIO;
 				}
@@ -972,8 +1294,8 @@ RSU_OSAL_INT rsu_slot_copy_to_file(RSU_OSAL_INT slot, RSU_OSAL_CHAR *filename)
 			    RSU_BUFFER_CHUNK_SIZE) {
 				RSU_LOG_ERR("Unable to wr to file '%s'", filename);
 				intf->file.close(df);
-				rsu_free(buf);
-				rsu_free(fill);
+				librsu_scratch_put(buf);
+				librsu_scratch_put(fill);
 				MUTEX_UNLOCK();
 				return -EFILEIO;
 			}
@@ -985,12 +1307,309 @@ RSU_OSAL_INT rsu_slot_copy_to_file(RSU_OSAL_INT slot, RSU_OSAL_CHAR *filename)
 	}
 
 	intf->file.close(df);
-	rsu_free(buf);
-	rsu_free(fill);
+	librsu_scratch_put(buf);
+	librsu_scratch_put(fill);
 	MUTEX_UNLOCK();
 	return 0;
 }
 
+RSU_OSAL_INT rsu_slot_copy_to_file_compressed(RSU_OSAL_INT slot, RSU_OSAL_CHAR *filename)
+{
+	RSU_OSAL_INT part_num;
+	RSU_OSAL_FILE *df;
+	RSU_OSAL_INT rtn;
+
+	if (ctx.state != initialized) {
+		RSU_LOG_ERR("Library not initialized");
+		return -ELIB;
+	}
+
+	if (filename == NULL) {
+		RSU_LOG_ERR("filename is NULL");
+		return -EARGS;
+	}
+
+	MUTEX_LOCK();
+
+	part_num = librsu_misc_slot2part(intf, slot);
+	if (part_num < 0) {
+		RSU_LOG_ERR("slot is not usable");
+		MUTEX_UNLOCK();
+		return -ESLOTNUM;
+	}
+
+	if (intf->spt_ops.corrupted()) {
+		RSU_LOG_ERR("corrupted SPT");
+		MUTEX_UNLOCK();
+		return -ECORRUPTED_SPT;
+	}
+
+	if (intf->cpb_ops.corrupted()) {
+		RSU_LOG_ERR("corrupted CPB");
+		MUTEX_UNLOCK();
+		return -ECORRUPTED_CPB;
+	}
+
+	if (intf->priority.get(part_num) <= 0) {
+		RSU_LOG_ERR("Trying to read an erased slot");
+		MUTEX_UNLOCK();
+		return -EERASE;
+	}
+
+	df = intf->file.open(filename, RSU_FILE_WRITE);
+	if (df == NULL) {
+		RSU_LOG_ERR("Unable to open output file '%s'", filename);
+		MUTEX_UNLOCK();
+		return -EFILEIO;
+	}
+
+	if (intf->file.ftruncate(0, df) < 0) {
+		RSU_LOG_ERR("Unable to truncate file '%s' to length zero", filename);
+		intf->file.close(df);
+		MUTEX_UNLOCK();
+		return -EFILEIO;
+	}
+
+	rtn = librsu_archive_write(intf, part_num, df);
+
+	intf->file.close(df);
+	MUTEX_UNLOCK();
+	return rtn;
+}
+
+/*
+ * slot_read_direct() - read a range of a partition into the caller buffer
+ *
+ * The word aligned middle of the buffer is read straight from the flash, only
+ * the unaligned head and tail go through a bounce buffer.
+ */
+static RSU_OSAL_INT slot_read_direct(RSU_OSAL_INT part_num, RSU_OSAL_U32 offset, RSU_OSAL_U32 len,
+				     RSU_OSAL_U8 *dst)
+{
+	RSU_OSAL_U8 bounce[RSU_SLOT_READ_ALIGN];
+	RSU_OSAL_U32 head, body, cnt;
+
+	head = (RSU_SLOT_READ_ALIGN - ((uintptr_t)dst & (RSU_SLOT_READ_ALIGN - 1))) &
+	       (RSU_SLOT_READ_ALIGN - 1);
+	if (head > len) {
+		head = len;
+	}
+	body = (len - head) & ~(RSU_OSAL_U32)(RSU_SLOT_READ_ALIGN - 1);
+
+	while (len) {
+		if (head) {
+			cnt = head;
+		} else if (body) {
+			cnt = body < RSU_SLOT_READ_CHUNK_SIZE ? body : RSU_SLOT_READ_CHUNK_SIZE;
+		} else {
+			cnt = len;
+		}
+
+		if (intf->data.read(part_num, offset, cnt, (head || !body) ? bounce : dst)) {
+			RSU_LOG_ERR("Unable to rd part %i, offs 0x%08x, cnt %u", part_num, offset,
+				    cnt);
+			return -ELOWLEVEL;
+		}
+
+		if (head || !body) {
+			rsu_memcpy(dst, bounce, cnt);
+			head = 0;
+		} else {
+			body -= cnt;
+		}
+
+		dst += cnt;
+		offset += cnt;
+		len -= cnt;
+	}
+
+	return 0;
+}
+
+RSU_OSAL_INT rsu_slot_read(RSU_OSAL_INT slot, RSU_OSAL_U32 offset, RSU_OSAL_U32 len,
+			   RSU_OSAL_VOID *buf)
+{
+	RSU_OSAL_INT part_num;
+	RSU_OSAL_INT part_size;
+	RSU_OSAL_INT rtn;
+
+	if (ctx.state != initialized) {
+		RSU_LOG_ERR("Library not initialized");
+		return -ELIB;
+	}
+
+	if (buf == NULL) {
+		RSU_LOG_ERR("buffer is NULL");
+		return -EARGS;
+	}
+
+	MUTEX_LOCK();
+
+	if (intf->spt_ops.corrupted()) {
+		RSU_LOG_ERR("corrupted SPT");
+		MUTEX_UNLOCK();
+		return -ECORRUPTED_SPT;
+	}
+
+	part_num = librsu_misc_slot2part(intf, slot);
+	if (part_num < 0) {
+		RSU_LOG_ERR("slot is not usable");
+		MUTEX_UNLOCK();
+		return -ESLOTNUM;
+	}
+
+	part_size = intf->partition.size(part_num);
+	if (part_size < 0) {
+		RSU_LOG_ERR("error while reading the part size");
+		MUTEX_UNLOCK();
+		return -ELOWLEVEL;
+	}
+
+	if (offset > (RSU_OSAL_U32)part_size || len > (RSU_OSAL_U32)part_size - offset) {
+		RSU_LOG_ERR("read of %u bytes @0x%08x is outside of the slot", len, offset);
+		MUTEX_UNLOCK();
+		return -EARGS;
+	}
+
+	rtn = slot_read_direct(part_num, offset, len, buf);
+
+	MUTEX_UNLOCK();
+	return rtn;
+}
+
+RSU_OSAL_INT rsu_slot_read_callback(RSU_OSAL_INT slot, rsu_sink_callback sink, RSU_OSAL_VOID *arg)
+{
+	RSU_OSAL_INT part_num;
+	RSU_OSAL_INT part_size;
+	RSU_OSAL_INT rtn;
+
+	if (ctx.state != initialized) {
+		RSU_LOG_ERR("Library not initialized");
+		return -ELIB;
+	}
+
+	if (sink == NULL) {
+		RSU_LOG_ERR("callback is NULL");
+		return -EARGS;
+	}
+
+	MUTEX_LOCK();
+
+	if (intf->spt_ops.corrupted()) {
+		RSU_LOG_ERR("corrupted SPT");
+		MUTEX_UNLOCK();
+		return -ECORRUPTED_SPT;
+	}
+
+	part_num = librsu_misc_slot2part(intf, slot);
+	if (part_num < 0) {
+		RSU_LOG_ERR("slot is not usable");
+		MUTEX_UNLOCK();
+		return -ESLOTNUM;
+	}
+
+	part_size = intf->partition.size(part_num);
+	if (part_size < 0) {
+		RSU_LOG_ERR("error while reading the part size");
+		MUTEX_UNLOCK();
+		return -ELOWLEVEL;
+	}
+
+	rtn = librsu_cb_read_common(intf, part_num, 0, part_size, sink, arg);
+
+	MUTEX_UNLOCK();
+	return rtn;
+}
+
+RSU_OSAL_INT rsu_slot_digest(RSU_OSAL_INT slot, RSU_OSAL_INT alg, RSU_OSAL_U8 *out)
+{
+	RSU_OSAL_INT part_num;
+	RSU_OSAL_INT rtn;
+
+	if (ctx.state != initialized) {
+		RSU_LOG_ERR("Library not initialized");
+		return -ELIB;
+	}
+
+	if (out == NULL || librsu_digest_size(alg) < 0 ||
+	    (alg & ~(RSU_DIGEST_ALG_MASK | RSU_DIGEST_TRIM_ERASED))) {
+		RSU_LOG_ERR("Bad digest arguments");
+		return -EARGS;
+	}
+
+	MUTEX_LOCK();
+
+	if (intf->spt_ops.corrupted()) {
+		RSU_LOG_ERR("corrupted SPT");
+		MUTEX_UNLOCK();
+		return -ECORRUPTED_SPT;
+	}
+
+	part_num = librsu_misc_slot2part(intf, slot);
+	if (part_num < 0) {
+		RSU_LOG_ERR("slot is not usable");
+		MUTEX_UNLOCK();
+		return -ESLOTNUM;
+	}
+
+	rtn = librsu_digest_slot(intf, part_num, alg, out);
+
+	MUTEX_UNLOCK();
+	return rtn;
+}
+
+RSU_OSAL_INT rsu_slot_matches_digest(RSU_OSAL_INT slot, RSU_OSAL_INT alg,
+				     const RSU_OSAL_U8 *digest, RSU_OSAL_INT flags)
+{
+	RSU_OSAL_U8 actual[RSU_DIGEST_SHA384_SIZE];
+	RSU_OSAL_INT part_num;
+	RSU_OSAL_INT rtn;
+
+	if (ctx.state != initialized) {
+		RSU_LOG_ERR("Library not initialized");
+		return -ELIB;
+	}
+
+	if (digest == NULL || librsu_digest_size(alg) < 0 ||
+	    (alg & ~(RSU_DIGEST_ALG_MASK | RSU_DIGEST_TRIM_ERASED)) ||
+	    (flags & ~RSU_MATCH_FALLBACK_VERIFY)) {
+		RSU_LOG_ERR("Bad digest arguments");
+		return -EARGS;
+	}
+
+	MUTEX_LOCK();
+
+	if (intf->spt_ops.corrupted()) {
+		RSU_LOG_ERR("corrupted SPT");
+		MUTEX_UNLOCK();
+		return -ECORRUPTED_SPT;
+	}
+
+	part_num = librsu_misc_slot2part(intf, slot);
+	if (part_num < 0) {
+		RSU_LOG_ERR("slot is not usable");
+		MUTEX_UNLOCK();
+		return -ESLOTNUM;
+	}
+
+	rtn = librsu_manifest_lookup(intf, part_num, alg, actual);
+	if (rtn == -ENODIGEST && (flags & RSU_MATCH_FALLBACK_VERIFY)) {
+		RSU_LOG_DBG("no digest recorded for slot %i, reading it back", slot);
+		rtn = librsu_digest_slot(intf, part_num, alg, actual);
+		if (rtn == 0) {
+			librsu_manifest_store(intf, part_num, alg, actual);
+		}
+	}
+
+	MUTEX_UNLOCK();
+
+	if (rtn) {
+		return rtn;
+	}
+
+	return memcmp(actual, digest, librsu_digest_size(alg)) == 0 ? 1 : 0;
+}
+
 RSU_OSAL_INT rsu_slot_disable(RSU_OSAL_INT slot)
 {
 	RSU_OSAL_INT part_num;
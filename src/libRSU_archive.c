@@ -0,0 +1,507 @@
+/*
+ * Copyright (C) 2023-2024 Intel Corporation
+ * SPDX-License-Identifier: MIT-0
+ */
+
+#include <libRSU_archive.h>
+#include <libRSU_cfg.h>
+#include <libRSU_image.h>
+#include <libRSU_ll_intf.h>
+#include <utils/RSU_logging.h>
+
+#ifdef RSU_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#define ARCHIVE_INDEX_SZ(n) ((n) * (RSU_OSAL_U32)sizeof(struct rsu_archive_chunk))
+
+/* shorter 0xFF runs cost less to store than a segment header */
+#define ARCHIVE_RLE_MIN_RUN 32
+
+struct archive_reader {
+	RSU_OSAL_FILE *file;
+	struct rsu_archive_header hdr;
+	struct rsu_archive_chunk *index;
+	RSU_OSAL_U8 *chunk;
+	RSU_OSAL_U8 *zbuf;
+	RSU_OSAL_U8 *rbuf;
+	RSU_OSAL_U32 next;
+	RSU_OSAL_U32 pos;
+	RSU_OSAL_U32 avail;
+	RSU_OSAL_U32 used;
+};
+
+static struct archive_reader reader;
+
+static RSU_OSAL_INT archive_read_full(struct librsu_ll_intf *hal, RSU_OSAL_FILE *file,
+				      RSU_OSAL_VOID *buf, RSU_OSAL_U32 len)
+{
+	RSU_OSAL_U32 cnt = 0;
+	RSU_OSAL_INT c;
+
+	while (cnt < len) {
+		c = hal->file.read((RSU_OSAL_U8 *)buf + cnt, len - cnt, file);
+		if (c <= 0) {
+			return -EIO;
+		}
+		cnt += c;
+	}
+
+	return 0;
+}
+
+static RSU_OSAL_U32 archive_chunk_len(const struct rsu_archive_header *hdr, RSU_OSAL_U32 chunk)
+{
+	RSU_OSAL_U32 start = chunk * hdr->chunk_size;
+
+	if (hdr->slot_size - start < hdr->chunk_size) {
+		return hdr->slot_size - start;
+	}
+
+	return hdr->chunk_size;
+}
+
+static RSU_OSAL_U32 archive_crc(struct rsu_archive_header *hdr, struct rsu_archive_chunk *index)
+{
+	RSU_OSAL_U32 saved = hdr->crc;
+	RSU_OSAL_U32 crc;
+
+	hdr->crc = 0;
+	crc = rsu_crc32(0, (RSU_OSAL_U8 *)hdr, sizeof(*hdr));
+	crc = rsu_crc32(crc, (RSU_OSAL_U8 *)index, ARCHIVE_INDEX_SZ(hdr->chunks));
+	hdr->crc = saved;
+
+	return crc;
+}
+
+/*
+ * archive_deflate() - try to compress a chunk into zbuf
+ *
+ * Return: compressed length, or 0 when the data does not shrink or zlib is
+ * not available on this platform.
+ */
+static RSU_OSAL_U32 archive_deflate(RSU_OSAL_U8 *zbuf, const RSU_OSAL_U8 *buf, RSU_OSAL_U32 len)
+{
+#ifdef RSU_HAVE_ZLIB
+	uLongf zlen = len - 1;
+
+	if (len < 2 || compress2(zbuf, &zlen, buf, len, Z_DEFAULT_COMPRESSION) != Z_OK) {
+		return 0;
+	}
+
+	return (RSU_OSAL_U32)zlen;
+#else
+	return 0;
+#endif
+}
+
+/*
+ * archive_inflate() - uncompress zbuf into buf
+ *
+ * @len: size of buf on entry, uncompressed length on return
+ */
+static RSU_OSAL_INT archive_inflate(RSU_OSAL_U8 *buf, RSU_OSAL_U32 *len, const RSU_OSAL_U8 *zbuf,
+				    RSU_OSAL_U32 zlen)
+{
+#ifdef RSU_HAVE_ZLIB
+	uLongf dlen = *len;
+
+	if (uncompress(buf, &dlen, zbuf, zlen) != Z_OK) {
+		return -EINVAL;
+	}
+
+	*len = (RSU_OSAL_U32)dlen;
+	return 0;
+#else
+	RSU_LOG_ERR("compressed chunk found but zlib support is not built in");
+	return -ENOTSUP;
+#endif
+}
+
+/*
+ * archive_rle() - run length encode the erased runs of a chunk into rbuf
+ *
+ * The output is a sequence of segments, each made of the count of 0xFF bytes
+ * to skip, the count of data bytes and the data bytes themselves.
+ *
+ * Return: encoded length, or 0 when the encoding does not shrink the data.
+ */
+static RSU_OSAL_U32 archive_rle(RSU_OSAL_U8 *rbuf, RSU_OSAL_U8 *buf, RSU_OSAL_U32 len)
+{
+	RSU_OSAL_U32 seg[2];
+	RSU_OSAL_U32 pos = 0;
+	RSU_OSAL_U32 out = 0;
+	RSU_OSAL_U32 start, run, x;
+
+	while (pos < len) {
+		for (x = pos; x < len && buf[x] == 0xFF; x++) {
+		}
+		start = (x - pos < ARCHIVE_RLE_MIN_RUN) ? pos : x;
+
+		/* data runs up to the next long enough 0xFF run */
+		run = 0;
+		for (x = start; x < len; x++) {
+			run = (buf[x] == 0xFF) ? run + 1 : 0;
+			if (run == ARCHIVE_RLE_MIN_RUN) {
+				break;
+			}
+		}
+		if (x < len) {
+			x = x + 1 - run;
+		}
+
+		seg[0] = start - pos;
+		seg[1] = x - start;
+		if (out + sizeof(seg) + seg[1] >= len) {
+			return 0;
+		}
+
+		rsu_memcpy(rbuf + out, seg, sizeof(seg));
+		rsu_memcpy(rbuf + out + sizeof(seg), buf + start, seg[1]);
+		out += sizeof(seg) + seg[1];
+		pos = x;
+	}
+
+	return out;
+}
+
+static RSU_OSAL_INT archive_unrle(RSU_OSAL_U8 *buf, RSU_OSAL_U32 len, RSU_OSAL_U8 *rbuf,
+				  RSU_OSAL_U32 rlen)
+{
+	RSU_OSAL_U32 seg[2];
+	RSU_OSAL_U32 pos = 0;
+	RSU_OSAL_U32 in = 0;
+
+	while (in < rlen) {
+		if (rlen - in < sizeof(seg)) {
+			return -EINVAL;
+		}
+		rsu_memcpy(seg, rbuf + in, sizeof(seg));
+		in += sizeof(seg);
+
+		if (seg[0] > len - pos || seg[1] > len - pos - seg[0] || seg[1] > rlen - in) {
+			return -EINVAL;
+		}
+
+		rsu_memset(buf + pos, 0xFF, seg[0]);
+		rsu_memcpy(buf + pos + seg[0], rbuf + in, seg[1]);
+		pos += seg[0] + seg[1];
+		in += seg[1];
+	}
+
+	return (pos == len) ? 0 : -EINVAL;
+}
+
+RSU_OSAL_INT librsu_archive_write(struct librsu_hl_intf *intf, RSU_OSAL_INT part_num,
+				  RSU_OSAL_FILE *file)
+{
+	struct rsu_archive_header hdr;
+	struct rsu_archive_chunk *index;
+	struct rsu_archive_chunk *e;
+	RSU_OSAL_U8 *buf;
+	RSU_OSAL_U8 *zbuf;
+	RSU_OSAL_U8 *rbuf;
+	RSU_OSAL_U32 offset, len, end, x, rlen;
+	RSU_OSAL_U8 *payload;
+	RSU_OSAL_INT size;
+	RSU_OSAL_INT rtn = 0;
+
+	size = intf->partition.size(part_num);
+	if (size < 0) {
+		RSU_LOG_ERR("Error in getting the slot size");
+		return -ELOWLEVEL;
+	}
+
+	rsu_memset(&hdr, 0, sizeof(hdr));
+	hdr.magic = RSU_ARCHIVE_MAGIC;
+	hdr.version = RSU_ARCHIVE_VERSION;
+	hdr.header_size = sizeof(hdr);
+	hdr.chunk_size = RSU_ARCHIVE_CHUNK_SZ;
+	hdr.slot_size = (RSU_OSAL_U32)size;
+	hdr.chunks = (hdr.slot_size + RSU_ARCHIVE_CHUNK_SZ - 1) / RSU_ARCHIVE_CHUNK_SZ;
+
+	index = rsu_malloc(ARCHIVE_INDEX_SZ(hdr.chunks));
+	buf = rsu_malloc(RSU_ARCHIVE_CHUNK_SZ);
+	zbuf = rsu_malloc(RSU_ARCHIVE_CHUNK_SZ);
+	rbuf = rsu_malloc(RSU_ARCHIVE_CHUNK_SZ);
+	if (!index || !buf || !zbuf || !rbuf) {
+		RSU_LOG_ERR("Error in allocating memory");
+		rtn = -ENOMEM;
+		goto out;
+	}
+
+	rsu_memset(index, 0, ARCHIVE_INDEX_SZ(hdr.chunks));
+
+	/* header and index are rewritten once all chunk entries are known */
+	if (intf->file.write(&hdr, sizeof(hdr), file) != sizeof(hdr) ||
+	    (hdr.chunks && intf->file.write(index, ARCHIVE_INDEX_SZ(hdr.chunks), file) !=
+				   (RSU_OSAL_INT)ARCHIVE_INDEX_SZ(hdr.chunks))) {
+		rtn = -EFILEIO;
+		goto out;
+	}
+
+	offset = sizeof(hdr) + ARCHIVE_INDEX_SZ(hdr.chunks);
+
+	for (x = 0; x < hdr.chunks; x++) {
+		e = &index[x];
+		len = archive_chunk_len(&hdr, x);
+
+		if (intf->data.read(part_num, x * RSU_ARCHIVE_CHUNK_SZ, len, buf)) {
+			RSU_LOG_ERR("Unable to rd slot part %i, offs 0x%08x, cnt %u", part_num,
+				    x * RSU_ARCHIVE_CHUNK_SZ, len);
+			rtn = -ELOWLEVEL;
+			goto out;
+		}
+
+		e->crc = rsu_crc32(0, buf, len);
+		e->offset = offset;
+
+		/* erased tail of the chunk is not stored */
+		e->data_len = len;
+		while (e->data_len && buf[e->data_len - 1] == 0xFF) {
+			e->data_len--;
+		}
+
+		if (!e->data_len) {
+			e->method = RSU_ARCHIVE_ERASED;
+			continue;
+		}
+
+		/* keep whole blocks, like rsu_slot_copy_to_file() does */
+		end = x * RSU_ARCHIVE_CHUNK_SZ +
+		      ((e->data_len + IMAGE_BLOCK_SZ - 1) / IMAGE_BLOCK_SZ) * IMAGE_BLOCK_SZ;
+		hdr.image_size = (end < hdr.slot_size) ? end : hdr.slot_size;
+
+		/* interior erased runs are skipped before compressing */
+		rlen = archive_rle(rbuf, buf, e->data_len);
+		if (rlen) {
+			e->method = RSU_ARCHIVE_RLE;
+			e->stored_len = rlen;
+			payload = rbuf;
+		} else {
+			e->method = RSU_ARCHIVE_STORED;
+			e->stored_len = e->data_len;
+			payload = buf;
+		}
+
+		rlen = archive_deflate(zbuf, payload, e->stored_len);
+		if (rlen) {
+			e->method = (e->method == RSU_ARCHIVE_RLE) ? RSU_ARCHIVE_RLE_DEFLATE :
+								     RSU_ARCHIVE_DEFLATE;
+			e->stored_len = rlen;
+			payload = zbuf;
+		}
+
+		if (intf->file.write(payload, e->stored_len, file) != (RSU_OSAL_INT)e->stored_len) {
+			rtn = -EFILEIO;
+			goto out;
+		}
+
+		offset += e->stored_len;
+	}
+
+	hdr.crc = archive_crc(&hdr, index);
+
+	if (intf->file.fseek(0, RSU_SEEK_SET, file) ||
+	    intf->file.write(&hdr, sizeof(hdr), file) != sizeof(hdr) ||
+	    (hdr.chunks && intf->file.write(index, ARCHIVE_INDEX_SZ(hdr.chunks), file) !=
+				   (RSU_OSAL_INT)ARCHIVE_INDEX_SZ(hdr.chunks))) {
+		rtn = -EFILEIO;
+		goto out;
+	}
+
+	RSU_LOG_INF("archived %u bytes of slot data into %u bytes", hdr.image_size, offset);
+
+out:
+	if (rtn == -EFILEIO) {
+		RSU_LOG_ERR("Unable to write archive");
+	}
+
+	if (rbuf) {
+		rsu_free(rbuf);
+	}
+	if (zbuf) {
+		rsu_free(zbuf);
+	}
+	if (buf) {
+		rsu_free(buf);
+	}
+	if (index) {
+		rsu_free(index);
+	}
+
+	return rtn;
+}
+
+RSU_OSAL_BOOL librsu_archive_probe(const RSU_OSAL_VOID *hdr, RSU_OSAL_INT len)
+{
+	const struct rsu_archive_header *h = hdr;
+
+	if (!hdr || len < (RSU_OSAL_INT)sizeof(*h)) {
+		return false;
+	}
+
+	return h->magic == RSU_ARCHIVE_MAGIC;
+}
+
+RSU_OSAL_INT librsu_archive_open(RSU_OSAL_FILE *file, RSU_OSAL_VOID *hdr)
+{
+	struct librsu_ll_intf *hal = librsu_get_ll_inf();
+	struct rsu_archive_header *h = &reader.hdr;
+
+	if (!hal || !file || !hdr) {
+		return -EINVAL;
+	}
+
+	librsu_archive_close();
+
+	rsu_memcpy(h, hdr, sizeof(*h));
+
+	if (h->magic != RSU_ARCHIVE_MAGIC || h->version != RSU_ARCHIVE_VERSION ||
+	    h->header_size != sizeof(*h) || !h->chunk_size ||
+	    h->chunk_size > RSU_ARCHIVE_MAX_CHUNK || h->chunk_size % IMAGE_BLOCK_SZ ||
+	    h->image_size > h->slot_size ||
+	    h->chunks != (h->slot_size + h->chunk_size - 1) / h->chunk_size) {
+		RSU_LOG_ERR("bad archive header");
+		return -EINVAL;
+	}
+
+	reader.index = rsu_malloc(ARCHIVE_INDEX_SZ(h->chunks));
+	reader.chunk = rsu_malloc(h->chunk_size);
+	reader.zbuf = rsu_malloc(h->chunk_size);
+	reader.rbuf = rsu_malloc(h->chunk_size);
+	if (!reader.index || !reader.chunk || !reader.zbuf || !reader.rbuf) {
+		RSU_LOG_ERR("Error in allocating memory");
+		librsu_archive_close();
+		return -ENOMEM;
+	}
+
+	if (h->chunks && archive_read_full(hal, file, reader.index, ARCHIVE_INDEX_SZ(h->chunks))) {
+		RSU_LOG_ERR("truncated archive index");
+		librsu_archive_close();
+		return -EIO;
+	}
+
+	if (archive_crc(h, reader.index) != h->crc) {
+		RSU_LOG_ERR("archive header crc mismatch");
+		librsu_archive_close();
+		return -EINVAL;
+	}
+
+	reader.file = file;
+	reader.pos = h->header_size + ARCHIVE_INDEX_SZ(h->chunks);
+
+	return 0;
+}
+
+static RSU_OSAL_INT archive_next_chunk(struct librsu_ll_intf *hal)
+{
+	struct rsu_archive_chunk *e = &reader.index[reader.next];
+	RSU_OSAL_U32 len = archive_chunk_len(&reader.hdr, reader.next);
+	RSU_OSAL_U32 start = reader.next * reader.hdr.chunk_size;
+	RSU_OSAL_U32 dlen = len;
+
+	if (e->offset != reader.pos || e->data_len > len ||
+	    (e->method == RSU_ARCHIVE_ERASED && (e->stored_len || e->data_len)) ||
+	    (e->method == RSU_ARCHIVE_STORED && e->stored_len != e->data_len) ||
+	    (e->method > RSU_ARCHIVE_STORED && e->stored_len >= e->data_len) ||
+	    e->method > RSU_ARCHIVE_RLE_DEFLATE) {
+		RSU_LOG_ERR("bad archive entry for chunk %u", reader.next);
+		return -EINVAL;
+	}
+
+	rsu_memset(reader.chunk + e->data_len, 0xFF, len - e->data_len);
+
+	if (e->method == RSU_ARCHIVE_STORED) {
+		if (archive_read_full(hal, reader.file, reader.chunk, e->stored_len)) {
+			return -EIO;
+		}
+	} else if (e->method != RSU_ARCHIVE_ERASED) {
+		if (archive_read_full(hal, reader.file, reader.zbuf, e->stored_len)) {
+			return -EIO;
+		}
+	}
+
+	if (e->method == RSU_ARCHIVE_DEFLATE) {
+		if (archive_inflate(reader.chunk, &dlen, reader.zbuf, e->stored_len) ||
+		    dlen != e->data_len) {
+			RSU_LOG_ERR("unable to inflate chunk %u", reader.next);
+			return -EINVAL;
+		}
+	} else if (e->method == RSU_ARCHIVE_RLE) {
+		if (archive_unrle(reader.chunk, e->data_len, reader.zbuf, e->stored_len)) {
+			RSU_LOG_ERR("bad run length data in chunk %u", reader.next);
+			return -EINVAL;
+		}
+	} else if (e->method == RSU_ARCHIVE_RLE_DEFLATE) {
+		if (archive_inflate(reader.rbuf, &dlen, reader.zbuf, e->stored_len) ||
+		    archive_unrle(reader.chunk, e->data_len, reader.rbuf, dlen)) {
+			RSU_LOG_ERR("unable to inflate chunk %u", reader.next);
+			return -EINVAL;
+		}
+	}
+
+	if (rsu_crc32(0, reader.chunk, len) != e->crc) {
+		RSU_LOG_ERR("crc mismatch in archive chunk %u", reader.next);
+		return -EINVAL;
+	}
+
+	reader.pos += e->stored_len;
+	reader.avail = len;
+	if (reader.hdr.image_size - start < len) {
+		reader.avail = reader.hdr.image_size - start;
+	}
+	reader.used = 0;
+	reader.next++;
+
+	return 0;
+}
+
+RSU_OSAL_INT librsu_archive_read(RSU_OSAL_VOID *buf, RSU_OSAL_INT len)
+{
+	struct librsu_ll_intf *hal = librsu_get_ll_inf();
+	RSU_OSAL_U32 cnt;
+
+	if (!hal || !reader.file || !buf || len < 0) {
+		return -EINVAL;
+	}
+
+	if (reader.used == reader.avail) {
+		if (reader.next == reader.hdr.chunks ||
+		    reader.next * reader.hdr.chunk_size >= reader.hdr.image_size) {
+			return 0;
+		}
+
+		if (archive_next_chunk(hal)) {
+			return -EIO;
+		}
+	}
+
+	cnt = reader.avail - reader.used;
+	if (cnt > (RSU_OSAL_U32)len) {
+		cnt = len;
+	}
+
+	rsu_memcpy(buf, reader.chunk + reader.used, cnt);
+	reader.used += cnt;
+
+	return cnt;
+}
+
+RSU_OSAL_VOID librsu_archive_close(RSU_OSAL_VOID)
+{
+	if (reader.index) {
+		rsu_free(reader.index);
+	}
+	if (reader.chunk) {
+		rsu_free(reader.chunk);
+	}
+	if (reader.zbuf) {
+		rsu_free(reader.zbuf);
+	}
+	if (reader.rbuf) {
+		rsu_free(reader.rbuf);
+	}
+
+	rsu_memset(&reader, 0, sizeof(reader));
+}
@@ -0,0 +1,234 @@
+/*
+ * Copyright (C) 2023-2024 Intel Corporation
+ * SPDX-License-Identifier: MIT-0
+ */
+
+#include <libRSU_bench.h>
+#include <libRSU_cfg.h>
+#include <libRSU_manifest.h>
+#include <utils/RSU_logging.h>
+#include <string.h>
+
+/* the random reads only need to be spread over the flash and repeatable */
+static RSU_OSAL_U32 bench_random(RSU_OSAL_U32 *seed)
+{
+	*seed = *seed * 1103515245U + 12345U;
+	return *seed >> 8;
+}
+
+static RSU_OSAL_INT bench_read_part(struct librsu_hl_intf *intf, RSU_OSAL_INT part_num,
+				    RSU_OSAL_INT offset, RSU_OSAL_INT len, RSU_OSAL_U8 *buf)
+{
+	RSU_OSAL_INT cnt;
+
+	while (len > 0) {
+		cnt = len < RSU_SLOT_READ_CHUNK_SIZE ? len : RSU_SLOT_READ_CHUNK_SIZE;
+		if (intf->data.read(part_num, offset, cnt, buf)) {
+			RSU_LOG_ERR("Unable to rd part %i, offs 0x%08x, cnt %i", part_num, offset,
+				    cnt);
+			return -ELOWLEVEL;
+		}
+		offset += cnt;
+		buf += cnt;
+		len -= cnt;
+	}
+
+	return 0;
+}
+
+static RSU_OSAL_INT bench_read(struct librsu_hl_intf *intf, RSU_OSAL_U8 *buf,
+			       struct rsu_bench *result)
+{
+	RSU_OSAL_INT partitions = intf->partition.count();
+	RSU_OSAL_U64 total = 0;
+	RSU_OSAL_U64 start, pos;
+	RSU_OSAL_U32 seed = 1;
+	RSU_OSAL_INT offset, size, cnt;
+	RSU_OSAL_INT x, n;
+
+	start = rsu_time_ns();
+
+	for (x = 0; x < partitions; x++) {
+		size = intf->partition.size(x);
+		if (size < 0) {
+			return -ELOWLEVEL;
+		}
+
+		for (offset = 0; offset < size; offset += cnt) {
+			cnt = size - offset;
+			if (cnt > RSU_SLOT_READ_CHUNK_SIZE) {
+				cnt = RSU_SLOT_READ_CHUNK_SIZE;
+			}
+			if (bench_read_part(intf, x, offset, cnt, buf)) {
+				return -ELOWLEVEL;
+			}
+		}
+
+		total += size;
+	}
+
+	result->seq_read_ns = rsu_time_ns() - start;
+	result->seq_read_bytes = total;
+
+	if (!total) {
+		return 0;
+	}
+
+	start = rsu_time_ns();
+
+	for (n = 0; n < RSU_BENCH_RANDOM_READS; n++) {
+		pos = ((RSU_OSAL_U64)bench_random(&seed) << 24 | bench_random(&seed)) % total;
+
+		for (x = 0; pos >= (RSU_OSAL_U64)intf->partition.size(x); x++) {
+			pos -= intf->partition.size(x);
+		}
+
+		offset = (RSU_OSAL_INT)pos & ~(RSU_BENCH_READ_SIZE - 1);
+		cnt = intf->partition.size(x) - offset;
+		if (cnt > RSU_BENCH_READ_SIZE) {
+			cnt = RSU_BENCH_READ_SIZE;
+		}
+
+		if (bench_read_part(intf, x, offset, cnt, buf)) {
+			return -ELOWLEVEL;
+		}
+
+		result->rand_read_bytes += cnt;
+	}
+
+	result->rand_read_ns = rsu_time_ns() - start;
+	result->rand_reads = RSU_BENCH_RANDOM_READS;
+
+	return 0;
+}
+
+/*
+ * The erase test leaves the region erased and the program test writes the
+ * saved contents back, so it is the restore at the same time. It also runs
+ * after a failed erase, programming data over itself changes nothing.
+ */
+static RSU_OSAL_INT bench_write(struct librsu_hl_intf *intf, RSU_OSAL_INT part_num,
+				RSU_OSAL_U8 *buf, struct rsu_bench *result)
+{
+	RSU_OSAL_U8 digest[RSU_DIGEST_SHA384_SIZE];
+	RSU_OSAL_U8 *saved;
+	RSU_OSAL_U64 start, t;
+	RSU_OSAL_INT region, offset;
+	RSU_OSAL_INT rtn = 0;
+	RSU_OSAL_INT alg = 0;
+	RSU_OSAL_BOOL recorded;
+
+	region = intf->partition.size(part_num);
+	if (region < 0) {
+		return -ELOWLEVEL;
+	}
+
+	if (region > RSU_BENCH_REGION_SIZE) {
+		region = RSU_BENCH_REGION_SIZE;
+	}
+	region -= region % RSU_BENCH_ERASE_SIZE;
+	if (region == 0) {
+		RSU_LOG_WRN("Scratch slot is smaller than an erase block");
+		return 0;
+	}
+
+	saved = rsu_malloc(region);
+	if (saved == NULL) {
+		RSU_LOG_ERR("Error in allocating memory");
+		return -ELIB;
+	}
+
+	if (bench_read_part(intf, part_num, 0, region, saved)) {
+		rsu_free(saved);
+		return -ELOWLEVEL;
+	}
+
+	/* the slot ends up as it was, so the digest it had before stays true */
+	librsu_cfg_digest_manifest(&alg);
+	recorded = librsu_manifest_lookup(intf, part_num, alg, digest) == 0;
+
+	if (librsu_manifest_invalidate(intf, part_num)) {
+		RSU_LOG_ERR("Unable to update the digest manifest");
+		rsu_free(saved);
+		return -EFILEIO;
+	}
+
+	result->erase_min_ns = (RSU_OSAL_U64)-1;
+
+	for (offset = 0; offset < region; offset += RSU_BENCH_ERASE_SIZE) {
+		start = rsu_time_ns();
+		if (intf->data.erase_range(part_num, offset, RSU_BENCH_ERASE_SIZE)) {
+			RSU_LOG_ERR("Unable to erase part %i, offs 0x%08x", part_num, offset);
+			rtn = -ELOWLEVEL;
+			break;
+		}
+		t = rsu_time_ns() - start;
+
+		result->erase_ns += t;
+		result->erase_blocks++;
+		if (t < result->erase_min_ns) {
+			result->erase_min_ns = t;
+		}
+		if (t > result->erase_max_ns) {
+			result->erase_max_ns = t;
+		}
+	}
+
+	if (!result->erase_blocks) {
+		result->erase_min_ns = 0;
+	}
+
+	start = rsu_time_ns();
+
+	for (offset = 0; offset < region; offset += RSU_BENCH_PAGE_SIZE) {
+		if (intf->data.write(part_num, offset, RSU_BENCH_PAGE_SIZE, saved + offset)) {
+			RSU_LOG_ERR("Unable to wr part %i, offs 0x%08x", part_num, offset);
+			rsu_free(saved);
+			return -ELOWLEVEL;
+		}
+	}
+
+	result->program_ns = rsu_time_ns() - start;
+	result->program_bytes = region;
+
+	for (offset = 0; offset < region; offset += RSU_SLOT_READ_CHUNK_SIZE) {
+		if (bench_read_part(intf, part_num, offset, RSU_SLOT_READ_CHUNK_SIZE, buf) ||
+		    memcmp(buf, saved + offset, RSU_SLOT_READ_CHUNK_SIZE)) {
+			RSU_LOG_ERR("Scratch slot not restored @ 0x%08x", offset);
+			rsu_free(saved);
+			return -ECMP;
+		}
+	}
+
+	rsu_free(saved);
+
+	if (rtn == 0 && recorded && librsu_manifest_store(intf, part_num, alg, digest)) {
+		RSU_LOG_WRN("Unable to record the slot digest");
+	}
+
+	return rtn;
+}
+
+RSU_OSAL_INT librsu_bench_run(struct librsu_hl_intf *intf, RSU_OSAL_INT part_num,
+			      struct rsu_bench *result)
+{
+	RSU_OSAL_U8 *buf;
+	RSU_OSAL_INT rtn;
+
+	rsu_memset(result, 0, sizeof(*result));
+
+	buf = rsu_malloc(RSU_SLOT_READ_CHUNK_SIZE);
+	if (buf == NULL) {
+		RSU_LOG_ERR("Error in allocating memory");
+		return -ELIB;
+	}
+
+	rtn = bench_read(intf, buf, result);
+
+	if (rtn == 0 && part_num >= 0) {
+		rtn = bench_write(intf, part_num, buf, result);
+	}
+
+	rsu_free(buf);
+	return rtn;
+}
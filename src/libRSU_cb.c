@@ -5,13 +5,73 @@
 
 #include <libRSU_cfg.h>
 #include <libRSU_cb.h>
+#include <libRSU_archive.h>
+#include <libRSU_inflate.h>
+#include <libRSU_manifest.h>
 #include <libRSU_image.h>
 #include <libRSU_misc.h>
+#include <libRSU_scratch.h>
 #include <utils/RSU_logging.h>
 
 static RSU_OSAL_FILE *cb_datafile;
 
-RSU_OSAL_INT librsu_cb_file_init(RSU_OSAL_CHAR *filename)
+/*
+ * The first bytes of the file are read ahead to look for a compressed slot
+ * archive, or for a gzip/zlib compressed image. When the file is a plain
+ * image they are handed out before the rest of the file.
+ */
+static RSU_OSAL_U8 cb_peek[sizeof(struct rsu_archive_header)];
+static RSU_OSAL_INT cb_peek_len;
+static RSU_OSAL_INT cb_peek_pos;
+static RSU_OSAL_BOOL cb_archive;
+static RSU_OSAL_BOOL cb_inflate;
+
+static RSU_OSAL_INT librsu_cb_file_peek(struct librsu_ll_intf *hal, RSU_OSAL_INT rawdata)
+{
+	RSU_OSAL_INT c;
+
+	cb_peek_len = 0;
+	cb_peek_pos = 0;
+
+	while (cb_peek_len < (RSU_OSAL_INT)sizeof(cb_peek)) {
+		c = hal->file.read(cb_peek + cb_peek_len, sizeof(cb_peek) - cb_peek_len,
+				   cb_datafile);
+		if (c < 0) {
+			return c;
+		} else if (c == 0) {
+			break;
+		}
+		cb_peek_len += c;
+	}
+
+	/* raw data is never taken for a compressed image */
+	if (!rawdata && librsu_inflate_probe(cb_peek, cb_peek_len)) {
+		RSU_LOG_INF("compressed image detected");
+		if (librsu_inflate_open(cb_datafile, cb_peek, cb_peek_len)) {
+			return -EINVAL;
+		}
+
+		cb_inflate = true;
+		cb_peek_len = 0;
+		return 0;
+	}
+
+	if (!librsu_archive_probe(cb_peek, cb_peek_len)) {
+		return 0;
+	}
+
+	RSU_LOG_INF("compressed slot archive detected");
+	if (librsu_archive_open(cb_datafile, cb_peek)) {
+		return -EINVAL;
+	}
+
+	cb_archive = true;
+	cb_peek_len = 0;
+
+	return 0;
+}
+
+RSU_OSAL_INT librsu_cb_file_init(RSU_OSAL_CHAR *filename, RSU_OSAL_INT rawdata)
 {
 
 	struct librsu_ll_intf *hal = librsu_get_ll_inf();
@@ -22,8 +82,7 @@ RSU_OSAL_INT librsu_cb_file_init(RSU_OSAL_CHAR *filename)
 
 	if (cb_datafile != NULL) {
 		RSU_LOG_DBG("cb_datafile is not NULL, close the file and make cb_datafile as NULL");
-		hal->file.close(cb_datafile);
-		cb_datafile = NULL;
+		librsu_cb_file_cleanup();
 	}
 
 	if (filename == NULL) {
@@ -36,6 +95,12 @@ RSU_OSAL_INT librsu_cb_file_init(RSU_OSAL_CHAR *filename)
 		return -ENFILE;
 	}
 
+	if (librsu_cb_file_peek(hal, rawdata)) {
+		hal->file.close(cb_datafile);
+		cb_datafile = NULL;
+		return -EINVAL;
+	}
+
 	return 0;
 }
 
@@ -46,20 +111,52 @@ RSU_OSAL_VOID librsu_cb_file_cleanup(RSU_OSAL_VOID)
 		return;
 	}
 
+	if (cb_archive) {
+		librsu_archive_close();
+		cb_archive = false;
+	}
+
+	if (cb_inflate) {
+		librsu_inflate_close();
+		cb_inflate = false;
+	}
+
 	if (cb_datafile != NULL) {
 		hal->file.close(cb_datafile);
 	}
 
 	cb_datafile = NULL;
+	cb_peek_len = 0;
+	cb_peek_pos = 0;
 }
 
 RSU_OSAL_INT librsu_cb_file(RSU_OSAL_VOID *buf, RSU_OSAL_INT len)
 {
+	RSU_OSAL_INT cnt;
+
 	struct librsu_ll_intf *hal = librsu_get_ll_inf();
 	if (hal == NULL) {
 		return -EINVAL;
 	}
 
+	if (cb_archive) {
+		return librsu_archive_read(buf, len);
+	}
+
+	if (cb_inflate) {
+		return librsu_inflate_read(buf, len);
+	}
+
+	if (cb_peek_pos < cb_peek_len) {
+		cnt = cb_peek_len - cb_peek_pos;
+		if (cnt > len) {
+			cnt = len;
+		}
+		rsu_memcpy(buf, cb_peek + cb_peek_pos, cnt);
+		cb_peek_pos += cnt;
+		return cnt;
+	}
+
 	return hal->file.read(buf, len, cb_datafile);
 }
 
@@ -114,6 +211,22 @@ RSU_OSAL_INT librsu_cb_buf(RSU_OSAL_VOID *buf, RSU_OSAL_INT len)
 	return read_len;
 }
 
+static rsu_progress_callback cb_progress;
+static RSU_OSAL_VOID *cb_progress_arg;
+
+RSU_OSAL_VOID librsu_cb_progress_set(rsu_progress_callback progress, RSU_OSAL_VOID *arg)
+{
+	cb_progress = progress;
+	cb_progress_arg = arg;
+}
+
+static RSU_OSAL_VOID librsu_cb_progress(RSU_OSAL_U32 done, RSU_OSAL_U32 total)
+{
+	if (cb_progress) {
+		cb_progress(cb_progress_arg, done, total);
+	}
+}
+
 RSU_OSAL_INT librsu_cb_program_common(struct librsu_hl_intf *intf, RSU_OSAL_INT slot,
 				      rsu_data_callback callback, RSU_OSAL_INT rawdata)
 {
@@ -125,6 +238,8 @@ RSU_OSAL_INT librsu_cb_program_common(struct librsu_hl_intf *intf, RSU_OSAL_INT
 	RSU_OSAL_U32 x;
 	struct rsu_slot_info info;
 	struct rsu_image_state state;
+	struct librsu_digest digest;
+	RSU_OSAL_BOOL record;
 
 	if (!intf) {
 		return -ELIB;
@@ -160,6 +275,15 @@ RSU_OSAL_INT librsu_cb_program_common(struct librsu_hl_intf *intf, RSU_OSAL_INT
 		return -EARGS;
 	}
 
+	/* whatever the manifest says about the slot stops being true from here */
+	if (librsu_manifest_invalidate(intf, part_num)) {
+		RSU_LOG_ERR("Unable to update the digest manifest");
+		return -EFILEIO;
+	}
+
+	/* the digest is fed with the data as it is checked, not read again after */
+	record = librsu_manifest_begin(&digest);
+
 	offset = 0;
 	done = 0;
 
@@ -167,15 +291,15 @@ RSU_OSAL_INT librsu_cb_program_common(struct librsu_hl_intf *intf, RSU_OSAL_INT
 		return -ELIB;
 	}
 
-	vbuf = rsu_malloc(IMAGE_BLOCK_SZ);
+	vbuf = librsu_scratch_get(IMAGE_BLOCK_SZ);
 	if (vbuf == NULL) {
 		RSU_LOG_ERR("Error in allocating memory");
 		return -EARGS;
 	}
 
-	buf = rsu_malloc(IMAGE_BLOCK_SZ);
+	buf = librsu_scratch_get(IMAGE_BLOCK_SZ);
 	if (buf == NULL) {
-		rsu_free(vbuf);
+		librsu_scratch_put(vbuf);
 		RSU_LOG_ERR("Error in allocating memory");
 		return -EARGS;
 	}
@@ -188,8 +312,8 @@ RSU_OSAL_INT librsu_cb_program_common(struct librsu_hl_intf *intf, RSU_OSAL_INT
 				done = 1;
 				break;
 			} else if (c < 0) {
-				rsu_free(vbuf);
-				rsu_free(buf);
+				librsu_scratch_put(vbuf);
+				librsu_scratch_put(buf);
 				return -ECALLBACK;
 			}
 
@@ -201,10 +325,10 @@ RSU_OSAL_INT librsu_cb_program_common(struct librsu_hl_intf *intf, RSU_OSAL_INT
 		}
 
 		if (!rawdata) {
-			RSU_LOG_INF("Programming bit stream block");
+			RSU_LOG_INF_RATELIMITED("Programming bit stream block");
 			if (librsu_image_block_process(&state, buf, NULL, &info)) {
-				rsu_free(vbuf);
-				rsu_free(buf);
+				librsu_scratch_put(vbuf);
+				librsu_scratch_put(buf);
 				return -EPROGRAM;
 			}
 		}
@@ -212,29 +336,29 @@ RSU_OSAL_INT librsu_cb_program_common(struct librsu_hl_intf *intf, RSU_OSAL_INT
 		size = intf->partition.size(part_num);
 		if (size < 0) {
 			RSU_LOG_ERR("Error in getting the slot size");
-			rsu_free(vbuf);
-			rsu_free(buf);
+			librsu_scratch_put(vbuf);
+			librsu_scratch_put(buf);
 			return -ELOWLEVEL;
 		}
 
 		if ((offset + cnt) > (RSU_OSAL_U32)size) {
 			RSU_LOG_ERR("Trying to program too much data into slot");
-			rsu_free(vbuf);
-			rsu_free(buf);
+			librsu_scratch_put(vbuf);
+			librsu_scratch_put(buf);
 			return -ESIZE;
 		}
 
 		if (intf->data.write(part_num, offset, cnt, buf)) {
 			RSU_LOG_ERR("Error in writing to slot");
-			rsu_free(vbuf);
-			rsu_free(buf);
+			librsu_scratch_put(vbuf);
+			librsu_scratch_put(buf);
 			return -ELOWLEVEL;
 		}
 
 		if (intf->data.read(part_num, offset, cnt, vbuf)) {
 			RSU_LOG_ERR("Error in reading from slot");
-			rsu_free(vbuf);
-			rsu_free(buf);
+			librsu_scratch_put(vbuf);
+			librsu_scratch_put(buf);
 			return -ELOWLEVEL;
 		}
 
@@ -242,25 +366,50 @@ RSU_OSAL_INT librsu_cb_program_common(struct librsu_hl_intf *intf, RSU_OSAL_INT
 			if (vbuf[x] != buf[x]) {
 				RSU_LOG_ERR("Expect %02X, got %02X @ 0x%08X", buf[x], vbuf[x],
 					offset + x);
-				rsu_free(vbuf);
-				rsu_free(buf);
+				librsu_scratch_put(vbuf);
+				librsu_scratch_put(buf);
 				return -ECMP;
 			}
 		}
 
+		if (record) {
+			librsu_digest_update(&digest, vbuf, cnt);
+		}
+
 		offset += cnt;
+		librsu_cb_progress(offset, size);
 	}
 
 	if (!rawdata && intf->priority.add(part_num)) {
-		rsu_free(vbuf);
-		rsu_free(buf);
+		librsu_scratch_put(vbuf);
+		librsu_scratch_put(buf);
 		return -ELOWLEVEL;
 	}
-	rsu_free(vbuf);
-	rsu_free(buf);
+	librsu_scratch_put(vbuf);
+	librsu_scratch_put(buf);
+
+	if (record && librsu_manifest_record(intf, part_num, &digest, offset)) {
+		RSU_LOG_WRN("Unable to record the slot digest");
+	}
+
 	return 0;
 }
 
+/* a slot that verifies fine gets a digest entry, unless it already has one */
+static RSU_OSAL_BOOL manifest_record_missing(struct librsu_hl_intf *intf, RSU_OSAL_INT part_num,
+					     struct librsu_digest *d)
+{
+	RSU_OSAL_U8 digest[RSU_DIGEST_SHA384_SIZE];
+	RSU_OSAL_INT alg;
+
+	if (!librsu_manifest_begin(d)) {
+		return false;
+	}
+
+	librsu_cfg_digest_manifest(&alg);
+	return librsu_manifest_lookup(intf, part_num, alg, digest) != 0;
+}
+
 RSU_OSAL_INT librsu_cb_verify_common(struct librsu_hl_intf *intf, RSU_OSAL_INT slot,
 				     rsu_data_callback callback, RSU_OSAL_INT rawdata)
 {
@@ -272,6 +421,8 @@ RSU_OSAL_INT librsu_cb_verify_common(struct librsu_hl_intf *intf, RSU_OSAL_INT s
 	RSU_OSAL_INT x;
 	struct rsu_slot_info info;
 	struct rsu_image_state state;
+	struct librsu_digest digest;
+	RSU_OSAL_BOOL record;
 
 	if (!intf) {
 		return -ELIB;
@@ -302,6 +453,8 @@ RSU_OSAL_INT librsu_cb_verify_common(struct librsu_hl_intf *intf, RSU_OSAL_INT s
 		return -EARGS;
 	}
 
+	record = manifest_record_missing(intf, part_num, &digest);
+
 	offset = 0;
 	done = 0;
 
@@ -309,15 +462,15 @@ RSU_OSAL_INT librsu_cb_verify_common(struct librsu_hl_intf *intf, RSU_OSAL_INT s
 		return -ELIB;
 	}
 
-	vbuf = rsu_malloc(IMAGE_BLOCK_SZ);
+	vbuf = librsu_scratch_get(IMAGE_BLOCK_SZ);
 	if (vbuf == NULL) {
 		RSU_LOG_ERR("Error in allocating memory");
 		return -EARGS;
 	}
 
-	buf = rsu_malloc(IMAGE_BLOCK_SZ);
+	buf = librsu_scratch_get(IMAGE_BLOCK_SZ);
 	if (buf == NULL) {
-		rsu_free(vbuf);
+		librsu_scratch_put(vbuf);
 		RSU_LOG_ERR("Error in allocating memory");
 		return -EARGS;
 	}
@@ -330,8 +483,8 @@ RSU_OSAL_INT librsu_cb_verify_common(struct librsu_hl_intf *intf, RSU_OSAL_INT s
 				done = 1;
 				break;
 			} else if (c < 0) {
-				rsu_free(vbuf);
-				rsu_free(buf);
+				librsu_scratch_put(vbuf);
+				librsu_scratch_put(buf);
 				return -ECALLBACK;
 			}
 
@@ -343,18 +496,23 @@ RSU_OSAL_INT librsu_cb_verify_common(struct librsu_hl_intf *intf, RSU_OSAL_INT s
 		}
 
 		if (intf->data.read(part_num, offset, cnt, vbuf)) {
-			rsu_free(vbuf);
-			rsu_free(buf);
+			librsu_scratch_put(vbuf);
+			librsu_scratch_put(buf);
 			return -ELOWLEVEL;
 		}
 
+		if (record) {
+			librsu_digest_update(&digest, vbuf, cnt);
+		}
+
 		if (!rawdata) {
 			if (librsu_image_block_process(&state, buf, vbuf, &info)) {
-				rsu_free(vbuf);
-				rsu_free(buf);
+				librsu_scratch_put(vbuf);
+				librsu_scratch_put(buf);
 				return -ECMP;
 			}
 			offset += cnt;
+			librsu_cb_progress(offset, info.size);
 			continue;
 		}
 
@@ -362,15 +520,162 @@ RSU_OSAL_INT librsu_cb_verify_common(struct librsu_hl_intf *intf, RSU_OSAL_INT s
 			if (vbuf[x] != buf[x]) {
 				RSU_LOG_ERR("Expect %02X, got %02X @ 0x%08X", buf[x], vbuf[x],
 					offset + x);
-				rsu_free(vbuf);
-				rsu_free(buf);
+				librsu_scratch_put(vbuf);
+				librsu_scratch_put(buf);
 				return -ECMP;
 			}
 		}
 
 		offset += cnt;
+		librsu_cb_progress(offset, info.size);
 	}
-	rsu_free(vbuf);
-	rsu_free(buf);
+	librsu_scratch_put(vbuf);
+	librsu_scratch_put(buf);
+
+	if (record && librsu_manifest_record(intf, part_num, &digest, offset)) {
+		RSU_LOG_WRN("Unable to record the slot digest");
+	}
+
 	return 0;
 }
+
+RSU_OSAL_INT librsu_cb_validate_common(struct librsu_hl_intf *intf, RSU_OSAL_INT slot,
+				       rsu_data_callback callback)
+{
+	RSU_OSAL_INT part_num;
+	RSU_OSAL_U32 offset;
+	RSU_OSAL_U8 *buf;
+	RSU_OSAL_INT cnt, c, done;
+	RSU_OSAL_INT rtn = 0;
+	struct rsu_slot_info info;
+	struct rsu_image_state state;
+
+	if (!intf) {
+		return -ELIB;
+	}
+
+	part_num = librsu_misc_slot2part(intf, slot);
+	if (part_num < 0) {
+		return -ESLOTNUM;
+	}
+
+	SAFE_STRCPY(info.name, sizeof(info.name), intf->partition.name(part_num),
+		    sizeof(info.name));
+
+	if (intf->partition.offset(part_num, &info.offset) < 0) {
+		RSU_LOG_ERR("Error in getting the partition offset");
+		return -EBADF;
+	}
+
+	info.size = intf->partition.size(part_num);
+	if (info.size < 0) {
+		RSU_LOG_ERR("Error in getting the slot size");
+		return -ELOWLEVEL;
+	}
+	info.priority = intf->priority.get(part_num);
+
+	if (!callback) {
+		return -EARGS;
+	}
+
+	offset = 0;
+	done = 0;
+
+	if (librsu_image_block_init(&state)) {
+		return -ELIB;
+	}
+
+	buf = librsu_scratch_get(IMAGE_BLOCK_SZ);
+	if (buf == NULL) {
+		RSU_LOG_ERR("Error in allocating memory");
+		return -ENOMEM;
+	}
+
+	/*
+	 * Same block processing as when programming, the relocated signature
+	 * blocks only ever land in buf.
+	 */
+	while (!done) {
+		cnt = 0;
+		while (cnt < IMAGE_BLOCK_SZ) {
+			c = callback(buf + cnt, IMAGE_BLOCK_SZ - cnt);
+			if (c == 0) {
+				done = 1;
+				break;
+			} else if (c < 0) {
+				librsu_scratch_put(buf);
+				return -ECALLBACK;
+			}
+
+			cnt += c;
+		}
+
+		if (cnt == 0) {
+			break;
+		}
+
+		if ((offset + cnt) > (RSU_OSAL_U32)info.size) {
+			RSU_LOG_ERR("Image does not fit in the slot");
+			rtn = -ESIZE;
+			break;
+		}
+
+		if (librsu_image_block_process(&state, buf, NULL, &info)) {
+			RSU_LOG_ERR("Bad image block @0x%08x", offset);
+			rtn = -EFORMAT;
+			break;
+		}
+
+		offset += cnt;
+	}
+
+	if (rtn == 0 && offset == 0) {
+		RSU_LOG_ERR("Image is empty");
+		rtn = -EFORMAT;
+	}
+
+	librsu_scratch_put(buf);
+	return rtn;
+}
+
+RSU_OSAL_INT librsu_cb_read_common(struct librsu_hl_intf *intf, RSU_OSAL_INT part_num,
+				   RSU_OSAL_U32 offset, RSU_OSAL_U32 len, rsu_sink_callback sink,
+				   RSU_OSAL_VOID *arg)
+{
+	RSU_OSAL_U8 *buf;
+	RSU_OSAL_U32 cnt;
+	RSU_OSAL_INT rtn = 0;
+
+	if (!intf || !sink) {
+		return -EARGS;
+	}
+
+	cnt = len < RSU_SLOT_READ_CHUNK_SIZE ? len : RSU_SLOT_READ_CHUNK_SIZE;
+	buf = librsu_scratch_get(cnt ? cnt : 1);
+	if (buf == NULL) {
+		RSU_LOG_ERR("Error in allocating memory");
+		return -ENOMEM;
+	}
+
+	while (len) {
+		cnt = len < RSU_SLOT_READ_CHUNK_SIZE ? len : RSU_SLOT_READ_CHUNK_SIZE;
+
+		if (intf->data.read(part_num, offset, cnt, buf)) {
+			RSU_LOG_ERR("Unable to rd part %i, offs 0x%08x, cnt %u", part_num, offset,
+				    cnt);
+			rtn = -ELOWLEVEL;
+			break;
+		}
+
+		if (sink(arg, buf, cnt)) {
+			rtn = -ECALLBACK;
+			break;
+		}
+
+		offset += cnt;
+		len -= cnt;
+	}
+
+	librsu_scratch_put(buf);
+	return rtn;
+}
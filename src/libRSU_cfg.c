@@ -3,11 +3,15 @@
  * SPDX-License-Identifier: MIT-0
  */
 
+#include <libRSU.h>
 #include <libRSU_cfg.h>
 #include <libRSU_ll_intf.h>
 #include <utils/RSU_logging.h>
 #include <utils/RSU_utils.h>
 #include <libRSU_ops.h>
+#include <libRSU_misc.h>
+#include <libRSU_stats.h>
+#include <libRSU_trace.h>
 #include <string.h>
 
 #define NUM_ARGS		(16U)
@@ -15,9 +19,43 @@
 
 static struct librsu_ll_intf *hal;
 
-RSU_OSAL_INT librsu_cfg_parse(RSU_OSAL_CHAR *filename, struct librsu_hl_intf **intf)
+/* both the lower case and the upper case level names are accepted */
+static RSU_OSAL_INT cfg_log_level(const RSU_OSAL_CHAR *name)
 {
-	if (filename == NULL || intf == NULL) {
+	static const struct {
+		const RSU_OSAL_CHAR *name;
+		const RSU_OSAL_CHAR *alias;
+		rsu_loglevel_t level;
+	} levels[] = {
+		{"off", "OFF", L_LOG_OFF}, {"err", "ERR", L_LOG_ERR}, {"low", "WRN", L_LOG_WRN},
+		{"med", "INF", L_LOG_INF}, {"high", "DBG", L_LOG_DBG},
+	};
+	RSU_OSAL_U32 x;
+
+	for (x = 0; x < sizeof(levels) / sizeof(levels[0]); x++) {
+		if (strcmp(name, levels[x].name) == 0 || strcmp(name, levels[x].alias) == 0) {
+			return levels[x].level;
+		}
+	}
+
+	return -EINVAL;
+}
+
+RSU_OSAL_VOID librsu_config_defaults(struct rsu_config *config)
+{
+	if (config == NULL) {
+		return;
+	}
+
+	rsu_memset(config, 0, sizeof(*config));
+	config->log_level = RSU_CONFIG_LOG_DEFAULT;
+	config->spt_checksum_enabled = 1; /*spt_checksum_enabled is enabled by default*/
+}
+
+RSU_OSAL_INT librsu_cfg_parse(RSU_OSAL_CHAR *filename, const struct rsu_config *config,
+			      struct librsu_hl_intf **intf)
+{
+	if ((filename == NULL && config == NULL) || intf == NULL) {
 		return -EINVAL;
 	}
 
@@ -31,23 +69,55 @@ RSU_OSAL_INT librsu_cfg_parse(RSU_OSAL_CHAR *filename, struct librsu_hl_intf **i
 
 	rsu_memset(hal, 0, sizeof(struct librsu_ll_intf));
 
-	ret = RSU_logging_init(filename);
+	ret = plat_filesys_init(&(hal->file));
 	if (ret != 0) {
-		RSU_LOG_ERR("error in setting log information");
 		rsu_free(hal);
 		hal = NULL;
-		return -EINVAL;
+		return -ENXIO;
 	}
 
-	ret = plat_filesys_init(&(hal->file));
+	if (config) {
+		hal->cfg = *config;
+	} else {
+		librsu_config_defaults(&(hal->cfg));
+		ret = librsu_common_cfg_parse(filename, hal);
+		if (ret == -ENOENT) {
+			hal->file.terminate();
+			rsu_free(hal);
+			hal = NULL;
+			return -ENOENT;
+		} else if (ret != 0) {
+			RSU_LOG_ERR("bad lines in the configuration file were ignored");
+		}
+	}
+
+	ret = RSU_logging_init(&(hal->cfg));
 	if (ret != 0) {
-		RSU_logging_exit();
+		RSU_LOG_ERR("error in setting log information");
+		hal->file.terminate();
 		rsu_free(hal);
 		hal = NULL;
-		return -ENXIO;
+		return -EINVAL;
+	}
+
+	if (hal->cfg.hal_replay[0] != '\0') {
+		/* the trace stands in for the flash, mailbox and misc platforms */
+		ret = hal->cfg.hal_trace[0] != '\0' ? -EINVAL : librsu_replay_init(hal);
+		if (ret != 0) {
+			RSU_LOG_ERR("Error during initializing HAL replay");
+			ret = hal->file.terminate();
+			if (ret) {
+				RSU_LOG_ERR("Error in terminating file system");
+			}
+			RSU_logging_exit();
+			rsu_free(hal);
+			hal = NULL;
+			return -ENXIO;
+		}
+		goto plat_ready;
 	}
 
-	ret = plat_mbox_init(&(hal->mbox), filename);
+	ret = plat_mbox_init(&(hal->mbox), &(hal->cfg));
 	if (ret != 0) {
 		RSU_LOG_ERR("Error during initializing mailbox API");
 		ret = hal->file.terminate();
@@ -60,7 +130,7 @@ RSU_OSAL_INT librsu_cfg_parse(RSU_OSAL_CHAR *filename, struct librsu_hl_intf **i
 		return -ENXIO;
 	}
 
-	ret = plat_qspi_init(&(hal->qspi), filename);
+	ret = plat_qspi_init(&(hal->qspi), &(hal->cfg));
 	if (ret != 0) {
 		RSU_LOG_ERR("Error during initializing QSPI API");
 		ret = hal->mbox.terminate();
@@ -77,7 +147,7 @@ RSU_OSAL_INT librsu_cfg_parse(RSU_OSAL_CHAR *filename, struct librsu_hl_intf **i
 		return -ENXIO;
 	}
 
-	ret = plat_rsu_misc_init(&(hal->misc), filename);
+	ret = plat_rsu_misc_init(&(hal->misc), &(hal->cfg));
 	if (ret != 0) {
 		RSU_LOG_ERR("Error during initializing misc API");
 		ret = hal->mbox.terminate();
@@ -98,12 +168,18 @@ RSU_OSAL_INT librsu_cfg_parse(RSU_OSAL_CHAR *filename, struct librsu_hl_intf **i
 		return -ENXIO;
 	}
 
-	ret = librsu_common_cfg_parse(filename, hal);
-	if (ret != 0) {
-		RSU_LOG_ERR("error in setting common configuration");
+	if (hal->cfg.hal_trace[0] != '\0') {
+		ret = librsu_trace_init(hal);
+		if (ret != 0) {
+			RSU_LOG_ERR("Error during initializing HAL trace");
+			librsu_cfg_reset();
+			return -ENXIO;
+		}
 	}
 
+plat_ready:
 	RSU_LOG_DBG("Platform initialization completed");
+	librsu_stats_wrap(hal);
 
 	ret = rsu_qspi_open(hal, intf);
 	if (ret) {
@@ -125,8 +201,8 @@ RSU_OSAL_INT librsu_common_cfg_parse(RSU_OSAL_CHAR *filename, struct librsu_ll_i
 	RSU_OSAL_CHAR line[RSU_DEV_BUF_SIZE], *argv[NUM_ARGS] = {0};
 	RSU_OSAL_INT argc, linenum;
 	RSU_OSAL_U32 slot;
-
-	intf->spt_checksum_enabled = 1; /*spt_checksum_enabled is enabled by default*/
+	RSU_OSAL_INT x, alg;
+	RSU_OSAL_INT rtn = 0;
 
 	file = intf->file.open(filename, RSU_FILE_READ);
 	if (!file) {
@@ -134,6 +210,7 @@ RSU_OSAL_INT librsu_common_cfg_parse(RSU_OSAL_CHAR *filename, struct librsu_ll_i
 		return -ENOENT;
 	}
 
+	/* a bad line is logged and skipped, the rest of the file still applies */
 	linenum = 0;
 	while (intf->file.fgets(line, RSU_DEV_BUF_SIZE, file) == 0) {
 		linenum++;
@@ -145,33 +222,164 @@ RSU_OSAL_INT librsu_common_cfg_parse(RSU_OSAL_CHAR *filename, struct librsu_ll_i
 		if (argv[0][0] == '#')
 			continue;
 
-		if (strcmp(argv[0], "write-protect") == 0) {
+		if (strcmp(argv[0], "log") == 0) {
+			if (argc != 3) {
+				continue;
+			}
+			intf->cfg.log_level = cfg_log_level(argv[1]);
+			if (intf->cfg.log_level < 0) {
+				RSU_LOG_ERR("Error in getting logging configuration at line number %i",
+					    linenum);
+				RSU_LOG_ERR("Setting log level to med and output as stderr");
+				intf->cfg.log_level = L_LOG_INF;
+				intf->cfg.log_file[0] = '\0';
+			} else if (strcmp(argv[2], "stderr") == 0) {
+				intf->cfg.log_file[0] = '\0';
+			} else {
+				SAFE_STRCPY(intf->cfg.log_file, sizeof(intf->cfg.log_file), argv[2],
+					    RSU_CONFIG_PATH_LEN);
+			}
+		} else if (strcmp(argv[0], "root") == 0) {
+			if (argc != 3) {
+				continue;
+			}
+			if (strcmp(argv[1], "qspi") == 0) {
+				SAFE_STRCPY(intf->cfg.qspi_dev, sizeof(intf->cfg.qspi_dev), argv[2],
+					    RSU_CONFIG_PATH_LEN);
+			} else {
+				RSU_LOG_ERR("root device not qspi at linenum %i", linenum);
+			}
+		} else if (strcmp(argv[0], "rsu-dev") == 0) {
+			if (argc != 2) {
+				continue;
+			}
+			SAFE_STRCPY(intf->cfg.rsu_dev, sizeof(intf->cfg.rsu_dev), argv[1],
+				    RSU_CONFIG_PATH_LEN);
+		} else if (strcmp(argv[0], "write-protect") == 0) {
 			if (argc != 2) {
 				RSU_LOG_ERR("error: Wrong number of parameters for '%s' @%i", argv[0],
 					linenum);
-				intf->file.close(file);
-				return -EINVAL;
+				rtn = -EINVAL;
+				continue;
 			}
 			slot = strtoul(argv[1], NULL, 10);
 			if (slot > 31) {
 				RSU_LOG_ERR("error: Write protection only works on first 32 slots @%i",
 					linenum);
-				intf->file.close(file);
-				return -EINVAL;
+				rtn = -EINVAL;
+				continue;
 			}
-			intf->writeprotect |= (1 << slot);
+			intf->cfg.writeprotect |= (1 << slot);
 		} else if (strcmp(argv[0], "rsu-spt-checksum") == 0) {
 			if (argc != 2) {
 				RSU_LOG_ERR("Wrong number of parameters for '%s' @%i", argv[0],
 					linenum);
-				intf->file.close(file);
-				return -EINVAL;
+				rtn = -EINVAL;
+				continue;
+			}
+			intf->cfg.spt_checksum_enabled = strtoul(argv[1], NULL, 10);
+		} else if (strcmp(argv[0], "program-preflight") == 0) {
+			if (argc != 2) {
+				RSU_LOG_ERR("Wrong number of parameters for '%s' @%i", argv[0],
+					linenum);
+				rtn = -EINVAL;
+				continue;
 			}
-			intf->spt_checksum_enabled = strtoul(argv[1], NULL, 10);
+			intf->cfg.program_preflight = strtoul(argv[1], NULL, 10);
+		} else if (strcmp(argv[0], "read-only") == 0) {
+			if (argc != 2) {
+				RSU_LOG_ERR("Wrong number of parameters for '%s' @%i", argv[0],
+					linenum);
+				rtn = -EINVAL;
+				continue;
+			}
+			intf->cfg.read_only = strtoul(argv[1], NULL, 10);
+		} else if (strcmp(argv[0], "metadata-repair") == 0) {
+			if (argc != 2) {
+				RSU_LOG_ERR("Wrong number of parameters for '%s' @%i", argv[0],
+					linenum);
+				rtn = -EINVAL;
+				continue;
+			}
+			if (strcmp(argv[1], "background") == 0) {
+				intf->cfg.metadata_repair = RSU_REPAIR_BACKGROUND;
+			} else if (strcmp(argv[1], "inline") == 0) {
+				intf->cfg.metadata_repair = RSU_REPAIR_INLINE;
+			} else if (strcmp(argv[1], "manual") == 0) {
+				intf->cfg.metadata_repair = RSU_REPAIR_MANUAL;
+			} else {
+				RSU_LOG_ERR("Unknown metadata-repair mode '%s' @%i", argv[1],
+					    linenum);
+				rtn = -EINVAL;
+				continue;
+			}
+		} else if (strcmp(argv[0], "status-poll-interval") == 0) {
+			if (argc != 2) {
+				RSU_LOG_ERR("Wrong number of parameters for '%s' @%i", argv[0],
+					linenum);
+				rtn = -EINVAL;
+				continue;
+			}
+			intf->cfg.status_poll_interval = strtoul(argv[1], NULL, 10);
+		} else if (strcmp(argv[0], "digest-manifest") == 0) {
+			if (argc < 2 || argc > 4) {
+				RSU_LOG_ERR("Wrong number of parameters for '%s' @%i", argv[0],
+					linenum);
+				rtn = -EINVAL;
+				continue;
+			}
+			alg = RSU_DIGEST_SHA256;
+			for (x = 2; x < argc; x++) {
+				if (strcmp(argv[x], "sha256") == 0) {
+					alg = RSU_DIGEST_SHA256 | (alg & RSU_DIGEST_TRIM_ERASED);
+				} else if (strcmp(argv[x], "sha384") == 0) {
+					alg = RSU_DIGEST_SHA384 | (alg & RSU_DIGEST_TRIM_ERASED);
+				} else if (strcmp(argv[x], "trim") == 0) {
+					alg |= RSU_DIGEST_TRIM_ERASED;
+				} else {
+					RSU_LOG_ERR("Unknown digest-manifest option '%s' @%i",
+						    argv[x], linenum);
+					break;
+				}
+			}
+			if (x < argc) {
+				rtn = -EINVAL;
+				continue;
+			}
+			SAFE_STRCPY(intf->cfg.digest_manifest, sizeof(intf->cfg.digest_manifest), argv[1],
+				    RSU_CONFIG_PATH_LEN);
+			intf->cfg.digest_manifest_alg = alg;
+		} else if (strcmp(argv[0], "metadata-cache") == 0) {
+			if (argc != 2) {
+				RSU_LOG_ERR("Wrong number of parameters for '%s' @%i", argv[0],
+					linenum);
+				rtn = -EINVAL;
+				continue;
+			}
+			SAFE_STRCPY(intf->cfg.metadata_cache, sizeof(intf->cfg.metadata_cache), argv[1],
+				    RSU_CONFIG_PATH_LEN);
+		} else if (strcmp(argv[0], "hal-trace") == 0) {
+			if (argc < 2 || argc > 3 || (argc == 3 && strcmp(argv[2], "data") != 0)) {
+				RSU_LOG_ERR("Wrong parameters for '%s' @%i", argv[0], linenum);
+				rtn = -EINVAL;
+				continue;
+			}
+			SAFE_STRCPY(intf->cfg.hal_trace, sizeof(intf->cfg.hal_trace), argv[1],
+				    RSU_CONFIG_PATH_LEN);
+			intf->cfg.hal_trace_data = argc == 3;
+		} else if (strcmp(argv[0], "hal-replay") == 0) {
+			if (argc < 2 || argc > 3 || (argc == 3 && strcmp(argv[2], "timing") != 0)) {
+				RSU_LOG_ERR("Wrong parameters for '%s' @%i", argv[0], linenum);
+				rtn = -EINVAL;
+				continue;
+			}
+			SAFE_STRCPY(intf->cfg.hal_replay, sizeof(intf->cfg.hal_replay), argv[1],
+				    RSU_CONFIG_PATH_LEN);
+			intf->cfg.hal_replay_timing = argc == 3;
 		}
 	}
 	intf->file.close(file);
-	return 0;
+	return rtn;
 }
 
 RSU_OSAL_VOID librsu_cfg_reset(RSU_OSAL_VOID)
@@ -200,7 +408,7 @@ RSU_OSAL_INT librsu_cfg_writeprotected(RSU_OSAL_INT slot)
 		return 0;
 	}
 
-	if (hal->writeprotect & (1 << slot)) {
+	if (hal->cfg.writeprotect & (1 << slot)) {
 		return 1;
 	}
 
@@ -210,9 +418,67 @@ RSU_OSAL_INT librsu_cfg_writeprotected(RSU_OSAL_INT slot)
 RSU_OSAL_INT librsu_cfg_spt_checksum_enabled(RSU_OSAL_VOID)
 {
 
-	if (hal->spt_checksum_enabled) {
+	if (hal->cfg.spt_checksum_enabled) {
 		return 1;
 	}
 
 	return 0;
 }
+
+RSU_OSAL_INT librsu_cfg_program_preflight(RSU_OSAL_VOID)
+{
+	if (hal != NULL && hal->cfg.program_preflight) {
+		return 1;
+	}
+
+	return 0;
+}
+
+RSU_OSAL_INT librsu_cfg_read_only(RSU_OSAL_VOID)
+{
+	if (hal != NULL && hal->cfg.read_only) {
+		return 1;
+	}
+
+	return 0;
+}
+
+RSU_OSAL_INT librsu_cfg_metadata_repair(RSU_OSAL_VOID)
+{
+	if (hal == NULL) {
+		return RSU_REPAIR_BACKGROUND;
+	}
+
+	return hal->cfg.metadata_repair;
+}
+
+RSU_OSAL_U32 librsu_cfg_status_poll_interval(RSU_OSAL_VOID)
+{
+	if (hal == NULL || hal->cfg.status_poll_interval == 0) {
+		return RSU_STATUS_POLL_INTERVAL;
+	}
+
+	return hal->cfg.status_poll_interval;
+}
+
+RSU_OSAL_CHAR *librsu_cfg_digest_manifest(RSU_OSAL_INT *alg)
+{
+	if (hal == NULL || hal->cfg.digest_manifest[0] == '\0') {
+		return NULL;
+	}
+
+	if (alg) {
+		*alg = hal->cfg.digest_manifest_alg;
+	}
+
+	return hal->cfg.digest_manifest;
+}
+
+RSU_OSAL_CHAR *librsu_cfg_metadata_cache(RSU_OSAL_VOID)
+{
+	if (hal == NULL || hal->cfg.metadata_cache[0] == '\0') {
+		return NULL;
+	}
+
+	return hal->cfg.metadata_cache;
+}
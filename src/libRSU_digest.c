@@ -0,0 +1,328 @@
+/*
+ * Copyright (C) 2023-2024 Intel Corporation
+ * SPDX-License-Identifier: MIT-0
+ */
+
+#include <libRSU_digest.h>
+#include <libRSU_cb.h>
+#include <libRSU_image.h>
+#include <utils/RSU_logging.h>
+#include <utils/RSU_utils.h>
+
+static RSU_OSAL_VOID digest_update(struct librsu_digest *st, const RSU_OSAL_U8 *data,
+				   RSU_OSAL_U32 len)
+{
+	if (st->alg == RSU_DIGEST_SHA256) {
+		librsu_sha256_update(&st->u.sha256, data, len);
+	} else {
+		librsu_sha512_update(&st->u.sha512, data, len);
+	}
+}
+
+static RSU_OSAL_BOOL digest_is_erased(const RSU_OSAL_U8 *data, RSU_OSAL_U32 len)
+{
+	RSU_OSAL_U32 x;
+
+	for (x = 0; x < len; x++) {
+		if (data[x] != 0xFF) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static RSU_OSAL_INT digest_sink(RSU_OSAL_VOID *arg, const RSU_OSAL_VOID *buf, RSU_OSAL_INT size)
+{
+	struct librsu_digest *st = arg;
+	const RSU_OSAL_U8 *data = buf;
+	RSU_OSAL_U32 len;
+	RSU_OSAL_U32 n;
+
+	if (!st->trim) {
+		digest_update(st, data, size);
+		return 0;
+	}
+
+	/*
+	 * Erased blocks are held back until a programmed block follows, so the
+	 * erased tail of the slot is never hashed. Blocks are counted from the
+	 * start of the slot and can come in pieces; once a block has programmed
+	 * bytes, the rest of it is hashed as it comes.
+	 */
+	while (size > 0) {
+		len = IMAGE_BLOCK_SZ - (st->pos % IMAGE_BLOCK_SZ);
+		if ((RSU_OSAL_U32)size < len) {
+			len = size;
+		}
+
+		if (!st->dirty && digest_is_erased(data, len)) {
+			st->pending += len;
+		} else {
+			while (st->pending) {
+				n = st->pending < sizeof(st->erased) ? st->pending
+								      : sizeof(st->erased);
+				digest_update(st, st->erased, n);
+				st->pending -= n;
+			}
+			digest_update(st, data, len);
+			st->dirty = true;
+		}
+
+		st->pos += len;
+		if (st->pos % IMAGE_BLOCK_SZ == 0) {
+			st->dirty = false;
+		}
+
+		data += len;
+		size -= len;
+	}
+
+	return 0;
+}
+
+/*
+ * The reader thread fills one buffer from the flash while the caller hashes
+ * the other one, so reading and hashing overlap.
+ */
+struct digest_reader {
+	struct librsu_hl_intf *intf;
+	RSU_OSAL_INT part_num;
+	RSU_OSAL_U32 offset;
+	RSU_OSAL_U32 len;
+	RSU_OSAL_U8 *buf[2];
+	RSU_OSAL_U32 fill[2];
+	RSU_OSAL_BOOL full[2];
+	RSU_OSAL_INT error;
+	RSU_OSAL_BOOL stop;
+	RSU_OSAL_MUTEX mutex;
+	RSU_OSAL_COND cond;
+};
+
+static RSU_OSAL_VOID *digest_read_worker(RSU_OSAL_VOID *arg)
+{
+	struct digest_reader *rd = arg;
+	RSU_OSAL_U32 idx = 0;
+	RSU_OSAL_U32 cnt;
+	RSU_OSAL_INT ret;
+
+	while (rd->len) {
+		rsu_mutex_timedlock(&rd->mutex, RSU_TIME_FOREVER);
+		while (rd->full[idx] && !rd->stop) {
+			rsu_cond_timedwait(&rd->cond, &rd->mutex, RSU_TIME_FOREVER);
+		}
+		if (rd->stop) {
+			rsu_mutex_unlock(&rd->mutex);
+			break;
+		}
+		rsu_mutex_unlock(&rd->mutex);
+
+		cnt = rd->len < RSU_SLOT_READ_CHUNK_SIZE ? rd->len : RSU_SLOT_READ_CHUNK_SIZE;
+		ret = rd->intf->data.read(rd->part_num, rd->offset, cnt, rd->buf[idx]);
+
+		rsu_mutex_timedlock(&rd->mutex, RSU_TIME_FOREVER);
+		if (ret) {
+			RSU_LOG_ERR("Unable to rd part %i, offs 0x%08x, cnt %u", rd->part_num,
+				    rd->offset, cnt);
+			rd->error = -ELOWLEVEL;
+		} else {
+			rd->fill[idx] = cnt;
+			rd->full[idx] = true;
+		}
+		rsu_cond_signal(&rd->cond);
+		rsu_mutex_unlock(&rd->mutex);
+
+		if (ret) {
+			break;
+		}
+
+		rd->offset += cnt;
+		rd->len -= cnt;
+		idx ^= 1;
+	}
+
+	return NULL;
+}
+
+static RSU_OSAL_INT digest_read_overlapped(struct digest_reader *rd, struct librsu_digest *st)
+{
+	RSU_OSAL_U32 left = rd->len;
+	RSU_OSAL_U32 idx = 0;
+	RSU_OSAL_THREAD thread;
+	RSU_OSAL_INT rtn = 0;
+
+	if (rsu_thread_create(&thread, digest_read_worker, rd)) {
+		return -EAGAIN;
+	}
+
+	while (left) {
+		rsu_mutex_timedlock(&rd->mutex, RSU_TIME_FOREVER);
+		while (!rd->full[idx] && !rd->error) {
+			rsu_cond_timedwait(&rd->cond, &rd->mutex, RSU_TIME_FOREVER);
+		}
+		rtn = rd->full[idx] ? 0 : rd->error;
+		rsu_mutex_unlock(&rd->mutex);
+
+		if (rtn) {
+			break;
+		}
+
+		digest_sink(st, rd->buf[idx], rd->fill[idx]);
+		left -= rd->fill[idx];
+
+		rsu_mutex_timedlock(&rd->mutex, RSU_TIME_FOREVER);
+		rd->full[idx] = false;
+		rsu_cond_signal(&rd->cond);
+		rsu_mutex_unlock(&rd->mutex);
+
+		idx ^= 1;
+	}
+
+	rsu_mutex_timedlock(&rd->mutex, RSU_TIME_FOREVER);
+	rd->stop = true;
+	rsu_cond_signal(&rd->cond);
+	rsu_mutex_unlock(&rd->mutex);
+
+	rsu_thread_join(&thread, NULL);
+
+	return rtn;
+}
+
+/*
+ * digest_read() - feed a partition to the hash, from offset to its end
+ *
+ * Slots of more than one chunk are read by a reader thread into two buffers
+ * in turn. Without the buffers or a thread, the slot is read and hashed one
+ * chunk at a time by the caller.
+ */
+static RSU_OSAL_INT digest_read(struct librsu_hl_intf *intf, RSU_OSAL_INT part_num,
+				RSU_OSAL_U32 offset, RSU_OSAL_U32 size, struct librsu_digest *st)
+{
+	struct digest_reader rd;
+	RSU_OSAL_INT rtn = -EAGAIN;
+
+	if (size - offset > RSU_SLOT_READ_CHUNK_SIZE) {
+		rsu_memset(&rd, 0, sizeof(rd));
+		rd.intf = intf;
+		rd.part_num = part_num;
+		rd.offset = offset;
+		rd.len = size - offset;
+		rd.buf[0] = rsu_malloc(RSU_SLOT_READ_CHUNK_SIZE);
+		rd.buf[1] = rsu_malloc(RSU_SLOT_READ_CHUNK_SIZE);
+
+		if (rd.buf[0] && rd.buf[1] && rsu_mutex_init(&rd.mutex) == 0) {
+			if (rsu_cond_init(&rd.cond) == 0) {
+				rtn = digest_read_overlapped(&rd, st);
+				rsu_cond_destroy(&rd.cond);
+			}
+			rsu_mutex_destroy(&rd.mutex);
+		}
+
+		if (rd.buf[1]) {
+			rsu_free(rd.buf[1]);
+		}
+		if (rd.buf[0]) {
+			rsu_free(rd.buf[0]);
+		}
+
+		if (rtn != -EAGAIN) {
+			return rtn;
+		}
+		RSU_LOG_DBG("reading the slot without a reader thread");
+	}
+
+	if (offset == size) {
+		return 0;
+	}
+
+	return librsu_cb_read_common(intf, part_num, offset, size - offset, digest_sink, st);
+}
+
+RSU_OSAL_INT librsu_digest_size(RSU_OSAL_INT alg)
+{
+	switch (alg & RSU_DIGEST_ALG_MASK) {
+	case RSU_DIGEST_SHA256:
+		return RSU_DIGEST_SHA256_SIZE;
+	case RSU_DIGEST_SHA384:
+		return RSU_DIGEST_SHA384_SIZE;
+	default:
+		return -EINVAL;
+	}
+}
+
+RSU_OSAL_INT librsu_digest_init(struct librsu_digest *d, RSU_OSAL_INT alg)
+{
+	if (!d || librsu_digest_size(alg) < 0) {
+		return -EARGS;
+	}
+
+	rsu_memset(d, 0, sizeof(*d));
+	d->alg = alg & RSU_DIGEST_ALG_MASK;
+	d->trim = (alg & RSU_DIGEST_TRIM_ERASED) != 0;
+	rsu_memset(d->erased, 0xFF, sizeof(d->erased));
+
+	if (d->alg == RSU_DIGEST_SHA256) {
+		librsu_sha256_init(&d->u.sha256);
+	} else {
+		librsu_sha384_init(&d->u.sha512);
+	}
+
+	return 0;
+}
+
+RSU_OSAL_VOID librsu_digest_update(struct librsu_digest *d, const RSU_OSAL_VOID *data,
+				   RSU_OSAL_U32 len)
+{
+	digest_sink(d, data, len);
+}
+
+RSU_OSAL_VOID librsu_digest_final(struct librsu_digest *d, RSU_OSAL_U8 *out)
+{
+	if (d->alg == RSU_DIGEST_SHA256) {
+		librsu_sha256_final(&d->u.sha256, out);
+	} else {
+		librsu_sha384_final(&d->u.sha512, out);
+	}
+}
+
+RSU_OSAL_INT librsu_digest_slot_rest(struct librsu_hl_intf *intf, RSU_OSAL_INT part_num,
+				     RSU_OSAL_U32 offset, struct librsu_digest *d)
+{
+	RSU_OSAL_INT size;
+
+	if (!intf || !d) {
+		return -EARGS;
+	}
+
+	size = intf->partition.size(part_num);
+	if (size < 0) {
+		RSU_LOG_ERR("Error in getting the slot size");
+		return -ELOWLEVEL;
+	}
+
+	if (offset > (RSU_OSAL_U32)size) {
+		return -EARGS;
+	}
+
+	return digest_read(intf, part_num, offset, size, d);
+}
+
+RSU_OSAL_INT librsu_digest_slot(struct librsu_hl_intf *intf, RSU_OSAL_INT part_num,
+				RSU_OSAL_INT alg, RSU_OSAL_U8 *out)
+{
+	struct librsu_digest d;
+	RSU_OSAL_INT rtn;
+
+	if (!intf || !out || librsu_digest_init(&d, alg)) {
+		return -EARGS;
+	}
+
+	rtn = librsu_digest_slot_rest(intf, part_num, 0, &d);
+	if (rtn) {
+		return rtn;
+	}
+
+	librsu_digest_final(&d, out);
+
+	return 0;
+}
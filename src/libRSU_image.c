@@ -6,8 +6,10 @@
 #include <libRSU.h>
 #include <libRSU_image.h>
 #include <libRSU_misc.h>
+#include <libRSU_probe.h>
 #include <hal/RSU_plat_crc32.h>
 #include <utils/RSU_logging.h>
+#include <string.h>
 
 /**
  * @brief pointer block in application image
@@ -25,21 +27,110 @@ struct pointer_block {
 	RSU_OSAL_U32 crc;
 };
 
+/** bit reversed value of every byte */
+static const RSU_OSAL_U8 bit_reverse[256] = {
+	0x00, 0x80, 0x40, 0xC0, 0x20, 0xA0, 0x60, 0xE0,
+	0x10, 0x90, 0x50, 0xD0, 0x30, 0xB0, 0x70, 0xF0,
+	0x08, 0x88, 0x48, 0xC8, 0x28, 0xA8, 0x68, 0xE8,
+	0x18, 0x98, 0x58, 0xD8, 0x38, 0xB8, 0x78, 0xF8,
+	0x04, 0x84, 0x44, 0xC4, 0x24, 0xA4, 0x64, 0xE4,
+	0x14, 0x94, 0x54, 0xD4, 0x34, 0xB4, 0x74, 0xF4,
+	0x0C, 0x8C, 0x4C, 0xCC, 0x2C, 0xAC, 0x6C, 0xEC,
+	0x1C, 0x9C, 0x5C, 0xDC, 0x3C, 0xBC, 0x7C, 0xFC,
+	0x02, 0x82, 0x42, 0xC2, 0x22, 0xA2, 0x62, 0xE2,
+	0x12, 0x92, 0x52, 0xD2, 0x32, 0xB2, 0x72, 0xF2,
+	0x0A, 0x8A, 0x4A, 0xCA, 0x2A, 0xAA, 0x6A, 0xEA,
+	0x1A, 0x9A, 0x5A, 0xDA, 0x3A, 0xBA, 0x7A, 0xFA,
+	0x06, 0x86, 0x46, 0xC6, 0x26, 0xA6, 0x66, 0xE6,
+	0x16, 0x96, 0x56, 0xD6, 0x36, 0xB6, 0x76, 0xF6,
+	0x0E, 0x8E, 0x4E, 0xCE, 0x2E, 0xAE, 0x6E, 0xEE,
+	0x1E, 0x9E, 0x5E, 0xDE, 0x3E, 0xBE, 0x7E, 0xFE,
+	0x01, 0x81, 0x41, 0xC1, 0x21, 0xA1, 0x61, 0xE1,
+	0x11, 0x91, 0x51, 0xD1, 0x31, 0xB1, 0x71, 0xF1,
+	0x09, 0x89, 0x49, 0xC9, 0x29, 0xA9, 0x69, 0xE9,
+	0x19, 0x99, 0x59, 0xD9, 0x39, 0xB9, 0x79, 0xF9,
+	0x05, 0x85, 0x45, 0xC5, 0x25, 0xA5, 0x65, 0xE5,
+	0x15, 0x95, 0x55, 0xD5, 0x35, 0xB5, 0x75, 0xF5,
+	0x0D, 0x8D, 0x4D, 0xCD, 0x2D, 0xAD, 0x6D, 0xED,
+	0x1D, 0x9D, 0x5D, 0xDD, 0x3D, 0xBD, 0x7D, 0xFD,
+	0x03, 0x83, 0x43, 0xC3, 0x23, 0xA3, 0x63, 0xE3,
+	0x13, 0x93, 0x53, 0xD3, 0x33, 0xB3, 0x73, 0xF3,
+	0x0B, 0x8B, 0x4B, 0xCB, 0x2B, 0xAB, 0x6B, 0xEB,
+	0x1B, 0x9B, 0x5B, 0xDB, 0x3B, 0xBB, 0x7B, 0xFB,
+	0x07, 0x87, 0x47, 0xC7, 0x27, 0xA7, 0x67, 0xE7,
+	0x17, 0x97, 0x57, 0xD7, 0x37, 0xB7, 0x77, 0xF7,
+	0x0F, 0x8F, 0x4F, 0xCF, 0x2F, 0xAF, 0x6F, 0xEF,
+	0x1F, 0x9F, 0x5F, 0xDF, 0x3F, 0xBF, 0x7F, 0xFF
+};
+
 /**
- * @brief search section in the current list of identified sections
+ * @brief compute the CRC32 of bit-swapped data
  *
- * @param state current state machine state
- * @param section section to be searched
- * @return 1 if section is found, 0 if section is not found
+ * @note Signature block CRCs are computed over the bit-swapped bytes of the block. The bytes are
+ * swapped through a small bounce buffer, so the block itself is never modified.
+ *
+ * @param crc CRC of the previous data, 0 to start
+ * @param data data to be processed
+ * @param len length of the data in bytes
+ * @return updated CRC value
  */
-static RSU_OSAL_INT find_section(struct rsu_image_state *state, RSU_OSAL_U64 section)
+static RSU_OSAL_U32 swapped_crc32(RSU_OSAL_U32 crc, const RSU_OSAL_U8 *data, RSU_OSAL_U32 len)
 {
-	RSU_OSAL_INT x;
+	RSU_OSAL_U8 tmp[256];
+	RSU_OSAL_U32 cnt, x;
 
-	for (x = 0; x < state->no_sections; x++) {
-		if (section == state->sections[x]) {
-			return 1;
+	while (len) {
+		cnt = len < sizeof(tmp) ? len : sizeof(tmp);
+		for (x = 0; x < cnt; x++) {
+			tmp[x] = bit_reverse[data[x]];
 		}
+		crc = rsu_crc32(crc, tmp, cnt);
+		data += cnt;
+		len -= cnt;
+	}
+
+	return crc;
+}
+
+/**
+ * @brief convert between the CRC field of a signature block and the CRC value
+ *
+ * @note The CRC value is stored in big endian in the bit-swapped block, the conversion is its own
+ * inverse.
+ *
+ * @param val CRC field or CRC value
+ * @return CRC value or CRC field
+ */
+static RSU_OSAL_U32 sig_block_crc_field(RSU_OSAL_U32 val)
+{
+	val = swap_endian32(val);
+
+	return (RSU_OSAL_U32)bit_reverse[val & 0xFF] |
+	       ((RSU_OSAL_U32)bit_reverse[(val >> 8) & 0xFF] << 8) |
+	       ((RSU_OSAL_U32)bit_reverse[(val >> 16) & 0xFF] << 16) |
+	       ((RSU_OSAL_U32)bit_reverse[(val >> 24) & 0xFF] << 24);
+}
+
+/**
+ * @brief check whether the current block starts a section
+ *
+ * @note Blocks are processed in increasing offset order and the sections are kept sorted, so
+ * only the first section not reached yet needs to be looked at.
+ *
+ * @param state current state machine state
+ * @return 1 if the current block starts a section, 0 otherwise
+ */
+static RSU_OSAL_INT next_section(struct rsu_image_state *state)
+{
+	while (state->next_section < state->no_sections &&
+	       (RSU_OSAL_S64)state->sections[state->next_section] < state->offset) {
+		state->next_section++;
+	}
+
+	if (state->next_section < state->no_sections &&
+	    (RSU_OSAL_S64)state->sections[state->next_section] == state->offset) {
+		state->next_section++;
+		return 1;
 	}
 
 	return 0;
@@ -48,21 +139,52 @@ static RSU_OSAL_INT find_section(struct rsu_image_state *state, RSU_OSAL_U64 sec
 /**
  * @brief add section to the current list of identified sections
  *
+ * @note Sections at or before the current block can never be reached again and are dropped,
+ * entries already passed are reclaimed when the list is full.
+ *
  * @param state current state machine state
  * @param section section to be added
  * @return zero value for success, or negative value on error
  */
 static RSU_OSAL_INT add_section(struct rsu_image_state *state, RSU_OSAL_U64 section)
 {
-	if (find_section(state, section)) {
+	RSU_OSAL_INT lo, hi, mid;
+
+	if ((RSU_OSAL_S64)section <= state->offset) {
+		return 0;
+	}
+
+	lo = state->next_section;
+	hi = state->no_sections;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (state->sections[mid] < section) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	if (lo < state->no_sections && state->sections[lo] == section) {
 		return 0;
 	}
 
 	if (state->no_sections >= MAX_SECTIONS) {
-		return -1;
+		if (state->next_section == 0) {
+			return -1;
+		}
+
+		memmove(&state->sections[0], &state->sections[state->next_section],
+			(state->no_sections - state->next_section) * sizeof(state->sections[0]));
+		state->no_sections -= state->next_section;
+		lo -= state->next_section;
+		state->next_section = 0;
 	}
 
-	state->sections[state->no_sections++] = section;
+	memmove(&state->sections[lo + 1], &state->sections[lo],
+		(state->no_sections - lo) * sizeof(state->sections[0]));
+	state->sections[lo] = section;
+	state->no_sections++;
 
 	return 0;
 }
@@ -83,6 +205,7 @@ static RSU_OSAL_INT sig_block_process(struct rsu_image_state *state, RSU_OSAL_VO
 {
 	RSU_OSAL_CHAR *data = (RSU_OSAL_CHAR *)block;
 	struct pointer_block *ptr_blk = (struct pointer_block *)(data + SIG_BLOCK_PTR_OFFS);
+	RSU_OSAL_INT ret;
 	RSU_OSAL_INT x;
 
 	/* Determine if absolute image - only done for 2nd block in an image
@@ -100,12 +223,19 @@ static RSU_OSAL_INT sig_block_process(struct rsu_image_state *state, RSU_OSAL_VO
 
 	/* Add pointers to list of identified sections */
 	for (x = 0; x < 4; x++) {
-		if (ptr_blk->ptrs[x]) {
-			if (state->absolute) {
-				add_section(state, ptr_blk->ptrs[x] - info->offset);
-			} else {
-				add_section(state, ptr_blk->ptrs[x]);
-			}
+		if (!ptr_blk->ptrs[x]) {
+			continue;
+		}
+
+		if (state->absolute) {
+			ret = add_section(state, ptr_blk->ptrs[x] - info->offset);
+		} else {
+			ret = add_section(state, ptr_blk->ptrs[x]);
+		}
+
+		if (ret) {
+			RSU_LOG_ERR("Error: More than %i sections ahead in the image", MAX_SECTIONS);
+			return -1;
 		}
 	}
 
@@ -132,18 +262,15 @@ static RSU_OSAL_INT sig_block_adjust(struct rsu_image_state *state, RSU_OSAL_VOI
 	struct pointer_block *ptr_blk = (struct pointer_block *)(data + SIG_BLOCK_PTR_OFFS);
 
 	/*
-	 * Check CRC on 4kB block before proceeding.  All bytes must be
-	 * bit-swapped before they can used in CRC32 library function.
-	 * The CRC value is stored in big endian in the bitstream.
+	 * Check CRC on 4kB block before proceeding.  The CRC is computed over
+	 * the bit-swapped bytes of the block.
 	 */
-	swap_bits(block, IMAGE_BLOCK_SZ);
-	calc_crc = rsu_crc32(0, block, SIG_BLOCK_CRC_OFFS);
-	if (swap_endian32(ptr_blk->crc) != calc_crc) {
+	calc_crc = swapped_crc32(0, (RSU_OSAL_U8 *)block, SIG_BLOCK_CRC_OFFS);
+	if (sig_block_crc_field(ptr_blk->crc) != calc_crc) {
 		RSU_LOG_ERR("Error: Bad CRC32. Calc = %08X / From Block = %08x", calc_crc,
-			    swap_endian32(ptr_blk->crc));
+			    sig_block_crc_field(ptr_blk->crc));
 		return -1;
 	}
-	swap_bits(block, IMAGE_BLOCK_SZ);
 
 	/* Check pointers */
 	for (x = 0; x < 4; x++) {
@@ -174,15 +301,13 @@ static RSU_OSAL_INT sig_block_adjust(struct rsu_image_state *state, RSU_OSAL_VOI
 			RSU_OSAL_U64 old = ptr_blk->ptrs[x];
 
 			ptr_blk->ptrs[x] += info->offset;
-			RSU_LOG_ERR("Adjusting pointer 0x%llx -> 0x%llx.", old, ptr_blk->ptrs[x]);
+			RSU_LOG_DBG("Adjusting pointer 0x%llx -> 0x%llx.", old, ptr_blk->ptrs[x]);
 		}
 	}
 
 	/* Update CRC in block */
-	swap_bits(block, IMAGE_BLOCK_SZ);
-	calc_crc = rsu_crc32(0, block, SIG_BLOCK_CRC_OFFS);
-	ptr_blk->crc = swap_endian32(calc_crc);
-	swap_bits(block, IMAGE_BLOCK_SZ);
+	calc_crc = swapped_crc32(0, (RSU_OSAL_U8 *)block, SIG_BLOCK_CRC_OFFS);
+	ptr_blk->crc = sig_block_crc_field(calc_crc);
 
 	return 0;
 }
@@ -229,46 +354,50 @@ static RSU_OSAL_INT block_compare(struct rsu_image_state *state, RSU_OSAL_VOID *
 static RSU_OSAL_INT sig_block_compare(struct rsu_image_state *state, RSU_OSAL_VOID *ublock,
 				      RSU_OSAL_VOID *vblock, struct rsu_slot_info *info)
 {
+	RSU_OSAL_CHAR *ubuf = (RSU_OSAL_CHAR *)ublock;
+	RSU_OSAL_CHAR *vbuf = (RSU_OSAL_CHAR *)vblock;
+	struct pointer_block ptr_blk;
 	RSU_OSAL_U32 calc_crc;
-	RSU_OSAL_INT ret;
 	RSU_OSAL_INT x;
-	RSU_OSAL_CHAR *block;
-
-	block = rsu_malloc(IMAGE_BLOCK_SZ);
-	if (block == NULL) {
-		RSU_LOG_ERR("error in allocating memory");
-		return -ENOMEM;
-	}
-
-	struct pointer_block *ptr_blk = (struct pointer_block *)(block + SIG_BLOCK_PTR_OFFS);
 
 	RSU_LOG_INF("Comparing signature block @0x%08x", (RSU_OSAL_U32)state->offset);
 
-	/* Make a copy of the data provided by the user */
-	rsu_memcpy(block, ublock, IMAGE_BLOCK_SZ);
+	if (state->absolute) {
+		return block_compare(state, ublock, vblock);
+	}
 
-	/* Update signature block to match what we expect in flash */
-	if (!state->absolute) {
+	/*
+	 * Only the pointer block changes when relocating, so just that part of the data provided
+	 * by the user is copied and updated to match what we expect in flash.
+	 */
+	rsu_memcpy(&ptr_blk, ubuf + SIG_BLOCK_PTR_OFFS, sizeof(ptr_blk));
 
-		/* Update pointers */
-		for (x = 0; x < 4; x++) {
-			if (ptr_blk->ptrs[x]) {
-				ptr_blk->ptrs[x] += info->offset;
-			}
+	/* Update pointers */
+	for (x = 0; x < 4; x++) {
+		if (ptr_blk.ptrs[x]) {
+			ptr_blk.ptrs[x] += info->offset;
 		}
-
-		/* Update CRC in block */
-		swap_bits(block, IMAGE_BLOCK_SZ);
-		calc_crc = rsu_crc32(0, (RSU_OSAL_U8 *)block, SIG_BLOCK_CRC_OFFS);
-		ptr_blk->crc = swap_endian32(calc_crc);
-		swap_bits(block, IMAGE_BLOCK_SZ);
 	}
 
-	ret = block_compare(state, block, vblock);
+	/* Update CRC in block */
+	calc_crc = swapped_crc32(0, (RSU_OSAL_U8 *)ubuf, SIG_BLOCK_PTR_OFFS);
+	calc_crc = swapped_crc32(calc_crc, (RSU_OSAL_U8 *)&ptr_blk,
+				 SIG_BLOCK_CRC_OFFS - SIG_BLOCK_PTR_OFFS);
+	ptr_blk.crc = sig_block_crc_field(calc_crc);
+
+	for (x = 0; x < IMAGE_BLOCK_SZ; x++) {
+		RSU_OSAL_CHAR expect = x < SIG_BLOCK_PTR_OFFS
+					       ? ubuf[x]
+					       : ((RSU_OSAL_CHAR *)&ptr_blk)[x - SIG_BLOCK_PTR_OFFS];
 
-	rsu_free(block);
+		if (vbuf[x] != expect) {
+			RSU_LOG_ERR("Expect %02X, got %02X @0x%08X", expect, vbuf[x],
+				    (RSU_OSAL_U32)state->offset + x);
+			return -ECMP;
+		}
+	}
 
-	return ret;
+	return 0;
 }
 
 RSU_OSAL_INT librsu_image_block_init(struct rsu_image_state *state)
@@ -276,10 +405,11 @@ RSU_OSAL_INT librsu_image_block_init(struct rsu_image_state *state)
 	RSU_LOG_INF("Resetting image block state machine.");
 
 	state->no_sections = 0;
-	add_section(state, 0);
+	state->next_section = 0;
 	state->block_type = REGULAR_BLOCK;
 	state->absolute = 0;
 	state->offset = -IMAGE_BLOCK_SZ;
+	add_section(state, 0);
 
 	return 0;
 }
@@ -291,10 +421,12 @@ RSU_OSAL_INT librsu_image_block_process(struct rsu_image_state *state, RSU_OSAL_
 
 	state->offset += IMAGE_BLOCK_SZ;
 
-	if (find_section(state, state->offset)) {
+	if (next_section(state)) {
 		state->block_type = SECTION_BLOCK;
 	}
 
+	RSU_PROBE2(image__block, state->offset, state->block_type);
+
 	switch (state->block_type) {
 
 	case SECTION_BLOCK:
@@ -0,0 +1,237 @@
+/*
+ * Copyright (C) 2023-2024 Intel Corporation
+ * SPDX-License-Identifier: MIT-0
+ */
+
+#include <libRSU_inflate.h>
+#include <libRSU_cfg.h>
+#include <libRSU_ll_intf.h>
+#include <utils/RSU_logging.h>
+
+#ifdef RSU_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#define GZIP_ID1     0x1F
+#define GZIP_ID2     0x8B
+#define ZLIB_DEFLATE 8
+
+static RSU_OSAL_BOOL inflate_magic(const RSU_OSAL_U8 *hdr, RSU_OSAL_INT len)
+{
+	if (!hdr || len < 2) {
+		return false;
+	}
+
+	/* gzip member header */
+	if (len >= 3 && hdr[0] == GZIP_ID1 && hdr[1] == GZIP_ID2 && hdr[2] == ZLIB_DEFLATE) {
+		return true;
+	}
+
+	/* zlib header: deflate, 32K window at most, no preset dictionary, valid check bits */
+	if ((hdr[0] & 0x0F) == ZLIB_DEFLATE && (hdr[0] >> 4) <= 7 && !(hdr[1] & 0x20) &&
+	    ((hdr[0] << 8) | hdr[1]) % 31 == 0) {
+		return true;
+	}
+
+	return false;
+}
+
+#ifdef RSU_HAVE_ZLIB
+
+/*
+ * The zlib header is only two bytes, so an uncompressed image could match it
+ * by chance. Run the peeked bytes through the decoder and only take the file
+ * as compressed when they decode cleanly.
+ */
+static RSU_OSAL_BOOL inflate_trial(const RSU_OSAL_U8 *hdr, RSU_OSAL_INT len)
+{
+	RSU_OSAL_U8 scratch[256];
+	z_stream zs;
+	RSU_OSAL_INT ret;
+
+	rsu_memset(&zs, 0, sizeof(zs));
+	if (inflateInit2(&zs, 15 + 32) != Z_OK) {
+		return false;
+	}
+
+	zs.next_in = (Bytef *)(uintptr_t)hdr;
+	zs.avail_in = len;
+
+	do {
+		zs.next_out = scratch;
+		zs.avail_out = sizeof(scratch);
+		ret = inflate(&zs, Z_NO_FLUSH);
+	} while (ret == Z_OK && zs.avail_in);
+
+	inflateEnd(&zs);
+
+	return ret == Z_OK || ret == Z_STREAM_END || ret == Z_BUF_ERROR;
+}
+
+#endif
+
+RSU_OSAL_BOOL librsu_inflate_probe(const RSU_OSAL_U8 *hdr, RSU_OSAL_INT len)
+{
+	if (!inflate_magic(hdr, len)) {
+		return false;
+	}
+
+#ifdef RSU_HAVE_ZLIB
+	return inflate_trial(hdr, len);
+#else
+	return true;
+#endif
+}
+
+#ifdef RSU_HAVE_ZLIB
+
+struct inflate_stream {
+	RSU_OSAL_FILE *file;
+	z_stream zs;
+	RSU_OSAL_U8 *in;
+	RSU_OSAL_BOOL active;
+	RSU_OSAL_BOOL eof;
+	RSU_OSAL_BOOL done;
+};
+
+static struct inflate_stream stream;
+
+static voidpf inflate_zalloc(voidpf opaque, uInt items, uInt size)
+{
+	return rsu_malloc((RSU_OSAL_SIZE)items * size);
+}
+
+static void inflate_zfree(voidpf opaque, voidpf address)
+{
+	rsu_free(address);
+}
+
+RSU_OSAL_INT librsu_inflate_open(RSU_OSAL_FILE *file, RSU_OSAL_U8 *hdr, RSU_OSAL_INT len)
+{
+	if (!file || !hdr || len < 0 || len > RSU_INFLATE_IN_SZ) {
+		return -EINVAL;
+	}
+
+	librsu_inflate_close();
+
+	stream.in = rsu_malloc(RSU_INFLATE_IN_SZ);
+	if (!stream.in) {
+		RSU_LOG_ERR("Error in allocating memory");
+		return -ENOMEM;
+	}
+
+	/* bytes already read while probing the file are the first input */
+	rsu_memcpy(stream.in, hdr, len);
+
+	stream.zs.zalloc = inflate_zalloc;
+	stream.zs.zfree = inflate_zfree;
+	stream.zs.opaque = Z_NULL;
+	stream.zs.next_in = stream.in;
+	stream.zs.avail_in = len;
+
+	/* 32 added to the window bits makes zlib accept both gzip and zlib headers */
+	if (inflateInit2(&stream.zs, 15 + 32) != Z_OK) {
+		RSU_LOG_ERR("unable to initialize inflate");
+		rsu_free(stream.in);
+		stream.in = NULL;
+		return -ENOMEM;
+	}
+
+	stream.file = file;
+	stream.active = true;
+
+	return 0;
+}
+
+static RSU_OSAL_INT inflate_fill(struct librsu_ll_intf *hal)
+{
+	RSU_OSAL_INT c;
+
+	if (stream.zs.avail_in || stream.eof) {
+		return 0;
+	}
+
+	c = hal->file.read(stream.in, RSU_INFLATE_IN_SZ, stream.file);
+	if (c < 0) {
+		return c;
+	} else if (c == 0) {
+		stream.eof = true;
+	}
+
+	stream.zs.next_in = stream.in;
+	stream.zs.avail_in = c;
+
+	return 0;
+}
+
+RSU_OSAL_INT librsu_inflate_read(RSU_OSAL_VOID *buf, RSU_OSAL_INT len)
+{
+	struct librsu_ll_intf *hal = librsu_get_ll_inf();
+	RSU_OSAL_INT ret;
+
+	if (!hal || !stream.active || !buf || len < 0) {
+		return -EINVAL;
+	}
+
+	stream.zs.next_out = buf;
+	stream.zs.avail_out = len;
+
+	while (stream.zs.avail_out && !stream.done) {
+		if (inflate_fill(hal)) {
+			return -EIO;
+		}
+
+		ret = inflate(&stream.zs, Z_NO_FLUSH);
+		if (ret == Z_STREAM_END) {
+			/* a gzip file may hold several members back to back */
+			if (inflate_fill(hal)) {
+				return -EIO;
+			}
+			if (!stream.zs.avail_in) {
+				stream.done = true;
+			} else if (inflateReset(&stream.zs) != Z_OK) {
+				return -EIO;
+			}
+		} else if (ret == Z_BUF_ERROR && stream.eof) {
+			RSU_LOG_ERR("compressed input is truncated");
+			return -EIO;
+		} else if (ret != Z_OK && ret != Z_BUF_ERROR) {
+			RSU_LOG_ERR("error %d while inflating input", ret);
+			return -EIO;
+		}
+	}
+
+	return len - (RSU_OSAL_INT)stream.zs.avail_out;
+}
+
+RSU_OSAL_VOID librsu_inflate_close(RSU_OSAL_VOID)
+{
+	if (stream.active) {
+		inflateEnd(&stream.zs);
+	}
+
+	if (stream.in) {
+		rsu_free(stream.in);
+	}
+
+	rsu_memset(&stream, 0, sizeof(stream));
+}
+
+#else
+
+RSU_OSAL_INT librsu_inflate_open(RSU_OSAL_FILE *file, RSU_OSAL_U8 *hdr, RSU_OSAL_INT len)
+{
+	RSU_LOG_ERR("compressed input found but zlib support is not built in");
+	return -ENOTSUP;
+}
+
+RSU_OSAL_INT librsu_inflate_read(RSU_OSAL_VOID *buf, RSU_OSAL_INT len)
+{
+	return -ENOTSUP;
+}
+
+RSU_OSAL_VOID librsu_inflate_close(RSU_OSAL_VOID)
+{
+}
+
+#endif
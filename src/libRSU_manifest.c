@@ -0,0 +1,331 @@
+/*
+ * Copyright (C) 2023-2024 Intel Corporation
+ * SPDX-License-Identifier: MIT-0
+ */
+
+#include <libRSU_manifest.h>
+#include <libRSU_cfg.h>
+#include <libRSU_digest.h>
+#include <libRSU_ll_intf.h>
+#include <libRSU_misc.h>
+#include <utils/RSU_logging.h>
+#include <string.h>
+
+#define MANIFEST_MAX_ENTRIES SPT_MAX_PARTITIONS
+
+struct manifest {
+	struct rsu_manifest_header hdr;
+	struct rsu_manifest_entry entry[MANIFEST_MAX_ENTRIES];
+};
+
+static RSU_OSAL_U32 manifest_crc(struct manifest *m)
+{
+	RSU_OSAL_U32 saved = m->hdr.crc;
+	RSU_OSAL_U32 crc;
+
+	m->hdr.crc = 0;
+	crc = rsu_crc32(0, (const RSU_OSAL_U8 *)&m->hdr, sizeof(m->hdr));
+	crc = rsu_crc32(crc, (const RSU_OSAL_U8 *)m->entry,
+			m->hdr.entries * sizeof(struct rsu_manifest_entry));
+	m->hdr.crc = saved;
+
+	return crc;
+}
+
+/*
+ * Neither the SPT nor the CPB carries a generation counter, so the slot table
+ * as seen through the partition API is hashed instead. Any change to it, from
+ * a slot being created, deleted, renamed or a restored SPT, retires all the
+ * entries made before.
+ */
+static RSU_OSAL_U32 manifest_generation(struct librsu_hl_intf *intf)
+{
+	RSU_OSAL_CHAR name[SPT_PARTITION_NAME_LENGTH];
+	RSU_OSAL_U64 offset;
+	RSU_OSAL_INT size;
+	RSU_OSAL_INT count;
+	RSU_OSAL_U32 crc = 0;
+	RSU_OSAL_INT x;
+
+	count = intf->partition.count();
+	for (x = 0; x < count; x++) {
+		rsu_memset(name, 0, sizeof(name));
+		SAFE_STRCPY(name, sizeof(name), intf->partition.name(x), sizeof(name));
+		offset = 0;
+		intf->partition.offset(x, &offset);
+		size = intf->partition.size(x);
+
+		crc = rsu_crc32(crc, (const RSU_OSAL_U8 *)name, sizeof(name));
+		crc = rsu_crc32(crc, (const RSU_OSAL_U8 *)&offset, sizeof(offset));
+		crc = rsu_crc32(crc, (const RSU_OSAL_U8 *)&size, sizeof(size));
+	}
+
+	return crc;
+}
+
+/* a missing or damaged manifest reads back as an empty one */
+static RSU_OSAL_VOID manifest_load(struct librsu_ll_intf *hal, RSU_OSAL_CHAR *path,
+				   struct manifest *m)
+{
+	RSU_OSAL_FILE *file;
+	RSU_OSAL_U32 len, cnt = 0;
+	RSU_OSAL_INT c;
+
+	rsu_memset(m, 0, sizeof(*m));
+
+	file = hal->file.open(path, RSU_FILE_READ);
+	if (file == NULL) {
+		goto empty;
+	}
+
+	len = sizeof(*m);
+	while (cnt < len) {
+		c = hal->file.read((RSU_OSAL_U8 *)m + cnt, len - cnt, file);
+		if (c <= 0) {
+			break;
+		}
+		cnt += c;
+	}
+	hal->file.close(file);
+
+	if (cnt < sizeof(m->hdr) || m->hdr.magic != RSU_MANIFEST_MAGIC ||
+	    m->hdr.version != RSU_MANIFEST_VERSION || m->hdr.entries > MANIFEST_MAX_ENTRIES ||
+	    cnt < sizeof(m->hdr) + m->hdr.entries * sizeof(struct rsu_manifest_entry) ||
+	    manifest_crc(m) != m->hdr.crc) {
+		RSU_LOG_DBG("digest manifest not valid, starting an empty one");
+		goto empty;
+	}
+
+	return;
+
+empty:
+	rsu_memset(m, 0, sizeof(*m));
+	m->hdr.magic = RSU_MANIFEST_MAGIC;
+	m->hdr.version = RSU_MANIFEST_VERSION;
+}
+
+static RSU_OSAL_INT manifest_save(struct librsu_ll_intf *hal, RSU_OSAL_CHAR *path,
+				  struct manifest *m)
+{
+	RSU_OSAL_FILE *file;
+	RSU_OSAL_U32 len;
+	RSU_OSAL_INT rtn = 0;
+
+	m->hdr.crc = manifest_crc(m);
+	len = sizeof(m->hdr) + m->hdr.entries * sizeof(struct rsu_manifest_entry);
+
+	file = hal->file.open(path, RSU_FILE_WRITE);
+	if (file == NULL) {
+		RSU_LOG_ERR("Unable to open digest manifest '%s'", path);
+		return -EFILEIO;
+	}
+
+	if (hal->file.write(m, len, file) != (RSU_OSAL_INT)len) {
+		RSU_LOG_ERR("Unable to write digest manifest '%s'", path);
+		rtn = -EFILEIO;
+	}
+
+	hal->file.close(file);
+	return rtn;
+}
+
+static RSU_OSAL_INT manifest_find(struct manifest *m, RSU_OSAL_U64 offset, RSU_OSAL_U32 size)
+{
+	RSU_OSAL_U32 x;
+
+	for (x = 0; x < m->hdr.entries; x++) {
+		if (m->entry[x].offset == offset && m->entry[x].size == size) {
+			return x;
+		}
+	}
+
+	return -1;
+}
+
+static RSU_OSAL_INT manifest_slot_key(struct librsu_hl_intf *intf, RSU_OSAL_INT part_num,
+				      RSU_OSAL_U64 *offset, RSU_OSAL_U32 *size)
+{
+	RSU_OSAL_INT c;
+
+	if (intf->partition.offset(part_num, offset) < 0) {
+		return -ELOWLEVEL;
+	}
+
+	c = intf->partition.size(part_num);
+	if (c < 0) {
+		return -ELOWLEVEL;
+	}
+	*size = c;
+
+	return 0;
+}
+
+/*
+ * Entries are replaced or removed under the library mutex, there is a single
+ * read-modify-write of the whole file per update.
+ */
+static RSU_OSAL_INT manifest_update(struct librsu_hl_intf *intf, RSU_OSAL_INT part_num,
+				    RSU_OSAL_INT alg, const RSU_OSAL_U8 *digest)
+{
+	struct librsu_ll_intf *hal = librsu_get_ll_inf();
+	struct manifest *m;
+	RSU_OSAL_CHAR *path;
+	RSU_OSAL_U64 offset;
+	RSU_OSAL_U32 size;
+	RSU_OSAL_INT x, rtn;
+
+	path = librsu_cfg_digest_manifest(NULL);
+	if (path == NULL || hal == NULL) {
+		return 0;
+	}
+
+	rtn = manifest_slot_key(intf, part_num, &offset, &size);
+	if (rtn) {
+		return rtn;
+	}
+
+	m = rsu_malloc(sizeof(*m));
+	if (m == NULL) {
+		RSU_LOG_ERR("Error in allocating memory");
+		return -ENOMEM;
+	}
+
+	manifest_load(hal, path, m);
+
+	x = manifest_find(m, offset, size);
+	if (digest == NULL) {
+		if (x < 0) {
+			rsu_free(m);
+			return 0;
+		}
+		m->hdr.entries--;
+		memmove(&m->entry[x], &m->entry[x + 1],
+			    (m->hdr.entries - x) * sizeof(struct rsu_manifest_entry));
+	} else {
+		if (x < 0) {
+			if (m->hdr.entries == MANIFEST_MAX_ENTRIES) {
+				memmove(&m->entry[0], &m->entry[1],
+					    (MANIFEST_MAX_ENTRIES - 1) *
+						    sizeof(struct rsu_manifest_entry));
+				m->hdr.entries--;
+			}
+			x = m->hdr.entries++;
+		}
+		rsu_memset(&m->entry[x], 0, sizeof(m->entry[x]));
+		m->entry[x].offset = offset;
+		m->entry[x].size = size;
+		m->entry[x].generation = manifest_generation(intf);
+		m->entry[x].alg = alg;
+		rsu_memcpy(m->entry[x].digest, (RSU_OSAL_VOID *)(uintptr_t)digest,
+			   librsu_digest_size(alg));
+	}
+
+	rtn = manifest_save(hal, path, m);
+
+	rsu_free(m);
+	return rtn;
+}
+
+RSU_OSAL_INT librsu_manifest_lookup(struct librsu_hl_intf *intf, RSU_OSAL_INT part_num,
+				    RSU_OSAL_INT alg, RSU_OSAL_U8 *digest)
+{
+	struct librsu_ll_intf *hal = librsu_get_ll_inf();
+	struct manifest *m;
+	RSU_OSAL_CHAR *path;
+	RSU_OSAL_U64 offset;
+	RSU_OSAL_U32 size;
+	RSU_OSAL_INT x, rtn;
+
+	if (!intf || !digest) {
+		return -EARGS;
+	}
+
+	path = librsu_cfg_digest_manifest(NULL);
+	if (path == NULL || hal == NULL) {
+		return -ENODIGEST;
+	}
+
+	rtn = manifest_slot_key(intf, part_num, &offset, &size);
+	if (rtn) {
+		return rtn;
+	}
+
+	m = rsu_malloc(sizeof(*m));
+	if (m == NULL) {
+		RSU_LOG_ERR("Error in allocating memory");
+		return -ENOMEM;
+	}
+
+	manifest_load(hal, path, m);
+
+	rtn = -ENODIGEST;
+	x = manifest_find(m, offset, size);
+	if (x >= 0 && (RSU_OSAL_INT)m->entry[x].alg == alg &&
+	    m->entry[x].generation == manifest_generation(intf)) {
+		rsu_memcpy(digest, m->entry[x].digest, librsu_digest_size(alg));
+		rtn = 0;
+	}
+
+	rsu_free(m);
+	return rtn;
+}
+
+RSU_OSAL_INT librsu_manifest_store(struct librsu_hl_intf *intf, RSU_OSAL_INT part_num,
+				   RSU_OSAL_INT alg, const RSU_OSAL_U8 *digest)
+{
+	if (!intf || !digest || librsu_digest_size(alg) < 0) {
+		return -EARGS;
+	}
+
+	return manifest_update(intf, part_num, alg, digest);
+}
+
+RSU_OSAL_BOOL librsu_manifest_begin(struct librsu_digest *d)
+{
+	RSU_OSAL_INT alg;
+
+	if (librsu_cfg_digest_manifest(&alg) == NULL) {
+		return false;
+	}
+
+	return librsu_digest_init(d, alg) == 0;
+}
+
+/*
+ * The caller fed the first done bytes of the slot to the digest while it
+ * went through them, only the rest of the slot is read here.
+ */
+RSU_OSAL_INT librsu_manifest_record(struct librsu_hl_intf *intf, RSU_OSAL_INT part_num,
+				    struct librsu_digest *d, RSU_OSAL_U32 done)
+{
+	RSU_OSAL_U8 digest[RSU_DIGEST_SHA384_SIZE];
+	RSU_OSAL_INT alg;
+	RSU_OSAL_INT rtn;
+
+	if (!intf || !d) {
+		return -EARGS;
+	}
+
+	if (librsu_cfg_digest_manifest(&alg) == NULL) {
+		return 0;
+	}
+
+	rtn = librsu_digest_slot_rest(intf, part_num, done, d);
+	if (rtn) {
+		manifest_update(intf, part_num, alg, NULL);
+		return rtn;
+	}
+
+	librsu_digest_final(d, digest);
+
+	return manifest_update(intf, part_num, alg, digest);
+}
+
+RSU_OSAL_INT librsu_manifest_invalidate(struct librsu_hl_intf *intf, RSU_OSAL_INT part_num)
+{
+	if (!intf) {
+		return -EARGS;
+	}
+
+	return manifest_update(intf, part_num, 0, NULL);
+}
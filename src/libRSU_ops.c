@@ -9,6 +9,9 @@
 #include <utils/RSU_utils.h>
 #include <libRSU_ops.h>
 #include <libRSU_misc.h>
+#include <libRSU_probe.h>
+#include <libRSU_scratch.h>
+#include <libRSU_snapshot.h>
 #include <string.h>
 
 #define STATE_DCIO_CORRUPTED	  (0xF004D00FUL)
@@ -27,8 +30,17 @@
 #define ERASED_ENTRY ((RSU_OSAL_U64)(-1))
 #define SPENT_ENTRY  ((RSU_OSAL_U64)(0))
 
+/* copies waiting to be rewritten from the good one, see queue_repair() */
+#define REPAIR_SPT0 (1U << 0)
+#define REPAIR_SPT1 (1U << 1)
+#define REPAIR_CPB0 (1U << 2)
+#define REPAIR_CPB1 (1U << 3)
+
 static struct database *plat_database = NULL;
 
+static RSU_OSAL_INT repair_metadata(RSU_OSAL_VOID);
+static RSU_OSAL_VOID save_snapshot(RSU_OSAL_VOID);
+
 static RSU_OSAL_INT read_dev(RSU_OSAL_OFFSET offset, RSU_OSAL_VOID *buf, RSU_OSAL_INT len)
 {
 	if (buf == NULL || len == 0) {
@@ -36,8 +48,13 @@ static RSU_OSAL_INT read_dev(RSU_OSAL_OFFSET offset, RSU_OSAL_VOID *buf, RSU_OSA
 		return -EINVAL;
 	}
 	struct librsu_ll_intf *intf = plat_database->hal;
+	RSU_OSAL_INT ret;
+
+	RSU_PROBE2(flash__read__start, offset, len);
+	ret = intf->qspi.read(offset, buf, len);
+	RSU_PROBE3(flash__read__done, offset, len, ret);
 
-	return intf->qspi.read(offset, buf, len);
+	return ret;
 }
 
 static RSU_OSAL_INT write_dev(RSU_OSAL_OFFSET offset, RSU_OSAL_VOID *buf, RSU_OSAL_INT len)
@@ -45,9 +62,23 @@ static RSU_OSAL_INT write_dev(RSU_OSAL_OFFSET offset, RSU_OSAL_VOID *buf, RSU_OS
 	if (buf == NULL || len == 0) {
 		return -EINVAL;
 	}
+	if (librsu_cfg_read_only()) {
+		return -EROFS;
+	}
+
+	/* a pending repair goes first, so nothing is written on top of a bad copy */
+	if (plat_database->repair && !plat_database->repairing && repair_metadata()) {
+		return -EIO;
+	}
+
 	struct librsu_ll_intf *intf = plat_database->hal;
+	RSU_OSAL_INT ret;
+
+	RSU_PROBE2(flash__write__start, offset, len);
+	ret = intf->qspi.write(offset, buf, len);
+	RSU_PROBE3(flash__write__done, offset, len, ret);
 
-	return intf->qspi.write(offset, buf, len);
+	return ret;
 }
 
 static RSU_OSAL_INT erase_dev(RSU_OSAL_OFFSET offset, RSU_OSAL_INT len)
@@ -57,10 +88,20 @@ static RSU_OSAL_INT erase_dev(RSU_OSAL_OFFSET offset, RSU_OSAL_INT len)
 		return -EINVAL;
 	}
 
+	if (librsu_cfg_read_only()) {
+		return -EROFS;
+	}
+
+	if (plat_database->repair && !plat_database->repairing && repair_metadata()) {
+		return -EIO;
+	}
+
 	RSU_OSAL_INT ret;
 	struct librsu_ll_intf *intf = plat_database->hal;
 
+	RSU_PROBE2(flash__erase__start, offset, len);
 	ret = intf->qspi.erase(offset, len);
+	RSU_PROBE3(flash__erase__done, offset, len, ret);
 	if (ret < 0) {
 		RSU_LOG_ERR("error: Erase error (errno=%i)", ret);
 		return ret;
@@ -159,6 +200,25 @@ static RSU_OSAL_INT erase_part(RSU_OSAL_S32 part_num)
 	return erase_dev(part_offset, plat_database->spt->partition[part_num].length);
 }
 
+static RSU_OSAL_INT erase_part_range(RSU_OSAL_S32 part_num, RSU_OSAL_OFFSET offset,
+				    RSU_OSAL_INT len)
+{
+	RSU_OSAL_OFFSET part_offset;
+	RSU_OSAL_INT ret;
+
+	ret = get_part_offset(part_num, &part_offset);
+	if (ret) {
+		return ret;
+	}
+
+	if (offset < 0 || len <= 0 ||
+	    (offset + len) > plat_database->spt->partition[part_num].length) {
+		return -ESPIPE;
+	}
+
+	return erase_dev(part_offset + offset, len);
+}
+
 static RSU_OSAL_INT load_spt0_offset(RSU_OSAL_VOID)
 {
 	RSU_OSAL_U32 x;
@@ -192,39 +252,39 @@ static RSU_OSAL_INT check_both_spt(RSU_OSAL_VOID)
 	RSU_OSAL_CHAR *spt0_data;
 	RSU_OSAL_CHAR *spt1_data;
 
-	spt0_data = (RSU_OSAL_CHAR *)rsu_malloc(SPT_SIZE);
+	spt0_data = (RSU_OSAL_CHAR *)librsu_scratch_get(SPT_SIZE);
 	if (!spt0_data) {
 		RSU_LOG_ERR("failed to allocate spt0_data");
 		return -ENOMEM;
 	}
 
-	spt1_data = (RSU_OSAL_CHAR *)rsu_malloc(SPT_SIZE);
+	spt1_data = (RSU_OSAL_CHAR *)librsu_scratch_get(SPT_SIZE);
 	if (!spt1_data) {
 		RSU_LOG_ERR("failed to allocate spt1_data");
-		rsu_free(spt0_data);
+		librsu_scratch_put(spt0_data);
 		return -ENOMEM;
 	}
 
 	ret = read_dev(plat_database->spt_addr.spt0_address, spt0_data, SPT_SIZE);
 	if (ret) {
 		RSU_LOG_ERR("failed to read spt0_data");
-		rsu_free(spt1_data);
-		rsu_free(spt0_data);
+		librsu_scratch_put(spt1_data);
+		librsu_scratch_put(spt0_data);
 		return -EPERM;
 	}
 
 	ret = read_dev(plat_database->spt_addr.spt1_address, spt1_data, SPT_SIZE);
 	if (ret) {
 		RSU_LOG_ERR("failed to read spt1_data");
-		rsu_free(spt1_data);
-		rsu_free(spt0_data);
+		librsu_scratch_put(spt1_data);
+		librsu_scratch_put(spt0_data);
 		return -EPERM;
 	}
 
 	ret = memcmp(spt0_data, spt1_data, SPT_SIZE);
 
-	rsu_free(spt1_data);
-	rsu_free(spt0_data);
+	librsu_scratch_put(spt1_data);
+	librsu_scratch_put(spt0_data);
 
 	return ret;
 }
@@ -250,7 +310,7 @@ static RSU_OSAL_INT check_spt(RSU_OSAL_VOID)
 
 	if (plat_database->spt->version > SPT_VERSION && librsu_cfg_spt_checksum_enabled()) {
 		RSU_LOG_DBG("check SPT checksum \n");
-		spt_data = (RSU_OSAL_CHAR *)rsu_malloc(SPT_SIZE);
+		spt_data = (RSU_OSAL_CHAR *)librsu_scratch_get(SPT_SIZE);
 		if (!spt_data) {
 			RSU_LOG_ERR("failed to allocate spt_data\n");
 			return -ENOEXEC;
@@ -264,11 +324,11 @@ static RSU_OSAL_INT check_spt(RSU_OSAL_VOID)
 		calc_crc = rsu_crc32(0, (RSU_OSAL_VOID *)spt_data, SPT_SIZE);
 		if (swap_endian32(plat_database->spt->checksum) != calc_crc) {
 			RSU_LOG_ERR("Error, bad SPT checksum\n");
-			rsu_free(spt_data);
+			librsu_scratch_put(spt_data);
 			return -EBADF;
 		}
 		swap_bits(spt_data, SPT_SIZE);
-		rsu_free(spt_data);
+		librsu_scratch_put(spt_data);
 	}
 
 	if (plat_database->spt->partitions > SPT_MAX_PARTITIONS) {
@@ -349,13 +409,150 @@ static RSU_OSAL_INT check_spt(RSU_OSAL_VOID)
  * Check SPT1 and then SPT0. If they both pass checks, use SPT0.
  * If only one passes, retore the bad one. If both are bad, fail.
  */
-static RSU_OSAL_INT load_spt(RSU_OSAL_VOID)
+static RSU_OSAL_INT restore_spt_copy(RSU_OSAL_U64 address)
+{
+	RSU_OSAL_INT ret = 0;
+
+	if (erase_dev(address, 32 * 1024)) {
+		RSU_LOG_ERR("error: Erase SPT region failed");
+		return -EPERM;
+	}
+
+	plat_database->spt->magic_number = (RSU_OSAL_S32)0xFFFFFFFF;
+	if (write_dev(address, plat_database->spt, sizeof(struct SUB_PARTITION_TABLE)) != 0) {
+		RSU_LOG_ERR("error: Unable to write SPT table");
+		ret = -EPERM;
+	}
+
+	plat_database->spt->magic_number = (RSU_OSAL_S32)SPT_MAGIC_NUMBER;
+	if (ret == 0 && write_dev(address, plat_database->spt,
+				  sizeof(plat_database->spt->magic_number)) != 0) {
+		RSU_LOG_ERR("error: Unable to write SPT magic #");
+		ret = -EPERM;
+	}
+
+	return ret;
+}
+
+static RSU_OSAL_INT restore_cpb_copy(RSU_OSAL_U32 part_num)
+{
+	RSU_OSAL_INT ret = 0;
+
+	if (erase_part(part_num)) {
+		RSU_LOG_ERR("error: Failed erase CPB");
+		return -EPERM;
+	}
+
+	plat_database->cpb->header.magic_number = (RSU_OSAL_S32)0xFFFFFFFF;
+	if (write_part(part_num, 0, plat_database->cpb, CPB_BLOCK_SIZE)) {
+		RSU_LOG_ERR("error: Unable to write CPB table");
+		ret = -EPERM;
+	}
+
+	plat_database->cpb->header.magic_number = (RSU_OSAL_S32)CPB_MAGIC_NUMBER;
+	if (ret == 0 && write_part(part_num, 0, plat_database->cpb,
+				   sizeof(plat_database->cpb->header.magic_number))) {
+		RSU_LOG_ERR("error: Unable to write CPB magic number");
+		ret = -EPERM;
+	}
+
+	return ret;
+}
+
+/*
+ * Rewrite the copies found bad by load_spt() and load_cpb() from the tables in
+ * memory. Runs under the library mutex, from the background worker started by
+ * librsu_init(), from rsu_repair_metadata() or before the next flash write.
+ */
+static RSU_OSAL_INT repair_metadata(RSU_OSAL_VOID)
+{
+	RSU_OSAL_INT ret = 0;
+
+	if (plat_database == NULL || plat_database->repair == 0) {
+		return 0;
+	}
+
+	if (librsu_cfg_read_only()) {
+		return -EROFS;
+	}
+
+	plat_database->repairing = true;
+
+	if (plat_database->repair & REPAIR_SPT0) {
+		RSU_LOG_WRN("warning: Restoring SPT0");
+		ret = restore_spt_copy(plat_database->spt_addr.spt0_address);
+		if (ret == 0) {
+			plat_database->repair &= ~REPAIR_SPT0;
+		}
+	}
+
+	if (ret == 0 && (plat_database->repair & REPAIR_SPT1)) {
+		RSU_LOG_WRN("warning: Restoring SPT1");
+		ret = restore_spt_copy(plat_database->spt_addr.spt1_address);
+		if (ret == 0) {
+			plat_database->repair &= ~REPAIR_SPT1;
+		}
+	}
+
+	if (ret == 0 && (plat_database->repair & REPAIR_CPB0)) {
+		RSU_LOG_WRN("warning: Restoring CPB0");
+		ret = restore_cpb_copy(plat_database->cpb0_part);
+		if (ret == 0) {
+			plat_database->repair &= ~REPAIR_CPB0;
+		}
+	}
+
+	if (ret == 0 && (plat_database->repair & REPAIR_CPB1)) {
+		RSU_LOG_WRN("warning: Restoring CPB1");
+		ret = restore_cpb_copy(plat_database->cpb1_part);
+		if (ret == 0) {
+			plat_database->repair &= ~REPAIR_CPB1;
+		}
+	}
+
+	plat_database->repairing = false;
+
+	/* the snapshot was not written by the load while a copy was bad */
+	if (ret == 0 && librsu_snapshot_enabled() && !plat_database->spt_corrupted &&
+	    !plat_database->cpb_corrupted) {
+		save_snapshot();
+	}
+
+	return ret;
+}
+
+/*
+ * A bad copy does not fail the load once the other one is validated. The
+ * rewrite is queued, and only done right away with 'metadata-repair inline'.
+ * Read-only mode never repairs.
+ */
+static RSU_OSAL_INT queue_repair(RSU_OSAL_U32 copy)
+{
+	if (librsu_cfg_read_only()) {
+		RSU_LOG_WRN("warning: not repaired in read-only mode");
+		return 0;
+	}
+
+	plat_database->repair |= copy;
+
+	if (librsu_cfg_metadata_repair() == RSU_REPAIR_INLINE) {
+		return repair_metadata();
+	}
+
+	return 0;
+}
+
+static RSU_OSAL_INT repair_pending(RSU_OSAL_VOID)
+{
+	return plat_database->repair != 0;
+}
+
+static RSU_OSAL_INT load_spt_copies(RSU_OSAL_VOID)
 {
 	struct SUB_PARTITION_TABLE *spt_ptr = plat_database->spt;
 	RSU_OSAL_BOOL spt0_good = false;
 	RSU_OSAL_BOOL spt1_good = false;
 	RSU_OSAL_INT ret;
-	struct librsu_ll_intf *intf = plat_database->hal;
 
 	RSU_LOG_DBG("reading SPT1");
 	ret = read_dev(plat_database->spt_addr.spt1_address, spt_ptr,
@@ -403,28 +600,8 @@ static RSU_OSAL_INT load_spt(RSU_OSAL_VOID)
 	}
 
 	if (spt0_good) {
-		RSU_LOG_WRN("warning: Restoring SPT1");
-
-		if (erase_dev(plat_database->spt_addr.spt1_address, 32 * 1024)) {
-			RSU_LOG_ERR("error: Erase SPT1 region failed");
-			return -EPERM;
-		}
-
-		plat_database->spt->magic_number = (RSU_OSAL_S32)0xFFFFFFFF;
-		if (write_dev(plat_database->spt_addr.spt1_address, plat_database->spt,
-			      sizeof(struct SUB_PARTITION_TABLE)) != 0) {
-			RSU_LOG_ERR("error: Unable to write SPT1 table");
-			return -EPERM;
-		}
-
-		plat_database->spt->magic_number = (RSU_OSAL_S32)SPT_MAGIC_NUMBER;
-		if (intf->qspi.write(plat_database->spt_addr.spt1_address, plat_database->spt,
-				     sizeof(plat_database->spt->magic_number)) != 0) {
-			RSU_LOG_ERR("error: Unable to write SPT1 magic #");
-			return -EPERM;
-		}
-
-		return 0;
+		RSU_LOG_WRN("warning: SPT1 is bad");
+		return queue_repair(REPAIR_SPT1);
 	}
 
 	if (spt1_good) {
@@ -436,28 +613,8 @@ static RSU_OSAL_INT load_spt(RSU_OSAL_VOID)
 			return -EPERM;
 		}
 
-		RSU_LOG_WRN("warning: Restoring SPT0");
-
-		if (erase_dev(plat_database->spt_addr.spt0_address, 32 * 1024)) {
-			RSU_LOG_ERR("error: Erase SPT0 region failed");
-			return -EPERM;
-		}
-
-		plat_database->spt->magic_number = (RSU_OSAL_S32)0xFFFFFFFF;
-		if (write_dev(plat_database->spt_addr.spt0_address, plat_database->spt,
-			      sizeof(struct SUB_PARTITION_TABLE)) != 0) {
-			RSU_LOG_ERR("error: Unable to write SPT0 table");
-			return -EPERM;
-		}
-
-		plat_database->spt->magic_number = (RSU_OSAL_S32)SPT_MAGIC_NUMBER;
-		if (write_dev(plat_database->spt_addr.spt0_address, plat_database->spt,
-			      sizeof(plat_database->spt->magic_number)) != 0) {
-			RSU_LOG_ERR("error: Unable to write SPT0 magic #");
-			return -EPERM;
-		}
-
-		return 0;
+		RSU_LOG_WRN("warning: SPT0 is bad");
+		return queue_repair(REPAIR_SPT0);
 	}
 
 	plat_database->spt_corrupted = true;
@@ -465,6 +622,17 @@ static RSU_OSAL_INT load_spt(RSU_OSAL_VOID)
 	return -EFAULT;
 }
 
+static RSU_OSAL_INT load_spt(RSU_OSAL_VOID)
+{
+	RSU_OSAL_INT ret;
+
+	RSU_PROBE0(spt__load__start);
+	ret = load_spt_copies();
+	RSU_PROBE1(spt__load__done, ret);
+
+	return ret;
+}
+
 static RSU_OSAL_VOID rsu_qspi_close(RSU_OSAL_VOID)
 {
 	if (plat_database == NULL) {
@@ -530,38 +698,38 @@ static RSU_OSAL_INT check_both_cpb(RSU_OSAL_VOID)
 	RSU_OSAL_CHAR *cpb0_data;
 	RSU_OSAL_CHAR *cpb1_data;
 
-	cpb0_data = (RSU_OSAL_CHAR *)rsu_malloc(CPB_SIZE);
+	cpb0_data = (RSU_OSAL_CHAR *)librsu_scratch_get(CPB_SIZE);
 	if (!cpb0_data) {
 		RSU_LOG_ERR("failed to allocate cpb0_data");
 		return -ENOMEM;
 	}
 
-	cpb1_data = (RSU_OSAL_CHAR *)rsu_malloc(CPB_SIZE);
+	cpb1_data = (RSU_OSAL_CHAR *)librsu_scratch_get(CPB_SIZE);
 	if (!cpb1_data) {
 		RSU_LOG_ERR("failed to allocate cpb1_data");
-		rsu_free(cpb0_data);
+		librsu_scratch_put(cpb0_data);
 		return -ENOMEM;
 	}
 
 	ret = read_part(plat_database->cpb0_part, 0, cpb0_data, CPB_SIZE);
 	if (ret) {
 		RSU_LOG_ERR("failed to read cpb0_data");
-		rsu_free(cpb1_data);
-		rsu_free(cpb0_data);
+		librsu_scratch_put(cpb1_data);
+		librsu_scratch_put(cpb0_data);
 		return ret;
 	}
 
 	ret = read_part(plat_database->cpb1_part, 0, cpb1_data, CPB_SIZE);
 	if (ret) {
 		RSU_LOG_ERR("failed to read cpb1_data");
-		rsu_free(cpb1_data);
-		rsu_free(cpb0_data);
+		librsu_scratch_put(cpb1_data);
+		librsu_scratch_put(cpb0_data);
 		return ret;
 	}
 
 	ret = memcmp(cpb0_data, cpb1_data, CPB_SIZE);
-	rsu_free(cpb1_data);
-	rsu_free(cpb0_data);
+	librsu_scratch_put(cpb1_data);
+	librsu_scratch_put(cpb0_data);
 	return ret;
 }
 
@@ -573,7 +741,7 @@ static RSU_OSAL_INT check_both_cpb(RSU_OSAL_VOID)
  * When CPB_CORRUPTED flag is true, all CPB operations are blocked
  * except restore_cpb and empty_cpb.
  */
-static RSU_OSAL_INT load_cpb(RSU_OSAL_VOID)
+static RSU_OSAL_INT load_cpb_copies(RSU_OSAL_VOID)
 {
 	RSU_OSAL_U32 x;
 	RSU_OSAL_INT ret;
@@ -674,28 +842,11 @@ static RSU_OSAL_INT load_cpb(RSU_OSAL_VOID)
 	}
 
 	if (cpb0_good) {
-		RSU_LOG_WRN("warning: Restoring CPB1");
-		if (erase_part(plat_database->cpb1_part)) {
-			RSU_LOG_ERR("error: Failed erase CPB1");
-			return -EPERM;
-		}
-
-		plat_database->cpb->header.magic_number = (RSU_OSAL_S32)0xFFFFFFFF;
-		if (write_part(plat_database->cpb1_part, 0, plat_database->cpb, CPB_BLOCK_SIZE)) {
-			RSU_LOG_ERR("error: Unable to write CPB1 table");
-			return -EPERM;
-		}
-		plat_database->cpb->header.magic_number = (RSU_OSAL_S32)CPB_MAGIC_NUMBER;
-		if (write_part(plat_database->cpb1_part, 0, plat_database->cpb,
-			       sizeof(plat_database->cpb->header.magic_number))) {
-			RSU_LOG_ERR("error: Unable to write CPB1 magic number");
-			return -EPERM;
-		}
-
+		RSU_LOG_WRN("warning: CPB1 is bad");
 		plat_database->cpb_slots =
 			(CMF_POINTER *)&plat_database->cpb
 				->data[plat_database->cpb->header.image_ptr_offset];
-		return 0;
+		return queue_repair(REPAIR_CPB1);
 	}
 
 	if (cpb1_good) {
@@ -706,28 +857,11 @@ static RSU_OSAL_INT load_cpb(RSU_OSAL_VOID)
 			return -EACCES;
 		}
 
-		RSU_LOG_WRN("warning: Restoring CPB0");
-		if (erase_part(plat_database->cpb0_part)) {
-			RSU_LOG_ERR("error: Failed erase CPB0");
-			return -EPERM;
-		}
-
-		plat_database->cpb->header.magic_number = (RSU_OSAL_S32)0xFFFFFFFF;
-		if (write_part(plat_database->cpb0_part, 0, plat_database->cpb, CPB_BLOCK_SIZE)) {
-			RSU_LOG_ERR("error: Unable to write CPB0 table");
-			return -EPERM;
-		}
-		plat_database->cpb->header.magic_number = (RSU_OSAL_S32)CPB_MAGIC_NUMBER;
-		if (write_part(plat_database->cpb0_part, 0, plat_database->cpb,
-			       sizeof(plat_database->cpb->header.magic_number))) {
-			RSU_LOG_ERR("error: Unable to write CPB0 magic number");
-			return -EPERM;
-		}
-
+		RSU_LOG_WRN("warning: CPB0 is bad");
 		plat_database->cpb_slots =
 			(CMF_POINTER *)&plat_database->cpb
 				->data[plat_database->cpb->header.image_ptr_offset];
-		return 0;
+		return queue_repair(REPAIR_CPB0);
 	}
 
 	plat_database->cpb_corrupted = true;
@@ -736,6 +870,17 @@ static RSU_OSAL_INT load_cpb(RSU_OSAL_VOID)
 	return -ECORRUPTED_CPB;
 }
 
+static RSU_OSAL_INT load_cpb(RSU_OSAL_VOID)
+{
+	RSU_OSAL_INT ret;
+
+	RSU_PROBE0(cpb__load__start);
+	ret = load_cpb_copies();
+	RSU_PROBE1(cpb__load__done, ret);
+
+	return ret;
+}
+
 static RSU_OSAL_INT update_cpb(RSU_OSAL_INT slot, RSU_OSAL_U64 ptr)
 {
 	RSU_OSAL_U32 x;
@@ -779,7 +924,7 @@ static RSU_OSAL_INT update_cpb(RSU_OSAL_INT slot, RSU_OSAL_U64 ptr)
 	return 0;
 }
 
-static RSU_OSAL_INT writeback_cpb(RSU_OSAL_VOID)
+static RSU_OSAL_INT writeback_cpb_copies(RSU_OSAL_VOID)
 {
 	RSU_OSAL_U32 x;
 	RSU_OSAL_INT updates = 0;
@@ -830,13 +975,192 @@ static RSU_OSAL_INT writeback_cpb(RSU_OSAL_VOID)
 	return 0;
 }
 
-static RSU_OSAL_INT writeback_spt(RSU_OSAL_VOID)
+static RSU_OSAL_INT writeback_cpb(RSU_OSAL_VOID)
+{
+	RSU_OSAL_INT ret;
+
+	RSU_PROBE0(cpb__writeback__start);
+	ret = writeback_cpb_copies();
+	RSU_PROBE1(cpb__writeback__done, ret);
+
+	return ret;
+}
+
+/*
+ * Take the SPT and CPB from the metadata snapshot when it was written in this
+ * boot for the same SPT addresses and the SPT0 and CPB pages in flash are
+ * still byte for byte the tables it recorded. The snapshot saves the SPT1
+ * read and the checks of both SPT copies. Returns 0 when the database is
+ * filled.
+ */
+static RSU_OSAL_INT load_snapshot(RSU_OSAL_VOID)
+{
+	struct rsu_snapshot *snap;
+	RSU_OSAL_U8 *page = NULL;
+	RSU_OSAL_INT ret = -ESTALE;
+
+	snap = rsu_malloc(sizeof(*snap));
+	if (snap == NULL) {
+		return -ENOMEM;
+	}
+
+	if (librsu_snapshot_load(snap)) {
+		goto out;
+	}
+
+	if (snap->hdr.spt0_address != plat_database->spt_addr.spt0_address ||
+	    snap->hdr.spt1_address != plat_database->spt_addr.spt1_address ||
+	    snap->spt.partitions > SPT_MAX_PARTITIONS ||
+	    snap->hdr.cpb0_part >= snap->spt.partitions ||
+	    snap->hdr.cpb1_part >= snap->spt.partitions ||
+	    snap->cpb.header.image_ptr_offset != CPB_IMAGE_PTR_OFFSET) {
+		RSU_LOG_DBG("metadata snapshot does not match the device");
+		goto out;
+	}
+
+	page = librsu_scratch_get(SPT_SIZE);
+	if (page == NULL) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	rsu_memcpy(plat_database->spt, &snap->spt, sizeof(struct SUB_PARTITION_TABLE));
+	plat_database->mtd_part_offset = snap->hdr.mtd_part_offset;
+	plat_database->cpb0_part = snap->hdr.cpb0_part;
+	plat_database->cpb1_part = snap->hdr.cpb1_part;
+
+	if (read_dev(plat_database->spt_addr.spt0_address, page, SPT_SIZE) ||
+	    memcmp(page, &snap->spt, sizeof(struct SUB_PARTITION_TABLE)) ||
+	    read_part(plat_database->cpb0_part, 0, page, CPB_BLOCK_SIZE) ||
+	    memcmp(page, &snap->cpb, CPB_BLOCK_SIZE) ||
+	    read_part(plat_database->cpb1_part, 0, page, CPB_BLOCK_SIZE) ||
+	    memcmp(page, &snap->cpb, CPB_BLOCK_SIZE)) {
+		RSU_LOG_DBG("flash changed since the metadata snapshot");
+		goto out;
+	}
+
+	rsu_memcpy(plat_database->cpb, &snap->cpb, CPB_BLOCK_SIZE);
+	plat_database->cpb_slots =
+		(CMF_POINTER *)&plat_database->cpb->data[plat_database->cpb->header.image_ptr_offset];
+	ret = 0;
+
+out:
+	if (page) {
+		librsu_scratch_put(page);
+	}
+	rsu_free(snap);
+	return ret;
+}
+
+/*
+ * Only a steady state is recorded: SPT0 and both CPB pages in flash must be
+ * identical to what the full load kept, so nothing was restored or repaired.
+ */
+static RSU_OSAL_VOID save_snapshot(RSU_OSAL_VOID)
+{
+	struct rsu_snapshot *snap;
+	RSU_OSAL_U8 *page;
+
+	snap = rsu_malloc(sizeof(*snap));
+	if (snap == NULL) {
+		return;
+	}
+
+	page = librsu_scratch_get(SPT_SIZE);
+	if (page == NULL) {
+		rsu_free(snap);
+		return;
+	}
+
+	if (read_dev(plat_database->spt_addr.spt0_address, page, SPT_SIZE) ||
+	    memcmp(page, plat_database->spt, SPT_SIZE) ||
+	    read_part(plat_database->cpb0_part, 0, page, CPB_BLOCK_SIZE) ||
+	    memcmp(page, plat_database->cpb, CPB_BLOCK_SIZE) ||
+	    read_part(plat_database->cpb1_part, 0, page, CPB_BLOCK_SIZE) ||
+	    memcmp(page, plat_database->cpb, CPB_BLOCK_SIZE)) {
+		RSU_LOG_DBG("flash metadata not in a steady state, no snapshot");
+		goto out;
+	}
+
+	rsu_memset(snap, 0, sizeof(*snap));
+	rsu_memcpy(&snap->spt, plat_database->spt, sizeof(struct SUB_PARTITION_TABLE));
+	rsu_memcpy(&snap->cpb, plat_database->cpb, CPB_BLOCK_SIZE);
+	snap->hdr.spt0_address = plat_database->spt_addr.spt0_address;
+	snap->hdr.spt1_address = plat_database->spt_addr.spt1_address;
+	snap->hdr.mtd_part_offset = plat_database->mtd_part_offset;
+	snap->hdr.cpb0_part = plat_database->cpb0_part;
+	snap->hdr.cpb1_part = plat_database->cpb1_part;
+
+	librsu_snapshot_save(snap);
+
+out:
+	librsu_scratch_put(page);
+	rsu_free(snap);
+}
+
+/*
+ * Read the SPT addresses, then the SPT and CPB, from the metadata snapshot
+ * when it is still valid or else from flash. Corrupted tables are recorded in
+ * the database and are not an error here.
+ */
+static RSU_OSAL_INT load_metadata(RSU_OSAL_VOID)
+{
+	struct librsu_ll_intf *intf = plat_database->hal;
+	RSU_OSAL_INT ret;
+
+	RSU_LOG_DBG("opening qspi flash and access spt and cpb tables");
+
+	ret = intf->mbox.get_spt_addresses(&(plat_database->spt_addr));
+	if (ret != 0) {
+		RSU_LOG_ERR("error in retrieving spt address");
+		return -ENODEV;
+	}
+
+	RSU_LOG_DBG("SPT0 offset is 0x%llx", plat_database->spt_addr.spt0_address);
+	RSU_LOG_DBG("SPT1 offset is 0x%llx", plat_database->spt_addr.spt1_address);
+
+	if (librsu_snapshot_enabled() && load_snapshot() == 0) {
+		RSU_LOG_DBG("loaded metadata snapshot");
+		plat_database->loaded = true;
+		return 0;
+	}
+
+	if (load_spt() && !plat_database->spt_corrupted) {
+		RSU_LOG_ERR("error: Bad SPT");
+		return -EFAULT;
+	}
+
+	if (plat_database->spt_corrupted) {
+		plat_database->cpb_corrupted = true;
+	} else if (load_cpb() && !plat_database->cpb_corrupted) {
+		RSU_LOG_ERR("error: Bad CPB");
+		return -EFAULT;
+	}
+
+	if (librsu_snapshot_enabled() && !plat_database->spt_corrupted &&
+	    !plat_database->cpb_corrupted && plat_database->repair == 0) {
+		save_snapshot();
+	}
+
+	RSU_LOG_DBG("finished reading qspi flash");
+	plat_database->loaded = true;
+
+	return 0;
+}
+
+static RSU_OSAL_INT writeback_spt_copies(RSU_OSAL_VOID)
 {
 	RSU_OSAL_U32 x;
 	RSU_OSAL_INT updates = 0;
 	RSU_OSAL_CHAR *spt_data;
 	RSU_OSAL_U32 calc_crc;
 
+	if (librsu_cfg_read_only()) {
+		return -EROFS;
+	}
+
+	librsu_snapshot_invalidate();
+
 	if (plat_database->spt->partitions > SPT_MAX_PARTITIONS) {
 		RSU_LOG_ERR("bigger than max partition\n");
 		return -EFBIG;
@@ -858,7 +1182,7 @@ static RSU_OSAL_INT writeback_spt(RSU_OSAL_VOID)
 		if (plat_database->spt->version > SPT_VERSION &&
 		    librsu_cfg_spt_checksum_enabled()) {
 			RSU_LOG_WRN("update SPT checksum \n");
-			spt_data = (RSU_OSAL_CHAR *)rsu_malloc(SPT_SIZE);
+			spt_data = (RSU_OSAL_CHAR *)librsu_scratch_get(SPT_SIZE);
 			if (!spt_data) {
 				RSU_LOG_ERR("failed to allocate spt_data\n");
 				return -ENOMEM;
@@ -870,7 +1194,7 @@ static RSU_OSAL_INT writeback_spt(RSU_OSAL_VOID)
 			swap_bits(spt_data, SPT_SIZE);
 			calc_crc = rsu_crc32(0, (RSU_OSAL_VOID *)spt_data, SPT_SIZE);
 			plat_database->spt->checksum = swap_endian32(calc_crc);
-			rsu_free(spt_data);
+			librsu_scratch_put(spt_data);
 		}
 
 		plat_database->spt->magic_number = (RSU_OSAL_S32)0xFFFFFFFF;
@@ -897,6 +1221,17 @@ static RSU_OSAL_INT writeback_spt(RSU_OSAL_VOID)
 	return 0;
 }
 
+static RSU_OSAL_INT writeback_spt(RSU_OSAL_VOID)
+{
+	RSU_OSAL_INT ret;
+
+	RSU_PROBE0(spt__writeback__start);
+	ret = writeback_spt_copies();
+	RSU_PROBE1(spt__writeback__done, ret);
+
+	return ret;
+}
+
 static RSU_OSAL_INT notify_sdm(RSU_OSAL_U32 value)
 {
 	return plat_database->hal->mbox.rsu_notify(value);
@@ -927,13 +1262,34 @@ static RSU_OSAL_INT rsu_get_dcmf_version(struct rsu_dcmf_version *version)
 	return plat_database->hal->misc.rsu_get_dcmf_version(version);
 }
 
+/*
+ * In read-only mode the tables are loaded by the first call which needs them,
+ * every accessor of the SPT and CPB goes through here first.
+ */
+static RSU_OSAL_INT ensure_loaded(RSU_OSAL_VOID)
+{
+	if (plat_database->loaded) {
+		return 0;
+	}
+
+	return load_metadata();
+}
+
 static RSU_OSAL_INT partition_count(RSU_OSAL_VOID)
 {
+	if (ensure_loaded()) {
+		return -ENODEV;
+	}
+
 	return plat_database->spt->partitions;
 }
 
 static RSU_OSAL_CHAR *partition_name(RSU_OSAL_INT part_num)
 {
+	if (ensure_loaded()) {
+		return "BAD";
+	}
+
 	if (part_num < 0 || (RSU_OSAL_U32)part_num >= plat_database->spt->partitions ||
 	    plat_database->spt->partitions > SPT_MAX_PARTITIONS) {
 		return "BAD";
@@ -944,6 +1300,10 @@ static RSU_OSAL_CHAR *partition_name(RSU_OSAL_INT part_num)
 
 static RSU_OSAL_INT partition_offset(RSU_OSAL_INT part_num, RSU_OSAL_U64 *offset)
 {
+	if (ensure_loaded()) {
+		return -ENODEV;
+	}
+
 	if (offset == NULL) {
 		RSU_LOG_ERR("offset is NULL");
 		return -EINVAL;
@@ -967,6 +1327,10 @@ static RSU_OSAL_INT factory_offset(RSU_OSAL_U64 *factory_offset)
 {
 	RSU_OSAL_U32 x;
 
+	if (ensure_loaded()) {
+		return -ENODEV;
+	}
+
 	if (factory_offset == NULL) {
 		return -EINVAL;
 	}
@@ -991,6 +1355,10 @@ static RSU_OSAL_INT factory_offset(RSU_OSAL_U64 *factory_offset)
 
 static RSU_OSAL_INT partition_size(RSU_OSAL_INT part_num)
 {
+	if (ensure_loaded()) {
+		return -ENODEV;
+	}
+
 	if (part_num < 0 || (RSU_OSAL_U32)part_num >= plat_database->spt->partitions ||
 	    plat_database->spt->partitions > SPT_MAX_PARTITIONS) {
 		RSU_LOG_ERR("Invalid part number");
@@ -1002,6 +1370,10 @@ static RSU_OSAL_INT partition_size(RSU_OSAL_INT part_num)
 
 static RSU_OSAL_INT partition_reserved(RSU_OSAL_INT part_num)
 {
+	if (ensure_loaded()) {
+		return -ENODEV;
+	}
+
 	if (part_num < 0 || (RSU_OSAL_U32)part_num >= plat_database->spt->partitions ||
 	    plat_database->spt->partitions > SPT_MAX_PARTITIONS) {
 		RSU_LOG_ERR("Invalid part number");
@@ -1013,6 +1385,10 @@ static RSU_OSAL_INT partition_reserved(RSU_OSAL_INT part_num)
 
 static RSU_OSAL_INT partition_readonly(RSU_OSAL_INT part_num)
 {
+	if (ensure_loaded()) {
+		return -ENODEV;
+	}
+
 	if (part_num < 0 || (RSU_OSAL_U32)part_num >= plat_database->spt->partitions ||
 	    plat_database->spt->partitions > SPT_MAX_PARTITIONS) {
 		RSU_LOG_ERR("Invalid part number");
@@ -1025,24 +1401,50 @@ static RSU_OSAL_INT partition_readonly(RSU_OSAL_INT part_num)
 static RSU_OSAL_INT data_read(RSU_OSAL_INT part_num, RSU_OSAL_INT offset, RSU_OSAL_INT bytes,
 			      RSU_OSAL_VOID *buf)
 {
+	if (ensure_loaded()) {
+		return -ENODEV;
+	}
+
 	return read_part(part_num, offset, buf, bytes);
 }
 
 static RSU_OSAL_INT data_write(RSU_OSAL_INT part_num, RSU_OSAL_INT offset, RSU_OSAL_INT bytes,
 			       RSU_OSAL_VOID *buf)
 {
+	if (ensure_loaded()) {
+		return -ENODEV;
+	}
+
 	return write_part(part_num, offset, buf, bytes);
 }
 
 static RSU_OSAL_INT data_erase(RSU_OSAL_INT part_num)
 {
+	if (ensure_loaded()) {
+		return -ENODEV;
+	}
+
 	return erase_part(part_num);
 }
 
+static RSU_OSAL_INT data_erase_range(RSU_OSAL_INT part_num, RSU_OSAL_INT offset,
+				    RSU_OSAL_INT bytes)
+{
+	if (ensure_loaded()) {
+		return -ENODEV;
+	}
+
+	return erase_part_range(part_num, offset, bytes);
+}
+
 static RSU_OSAL_INT partition_rename(RSU_OSAL_INT part_num, RSU_OSAL_CHAR *name)
 {
 	RSU_OSAL_U32 x;
 
+	if (ensure_loaded()) {
+		return -ENODEV;
+	}
+
 	if (part_num < 0 || (RSU_OSAL_U32)part_num >= plat_database->spt->partitions ||
 	    plat_database->spt->partitions > SPT_MAX_PARTITIONS) {
 		RSU_LOG_ERR("Invalid part number");
@@ -1088,6 +1490,10 @@ static RSU_OSAL_INT partition_delete(RSU_OSAL_INT part_num)
 	RSU_OSAL_U32 x;
 	RSU_OSAL_INT err;
 
+	if (ensure_loaded()) {
+		return -ENODEV;
+	}
+
 	if (part_num < 0 || (RSU_OSAL_U32)part_num >= plat_database->spt->partitions ||
 	    plat_database->spt->partitions > SPT_MAX_PARTITIONS) {
 		RSU_LOG_ERR("error: Invalid partition number");
@@ -1130,6 +1536,10 @@ static RSU_OSAL_INT partition_create(RSU_OSAL_CHAR *name, RSU_OSAL_U64 start, RS
 	RSU_OSAL_U64 end = start + size;
 	RSU_OSAL_INT err;
 
+	if (ensure_loaded()) {
+		return -ENODEV;
+	}
+
 	if (strnlen(name, SPT_PARTITION_NAME_LENGTH) >= SPT_PARTITION_NAME_LENGTH) {
 		RSU_LOG_ERR("error: Partition name is too long - limited to %i",
 			    SPT_PARTITION_NAME_LENGTH - 1);
@@ -1193,6 +1603,10 @@ static RSU_OSAL_INT priority_get(RSU_OSAL_INT part_num)
 	RSU_OSAL_U32 x;
 	RSU_OSAL_INT priority = 0;
 
+	if (ensure_loaded()) {
+		return -ENODEV;
+	}
+
 	if (part_num < 0 || (RSU_OSAL_U32)part_num >= plat_database->spt->partitions) {
 		RSU_LOG_ERR("Invalid part number");
 		return -EINVAL;
@@ -1218,6 +1632,10 @@ static RSU_OSAL_INT priority_add(RSU_OSAL_INT part_num)
 	RSU_OSAL_U32 y;
 	RSU_OSAL_INT err;
 
+	if (ensure_loaded()) {
+		return -ENODEV;
+	}
+
 	if (part_num < 0 || (RSU_OSAL_U32)part_num >= plat_database->spt->partitions ||
 	    plat_database->spt->partitions > SPT_MAX_PARTITIONS) {
 		RSU_LOG_ERR("Invalid part number");
@@ -1275,6 +1693,10 @@ static RSU_OSAL_INT priority_remove(RSU_OSAL_INT part_num)
 	RSU_OSAL_U32 x;
 	RSU_OSAL_INT err = 0;
 
+	if (ensure_loaded()) {
+		return -ENODEV;
+	}
+
 	if (part_num < 0 || (RSU_OSAL_U32)part_num >= plat_database->spt->partitions ||
 	    plat_database->spt->partitions > SPT_MAX_PARTITIONS) {
 		return -EINVAL;
@@ -1335,13 +1757,17 @@ static RSU_OSAL_INT restore_spt_from_file(RSU_OSAL_CHAR *name)
 	RSU_OSAL_U32 magic_number;
 	RSU_OSAL_INT ret;
 
+	if (ensure_loaded()) {
+		return -ENODEV;
+	}
+
 	fp = rsu_fopen(name, RSU_FILE_READ);
 	if (!fp) {
 		RSU_LOG_ERR("failed to open file for restoring SPT");
 		return -EFAULT;
 	}
 
-	spt_data = (RSU_OSAL_CHAR *)rsu_malloc(SPT_SIZE);
+	spt_data = (RSU_OSAL_CHAR *)librsu_scratch_get(SPT_SIZE);
 	if (spt_data == NULL) {
 		RSU_LOG_ERR("failed to allocate spt_data");
 		rsu_close(fp);
@@ -1351,7 +1777,7 @@ static RSU_OSAL_INT restore_spt_from_file(RSU_OSAL_CHAR *name)
 	ret = rsu_read(spt_data, SPT_SIZE, fp);
 	if (ret < 0) {
 		RSU_LOG_ERR("failed to read spt_data");
-		rsu_free(spt_data);
+		librsu_scratch_put(spt_data);
 		rsu_close(fp);
 		return ret;
 	}
@@ -1361,7 +1787,7 @@ static RSU_OSAL_INT restore_spt_from_file(RSU_OSAL_CHAR *name)
 	ret = rsu_fseek(SPT_SIZE, RSU_SEEK_SET, fp);
 	if (ret != 0) {
 		RSU_LOG_ERR("failed to fseek");
-		rsu_free(spt_data);
+		librsu_scratch_put(spt_data);
 		rsu_close(fp);
 		return ret;
 	}
@@ -1369,7 +1795,7 @@ static RSU_OSAL_INT restore_spt_from_file(RSU_OSAL_CHAR *name)
 	ret = rsu_read(&crc_from_saved_file, sizeof(crc_from_saved_file), fp);
 	if (ret < 0) {
 		RSU_LOG_ERR("failed to read spt_data");
-		rsu_free(spt_data);
+		librsu_scratch_put(spt_data);
 		rsu_close(fp);
 		return ret;
 	}
@@ -1377,7 +1803,7 @@ static RSU_OSAL_INT restore_spt_from_file(RSU_OSAL_CHAR *name)
 
 	if (crc_from_saved_file != calc_crc) {
 		RSU_LOG_ERR("saved file is corrupted");
-		rsu_free(spt_data);
+		librsu_scratch_put(spt_data);
 		rsu_close(fp);
 		return -EBADF;
 	}
@@ -1385,7 +1811,7 @@ static RSU_OSAL_INT restore_spt_from_file(RSU_OSAL_CHAR *name)
 	rsu_memcpy(&magic_number, spt_data, sizeof(magic_number));
 	if (magic_number != SPT_MAGIC_NUMBER) {
 		RSU_LOG_ERR("failure due to mismatch magic number\n");
-		rsu_free(spt_data);
+		librsu_scratch_put(spt_data);
 		rsu_close(fp);
 		return -EFAULT;
 	}
@@ -1394,7 +1820,7 @@ static RSU_OSAL_INT restore_spt_from_file(RSU_OSAL_CHAR *name)
 
 	if (load_spt0_offset()) {
 		RSU_LOG_ERR("failure to determine SPT0 offset");
-		rsu_free(spt_data);
+		librsu_scratch_put(spt_data);
 		rsu_close(fp);
 		return -EPERM;
 	}
@@ -1402,7 +1828,7 @@ static RSU_OSAL_INT restore_spt_from_file(RSU_OSAL_CHAR *name)
 	ret = writeback_spt();
 	if (ret < 0) {
 		RSU_LOG_ERR("failed to write back spt\n");
-		rsu_free(spt_data);
+		librsu_scratch_put(spt_data);
 		rsu_close(fp);
 		return ret;
 	}
@@ -1415,7 +1841,7 @@ static RSU_OSAL_INT restore_spt_from_file(RSU_OSAL_CHAR *name)
 		RSU_LOG_ERR("failed to load CPB after restoring SPT\n");
 	}
 
-	rsu_free(spt_data);
+	librsu_scratch_put(spt_data);
 	rsu_close(fp);
 	return ret;
 }
@@ -1428,13 +1854,17 @@ static RSU_OSAL_INT save_spt_to_file(RSU_OSAL_CHAR *name)
 	RSU_OSAL_INT write_size;
 	RSU_OSAL_U32 calc_crc;
 
+	if (ensure_loaded()) {
+		return -ENODEV;
+	}
+
 	fp = rsu_fopen(name, RSU_FILE_WRITE);
 	if (fp == NULL) {
 		RSU_LOG_ERR("failed to open file for saving SPT");
 		return -EFAULT;
 	}
 
-	spt_data = (RSU_OSAL_CHAR *)rsu_malloc(SPT_SIZE);
+	spt_data = (RSU_OSAL_CHAR *)librsu_scratch_get(SPT_SIZE);
 	if (spt_data == NULL) {
 		RSU_LOG_ERR("failed to allocate spt_data");
 		rsu_close(fp);
@@ -1444,7 +1874,7 @@ static RSU_OSAL_INT save_spt_to_file(RSU_OSAL_CHAR *name)
 	ret = read_dev(plat_database->spt_addr.spt0_address, spt_data, SPT_SIZE);
 	if (ret < 0) {
 		RSU_LOG_ERR("failed to read spt_data");
-		rsu_free(spt_data);
+		librsu_scratch_put(spt_data);
 		rsu_close(fp);
 		return ret;
 	}
@@ -1455,7 +1885,7 @@ static RSU_OSAL_INT save_spt_to_file(RSU_OSAL_CHAR *name)
 	write_size = rsu_write(spt_data, SPT_SIZE, fp);
 	if (write_size != SPT_SIZE) {
 		RSU_LOG_ERR("failed to write %lu SPT data", SPT_SIZE);
-		rsu_free(spt_data);
+		librsu_scratch_put(spt_data);
 		rsu_close(fp);
 		return -EPERM;
 	}
@@ -1463,12 +1893,12 @@ static RSU_OSAL_INT save_spt_to_file(RSU_OSAL_CHAR *name)
 	write_size = rsu_write(&calc_crc, sizeof(calc_crc), fp);
 	if (write_size != sizeof(calc_crc)) {
 		RSU_LOG_ERR("failed to write %lu calc_crc", sizeof(calc_crc));
-		rsu_free(spt_data);
+		librsu_scratch_put(spt_data);
 		rsu_close(fp);
 		return -EPERM;
 	}
 
-	rsu_free(spt_data);
+	librsu_scratch_put(spt_data);
 	rsu_close(fp);
 	return ret;
 }
@@ -1479,6 +1909,10 @@ static RSU_OSAL_INT save_spt_to_buf(RSU_OSAL_U8 *buffer, RSU_OSAL_SIZE size)
 	RSU_OSAL_INT ret;
 	RSU_OSAL_U32 calc_crc;
 
+	if (ensure_loaded()) {
+		return -ENODEV;
+	}
+
 	if (buffer == NULL) {
 		RSU_LOG_ERR("Buffer is NULL");
 		return -EFAULT;
@@ -1509,6 +1943,10 @@ static RSU_OSAL_INT restore_spt_from_buf(RSU_OSAL_U8 *buffer, RSU_OSAL_SIZE size
 	RSU_OSAL_U32 magic_number;
 	RSU_OSAL_INT ret;
 
+	if (ensure_loaded()) {
+		return -ENODEV;
+	}
+
 	if (buffer == NULL) {
 		RSU_LOG_ERR("Buffer is NULL");
 		return -EFAULT;
@@ -1559,6 +1997,10 @@ static RSU_OSAL_INT restore_spt_from_buf(RSU_OSAL_U8 *buffer, RSU_OSAL_SIZE size
 
 static RSU_OSAL_INT corrupted_spt(RSU_OSAL_VOID)
 {
+	if (ensure_loaded()) {
+		return 1;
+	}
+
 	return plat_database->spt_corrupted;
 }
 
@@ -1576,12 +2018,16 @@ static RSU_OSAL_INT empty_cpb(RSU_OSAL_VOID)
 
 	struct cpb_header *c_header;
 
+	if (ensure_loaded()) {
+		return -ENODEV;
+	}
+
 	if (plat_database->spt_corrupted) {
 		RSU_LOG_ERR("corrupted SPT");
 		return -ECORRUPTED_CPB;
 	}
 
-	c_header = (struct cpb_header *)rsu_malloc(sizeof(struct cpb_header));
+	c_header = (struct cpb_header *)librsu_scratch_get(sizeof(struct cpb_header));
 	if (c_header == NULL) {
 		RSU_LOG_ERR("failed to allocate cpb_header");
 		return -ENOMEM;
@@ -1601,7 +2047,7 @@ static RSU_OSAL_INT empty_cpb(RSU_OSAL_VOID)
 	ret = writeback_cpb();
 	if (ret) {
 		RSU_LOG_ERR("failed to write back cpb\n");
-		rsu_free(c_header);
+		librsu_scratch_put(c_header);
 		return ret;
 	}
 
@@ -1610,7 +2056,7 @@ static RSU_OSAL_INT empty_cpb(RSU_OSAL_VOID)
 	plat_database->cpb_corrupted = false;
 	plat_database->cpb_fixed = true;
 
-	rsu_free(c_header);
+	librsu_scratch_put(c_header);
 	return ret;
 }
 
@@ -1623,6 +2069,10 @@ static RSU_OSAL_INT restore_cpb_from_file(RSU_OSAL_CHAR *name)
 	RSU_OSAL_U32 magic_number;
 	RSU_OSAL_INT ret;
 
+	if (ensure_loaded()) {
+		return -ENODEV;
+	}
+
 	if (plat_database->spt_corrupted) {
 		RSU_LOG_ERR("corrupted SPT");
 		return -ECORRUPTED_SPT;
@@ -1634,7 +2084,7 @@ static RSU_OSAL_INT restore_cpb_from_file(RSU_OSAL_CHAR *name)
 		return -EFAULT;
 	}
 
-	cpb_data = (RSU_OSAL_CHAR *)rsu_malloc(CPB_SIZE);
+	cpb_data = (RSU_OSAL_CHAR *)librsu_scratch_get(CPB_SIZE);
 	if (!cpb_data) {
 		RSU_LOG_ERR("failed to allocate cpb_data");
 		rsu_close(fp);
@@ -1644,7 +2094,7 @@ static RSU_OSAL_INT restore_cpb_from_file(RSU_OSAL_CHAR *name)
 	ret = rsu_read(cpb_data, CPB_SIZE, fp);
 	if (!ret) {
 		RSU_LOG_ERR("failed to read");
-		rsu_free(cpb_data);
+		librsu_scratch_put(cpb_data);
 		rsu_close(fp);
 		return -EPERM;
 	}
@@ -1655,7 +2105,7 @@ static RSU_OSAL_INT restore_cpb_from_file(RSU_OSAL_CHAR *name)
 	ret = rsu_fseek(CPB_SIZE, RSU_SEEK_SET, fp);
 	if (ret != 0) {
 		RSU_LOG_ERR("failed to fseek, %d", ret);
-		rsu_free(cpb_data);
+		librsu_scratch_put(cpb_data);
 		rsu_close(fp);
 		return -EIO;
 	}
@@ -1663,7 +2113,7 @@ static RSU_OSAL_INT restore_cpb_from_file(RSU_OSAL_CHAR *name)
 	ret = rsu_read(&crc_from_saved_file, sizeof(crc_from_saved_file), fp);
 	if (!ret) {
 		RSU_LOG_ERR("failed to read");
-		rsu_free(cpb_data);
+		librsu_scratch_put(cpb_data);
 		rsu_close(fp);
 		return -EPERM;
 	}
@@ -1671,7 +2121,7 @@ static RSU_OSAL_INT restore_cpb_from_file(RSU_OSAL_CHAR *name)
 
 	if (crc_from_saved_file != calc_crc) {
 		RSU_LOG_ERR("saved file is corrupted");
-		rsu_free(cpb_data);
+		librsu_scratch_put(cpb_data);
 		rsu_close(fp);
 		return -EBADF;
 	}
@@ -1679,7 +2129,7 @@ static RSU_OSAL_INT restore_cpb_from_file(RSU_OSAL_CHAR *name)
 	rsu_memcpy(&magic_number, cpb_data, sizeof(magic_number));
 	if (magic_number != CPB_MAGIC_NUMBER) {
 		RSU_LOG_ERR("failure due to mismatch magic number");
-		rsu_free(cpb_data);
+		librsu_scratch_put(cpb_data);
 		rsu_close(fp);
 		return -EFAULT;
 	}
@@ -1688,7 +2138,7 @@ static RSU_OSAL_INT restore_cpb_from_file(RSU_OSAL_CHAR *name)
 	ret = writeback_cpb();
 	if (ret) {
 		RSU_LOG_ERR("failed to write back cpb\n");
-		rsu_free(cpb_data);
+		librsu_scratch_put(cpb_data);
 		rsu_close(fp);
 		return ret;
 	}
@@ -1698,7 +2148,7 @@ static RSU_OSAL_INT restore_cpb_from_file(RSU_OSAL_CHAR *name)
 	plat_database->cpb_corrupted = false;
 	plat_database->cpb_fixed = true;
 
-	rsu_free(cpb_data);
+	librsu_scratch_put(cpb_data);
 	rsu_close(fp);
 	return ret;
 }
@@ -1711,13 +2161,17 @@ static RSU_OSAL_INT save_cpb_to_file(RSU_OSAL_CHAR *name)
 	RSU_OSAL_INT write_size;
 	RSU_OSAL_U32 calc_crc;
 
+	if (ensure_loaded()) {
+		return -ENODEV;
+	}
+
 	fp = rsu_fopen(name, RSU_FILE_WRITE);
 	if (!fp) {
 		RSU_LOG_ERR("failed to open file for saving CPB");
 		return -EFAULT;
 	}
 
-	cpb_data = (RSU_OSAL_CHAR *)rsu_malloc(CPB_SIZE);
+	cpb_data = (RSU_OSAL_CHAR *)librsu_scratch_get(CPB_SIZE);
 	if (!cpb_data) {
 		RSU_LOG_ERR("failed to allocate cpb_data");
 		rsu_close(fp);
@@ -1727,7 +2181,7 @@ static RSU_OSAL_INT save_cpb_to_file(RSU_OSAL_CHAR *name)
 	ret = read_part(plat_database->cpb0_part, 0, cpb_data, CPB_SIZE);
 	if (ret) {
 		RSU_LOG_ERR("failed to read CPB data");
-		rsu_free(cpb_data);
+		librsu_scratch_put(cpb_data);
 		rsu_close(fp);
 		return ret;
 	}
@@ -1738,19 +2192,19 @@ static RSU_OSAL_INT save_cpb_to_file(RSU_OSAL_CHAR *name)
 	write_size = rsu_write(cpb_data, CPB_SIZE, fp);
 	if (write_size != CPB_SIZE) {
 		RSU_LOG_ERR("failed to write %d CPB data", CPB_SIZE);
-		rsu_free(cpb_data);
+		librsu_scratch_put(cpb_data);
 		rsu_close(fp);
 		return -EPERM;
 	}
 	write_size = rsu_write(&calc_crc, sizeof(calc_crc), fp);
 	if (write_size != sizeof(calc_crc)) {
 		RSU_LOG_ERR("failed to write %lu calc_crc", sizeof(calc_crc));
-		rsu_free(cpb_data);
+		librsu_scratch_put(cpb_data);
 		rsu_close(fp);
 		return -EPERM;
 	}
 
-	rsu_free(cpb_data);
+	librsu_scratch_put(cpb_data);
 	rsu_close(fp);
 	return ret;
 }
@@ -1760,6 +2214,10 @@ static RSU_OSAL_INT save_cpb_to_buf(RSU_OSAL_U8 *buffer, RSU_OSAL_SIZE size)
 	RSU_OSAL_INT ret;
 	RSU_OSAL_U32 calc_crc;
 
+	if (ensure_loaded()) {
+		return -ENODEV;
+	}
+
 	if (buffer == NULL) {
 		RSU_LOG_ERR("Buffer is NULL");
 		return -EFAULT;
@@ -1791,6 +2249,10 @@ static RSU_OSAL_INT restore_cpb_from_buf(RSU_OSAL_U8 *buffer, RSU_OSAL_SIZE size
 	RSU_OSAL_U32 magic_number;
 	RSU_OSAL_INT ret;
 
+	if (ensure_loaded()) {
+		return -ENODEV;
+	}
+
 	if (plat_database->spt_corrupted) {
 		return -ECORRUPTED_SPT;
 	}
@@ -1836,6 +2298,10 @@ static RSU_OSAL_INT restore_cpb_from_buf(RSU_OSAL_U8 *buffer, RSU_OSAL_SIZE size
 
 static RSU_OSAL_INT corrupted_cpb(RSU_OSAL_VOID)
 {
+	if (ensure_loaded()) {
+		return 1;
+	}
+
 	return plat_database->cpb_corrupted;
 }
 
@@ -1867,6 +2333,7 @@ static struct librsu_hl_intf hl_intf = {
 	.data.read = data_read,
 	.data.write = data_write,
 	.data.erase = data_erase,
+	.data.erase_range = data_erase_range,
 
 	.spt_ops.restore_file = restore_spt_from_file,
 	.spt_ops.save_file = save_spt_to_file,
@@ -1887,6 +2354,9 @@ static struct librsu_hl_intf hl_intf = {
 	.misc_ops.rsu_get_dcmf_status = rsu_get_dcmf_status,
 	.misc_ops.rsu_get_dcmf_version = rsu_get_dcmf_version,
 	.misc_ops.rsu_get_max_retry_count = rsu_get_max_retry_count,
+
+	.repair_ops.pending = repair_pending,
+	.repair_ops.run = repair_metadata,
 };
 
 RSU_OSAL_INT rsu_qspi_open(struct librsu_ll_intf *intf, struct librsu_hl_intf **hl_ptr)
@@ -1926,38 +2396,20 @@ RSU_OSAL_INT rsu_qspi_open(struct librsu_ll_intf *intf, struct librsu_hl_intf **
 		return -ENOMEM;
 	}
 
-	RSU_LOG_DBG("opening qspi flash and access spt and cpb tables");
-
-	RSU_OSAL_INT ret;
-
-	ret = intf->mbox.get_spt_addresses(&(plat_database->spt_addr));
-	if (ret != 0) {
-		RSU_LOG_ERR("error in retrieving spt address");
-		rsu_free(plat_database->spt);
-		rsu_free(plat_database->cpb);
-		rsu_free(plat_database);
-		return -ENODEV;
+	if (librsu_cfg_read_only()) {
+		RSU_LOG_DBG("read-only, spt and cpb are loaded on first use");
+		*hl_ptr = &hl_intf;
+		return 0;
 	}
 
-	RSU_LOG_DBG("SPT0 offset is 0x%llx", plat_database->spt_addr.spt0_address);
-	RSU_LOG_DBG("SPT1 offset is 0x%llx", plat_database->spt_addr.spt1_address);
-
-	if (load_spt() && !plat_database->spt_corrupted) {
-		RSU_LOG_ERR("error: Bad SPT");
-		rsu_qspi_close();
-		return -EFAULT;
-	}
+	RSU_OSAL_INT ret;
 
-	if (plat_database->spt_corrupted) {
-		plat_database->cpb_corrupted = true;
-	} else if (load_cpb() && !plat_database->cpb_corrupted) {
-		RSU_LOG_ERR("error: Bad CPB");
+	ret = load_metadata();
+	if (ret) {
 		rsu_qspi_close();
-		return -EFAULT;
+		return ret;
 	}
 
-	RSU_LOG_DBG("finished reading qspi flash");
-
 	*hl_ptr = &hl_intf;
 
 	return 0;
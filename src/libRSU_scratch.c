@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2023-2024 Intel Corporation
+ * SPDX-License-Identifier: MIT-0
+ */
+
+#include <libRSU_scratch.h>
+#include <utils/RSU_logging.h>
+
+static RSU_OSAL_U8 *arena;
+/* number of granules lent out starting at each granule, 0 when free */
+static RSU_OSAL_U8 lent[RSU_SCRATCH_BLOCKS];
+
+RSU_OSAL_INT librsu_scratch_init(RSU_OSAL_VOID)
+{
+	if (arena) {
+		return 0;
+	}
+
+	arena = rsu_malloc(RSU_SCRATCH_BLOCKS * RSU_SCRATCH_BLOCK_SZ);
+	if (arena == NULL) {
+		RSU_LOG_ERR("Error in allocating memory");
+		return -ENOMEM;
+	}
+
+	rsu_memset(lent, 0, sizeof(lent));
+
+	return 0;
+}
+
+RSU_OSAL_VOID librsu_scratch_exit(RSU_OSAL_VOID)
+{
+	RSU_OSAL_INT x;
+
+	for (x = 0; x < RSU_SCRATCH_BLOCKS; x++) {
+		if (lent[x]) {
+			RSU_LOG_ERR("scratch buffer @%i still in use", x);
+		}
+	}
+
+	rsu_free(arena);
+	arena = NULL;
+}
+
+RSU_OSAL_VOID *librsu_scratch_get(RSU_OSAL_SIZE size)
+{
+	RSU_OSAL_INT cnt, x, y;
+
+	cnt = (size + RSU_SCRATCH_BLOCK_SZ - 1) / RSU_SCRATCH_BLOCK_SZ;
+
+	if (arena && size && cnt <= RSU_SCRATCH_BLOCKS) {
+		for (x = 0; x + cnt <= RSU_SCRATCH_BLOCKS; x++) {
+			for (y = x; y < x + cnt; y++) {
+				if (lent[y]) {
+					break;
+				}
+			}
+
+			if (y == x + cnt) {
+				rsu_memset(&lent[x], 1, cnt);
+				lent[x] = cnt;
+				return arena + x * RSU_SCRATCH_BLOCK_SZ;
+			}
+
+			x = y;
+		}
+	}
+
+	RSU_LOG_DBG("no scratch space for %u bytes, using the heap", (RSU_OSAL_U32)size);
+	return rsu_malloc(size);
+}
+
+RSU_OSAL_VOID librsu_scratch_put(RSU_OSAL_VOID *ptr)
+{
+	RSU_OSAL_U8 *p = ptr;
+	RSU_OSAL_INT x;
+
+	if (arena && p >= arena && p < arena + RSU_SCRATCH_BLOCKS * RSU_SCRATCH_BLOCK_SZ) {
+		x = (p - arena) / RSU_SCRATCH_BLOCK_SZ;
+		rsu_memset(&lent[x], 0, lent[x]);
+		return;
+	}
+
+	rsu_free(ptr);
+}
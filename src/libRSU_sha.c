@@ -0,0 +1,297 @@
+/*
+ * Copyright (C) 2023-2024 Intel Corporation
+ * SPDX-License-Identifier: MIT-0
+ */
+
+#include <libRSU_sha.h>
+
+#define ROR32(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+#define ROR64(x, n) (((x) >> (n)) | ((x) << (64 - (n))))
+
+static const RSU_OSAL_U32 k256[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4,
+	0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe,
+	0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f,
+	0x4a7484aa, 0x5cb0a9dc, 0x76f988da, 0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+	0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc,
+	0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+	0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070, 0x19a4c116,
+	0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7,
+	0xc67178f2};
+
+static const RSU_OSAL_U64 k512[80] = {
+	0x428a2f98d728ae22ULL, 0x7137449123ef65cdULL, 0xb5c0fbcfec4d3b2fULL, 0xe9b5dba58189dbbcULL,
+	0x3956c25bf348b538ULL, 0x59f111f1b605d019ULL, 0x923f82a4af194f9bULL, 0xab1c5ed5da6d8118ULL,
+	0xd807aa98a3030242ULL, 0x12835b0145706fbeULL, 0x243185be4ee4b28cULL, 0x550c7dc3d5ffb4e2ULL,
+	0x72be5d74f27b896fULL, 0x80deb1fe3b1696b1ULL, 0x9bdc06a725c71235ULL, 0xc19bf174cf692694ULL,
+	0xe49b69c19ef14ad2ULL, 0xefbe4786384f25e3ULL, 0x0fc19dc68b8cd5b5ULL, 0x240ca1cc77ac9c65ULL,
+	0x2de92c6f592b0275ULL, 0x4a7484aa6ea6e483ULL, 0x5cb0a9dcbd41fbd4ULL, 0x76f988da831153b5ULL,
+	0x983e5152ee66dfabULL, 0xa831c66d2db43210ULL, 0xb00327c898fb213fULL, 0xbf597fc7beef0ee4ULL,
+	0xc6e00bf33da88fc2ULL, 0xd5a79147930aa725ULL, 0x06ca6351e003826fULL, 0x142929670a0e6e70ULL,
+	0x27b70a8546d22ffcULL, 0x2e1b21385c26c926ULL, 0x4d2c6dfc5ac42aedULL, 0x53380d139d95b3dfULL,
+	0x650a73548baf63deULL, 0x766a0abb3c77b2a8ULL, 0x81c2c92e47edaee6ULL, 0x92722c851482353bULL,
+	0xa2bfe8a14cf10364ULL, 0xa81a664bbc423001ULL, 0xc24b8b70d0f89791ULL, 0xc76c51a30654be30ULL,
+	0xd192e819d6ef5218ULL, 0xd69906245565a910ULL, 0xf40e35855771202aULL, 0x106aa07032bbd1b8ULL,
+	0x19a4c116b8d2d0c8ULL, 0x1e376c085141ab53ULL, 0x2748774cdf8eeb99ULL, 0x34b0bcb5e19b48a8ULL,
+	0x391c0cb3c5c95a63ULL, 0x4ed8aa4ae3418acbULL, 0x5b9cca4f7763e373ULL, 0x682e6ff3d6b2b8a3ULL,
+	0x748f82ee5defb2fcULL, 0x78a5636f43172f60ULL, 0x84c87814a1f0ab72ULL, 0x8cc702081a6439ecULL,
+	0x90befffa23631e28ULL, 0xa4506cebde82bde9ULL, 0xbef9a3f7b2c67915ULL, 0xc67178f2e372532bULL,
+	0xca273eceea26619cULL, 0xd186b8c721c0c207ULL, 0xeada7dd6cde0eb1eULL, 0xf57d4f7fee6ed178ULL,
+	0x06f067aa72176fbaULL, 0x0a637dc5a2c898a6ULL, 0x113f9804bef90daeULL, 0x1b710b35131c471bULL,
+	0x28db77f523047d84ULL, 0x32caab7b40c72493ULL, 0x3c9ebe0a15c9bebcULL, 0x431d67c49c100d4cULL,
+	0x4cc5d4becb3e42b6ULL, 0x597f299cfc657e2aULL, 0x5fcb6fab3ad6faecULL, 0x6c44198c4a475817ULL};
+
+static RSU_OSAL_U32 load_be32(const RSU_OSAL_U8 *p)
+{
+	return ((RSU_OSAL_U32)p[0] << 24) | ((RSU_OSAL_U32)p[1] << 16) | ((RSU_OSAL_U32)p[2] << 8) |
+	       p[3];
+}
+
+static RSU_OSAL_U64 load_be64(const RSU_OSAL_U8 *p)
+{
+	return ((RSU_OSAL_U64)load_be32(p) << 32) | load_be32(p + 4);
+}
+
+static RSU_OSAL_VOID store_be32(RSU_OSAL_U8 *p, RSU_OSAL_U32 v)
+{
+	p[0] = v >> 24;
+	p[1] = v >> 16;
+	p[2] = v >> 8;
+	p[3] = v;
+}
+
+static RSU_OSAL_VOID store_be64(RSU_OSAL_U8 *p, RSU_OSAL_U64 v)
+{
+	store_be32(p, v >> 32);
+	store_be32(p + 4, v);
+}
+
+static RSU_OSAL_VOID sha256_block(RSU_OSAL_U32 *state, const RSU_OSAL_U8 *blk)
+{
+	RSU_OSAL_U32 w[64];
+	RSU_OSAL_U32 a, b, c, d, e, f, g, h, t1, t2;
+	RSU_OSAL_INT i;
+
+	for (i = 0; i < 16; i++) {
+		w[i] = load_be32(blk + 4 * i);
+	}
+	for (i = 16; i < 64; i++) {
+		w[i] = (ROR32(w[i - 2], 17) ^ ROR32(w[i - 2], 19) ^ (w[i - 2] >> 10)) + w[i - 7] +
+		       (ROR32(w[i - 15], 7) ^ ROR32(w[i - 15], 18) ^ (w[i - 15] >> 3)) + w[i - 16];
+	}
+
+	a = state[0];
+	b = state[1];
+	c = state[2];
+	d = state[3];
+	e = state[4];
+	f = state[5];
+	g = state[6];
+	h = state[7];
+
+	for (i = 0; i < 64; i++) {
+		t1 = h + (ROR32(e, 6) ^ ROR32(e, 11) ^ ROR32(e, 25)) + ((e & f) ^ (~e & g)) +
+		     k256[i] + w[i];
+		t2 = (ROR32(a, 2) ^ ROR32(a, 13) ^ ROR32(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+		h = g;
+		g = f;
+		f = e;
+		e = d + t1;
+		d = c;
+		c = b;
+		b = a;
+		a = t1 + t2;
+	}
+
+	state[0] += a;
+	state[1] += b;
+	state[2] += c;
+	state[3] += d;
+	state[4] += e;
+	state[5] += f;
+	state[6] += g;
+	state[7] += h;
+}
+
+static RSU_OSAL_VOID sha512_block(RSU_OSAL_U64 *state, const RSU_OSAL_U8 *blk)
+{
+	RSU_OSAL_U64 w[80];
+	RSU_OSAL_U64 a, b, c, d, e, f, g, h, t1, t2;
+	RSU_OSAL_INT i;
+
+	for (i = 0; i < 16; i++) {
+		w[i] = load_be64(blk + 8 * i);
+	}
+	for (i = 16; i < 80; i++) {
+		w[i] = (ROR64(w[i - 2], 19) ^ ROR64(w[i - 2], 61) ^ (w[i - 2] >> 6)) + w[i - 7] +
+		       (ROR64(w[i - 15], 1) ^ ROR64(w[i - 15], 8) ^ (w[i - 15] >> 7)) + w[i - 16];
+	}
+
+	a = state[0];
+	b = state[1];
+	c = state[2];
+	d = state[3];
+	e = state[4];
+	f = state[5];
+	g = state[6];
+	h = state[7];
+
+	for (i = 0; i < 80; i++) {
+		t1 = h + (ROR64(e, 14) ^ ROR64(e, 18) ^ ROR64(e, 41)) + ((e & f) ^ (~e & g)) +
+		     k512[i] + w[i];
+		t2 = (ROR64(a, 28) ^ ROR64(a, 34) ^ ROR64(a, 39)) + ((a & b) ^ (a & c) ^ (b & c));
+		h = g;
+		g = f;
+		f = e;
+		e = d + t1;
+		d = c;
+		c = b;
+		b = a;
+		a = t1 + t2;
+	}
+
+	state[0] += a;
+	state[1] += b;
+	state[2] += c;
+	state[3] += d;
+	state[4] += e;
+	state[5] += f;
+	state[6] += g;
+	state[7] += h;
+}
+
+RSU_OSAL_VOID librsu_sha256_init(struct rsu_sha256_ctx *c)
+{
+	static const RSU_OSAL_U32 iv[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+					   0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+	RSU_OSAL_INT i;
+
+	for (i = 0; i < 8; i++) {
+		c->state[i] = iv[i];
+	}
+	c->count = 0;
+}
+
+RSU_OSAL_VOID librsu_sha256_update(struct rsu_sha256_ctx *c, const RSU_OSAL_U8 *data,
+				   RSU_OSAL_SIZE len)
+{
+	RSU_OSAL_SIZE used = c->count % sizeof(c->buf);
+	RSU_OSAL_SIZE n;
+
+	c->count += len;
+
+	if (used) {
+		n = sizeof(c->buf) - used;
+		if (n > len) {
+			n = len;
+		}
+		rsu_memcpy(c->buf + used, (RSU_OSAL_VOID *)(uintptr_t)data, n);
+		data += n;
+		len -= n;
+		if (used + n < sizeof(c->buf)) {
+			return;
+		}
+		sha256_block(c->state, c->buf);
+	}
+
+	while (len >= sizeof(c->buf)) {
+		sha256_block(c->state, data);
+		data += sizeof(c->buf);
+		len -= sizeof(c->buf);
+	}
+
+	if (len) {
+		rsu_memcpy(c->buf, (RSU_OSAL_VOID *)(uintptr_t)data, len);
+	}
+}
+
+RSU_OSAL_VOID librsu_sha256_final(struct rsu_sha256_ctx *c, RSU_OSAL_U8 *out)
+{
+	RSU_OSAL_SIZE used = c->count % sizeof(c->buf);
+	RSU_OSAL_U64 bits = c->count * 8;
+	RSU_OSAL_INT i;
+
+	c->buf[used++] = 0x80;
+	if (used > sizeof(c->buf) - 8) {
+		rsu_memset(c->buf + used, 0, sizeof(c->buf) - used);
+		sha256_block(c->state, c->buf);
+		used = 0;
+	}
+	rsu_memset(c->buf + used, 0, sizeof(c->buf) - 8 - used);
+	store_be64(c->buf + sizeof(c->buf) - 8, bits);
+	sha256_block(c->state, c->buf);
+
+	for (i = 0; i < 8; i++) {
+		store_be32(out + 4 * i, c->state[i]);
+	}
+}
+
+RSU_OSAL_VOID librsu_sha384_init(struct rsu_sha512_ctx *c)
+{
+	static const RSU_OSAL_U64 iv[8] = {0xcbbb9d5dc1059ed8ULL, 0x629a292a367cd507ULL,
+					   0x9159015a3070dd17ULL, 0x152fecd8f70e5939ULL,
+					   0x67332667ffc00b31ULL, 0x8eb44a8768581511ULL,
+					   0xdb0c2e0d64f98fa7ULL, 0x47b5481dbefa4fa4ULL};
+	RSU_OSAL_INT i;
+
+	for (i = 0; i < 8; i++) {
+		c->state[i] = iv[i];
+	}
+	c->count = 0;
+}
+
+RSU_OSAL_VOID librsu_sha512_update(struct rsu_sha512_ctx *c, const RSU_OSAL_U8 *data,
+				   RSU_OSAL_SIZE len)
+{
+	RSU_OSAL_SIZE used = c->count % sizeof(c->buf);
+	RSU_OSAL_SIZE n;
+
+	c->count += len;
+
+	if (used) {
+		n = sizeof(c->buf) - used;
+		if (n > len) {
+			n = len;
+		}
+		rsu_memcpy(c->buf + used, (RSU_OSAL_VOID *)(uintptr_t)data, n);
+		data += n;
+		len -= n;
+		if (used + n < sizeof(c->buf)) {
+			return;
+		}
+		sha512_block(c->state, c->buf);
+	}
+
+	while (len >= sizeof(c->buf)) {
+		sha512_block(c->state, data);
+		data += sizeof(c->buf);
+		len -= sizeof(c->buf);
+	}
+
+	if (len) {
+		rsu_memcpy(c->buf, (RSU_OSAL_VOID *)(uintptr_t)data, len);
+	}
+}
+
+RSU_OSAL_VOID librsu_sha384_final(struct rsu_sha512_ctx *c, RSU_OSAL_U8 *out)
+{
+	RSU_OSAL_SIZE used = c->count % sizeof(c->buf);
+	RSU_OSAL_U64 bits = c->count * 8;
+	RSU_OSAL_INT i;
+
+	c->buf[used++] = 0x80;
+	if (used > sizeof(c->buf) - 16) {
+		rsu_memset(c->buf + used, 0, sizeof(c->buf) - used);
+		sha512_block(c->state, c->buf);
+		used = 0;
+	}
+	/* the upper 64 bits of the 128 bit length are always zero here */
+	rsu_memset(c->buf + used, 0, sizeof(c->buf) - 8 - used);
+	store_be64(c->buf + sizeof(c->buf) - 8, bits);
+	sha512_block(c->state, c->buf);
+
+	for (i = 0; i < 6; i++) {
+		store_be64(out + 8 * i, c->state[i]);
+	}
+}
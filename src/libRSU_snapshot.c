@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2023-2024 Intel Corporation
+ * SPDX-License-Identifier: MIT-0
+ */
+
+#include <libRSU_snapshot.h>
+#include <libRSU_cfg.h>
+#include <libRSU_ll_intf.h>
+#include <libRSU_misc.h>
+#include <utils/RSU_logging.h>
+#include <string.h>
+
+static RSU_OSAL_U32 snapshot_crc(struct rsu_snapshot *snap)
+{
+	RSU_OSAL_U32 saved = snap->hdr.crc;
+	RSU_OSAL_U32 crc;
+
+	snap->hdr.crc = 0;
+	crc = rsu_crc32(0, (const RSU_OSAL_U8 *)snap, sizeof(*snap));
+	snap->hdr.crc = saved;
+
+	return crc;
+}
+
+/* systems without a boot id get an empty one, the flash confirmation still applies */
+static RSU_OSAL_VOID snapshot_boot_id(struct librsu_ll_intf *hal, RSU_OSAL_CHAR *boot_id)
+{
+	RSU_OSAL_FILE *file;
+	RSU_OSAL_INT len;
+	RSU_OSAL_INT x;
+
+	rsu_memset(boot_id, 0, RSU_SNAPSHOT_BOOT_ID_LEN);
+
+	file = hal->file.open(RSU_BOOT_ID_FILE, RSU_FILE_READ);
+	if (file == NULL) {
+		return;
+	}
+
+	len = hal->file.read(boot_id, RSU_SNAPSHOT_BOOT_ID_LEN - 1, file);
+	hal->file.close(file);
+
+	if (len <= 0) {
+		rsu_memset(boot_id, 0, RSU_SNAPSHOT_BOOT_ID_LEN);
+		return;
+	}
+
+	for (x = 0; x < len; x++) {
+		if (boot_id[x] == '\n') {
+			boot_id[x] = '\0';
+			break;
+		}
+	}
+}
+
+RSU_OSAL_BOOL librsu_snapshot_enabled(RSU_OSAL_VOID)
+{
+	return librsu_cfg_metadata_cache() != NULL;
+}
+
+RSU_OSAL_INT librsu_snapshot_load(struct rsu_snapshot *snap)
+{
+	struct librsu_ll_intf *hal = librsu_get_ll_inf();
+	RSU_OSAL_CHAR boot_id[RSU_SNAPSHOT_BOOT_ID_LEN];
+	RSU_OSAL_CHAR *path;
+	RSU_OSAL_FILE *file;
+	RSU_OSAL_U32 len, cnt = 0;
+	RSU_OSAL_INT c;
+
+	path = librsu_cfg_metadata_cache();
+	if (hal == NULL || path == NULL || snap == NULL) {
+		return -EINVAL;
+	}
+
+	file = hal->file.open(path, RSU_FILE_READ);
+	if (file == NULL) {
+		return -ENOENT;
+	}
+
+	len = sizeof(*snap);
+	while (cnt < len) {
+		c = hal->file.read((RSU_OSAL_U8 *)snap + cnt, len - cnt, file);
+		if (c <= 0) {
+			break;
+		}
+		cnt += c;
+	}
+	hal->file.close(file);
+
+	if (cnt != len || snap->hdr.magic != RSU_SNAPSHOT_MAGIC ||
+	    snap->hdr.version != RSU_SNAPSHOT_VERSION || snap->hdr.size != len ||
+	    snapshot_crc(snap) != snap->hdr.crc) {
+		RSU_LOG_DBG("metadata snapshot not valid");
+		return -EBADF;
+	}
+
+	snapshot_boot_id(hal, boot_id);
+	if (strncmp(boot_id, snap->hdr.boot_id, RSU_SNAPSHOT_BOOT_ID_LEN) != 0) {
+		RSU_LOG_DBG("metadata snapshot taken in another boot");
+		return -ESTALE;
+	}
+
+	return 0;
+}
+
+RSU_OSAL_INT librsu_snapshot_save(struct rsu_snapshot *snap)
+{
+	struct librsu_ll_intf *hal = librsu_get_ll_inf();
+	RSU_OSAL_CHAR *path;
+	RSU_OSAL_FILE *file;
+	RSU_OSAL_INT rtn = 0;
+
+	path = librsu_cfg_metadata_cache();
+	if (hal == NULL || path == NULL || snap == NULL) {
+		return -EINVAL;
+	}
+
+	snap->hdr.magic = RSU_SNAPSHOT_MAGIC;
+	snap->hdr.version = RSU_SNAPSHOT_VERSION;
+	snap->hdr.size = sizeof(*snap);
+	snapshot_boot_id(hal, snap->hdr.boot_id);
+	snap->hdr.crc = snapshot_crc(snap);
+
+	file = hal->file.open(path, RSU_FILE_WRITE);
+	if (file == NULL) {
+		RSU_LOG_ERR("Unable to open metadata snapshot '%s'", path);
+		return -EFILEIO;
+	}
+
+	if (hal->file.write(snap, sizeof(*snap), file) != (RSU_OSAL_INT)sizeof(*snap)) {
+		RSU_LOG_ERR("Unable to write metadata snapshot '%s'", path);
+		rtn = -EFILEIO;
+	}
+
+	hal->file.close(file);
+	return rtn;
+}
+
+/* opening for write truncates the file, which then fails validation */
+RSU_OSAL_VOID librsu_snapshot_invalidate(RSU_OSAL_VOID)
+{
+	struct librsu_ll_intf *hal = librsu_get_ll_inf();
+	RSU_OSAL_CHAR *path;
+	RSU_OSAL_FILE *file;
+
+	path = librsu_cfg_metadata_cache();
+	if (hal == NULL || path == NULL) {
+		return;
+	}
+
+	file = hal->file.open(path, RSU_FILE_WRITE);
+	if (file != NULL) {
+		hal->file.close(file);
+	}
+}
@@ -0,0 +1,241 @@
+/*
+ * Copyright (C) 2023-2024 Intel Corporation
+ * SPDX-License-Identifier: MIT-0
+ */
+
+#include <libRSU_stats.h>
+
+/*
+ * The counters are plain atomic adds, no lock is taken on the measured paths.
+ * A call costs two reads of the monotonic clock and a handful of adds, which
+ * is noise next to a flash access or a mailbox round trip.
+ */
+struct stats_counter {
+	RSU_OSAL_ATOMIC64 count;
+	RSU_OSAL_ATOMIC64 errors;
+	RSU_OSAL_ATOMIC64 bytes;
+	RSU_OSAL_ATOMIC64 ns;
+	RSU_OSAL_ATOMIC64 hist[RSU_STATS_BUCKETS];
+};
+
+static struct stats_counter stats[RSU_STATS_OPS];
+
+static const RSU_OSAL_CHAR *const stats_names[RSU_STATS_OPS] = {
+	[RSU_STATS_FLASH_READ] = "flash_read",
+	[RSU_STATS_FLASH_WRITE] = "flash_write",
+	[RSU_STATS_FLASH_ERASE] = "flash_erase",
+	[RSU_STATS_MAILBOX] = "mailbox",
+	[RSU_STATS_MISC] = "misc",
+	[RSU_STATS_FILE_READ] = "file_read",
+	[RSU_STATS_FILE_WRITE] = "file_write",
+	[RSU_STATS_API] = "api",
+	[RSU_STATS_LOCK_WAIT] = "lock_wait",
+};
+
+/* the platform operations, called by the wrappers installed in the HAL */
+static struct librsu_ll_intf stats_hal;
+
+static RSU_OSAL_U32 stats_bucket(RSU_OSAL_U64 ns)
+{
+	RSU_OSAL_U32 b = 0;
+
+	while (ns > 1 && b < RSU_STATS_BUCKETS - 1) {
+		ns >>= 1;
+		b++;
+	}
+
+	return b;
+}
+
+RSU_OSAL_VOID librsu_stats_add(enum rsu_stats_op op, RSU_OSAL_U64 ns, RSU_OSAL_INT failed,
+			       RSU_OSAL_U64 bytes)
+{
+	struct stats_counter *c = &stats[op];
+
+	rsu_atomic64_add(&c->count, 1);
+	if (failed) {
+		rsu_atomic64_add(&c->errors, 1);
+	} else if (bytes) {
+		rsu_atomic64_add(&c->bytes, bytes);
+	}
+	rsu_atomic64_add(&c->ns, ns);
+	rsu_atomic64_add(&c->hist[stats_bucket(ns)], 1);
+}
+
+static RSU_OSAL_INT stats_qspi_read(RSU_OSAL_OFFSET offset, RSU_OSAL_VOID *data,
+				    RSU_OSAL_SIZE len)
+{
+	RSU_OSAL_U64 start = rsu_time_ns();
+	RSU_OSAL_INT ret = stats_hal.qspi.read(offset, data, len);
+
+	librsu_stats_add(RSU_STATS_FLASH_READ, rsu_time_ns() - start, ret, len);
+	return ret;
+}
+
+static RSU_OSAL_INT stats_qspi_write(RSU_OSAL_OFFSET offset, const RSU_OSAL_VOID *data,
+				     RSU_OSAL_SIZE len)
+{
+	RSU_OSAL_U64 start = rsu_time_ns();
+	RSU_OSAL_INT ret = stats_hal.qspi.write(offset, data, len);
+
+	librsu_stats_add(RSU_STATS_FLASH_WRITE, rsu_time_ns() - start, ret, len);
+	return ret;
+}
+
+static RSU_OSAL_INT stats_qspi_erase(RSU_OSAL_OFFSET offset, RSU_OSAL_SIZE len)
+{
+	RSU_OSAL_U64 start = rsu_time_ns();
+	RSU_OSAL_INT ret = stats_hal.qspi.erase(offset, len);
+
+	librsu_stats_add(RSU_STATS_FLASH_ERASE, rsu_time_ns() - start, ret, len);
+	return ret;
+}
+
+static RSU_OSAL_INT stats_get_rsu_status(struct mbox_status_info *data)
+{
+	RSU_OSAL_U64 start = rsu_time_ns();
+	RSU_OSAL_INT ret = stats_hal.mbox.get_rsu_status(data);
+
+	librsu_stats_add(RSU_STATS_MAILBOX, rsu_time_ns() - start, ret, 0);
+	return ret;
+}
+
+static RSU_OSAL_INT stats_send_rsu_update(RSU_OSAL_U64 addr)
+{
+	RSU_OSAL_U64 start = rsu_time_ns();
+	RSU_OSAL_INT ret = stats_hal.mbox.send_rsu_update(addr);
+
+	librsu_stats_add(RSU_STATS_MAILBOX, rsu_time_ns() - start, ret, 0);
+	return ret;
+}
+
+static RSU_OSAL_INT stats_get_spt_addresses(struct mbox_data_rsu_spt_address *data)
+{
+	RSU_OSAL_U64 start = rsu_time_ns();
+	RSU_OSAL_INT ret = stats_hal.mbox.get_spt_addresses(data);
+
+	librsu_stats_add(RSU_STATS_MAILBOX, rsu_time_ns() - start, ret, 0);
+	return ret;
+}
+
+static RSU_OSAL_INT stats_rsu_notify(RSU_OSAL_U32 notify)
+{
+	RSU_OSAL_U64 start = rsu_time_ns();
+	RSU_OSAL_INT ret = stats_hal.mbox.rsu_notify(notify);
+
+	librsu_stats_add(RSU_STATS_MAILBOX, rsu_time_ns() - start, ret, 0);
+	return ret;
+}
+
+static RSU_OSAL_INT stats_get_dcmf_status(struct rsu_dcmf_status *data)
+{
+	RSU_OSAL_U64 start = rsu_time_ns();
+	RSU_OSAL_INT ret = stats_hal.misc.rsu_get_dcmf_status(data);
+
+	librsu_stats_add(RSU_STATS_MISC, rsu_time_ns() - start, ret, 0);
+	return ret;
+}
+
+static RSU_OSAL_INT stats_get_max_retry_count(RSU_OSAL_U8 *rsu_max_retry)
+{
+	RSU_OSAL_U64 start = rsu_time_ns();
+	RSU_OSAL_INT ret = stats_hal.misc.rsu_get_max_retry_count(rsu_max_retry);
+
+	librsu_stats_add(RSU_STATS_MISC, rsu_time_ns() - start, ret, 0);
+	return ret;
+}
+
+static RSU_OSAL_INT stats_get_dcmf_version(struct rsu_dcmf_version *version)
+{
+	RSU_OSAL_U64 start = rsu_time_ns();
+	RSU_OSAL_INT ret = stats_hal.misc.rsu_get_dcmf_version(version);
+
+	librsu_stats_add(RSU_STATS_MISC, rsu_time_ns() - start, ret, 0);
+	return ret;
+}
+
+static RSU_OSAL_INT stats_file_read(RSU_OSAL_VOID *buf, RSU_OSAL_SIZE len, RSU_OSAL_FILE *file)
+{
+	RSU_OSAL_U64 start = rsu_time_ns();
+	RSU_OSAL_INT ret = stats_hal.file.read(buf, len, file);
+
+	librsu_stats_add(RSU_STATS_FILE_READ, rsu_time_ns() - start, ret < 0, ret < 0 ? 0 : ret);
+	return ret;
+}
+
+static RSU_OSAL_INT stats_file_write(RSU_OSAL_VOID *buf, RSU_OSAL_SIZE len, RSU_OSAL_FILE *file)
+{
+	RSU_OSAL_U64 start = rsu_time_ns();
+	RSU_OSAL_INT ret = stats_hal.file.write(buf, len, file);
+
+	librsu_stats_add(RSU_STATS_FILE_WRITE, rsu_time_ns() - start, ret < 0, ret < 0 ? 0 : ret);
+	return ret;
+}
+
+/*
+ * librsu_stats_wrap() - count the platform calls made through a HAL
+ * hal: initialized HAL, its operations are replaced by counting wrappers
+ *
+ * Operations the platform leaves NULL stay NULL.
+ */
+RSU_OSAL_VOID librsu_stats_wrap(struct librsu_ll_intf *hal)
+{
+	stats_hal = *hal;
+
+#define STATS_WRAP(field, wrapper)                                                                 \
+	do {                                                                                       \
+		if (hal->field) {                                                                  \
+			hal->field = wrapper;                                                      \
+		}                                                                                  \
+	} while (0)
+
+	STATS_WRAP(qspi.read, stats_qspi_read);
+	STATS_WRAP(qspi.write, stats_qspi_write);
+	STATS_WRAP(qspi.erase, stats_qspi_erase);
+	STATS_WRAP(mbox.get_rsu_status, stats_get_rsu_status);
+	STATS_WRAP(mbox.send_rsu_update, stats_send_rsu_update);
+	STATS_WRAP(mbox.get_spt_addresses, stats_get_spt_addresses);
+	STATS_WRAP(mbox.rsu_notify, stats_rsu_notify);
+	STATS_WRAP(misc.rsu_get_dcmf_status, stats_get_dcmf_status);
+	STATS_WRAP(misc.rsu_get_max_retry_count, stats_get_max_retry_count);
+	STATS_WRAP(misc.rsu_get_dcmf_version, stats_get_dcmf_version);
+	STATS_WRAP(file.read, stats_file_read);
+	STATS_WRAP(file.write, stats_file_write);
+
+#undef STATS_WRAP
+}
+
+RSU_OSAL_VOID librsu_stats_get(struct rsu_stats *result)
+{
+	RSU_OSAL_U32 x, y;
+
+	for (x = 0; x < RSU_STATS_OPS; x++) {
+		result->op[x].count = rsu_atomic64_load(&stats[x].count);
+		result->op[x].errors = rsu_atomic64_load(&stats[x].errors);
+		result->op[x].bytes = rsu_atomic64_load(&stats[x].bytes);
+		result->op[x].ns = rsu_atomic64_load(&stats[x].ns);
+		for (y = 0; y < RSU_STATS_BUCKETS; y++) {
+			result->op[x].hist[y] = rsu_atomic64_load(&stats[x].hist[y]);
+		}
+	}
+}
+
+RSU_OSAL_VOID librsu_stats_reset(RSU_OSAL_VOID)
+{
+	RSU_OSAL_U32 x, y;
+
+	for (x = 0; x < RSU_STATS_OPS; x++) {
+		rsu_atomic64_store(&stats[x].count, 0);
+		rsu_atomic64_store(&stats[x].errors, 0);
+		rsu_atomic64_store(&stats[x].bytes, 0);
+		rsu_atomic64_store(&stats[x].ns, 0);
+		for (y = 0; y < RSU_STATS_BUCKETS; y++) {
+			rsu_atomic64_store(&stats[x].hist[y], 0);
+		}
+	}
+}
+
+const RSU_OSAL_CHAR *librsu_stats_name(enum rsu_stats_op op)
+{
+	return stats_names[op];
+}
@@ -0,0 +1,206 @@
+/*
+ * Copyright (C) 2023-2024 Intel Corporation
+ * SPDX-License-Identifier: MIT-0
+ */
+
+#include <libRSU.h>
+#include <libRSU_OSAL.h>
+#include <libRSU_ll_intf.h>
+#include <libRSU_cfg.h>
+#include <libRSU_status.h>
+#include <utils/RSU_logging.h>
+#include <utils/RSU_utils.h>
+#include <string.h>
+
+static struct {
+	RSU_OSAL_MUTEX mutex;
+	/* broadcast on every status change and when a waiter leaves during exit */
+	RSU_OSAL_COND changed;
+	/* ends the sleep of the poller early on exit and when a waiter comes */
+	RSU_OSAL_COND wake;
+	RSU_OSAL_THREAD thread;
+	RSU_OSAL_BOOL ready;
+	RSU_OSAL_BOOL running;
+	RSU_OSAL_BOOL stop;
+	RSU_OSAL_BOOL valid;
+	RSU_OSAL_U32 waiters;
+	struct rsu_status_info status;
+} watch;
+
+#define WATCH_LOCK()   rsu_mutex_timedlock(&(watch.mutex), RSU_TIME_FOREVER)
+#define WATCH_UNLOCK() rsu_mutex_unlock(&(watch.mutex))
+
+static RSU_OSAL_VOID *status_poller(RSU_OSAL_VOID *arg)
+{
+	struct librsu_ll_intf *hal = librsu_get_ll_inf();
+	RSU_OSAL_U32 interval = librsu_cfg_status_poll_interval();
+	RSU_OSAL_BOOL notify = (hal && hal->mbox.wait_rsu_status);
+	struct rsu_status_info now;
+	RSU_OSAL_INT ret;
+
+	ARG_UNUSED(arg);
+
+	WATCH_LOCK();
+	while (!watch.stop) {
+		/* nobody waits, park until the next rsu_status_wait() */
+		if (!watch.waiters) {
+			watch.valid = false;
+			rsu_cond_timedwait(&watch.wake, &watch.mutex, RSU_TIME_FOREVER);
+			continue;
+		}
+
+		WATCH_UNLOCK();
+		ret = rsu_status_log(&now);
+		WATCH_LOCK();
+
+		if (ret == 0 &&
+		    (!watch.valid || memcmp(&now, &watch.status, sizeof(now)) != 0)) {
+			watch.status = now;
+			watch.valid = true;
+			rsu_cond_broadcast(&watch.changed);
+		}
+
+		if (watch.stop) {
+			break;
+		}
+
+		if (notify) {
+			WATCH_UNLOCK();
+			ret = hal->mbox.wait_rsu_status(interval);
+			WATCH_LOCK();
+			if (ret == 0 || ret == -ETIMEDOUT) {
+				continue;
+			}
+			RSU_LOG_DBG("status notifications not available (%d), polling", ret);
+			notify = false;
+		}
+
+		rsu_cond_timedwait(&watch.wake, &watch.mutex, interval);
+	}
+	WATCH_UNLOCK();
+
+	return NULL;
+}
+
+RSU_OSAL_INT librsu_status_watch_init(RSU_OSAL_VOID)
+{
+	RSU_OSAL_INT ret;
+
+	rsu_memset(&watch, 0, sizeof(watch));
+
+	ret = rsu_mutex_init(&watch.mutex);
+	if (ret) {
+		return ret;
+	}
+
+	ret = rsu_cond_init(&watch.changed);
+	if (ret) {
+		rsu_mutex_destroy(&watch.mutex);
+		return ret;
+	}
+
+	ret = rsu_cond_init(&watch.wake);
+	if (ret) {
+		rsu_cond_destroy(&watch.changed);
+		rsu_mutex_destroy(&watch.mutex);
+		return ret;
+	}
+
+	watch.ready = true;
+	return 0;
+}
+
+RSU_OSAL_VOID librsu_status_watch_exit(RSU_OSAL_VOID)
+{
+	if (!watch.ready) {
+		return;
+	}
+
+	WATCH_LOCK();
+	watch.stop = true;
+	rsu_cond_broadcast(&watch.wake);
+	rsu_cond_broadcast(&watch.changed);
+	while (watch.waiters) {
+		rsu_cond_timedwait(&watch.changed, &watch.mutex, RSU_TIME_FOREVER);
+	}
+	WATCH_UNLOCK();
+
+	if (watch.running) {
+		rsu_thread_join(&watch.thread, NULL);
+		watch.running = false;
+	}
+
+	rsu_cond_destroy(&watch.wake);
+	rsu_cond_destroy(&watch.changed);
+	rsu_mutex_destroy(&watch.mutex);
+	watch.ready = false;
+}
+
+RSU_OSAL_INT librsu_status_wait(RSU_OSAL_U32 timeout, struct rsu_status_info *info)
+{
+	RSU_OSAL_U64 deadline = 0;
+	RSU_OSAL_U64 now;
+	RSU_OSAL_INT ret = 0;
+
+	if (!info) {
+		return -EINVAL;
+	}
+
+	if (!watch.ready) {
+		return -ELIB;
+	}
+
+	if (timeout != RSU_TIME_FOREVER) {
+		deadline = rsu_time_ns() + (RSU_OSAL_U64)timeout * 1000000ULL;
+	}
+
+	WATCH_LOCK();
+	if (watch.stop) {
+		WATCH_UNLOCK();
+		return -ELIB;
+	}
+
+	if (!watch.running) {
+		ret = rsu_thread_create(&watch.thread, status_poller, NULL);
+		if (ret) {
+			WATCH_UNLOCK();
+			RSU_LOG_ERR("Error in starting status poller %d", ret);
+			return -ELIB;
+		}
+		watch.running = true;
+	}
+
+	if (watch.waiters++ == 0) {
+		rsu_cond_broadcast(&watch.wake);
+	}
+	while (!watch.stop &&
+	       (!watch.valid || memcmp(&watch.status, info, sizeof(*info)) == 0)) {
+		if (timeout == RSU_TIME_FOREVER) {
+			rsu_cond_timedwait(&watch.changed, &watch.mutex, RSU_TIME_FOREVER);
+			continue;
+		}
+
+		now = rsu_time_ns();
+		if (now >= deadline) {
+			ret = -ETIMEDOUT;
+			break;
+		}
+
+		rsu_cond_timedwait(&watch.changed, &watch.mutex,
+				   (RSU_OSAL_U32)((deadline - now + 999999ULL) / 1000000ULL));
+	}
+
+	if (watch.stop) {
+		ret = -ELIB;
+	} else if (ret == 0) {
+		*info = watch.status;
+	}
+
+	watch.waiters--;
+	if (watch.stop) {
+		rsu_cond_broadcast(&watch.changed);
+	}
+	WATCH_UNLOCK();
+
+	return ret;
+}
@@ -0,0 +1,880 @@
+/*
+ * Copyright (C) 2023-2024 Intel Corporation
+ * SPDX-License-Identifier: MIT-0
+ */
+
+#include <libRSU.h>
+#include <libRSU_trace.h>
+#include <hal/RSU_plat_crc32.h>
+#include <utils/RSU_logging.h>
+#include <string.h>
+
+#define TRACE_BUF_SIZE	0x10000
+#define TRACE_MAX_FILES 16
+
+/*
+ * Tracing: the platform operations are replaced by wrappers which call the
+ * original one and append a record to a buffer, written out to the trace file
+ * through the original file operations when full and when the file platform
+ * terminates.
+ */
+static struct {
+	struct librsu_ll_intf plat;
+	RSU_OSAL_FILE *file;
+	RSU_OSAL_MUTEX lock;
+	RSU_OSAL_BOOL data;
+	RSU_OSAL_BOOL failed;
+	RSU_OSAL_U64 base;
+	RSU_OSAL_U8 *buf;
+	RSU_OSAL_U32 used;
+	RSU_OSAL_FILE *files[TRACE_MAX_FILES];
+} trace;
+
+/*
+ * Replay: the flash, mailbox, misc and file operations are served from a
+ * trace, one record per call in the traced order. A call which does not match
+ * its record fails, and so do all the calls after it.
+ */
+static struct {
+	struct filesys_ll_intf plat;
+	RSU_OSAL_FILE *file;
+	RSU_OSAL_MUTEX lock;
+	RSU_OSAL_MUTEX sleep_lock;
+	RSU_OSAL_COND sleep;
+	RSU_OSAL_BOOL timing;
+	RSU_OSAL_BOOL diverged;
+	RSU_OSAL_U32 index;
+	RSU_OSAL_U8 *data;
+	RSU_OSAL_U32 data_size;
+	RSU_OSAL_U8 files[TRACE_MAX_FILES + 1];
+} replay;
+
+static RSU_OSAL_VOID trace_flush(RSU_OSAL_VOID)
+{
+	if (trace.used && !trace.failed &&
+	    trace.plat.file.write(trace.buf, trace.used, trace.file) != (RSU_OSAL_INT)trace.used) {
+		RSU_LOG_ERR("Error in writing the HAL trace, tracing stopped");
+		trace.failed = true;
+	}
+	trace.used = 0;
+}
+
+static RSU_OSAL_VOID trace_put(const RSU_OSAL_VOID *data, RSU_OSAL_U32 len)
+{
+	const RSU_OSAL_U8 *p = data;
+	RSU_OSAL_U32 cnt;
+
+	while (len) {
+		if (trace.used == TRACE_BUF_SIZE) {
+			trace_flush();
+		}
+		cnt = TRACE_BUF_SIZE - trace.used;
+		if (cnt > len) {
+			cnt = len;
+		}
+		memcpy(trace.buf + trace.used, p, cnt);
+		trace.used += cnt;
+		p += cnt;
+		len -= cnt;
+	}
+}
+
+/*
+ * trace_add() - append the record of a call to the trace
+ * op, handle, ret, arg, len: record fields
+ * start: time the call started
+ * data, size: data moved by the call, for the crc and the payload
+ * keep: store the data in the trace, not only its crc
+ */
+static RSU_OSAL_VOID trace_add(enum rsu_trace_op op, RSU_OSAL_U16 handle, RSU_OSAL_INT ret,
+			       RSU_OSAL_U64 arg, RSU_OSAL_U32 len, RSU_OSAL_U64 start,
+			       const RSU_OSAL_VOID *data, RSU_OSAL_U32 size, RSU_OSAL_BOOL keep)
+{
+	struct rsu_trace_record rec;
+
+	rec.ns = rsu_time_ns() - start;
+	rec.op = op;
+	rec.reserved = 0;
+	rec.handle = handle;
+	rec.ret = ret;
+	rec.arg = arg;
+	rec.len = len;
+	rec.crc = size ? rsu_crc32(0, data, size) : 0;
+	rec.start = start - trace.base;
+	rec.size = keep ? size : 0;
+
+	rsu_mutex_timedlock(&trace.lock, RSU_TIME_FOREVER);
+	trace_put(&rec, sizeof(rec));
+	if (rec.size) {
+		trace_put(data, rec.size);
+	}
+	rsu_mutex_unlock(&trace.lock);
+}
+
+/* number of an open file, 0 when it is not known or the table is full */
+static RSU_OSAL_U16 trace_handle(RSU_OSAL_FILE *file, RSU_OSAL_BOOL add, RSU_OSAL_BOOL remove)
+{
+	RSU_OSAL_U16 x, found = 0;
+
+	if (file == NULL) {
+		return 0;
+	}
+
+	rsu_mutex_timedlock(&trace.lock, RSU_TIME_FOREVER);
+	for (x = 0; x < TRACE_MAX_FILES; x++) {
+		if (trace.files[x] == (add ? NULL : file)) {
+			found = x + 1;
+			trace.files[x] = remove ? NULL : file;
+			break;
+		}
+	}
+	rsu_mutex_unlock(&trace.lock);
+
+	return found;
+}
+
+static RSU_OSAL_INT trace_qspi_read(RSU_OSAL_OFFSET offset, RSU_OSAL_VOID *data,
+				    RSU_OSAL_SIZE len)
+{
+	RSU_OSAL_U64 start = rsu_time_ns();
+	RSU_OSAL_INT ret = trace.plat.qspi.read(offset, data, len);
+
+	trace_add(RSU_TRACE_QSPI_READ, 0, ret, offset, len, start, data, ret ? 0 : len, trace.data);
+	return ret;
+}
+
+static RSU_OSAL_INT trace_qspi_write(RSU_OSAL_OFFSET offset, const RSU_OSAL_VOID *data,
+				     RSU_OSAL_SIZE len)
+{
+	RSU_OSAL_U64 start = rsu_time_ns();
+	RSU_OSAL_INT ret = trace.plat.qspi.write(offset, data, len);
+
+	trace_add(RSU_TRACE_QSPI_WRITE, 0, ret, offset, len, start, data, len, trace.data);
+	return ret;
+}
+
+static RSU_OSAL_INT trace_qspi_erase(RSU_OSAL_OFFSET offset, RSU_OSAL_SIZE len)
+{
+	RSU_OSAL_U64 start = rsu_time_ns();
+	RSU_OSAL_INT ret = trace.plat.qspi.erase(offset, len);
+
+	trace_add(RSU_TRACE_QSPI_ERASE, 0, ret, offset, len, start, NULL, 0, false);
+	return ret;
+}
+
+static RSU_OSAL_INT trace_get_rsu_status(struct mbox_status_info *data)
+{
+	RSU_OSAL_U64 start = rsu_time_ns();
+	RSU_OSAL_INT ret = trace.plat.mbox.get_rsu_status(data);
+
+	trace_add(RSU_TRACE_MBOX_GET_STATUS, 0, ret, 0, 0, start, data, sizeof(*data), true);
+	return ret;
+}
+
+static RSU_OSAL_INT trace_send_rsu_update(RSU_OSAL_U64 addr)
+{
+	RSU_OSAL_U64 start = rsu_time_ns();
+	RSU_OSAL_INT ret = trace.plat.mbox.send_rsu_update(addr);
+
+	trace_add(RSU_TRACE_MBOX_SEND_UPDATE, 0, ret, addr, 0, start, NULL, 0, false);
+	return ret;
+}
+
+static RSU_OSAL_INT trace_get_spt_addresses(struct mbox_data_rsu_spt_address *data)
+{
+	RSU_OSAL_U64 start = rsu_time_ns();
+	RSU_OSAL_INT ret = trace.plat.mbox.get_spt_addresses(data);
+
+	trace_add(RSU_TRACE_MBOX_GET_SPT, 0, ret, 0, 0, start, data, sizeof(*data), true);
+	return ret;
+}
+
+static RSU_OSAL_INT trace_rsu_notify(RSU_OSAL_U32 notify)
+{
+	RSU_OSAL_U64 start = rsu_time_ns();
+	RSU_OSAL_INT ret = trace.plat.mbox.rsu_notify(notify);
+
+	trace_add(RSU_TRACE_MBOX_NOTIFY, 0, ret, notify, 0, start, NULL, 0, false);
+	return ret;
+}
+
+static RSU_OSAL_INT trace_wait_rsu_status(RSU_OSAL_U32 timeout)
+{
+	RSU_OSAL_U64 start = rsu_time_ns();
+	RSU_OSAL_INT ret = trace.plat.mbox.wait_rsu_status(timeout);
+
+	trace_add(RSU_TRACE_MBOX_WAIT_STATUS, 0, ret, timeout, 0, start, NULL, 0, false);
+	return ret;
+}
+
+static RSU_OSAL_INT trace_get_dcmf_status(struct rsu_dcmf_status *data)
+{
+	RSU_OSAL_U64 start = rsu_time_ns();
+	RSU_OSAL_INT ret = trace.plat.misc.rsu_get_dcmf_status(data);
+
+	trace_add(RSU_TRACE_MISC_DCMF_STATUS, 0, ret, 0, 0, start, data, sizeof(*data), true);
+	return ret;
+}
+
+static RSU_OSAL_INT trace_get_max_retry_count(RSU_OSAL_U8 *rsu_max_retry)
+{
+	RSU_OSAL_U64 start = rsu_time_ns();
+	RSU_OSAL_INT ret = trace.plat.misc.rsu_get_max_retry_count(rsu_max_retry);
+
+	trace_add(RSU_TRACE_MISC_MAX_RETRY, 0, ret, 0, 0, start, rsu_max_retry,
+		  sizeof(*rsu_max_retry), true);
+	return ret;
+}
+
+static RSU_OSAL_INT trace_get_dcmf_version(struct rsu_dcmf_version *version)
+{
+	RSU_OSAL_U64 start = rsu_time_ns();
+	RSU_OSAL_INT ret = trace.plat.misc.rsu_get_dcmf_version(version);
+
+	trace_add(RSU_TRACE_MISC_DCMF_VERSION, 0, ret, 0, 0, start, version, sizeof(*version),
+		  true);
+	return ret;
+}
+
+static RSU_OSAL_FILE *trace_file_open(RSU_OSAL_CHAR *filename, RSU_filesys_flags_t flag)
+{
+	RSU_OSAL_U64 start = rsu_time_ns();
+	RSU_OSAL_FILE *file = trace.plat.file.open(filename, flag);
+
+	trace_add(RSU_TRACE_FILE_OPEN, trace_handle(file, true, false), file ? 0 : -1, flag, 0,
+		  start, filename, filename ? strlen(filename) + 1 : 0, true);
+	return file;
+}
+
+static RSU_OSAL_INT trace_file_read(RSU_OSAL_VOID *buf, RSU_OSAL_SIZE len, RSU_OSAL_FILE *file)
+{
+	RSU_OSAL_U64 start = rsu_time_ns();
+	RSU_OSAL_INT ret = trace.plat.file.read(buf, len, file);
+
+	trace_add(RSU_TRACE_FILE_READ, trace_handle(file, false, false), ret, 0, len, start, buf,
+		  ret > 0 ? ret : 0, trace.data);
+	return ret;
+}
+
+static RSU_OSAL_INT trace_file_write(RSU_OSAL_VOID *buf, RSU_OSAL_SIZE len, RSU_OSAL_FILE *file)
+{
+	RSU_OSAL_U64 start = rsu_time_ns();
+	RSU_OSAL_INT ret = trace.plat.file.write(buf, len, file);
+
+	trace_add(RSU_TRACE_FILE_WRITE, trace_handle(file, false, false), ret, 0, len, start, buf,
+		  len, trace.data);
+	return ret;
+}
+
+static RSU_OSAL_INT trace_file_fgets(RSU_OSAL_CHAR *str, RSU_OSAL_SIZE len, RSU_OSAL_FILE *file)
+{
+	RSU_OSAL_U64 start = rsu_time_ns();
+	RSU_OSAL_INT ret = trace.plat.file.fgets(str, len, file);
+
+	trace_add(RSU_TRACE_FILE_FGETS, trace_handle(file, false, false), ret, 0, len, start, str,
+		  ret == 0 ? strlen(str) + 1 : 0, true);
+	return ret;
+}
+
+static RSU_OSAL_INT trace_file_fseek(RSU_OSAL_OFFSET offset, RSU_filesys_whence_t whence,
+				     RSU_OSAL_FILE *file)
+{
+	RSU_OSAL_U64 start = rsu_time_ns();
+	RSU_OSAL_INT ret = trace.plat.file.fseek(offset, whence, file);
+
+	trace_add(RSU_TRACE_FILE_FSEEK, trace_handle(file, false, false), ret, offset, whence,
+		  start, NULL, 0, false);
+	return ret;
+}
+
+static RSU_OSAL_INT trace_file_ftruncate(RSU_OSAL_OFFSET length, RSU_OSAL_FILE *file)
+{
+	RSU_OSAL_U64 start = rsu_time_ns();
+	RSU_OSAL_INT ret = trace.plat.file.ftruncate(length, file);
+
+	trace_add(RSU_TRACE_FILE_FTRUNCATE, trace_handle(file, false, false), ret, length, 0,
+		  start, NULL, 0, false);
+	return ret;
+}
+
+static RSU_OSAL_INT trace_file_close(RSU_OSAL_FILE *file)
+{
+	RSU_OSAL_U16 handle = trace_handle(file, false, true);
+	RSU_OSAL_U64 start = rsu_time_ns();
+	RSU_OSAL_INT ret = trace.plat.file.close(file);
+
+	trace_add(RSU_TRACE_FILE_CLOSE, handle, ret, 0, 0, start, NULL, 0, false);
+	return ret;
+}
+
+/* the file platform goes last, the trace is written out before it */
+static RSU_OSAL_INT trace_file_terminate(RSU_OSAL_VOID)
+{
+	trace_flush();
+	trace.plat.file.close(trace.file);
+	rsu_free(trace.buf);
+	rsu_mutex_destroy(&trace.lock);
+	trace.buf = NULL;
+	trace.file = NULL;
+
+	return trace.plat.file.terminate();
+}
+
+/*
+ * librsu_trace_init() - trace every platform call to the hal-trace file
+ * hal: initialized HAL, its operations are replaced by tracing wrappers
+ *
+ * Return: 0 on success, or negative errno on error
+ */
+RSU_OSAL_INT librsu_trace_init(struct librsu_ll_intf *hal)
+{
+	struct rsu_trace_header hdr;
+	RSU_OSAL_INT ret;
+
+	rsu_memset(&trace, 0, sizeof(trace));
+	trace.plat = *hal;
+	trace.data = hal->cfg.hal_trace_data != 0;
+
+	trace.buf = rsu_malloc(TRACE_BUF_SIZE);
+	if (trace.buf == NULL) {
+		return -ENOMEM;
+	}
+
+	ret = rsu_mutex_init(&trace.lock);
+	if (ret) {
+		rsu_free(trace.buf);
+		return ret;
+	}
+
+	trace.file = hal->file.open(hal->cfg.hal_trace, RSU_FILE_WRITE);
+	if (trace.file == NULL) {
+		RSU_LOG_ERR("Unable to create HAL trace file %s", hal->cfg.hal_trace);
+		rsu_mutex_destroy(&trace.lock);
+		rsu_free(trace.buf);
+		return -ENOENT;
+	}
+
+	hdr.magic = RSU_TRACE_MAGIC;
+	hdr.version = RSU_TRACE_VERSION;
+	hdr.flags = (trace.data ? RSU_TRACE_DATA : 0) |
+		    (hal->mbox.wait_rsu_status ? RSU_TRACE_WAIT_STATUS : 0);
+	trace_put(&hdr, sizeof(hdr));
+	trace.base = rsu_time_ns();
+
+#define TRACE_WRAP(field, wrapper)                                                                 \
+	do {                                                                                       \
+		if (hal->field) {                                                                  \
+			hal->field = wrapper;                                                      \
+		}                                                                                  \
+	} while (0)
+
+	TRACE_WRAP(qspi.read, trace_qspi_read);
+	TRACE_WRAP(qspi.write, trace_qspi_write);
+	TRACE_WRAP(qspi.erase, trace_qspi_erase);
+	TRACE_WRAP(mbox.get_rsu_status, trace_get_rsu_status);
+	TRACE_WRAP(mbox.send_rsu_update, trace_send_rsu_update);
+	TRACE_WRAP(mbox.get_spt_addresses, trace_get_spt_addresses);
+	TRACE_WRAP(mbox.rsu_notify, trace_rsu_notify);
+	TRACE_WRAP(mbox.wait_rsu_status, trace_wait_rsu_status);
+	TRACE_WRAP(misc.rsu_get_dcmf_status, trace_get_dcmf_status);
+	TRACE_WRAP(misc.rsu_get_max_retry_count, trace_get_max_retry_count);
+	TRACE_WRAP(misc.rsu_get_dcmf_version, trace_get_dcmf_version);
+	TRACE_WRAP(file.open, trace_file_open);
+	TRACE_WRAP(file.read, trace_file_read);
+	TRACE_WRAP(file.write, trace_file_write);
+	TRACE_WRAP(file.fgets, trace_file_fgets);
+	TRACE_WRAP(file.fseek, trace_file_fseek);
+	TRACE_WRAP(file.ftruncate, trace_file_ftruncate);
+	TRACE_WRAP(file.close, trace_file_close);
+	hal->file.terminate = trace_file_terminate;
+
+#undef TRACE_WRAP
+
+	return 0;
+}
+
+static RSU_OSAL_INT replay_read(RSU_OSAL_VOID *buf, RSU_OSAL_U32 len)
+{
+	RSU_OSAL_U32 cnt = 0;
+	RSU_OSAL_INT c;
+
+	while (cnt < len) {
+		c = replay.plat.read((RSU_OSAL_U8 *)buf + cnt, len - cnt, replay.file);
+		if (c <= 0) {
+			return -EIO;
+		}
+		cnt += c;
+	}
+
+	return 0;
+}
+
+/*
+ * replay_next() - take the record of a call, and its payload
+ * op, handle, arg, len: the call, they must match the record
+ * rec: record of the call
+ *
+ * The replay lock is taken, and is kept on success until replay_done().
+ *
+ * Return: 0 on success, or -EIO when the replay diverged from the trace
+ */
+static RSU_OSAL_INT replay_next(enum rsu_trace_op op, RSU_OSAL_U16 handle, RSU_OSAL_U64 arg,
+				RSU_OSAL_U32 len, struct rsu_trace_record *rec)
+{
+	RSU_OSAL_U8 *data;
+
+	rsu_mutex_timedlock(&replay.lock, RSU_TIME_FOREVER);
+
+	if (replay.diverged) {
+		goto fail;
+	}
+
+	if (replay_read(rec, sizeof(*rec))) {
+		RSU_LOG_ERR("HAL replay: trace ended after %u calls", replay.index);
+		goto diverged;
+	}
+
+	if (rec->size > replay.data_size) {
+		data = rsu_malloc(rec->size);
+		if (data == NULL) {
+			RSU_LOG_ERR("HAL replay: no memory for %u bytes of record %u", rec->size,
+				    replay.index);
+			goto diverged;
+		}
+		rsu_free(replay.data);
+		replay.data = data;
+		replay.data_size = rec->size;
+	}
+
+	if (rec->size && replay_read(replay.data, rec->size)) {
+		RSU_LOG_ERR("HAL replay: record %u is truncated", replay.index);
+		goto diverged;
+	}
+
+	if (rec->op != op || (op != RSU_TRACE_FILE_OPEN && rec->handle != handle) ||
+	    rec->arg != arg || rec->len != len) {
+		RSU_LOG_ERR("HAL replay: call %u is op %u 0x%llx/%u, the trace has op %u 0x%llx/%u",
+			    replay.index, op, arg, len, rec->op, rec->arg, rec->len);
+		goto diverged;
+	}
+
+	replay.index++;
+	return 0;
+
+diverged:
+	replay.diverged = true;
+fail:
+	rsu_mutex_unlock(&replay.lock);
+	return -EIO;
+}
+
+/* lets the call last as long as when it was traced, then drops the lock */
+static RSU_OSAL_VOID replay_done(const struct rsu_trace_record *rec, RSU_OSAL_U64 start)
+{
+	RSU_OSAL_U64 until = start + rec->ns;
+	RSU_OSAL_U64 now = rsu_time_ns();
+
+	while (replay.timing && now < until) {
+		if (until - now > 1000000) {
+			rsu_mutex_timedlock(&replay.sleep_lock, RSU_TIME_FOREVER);
+			rsu_cond_timedwait(&replay.sleep, &replay.sleep_lock,
+					   (RSU_OSAL_U32)((until - now) / 1000000));
+			rsu_mutex_unlock(&replay.sleep_lock);
+		}
+		now = rsu_time_ns();
+	}
+
+	rsu_mutex_unlock(&replay.lock);
+}
+
+/* the data a call read, from the payload of its record */
+static RSU_OSAL_VOID replay_copy(const struct rsu_trace_record *rec, RSU_OSAL_VOID *data,
+				 RSU_OSAL_U32 len)
+{
+	if (rec->size < len) {
+		len = rec->size;
+	}
+	memcpy(data, replay.data, len);
+}
+
+/* the data a call wrote is only checked against the crc of the trace */
+static RSU_OSAL_VOID replay_check(const struct rsu_trace_record *rec, const RSU_OSAL_VOID *data,
+				  RSU_OSAL_U32 len)
+{
+	if (rsu_crc32(0, data, len) != rec->crc) {
+		RSU_LOG_ERR("HAL replay: call %u wrote other data than traced", replay.index - 1);
+	}
+}
+
+static RSU_OSAL_INT replay_qspi_read(RSU_OSAL_OFFSET offset, RSU_OSAL_VOID *data,
+				     RSU_OSAL_SIZE len)
+{
+	RSU_OSAL_U64 start = rsu_time_ns();
+	struct rsu_trace_record rec;
+
+	if (replay_next(RSU_TRACE_QSPI_READ, 0, offset, len, &rec)) {
+		return -EIO;
+	}
+	replay_copy(&rec, data, len);
+	replay_done(&rec, start);
+
+	return rec.ret;
+}
+
+static RSU_OSAL_INT replay_qspi_write(RSU_OSAL_OFFSET offset, const RSU_OSAL_VOID *data,
+				      RSU_OSAL_SIZE len)
+{
+	RSU_OSAL_U64 start = rsu_time_ns();
+	struct rsu_trace_record rec;
+
+	if (replay_next(RSU_TRACE_QSPI_WRITE, 0, offset, len, &rec)) {
+		return -EIO;
+	}
+	replay_check(&rec, data, len);
+	replay_done(&rec, start);
+
+	return rec.ret;
+}
+
+static RSU_OSAL_INT replay_qspi_erase(RSU_OSAL_OFFSET offset, RSU_OSAL_SIZE len)
+{
+	RSU_OSAL_U64 start = rsu_time_ns();
+	struct rsu_trace_record rec;
+
+	if (replay_next(RSU_TRACE_QSPI_ERASE, 0, offset, len, &rec)) {
+		return -EIO;
+	}
+	replay_done(&rec, start);
+
+	return rec.ret;
+}
+
+static RSU_OSAL_INT replay_get_rsu_status(struct mbox_status_info *data)
+{
+	RSU_OSAL_U64 start = rsu_time_ns();
+	struct rsu_trace_record rec;
+
+	if (replay_next(RSU_TRACE_MBOX_GET_STATUS, 0, 0, 0, &rec)) {
+		return -EIO;
+	}
+	replay_copy(&rec, data, sizeof(*data));
+	replay_done(&rec, start);
+
+	return rec.ret;
+}
+
+static RSU_OSAL_INT replay_send_rsu_update(RSU_OSAL_U64 addr)
+{
+	RSU_OSAL_U64 start = rsu_time_ns();
+	struct rsu_trace_record rec;
+
+	if (replay_next(RSU_TRACE_MBOX_SEND_UPDATE, 0, addr, 0, &rec)) {
+		return -EIO;
+	}
+	replay_done(&rec, start);
+
+	return rec.ret;
+}
+
+static RSU_OSAL_INT replay_get_spt_addresses(struct mbox_data_rsu_spt_address *data)
+{
+	RSU_OSAL_U64 start = rsu_time_ns();
+	struct rsu_trace_record rec;
+
+	if (replay_next(RSU_TRACE_MBOX_GET_SPT, 0, 0, 0, &rec)) {
+		return -EIO;
+	}
+	replay_copy(&rec, data, sizeof(*data));
+	replay_done(&rec, start);
+
+	return rec.ret;
+}
+
+static RSU_OSAL_INT replay_rsu_notify(RSU_OSAL_U32 notify)
+{
+	RSU_OSAL_U64 start = rsu_time_ns();
+	struct rsu_trace_record rec;
+
+	if (replay_next(RSU_TRACE_MBOX_NOTIFY, 0, notify, 0, &rec)) {
+		return -EIO;
+	}
+	replay_done(&rec, start);
+
+	return rec.ret;
+}
+
+static RSU_OSAL_INT replay_wait_rsu_status(RSU_OSAL_U32 timeout)
+{
+	RSU_OSAL_U64 start = rsu_time_ns();
+	struct rsu_trace_record rec;
+
+	if (replay_next(RSU_TRACE_MBOX_WAIT_STATUS, 0, timeout, 0, &rec)) {
+		return -EIO;
+	}
+	replay_done(&rec, start);
+
+	return rec.ret;
+}
+
+static RSU_OSAL_INT replay_get_dcmf_status(struct rsu_dcmf_status *data)
+{
+	RSU_OSAL_U64 start = rsu_time_ns();
+	struct rsu_trace_record rec;
+
+	if (replay_next(RSU_TRACE_MISC_DCMF_STATUS, 0, 0, 0, &rec)) {
+		return -EIO;
+	}
+	replay_copy(&rec, data, sizeof(*data));
+	replay_done(&rec, start);
+
+	return rec.ret;
+}
+
+static RSU_OSAL_INT replay_get_max_retry_count(RSU_OSAL_U8 *rsu_max_retry)
+{
+	RSU_OSAL_U64 start = rsu_time_ns();
+	struct rsu_trace_record rec;
+
+	if (replay_next(RSU_TRACE_MISC_MAX_RETRY, 0, 0, 0, &rec)) {
+		return -EIO;
+	}
+	replay_copy(&rec, rsu_max_retry, sizeof(*rsu_max_retry));
+	replay_done(&rec, start);
+
+	return rec.ret;
+}
+
+static RSU_OSAL_INT replay_get_dcmf_version(struct rsu_dcmf_version *version)
+{
+	RSU_OSAL_U64 start = rsu_time_ns();
+	struct rsu_trace_record rec;
+
+	if (replay_next(RSU_TRACE_MISC_DCMF_VERSION, 0, 0, 0, &rec)) {
+		return -EIO;
+	}
+	replay_copy(&rec, version, sizeof(*version));
+	replay_done(&rec, start);
+
+	return rec.ret;
+}
+
+/* the replayed files are only numbers, handed out as pointers into a table */
+static RSU_OSAL_U16 replay_handle(RSU_OSAL_FILE *file)
+{
+	RSU_OSAL_U8 *p = (RSU_OSAL_U8 *)file;
+
+	if (p <= replay.files || p > replay.files + TRACE_MAX_FILES) {
+		return 0;
+	}
+
+	return (RSU_OSAL_U16)(p - replay.files);
+}
+
+static RSU_OSAL_FILE *replay_file_open(RSU_OSAL_CHAR *filename, RSU_filesys_flags_t flag)
+{
+	RSU_OSAL_U64 start = rsu_time_ns();
+	struct rsu_trace_record rec;
+	RSU_OSAL_FILE *file = NULL;
+
+	if (replay_next(RSU_TRACE_FILE_OPEN, 0, flag, 0, &rec)) {
+		return NULL;
+	}
+	if (filename == NULL || rec.size != strlen(filename) + 1 ||
+	    memcmp(replay.data, filename, rec.size) != 0) {
+		RSU_LOG_ERR("HAL replay: call %u opens %s, not the traced file", replay.index - 1,
+			    filename ? filename : "NULL");
+	}
+	if (rec.ret == 0 && rec.handle && rec.handle <= TRACE_MAX_FILES) {
+		file = (RSU_OSAL_FILE *)(RSU_OSAL_VOID *)&replay.files[rec.handle];
+	}
+	replay_done(&rec, start);
+
+	return file;
+}
+
+static RSU_OSAL_INT replay_file_read(RSU_OSAL_VOID *buf, RSU_OSAL_SIZE len, RSU_OSAL_FILE *file)
+{
+	RSU_OSAL_U64 start = rsu_time_ns();
+	struct rsu_trace_record rec;
+
+	if (replay_next(RSU_TRACE_FILE_READ, replay_handle(file), 0, len, &rec)) {
+		return -EIO;
+	}
+	if (rec.ret > 0) {
+		replay_copy(&rec, buf, rec.ret);
+	}
+	replay_done(&rec, start);
+
+	return rec.ret;
+}
+
+static RSU_OSAL_INT replay_file_write(RSU_OSAL_VOID *buf, RSU_OSAL_SIZE len, RSU_OSAL_FILE *file)
+{
+	RSU_OSAL_U64 start = rsu_time_ns();
+	struct rsu_trace_record rec;
+
+	if (replay_next(RSU_TRACE_FILE_WRITE, replay_handle(file), 0, len, &rec)) {
+		return -EIO;
+	}
+	replay_check(&rec, buf, len);
+	replay_done(&rec, start);
+
+	return rec.ret;
+}
+
+static RSU_OSAL_INT replay_file_fgets(RSU_OSAL_CHAR *str, RSU_OSAL_SIZE len, RSU_OSAL_FILE *file)
+{
+	RSU_OSAL_U64 start = rsu_time_ns();
+	struct rsu_trace_record rec;
+
+	if (replay_next(RSU_TRACE_FILE_FGETS, replay_handle(file), 0, len, &rec)) {
+		return -EIO;
+	}
+	if (rec.ret == 0) {
+		replay_copy(&rec, str, len);
+		str[len - 1] = '\0';
+	}
+	replay_done(&rec, start);
+
+	return rec.ret;
+}
+
+static RSU_OSAL_INT replay_file_fseek(RSU_OSAL_OFFSET offset, RSU_filesys_whence_t whence,
+				      RSU_OSAL_FILE *file)
+{
+	RSU_OSAL_U64 start = rsu_time_ns();
+	struct rsu_trace_record rec;
+
+	if (replay_next(RSU_TRACE_FILE_FSEEK, replay_handle(file), offset, whence, &rec)) {
+		return -EIO;
+	}
+	replay_done(&rec, start);
+
+	return rec.ret;
+}
+
+static RSU_OSAL_INT replay_file_ftruncate(RSU_OSAL_OFFSET length, RSU_OSAL_FILE *file)
+{
+	RSU_OSAL_U64 start = rsu_time_ns();
+	struct rsu_trace_record rec;
+
+	if (replay_next(RSU_TRACE_FILE_FTRUNCATE, replay_handle(file), length, 0, &rec)) {
+		return -EIO;
+	}
+	replay_done(&rec, start);
+
+	return rec.ret;
+}
+
+static RSU_OSAL_INT replay_file_close(RSU_OSAL_FILE *file)
+{
+	RSU_OSAL_U64 start = rsu_time_ns();
+	struct rsu_trace_record rec;
+
+	if (replay_next(RSU_TRACE_FILE_CLOSE, replay_handle(file), 0, 0, &rec)) {
+		return -EIO;
+	}
+	replay_done(&rec, start);
+
+	return rec.ret;
+}
+
+static RSU_OSAL_INT replay_terminate(RSU_OSAL_VOID)
+{
+	return 0;
+}
+
+static RSU_OSAL_INT replay_file_terminate(RSU_OSAL_VOID)
+{
+	replay.plat.close(replay.file);
+	rsu_free(replay.data);
+	rsu_cond_destroy(&replay.sleep);
+	rsu_mutex_destroy(&replay.sleep_lock);
+	rsu_mutex_destroy(&replay.lock);
+	replay.data = NULL;
+	replay.file = NULL;
+
+	return replay.plat.terminate();
+}
+
+/*
+ * librsu_replay_init() - serve the platform calls from the hal-replay trace
+ * hal: HAL with the file platform initialized, the flash, mailbox and misc
+ *      ones are not
+ *
+ * Return: 0 on success, or negative errno on error
+ */
+RSU_OSAL_INT librsu_replay_init(struct librsu_ll_intf *hal)
+{
+	struct rsu_trace_header hdr;
+	RSU_OSAL_INT ret;
+
+	rsu_memset(&replay, 0, sizeof(replay));
+	replay.plat = hal->file;
+	replay.timing = hal->cfg.hal_replay_timing != 0;
+
+	replay.file = hal->file.open(hal->cfg.hal_replay, RSU_FILE_READ);
+	if (replay.file == NULL) {
+		RSU_LOG_ERR("Unable to open HAL trace file %s", hal->cfg.hal_replay);
+		return -ENOENT;
+	}
+
+	if (replay_read(&hdr, sizeof(hdr)) || hdr.magic != RSU_TRACE_MAGIC ||
+	    hdr.version != RSU_TRACE_VERSION) {
+		RSU_LOG_ERR("%s is not a HAL trace", hal->cfg.hal_replay);
+		hal->file.close(replay.file);
+		return -EINVAL;
+	}
+
+	if (!(hdr.flags & RSU_TRACE_DATA)) {
+		RSU_LOG_ERR("%s was traced without data and cannot be replayed",
+			    hal->cfg.hal_replay);
+		hal->file.close(replay.file);
+		return -EINVAL;
+	}
+
+	ret = rsu_mutex_init(&replay.lock);
+	if (ret == 0) {
+		ret = rsu_mutex_init(&replay.sleep_lock);
+		if (ret) {
+			rsu_mutex_destroy(&replay.lock);
+		}
+	}
+	if (ret == 0) {
+		ret = rsu_cond_init(&replay.sleep);
+		if (ret) {
+			rsu_mutex_destroy(&replay.sleep_lock);
+			rsu_mutex_destroy(&replay.lock);
+		}
+	}
+	if (ret) {
+		hal->file.close(replay.file);
+		return ret;
+	}
+
+	hal->qspi.read = replay_qspi_read;
+	hal->qspi.write = replay_qspi_write;
+	hal->qspi.erase = replay_qspi_erase;
+	hal->qspi.terminate = replay_terminate;
+	hal->mbox.get_rsu_status = replay_get_rsu_status;
+	hal->mbox.send_rsu_update = replay_send_rsu_update;
+	hal->mbox.get_spt_addresses = replay_get_spt_addresses;
+	hal->mbox.rsu_notify = replay_rsu_notify;
+	hal->mbox.wait_rsu_status =
+		(hdr.flags & RSU_TRACE_WAIT_STATUS) ? replay_wait_rsu_status : NULL;
+	hal->mbox.terminate = replay_terminate;
+	hal->misc.rsu_get_dcmf_status = replay_get_dcmf_status;
+	hal->misc.rsu_get_max_retry_count = replay_get_max_retry_count;
+	hal->misc.rsu_get_dcmf_version = replay_get_dcmf_version;
+	hal->misc.terminate = replay_terminate;
+	hal->file.open = replay_file_open;
+	hal->file.read = replay_file_read;
+	hal->file.write = replay_file_write;
+	hal->file.fgets = replay_file_fgets;
+	hal->file.fseek = replay_file_fseek;
+	hal->file.ftruncate = replay_file_ftruncate;
+	hal->file.close = replay_file_close;
+	hal->file.terminate = replay_file_terminate;
+
+	return 0;
+}
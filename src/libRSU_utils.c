@@ -4,6 +4,8 @@
  */
 
 #include <utils/RSU_utils.h>
+#include <utils/RSU_logging.h>
+
 /*
  * split_line() - Split a line buffer into words, leaving the words null
  *                terminated in place in the buffer.
@@ -43,3 +45,21 @@ RSU_OSAL_U32 split_line(RSU_OSAL_CHAR *line, RSU_OSAL_CHAR **words, RSU_OSAL_U32
 	}
 	return y;
 }
+
+/*
+ * RSU_log_ratelimit() - Check the deadline of a rate limited log call site
+ * next - Pointer to the deadline of the call site, 0 before the first message
+ *
+ * Returns true if the message is due, and pushes the deadline forward.
+ */
+RSU_OSAL_BOOL RSU_log_ratelimit(RSU_OSAL_U64 *next)
+{
+	RSU_OSAL_U64 now = rsu_time_ns();
+
+	if (*next && now < *next) {
+		return false;
+	}
+
+	*next = now + (RSU_OSAL_U64)RSU_LOG_RATELIMIT_MS * 1000000;
+	return true;
+}
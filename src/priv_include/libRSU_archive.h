@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2023-2024 Intel Corporation
+ * SPDX-License-Identifier: MIT-0
+ */
+
+#ifndef __LIBRSU_ARCHIVE_H__
+#define __LIBRSU_ARCHIVE_H__
+
+#include <libRSU.h>
+#include <libRSU_OSAL.h>
+#include <libRSU_hl_intf.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define RSU_ARCHIVE_MAGIC     0x5A555352 /* "RSUZ" */
+#define RSU_ARCHIVE_VERSION   1
+#define RSU_ARCHIVE_CHUNK_SZ  0x10000
+#define RSU_ARCHIVE_MAX_CHUNK 0x100000
+
+/* chunk storage methods */
+#define RSU_ARCHIVE_ERASED      0 /* chunk is all 0xFF, no payload */
+#define RSU_ARCHIVE_STORED      1 /* payload is stored as is */
+#define RSU_ARCHIVE_DEFLATE     2 /* payload is zlib compressed */
+#define RSU_ARCHIVE_RLE         3 /* payload is a run length encoded segment list */
+#define RSU_ARCHIVE_RLE_DEFLATE 4 /* payload is a zlib compressed segment list */
+
+/*
+ * The container starts with the header, followed by the chunk index and then
+ * the chunk payloads in slot order. Trailing 0xFF bytes of each chunk are not
+ * stored, data_len tells how many leading bytes the payload expands to.
+ *
+ * Interior runs of 0xFF are run length encoded: the payload is then a list of
+ * segments, each a U32 count of 0xFF bytes, a U32 count of data bytes and the
+ * data bytes, which expands to exactly data_len bytes.
+ */
+struct rsu_archive_header {
+	RSU_OSAL_U32 magic;
+	RSU_OSAL_U32 version;
+	RSU_OSAL_U32 header_size;
+	RSU_OSAL_U32 chunk_size;
+	RSU_OSAL_U32 slot_size;
+	RSU_OSAL_U32 image_size;
+	RSU_OSAL_U32 chunks;
+	RSU_OSAL_U32 crc;
+} __attribute__((__packed__));
+
+struct rsu_archive_chunk {
+	RSU_OSAL_U32 offset;
+	RSU_OSAL_U32 stored_len;
+	RSU_OSAL_U32 data_len;
+	RSU_OSAL_U32 method;
+	RSU_OSAL_U32 crc;
+} __attribute__((__packed__));
+
+RSU_OSAL_INT librsu_archive_write(struct librsu_hl_intf *intf, RSU_OSAL_INT part_num,
+				  RSU_OSAL_FILE *file);
+
+RSU_OSAL_BOOL librsu_archive_probe(const RSU_OSAL_VOID *hdr, RSU_OSAL_INT len);
+RSU_OSAL_INT librsu_archive_open(RSU_OSAL_FILE *file, RSU_OSAL_VOID *hdr);
+RSU_OSAL_INT librsu_archive_read(RSU_OSAL_VOID *buf, RSU_OSAL_INT len);
+RSU_OSAL_VOID librsu_archive_close(RSU_OSAL_VOID);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif
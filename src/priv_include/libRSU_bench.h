@@ -0,0 +1,24 @@
+/*
+ * Copyright (C) 2023-2024 Intel Corporation
+ * SPDX-License-Identifier: MIT-0
+ */
+
+#ifndef __LIBRSU_BENCH_H__
+#define __LIBRSU_BENCH_H__
+
+#include <libRSU.h>
+#include <libRSU_OSAL.h>
+#include <libRSU_hl_intf.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+RSU_OSAL_INT librsu_bench_run(struct librsu_hl_intf *intf, RSU_OSAL_INT part_num,
+			      struct rsu_bench *result);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif
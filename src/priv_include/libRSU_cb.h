@@ -14,7 +14,7 @@
 extern "C" {
 #endif /* __cplusplus */
 
-RSU_OSAL_INT librsu_cb_file_init(RSU_OSAL_CHAR *filename);
+RSU_OSAL_INT librsu_cb_file_init(RSU_OSAL_CHAR *filename, RSU_OSAL_INT rawdata);
 RSU_OSAL_VOID librsu_cb_file_cleanup(RSU_OSAL_VOID);
 RSU_OSAL_INT librsu_cb_file(RSU_OSAL_VOID *buf, RSU_OSAL_INT len);
 
@@ -22,12 +22,21 @@ RSU_OSAL_INT librsu_cb_buf_init(RSU_OSAL_VOID *buf, RSU_OSAL_INT size);
 RSU_OSAL_VOID librsu_cb_buf_cleanup(RSU_OSAL_VOID);
 RSU_OSAL_INT librsu_cb_buf(RSU_OSAL_VOID *buf, RSU_OSAL_INT len);
 
+RSU_OSAL_VOID librsu_cb_progress_set(rsu_progress_callback progress, RSU_OSAL_VOID *arg);
+
 RSU_OSAL_INT librsu_cb_program_common(struct librsu_hl_intf *intf, RSU_OSAL_INT slot,
 				      rsu_data_callback callback, RSU_OSAL_INT rawdata);
 
 RSU_OSAL_INT librsu_cb_verify_common(struct librsu_hl_intf *intf, RSU_OSAL_INT slot,
 				     rsu_data_callback callback, RSU_OSAL_INT rawdata);
 
+RSU_OSAL_INT librsu_cb_validate_common(struct librsu_hl_intf *intf, RSU_OSAL_INT slot,
+				       rsu_data_callback callback);
+
+RSU_OSAL_INT librsu_cb_read_common(struct librsu_hl_intf *intf, RSU_OSAL_INT part_num,
+				   RSU_OSAL_U32 offset, RSU_OSAL_U32 len, rsu_sink_callback sink,
+				   RSU_OSAL_VOID *arg);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -12,12 +12,19 @@
 extern "C" {
 #endif /* __cplusplus */
 
-RSU_OSAL_INT librsu_cfg_parse(RSU_OSAL_CHAR *filename, struct librsu_hl_intf **intf);
+RSU_OSAL_INT librsu_cfg_parse(RSU_OSAL_CHAR *filename, const struct rsu_config *config,
+			      struct librsu_hl_intf **intf);
 RSU_OSAL_INT librsu_common_cfg_parse(RSU_OSAL_CHAR *filename, struct librsu_ll_intf *intf);
 RSU_OSAL_VOID librsu_cfg_reset(RSU_OSAL_VOID);
 
 RSU_OSAL_INT librsu_cfg_writeprotected(RSU_OSAL_INT slot);
 RSU_OSAL_INT librsu_cfg_spt_checksum_enabled(RSU_OSAL_VOID);
+RSU_OSAL_INT librsu_cfg_program_preflight(RSU_OSAL_VOID);
+RSU_OSAL_INT librsu_cfg_read_only(RSU_OSAL_VOID);
+RSU_OSAL_INT librsu_cfg_metadata_repair(RSU_OSAL_VOID);
+RSU_OSAL_CHAR *librsu_cfg_digest_manifest(RSU_OSAL_INT *alg);
+RSU_OSAL_U32 librsu_cfg_status_poll_interval(RSU_OSAL_VOID);
+RSU_OSAL_CHAR *librsu_cfg_metadata_cache(RSU_OSAL_VOID);
 struct librsu_ll_intf *librsu_get_ll_inf(RSU_OSAL_VOID);
 
 #ifdef __cplusplus
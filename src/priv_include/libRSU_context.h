@@ -22,6 +22,11 @@ enum rsu_state {
 struct rsu_context {
     volatile enum rsu_state state;
     RSU_OSAL_MUTEX mutex;
+    /* background repair of a bad SPT or CPB copy */
+    RSU_OSAL_THREAD repair_thread;
+    RSU_OSAL_BOOL repair_started;
+    /* when the mutex was taken, for the lock hold time statistics */
+    RSU_OSAL_U64 locked_at;
 };
 
 
@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2023-2024 Intel Corporation
+ * SPDX-License-Identifier: MIT-0
+ */
+
+#ifndef __LIBRSU_DIGEST_H__
+#define __LIBRSU_DIGEST_H__
+
+#include <libRSU.h>
+#include <libRSU_OSAL.h>
+#include <libRSU_hl_intf.h>
+#include <libRSU_sha.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * Running digest of a slot, fed in order from its start in pieces of any size.
+ * With RSU_DIGEST_TRIM_ERASED the erased tail of the slot is left out.
+ */
+struct librsu_digest {
+	RSU_OSAL_INT alg;
+	RSU_OSAL_BOOL trim;
+	/* erased bytes seen but not hashed yet, only used when trimming */
+	RSU_OSAL_U32 pending;
+	/* bytes fed so far, and whether the current block has programmed bytes */
+	RSU_OSAL_U64 pos;
+	RSU_OSAL_BOOL dirty;
+	RSU_OSAL_U8 erased[256];
+	union {
+		struct rsu_sha256_ctx sha256;
+		struct rsu_sha512_ctx sha512;
+	} u;
+};
+
+RSU_OSAL_INT librsu_digest_size(RSU_OSAL_INT alg);
+RSU_OSAL_INT librsu_digest_init(struct librsu_digest *d, RSU_OSAL_INT alg);
+RSU_OSAL_VOID librsu_digest_update(struct librsu_digest *d, const RSU_OSAL_VOID *data,
+				   RSU_OSAL_U32 len);
+RSU_OSAL_VOID librsu_digest_final(struct librsu_digest *d, RSU_OSAL_U8 *out);
+RSU_OSAL_INT librsu_digest_slot_rest(struct librsu_hl_intf *intf, RSU_OSAL_INT part_num,
+				     RSU_OSAL_U32 offset, struct librsu_digest *d);
+RSU_OSAL_INT librsu_digest_slot(struct librsu_hl_intf *intf, RSU_OSAL_INT part_num,
+				RSU_OSAL_INT alg, RSU_OSAL_U8 *out);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif
@@ -80,6 +80,7 @@ struct data {
 	RSU_OSAL_INT(*write)
 	(RSU_OSAL_INT part_num, RSU_OSAL_INT offset, RSU_OSAL_INT bytes, RSU_OSAL_VOID *buf);
 	RSU_OSAL_INT (*erase)(RSU_OSAL_INT part_num);
+	RSU_OSAL_INT (*erase_range)(RSU_OSAL_INT part_num, RSU_OSAL_INT offset, RSU_OSAL_INT bytes);
 };
 
 struct spt_ops {
@@ -108,6 +109,11 @@ struct misc_ops {
 	RSU_OSAL_INT (*rsu_get_dcmf_version)(struct rsu_dcmf_version *version);
 };
 
+struct repair_ops {
+	RSU_OSAL_INT (*pending)(RSU_OSAL_VOID);
+	RSU_OSAL_INT (*run)(RSU_OSAL_VOID);
+};
+
 struct files_ops {
 	RSU_OSAL_FILE *(*open)(RSU_OSAL_CHAR *filename, RSU_filesys_flags_t flag);
 	RSU_OSAL_INT (*read)(RSU_OSAL_VOID *buf, RSU_OSAL_SIZE len, RSU_OSAL_FILE *file);
@@ -125,6 +131,7 @@ struct librsu_hl_intf {
 	struct spt_ops spt_ops;
 	struct cpb_ops cpb_ops;
 	struct misc_ops misc_ops;
+	struct repair_ops repair_ops;
 	struct files_ops file;
 };
 
@@ -132,6 +139,11 @@ struct database {
 	RSU_OSAL_BOOL spt_corrupted;
 	RSU_OSAL_BOOL cpb_corrupted;
 	RSU_OSAL_BOOL cpb_fixed;
+	/* SPT and CPB loaded, deferred to the first use in read-only mode */
+	RSU_OSAL_BOOL loaded;
+	/* REPAIR_* copies still to be rewritten, and a rewrite in progress */
+	RSU_OSAL_U32 repair;
+	RSU_OSAL_BOOL repairing;
 	RSU_OSAL_U32 cpb0_part;
 	RSU_OSAL_U32 cpb1_part;
 	/*mtd_part_offset will be 0 for systems which can access whole qspi  or will be changed to
@@ -38,8 +38,13 @@ enum rsu_block_type {
 	REGULAR_BLOCK /** all other block types*/
 };
 
-/** maximum number of sections supported for an image */
+/**
+ * maximum number of sections an image may point to ahead of the block being
+ * processed, sections already passed do not count against it
+ */
+#ifndef MAX_SECTIONS
 #define MAX_SECTIONS 64
+#endif
 
 /**
  * @brief struct rsu_image_state - structure for stated of image processing
@@ -51,8 +56,9 @@ enum rsu_block_type {
 struct rsu_image_state {
 	RSU_OSAL_S32 offset; /** current block offset in bytes*/
 	enum rsu_block_type block_type; /** current block type*/
-	RSU_OSAL_U64 sections[MAX_SECTIONS]; /** identified section offsets*/
-	RSU_OSAL_INT no_sections; /** number of identified sections*/
+	RSU_OSAL_U64 sections[MAX_SECTIONS]; /** identified section offsets, sorted*/
+	RSU_OSAL_INT no_sections; /** number of entries in sections*/
+	RSU_OSAL_INT next_section; /** first entry in sections not reached yet*/
 	RSU_OSAL_INT absolute; /** current image is an absolute image*/
 };
 
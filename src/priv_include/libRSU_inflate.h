@@ -0,0 +1,27 @@
+/*
+ * Copyright (C) 2023-2024 Intel Corporation
+ * SPDX-License-Identifier: MIT-0
+ */
+
+#ifndef __LIBRSU_INFLATE_H__
+#define __LIBRSU_INFLATE_H__
+
+#include <libRSU.h>
+#include <libRSU_OSAL.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define RSU_INFLATE_IN_SZ 0x1000
+
+RSU_OSAL_BOOL librsu_inflate_probe(const RSU_OSAL_U8 *hdr, RSU_OSAL_INT len);
+RSU_OSAL_INT librsu_inflate_open(RSU_OSAL_FILE *file, RSU_OSAL_U8 *hdr, RSU_OSAL_INT len);
+RSU_OSAL_INT librsu_inflate_read(RSU_OSAL_VOID *buf, RSU_OSAL_INT len);
+RSU_OSAL_VOID librsu_inflate_close(RSU_OSAL_VOID);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif
@@ -15,14 +15,17 @@ extern "C" {
 #include <hal/RSU_plat_file.h>
 #include <hal/RSU_plat_misc.h>
 #include <hal/RSU_plat_crc32.h>
+#include <libRSU_config.h>
+
+/* default period of the status poller in milliseconds */
+#define RSU_STATUS_POLL_INTERVAL (100U)
 
 struct librsu_ll_intf {
 	struct qspi_ll_intf qspi;
 	struct mbox_ll_intf mbox;
 	struct filesys_ll_intf file;
 	struct rsu_ll_misc misc;
-	RSU_OSAL_U32 writeprotect;
-	RSU_OSAL_U32 spt_checksum_enabled;
+	struct rsu_config cfg;
 };
 
 #ifdef __cplusplus
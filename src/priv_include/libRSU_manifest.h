@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2023-2024 Intel Corporation
+ * SPDX-License-Identifier: MIT-0
+ */
+
+#ifndef __LIBRSU_MANIFEST_H__
+#define __LIBRSU_MANIFEST_H__
+
+#include <libRSU.h>
+#include <libRSU_OSAL.h>
+#include <libRSU_hl_intf.h>
+#include <libRSU_digest.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define RSU_MANIFEST_MAGIC   0x4D555352 /* "RSUM" */
+#define RSU_MANIFEST_VERSION 1
+
+/*
+ * The manifest file is the header followed by the entries. The crc covers the
+ * header, with the crc field set to zero, and all the entries.
+ */
+struct rsu_manifest_header {
+	RSU_OSAL_U32 magic;
+	RSU_OSAL_U32 version;
+	RSU_OSAL_U32 entries;
+	RSU_OSAL_U32 crc;
+} __attribute__((__packed__));
+
+/*
+ * An entry is keyed by the flash offset and size of the slot, and is only
+ * valid while the slot table has the same generation as when it was made.
+ */
+struct rsu_manifest_entry {
+	RSU_OSAL_U64 offset;
+	RSU_OSAL_U32 size;
+	RSU_OSAL_U32 generation;
+	RSU_OSAL_U32 alg;
+	RSU_OSAL_U8 digest[RSU_DIGEST_SHA384_SIZE];
+} __attribute__((__packed__));
+
+RSU_OSAL_INT librsu_manifest_lookup(struct librsu_hl_intf *intf, RSU_OSAL_INT part_num,
+				    RSU_OSAL_INT alg, RSU_OSAL_U8 *digest);
+RSU_OSAL_INT librsu_manifest_store(struct librsu_hl_intf *intf, RSU_OSAL_INT part_num,
+				   RSU_OSAL_INT alg, const RSU_OSAL_U8 *digest);
+RSU_OSAL_BOOL librsu_manifest_begin(struct librsu_digest *d);
+RSU_OSAL_INT librsu_manifest_record(struct librsu_hl_intf *intf, RSU_OSAL_INT part_num,
+				    struct librsu_digest *d, RSU_OSAL_U32 done);
+RSU_OSAL_INT librsu_manifest_invalidate(struct librsu_hl_intf *intf, RSU_OSAL_INT part_num);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif
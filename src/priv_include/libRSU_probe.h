@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2023-2024 Intel Corporation
+ * SPDX-License-Identifier: MIT-0
+ */
+
+#ifndef __LIBRSU_PROBE_H__
+#define __LIBRSU_PROBE_H__
+
+/*
+ * USDT probes of the librsu provider, built in with -DUSDT=ON. A probe is a
+ * single nop in the code and a note in the ELF file until perf or bpftrace
+ * attaches to it, e.g.:
+ *   bpftrace -e 'usdt:libuniLibRSU.so:librsu:flash__erase__done { @[arg2] = count(); }'
+ * Arguments are evaluated even when no tracer is attached, so only pass values
+ * which are at hand.
+ *
+ * api__entry(name), api__return(name, ns locked)
+ * flash__{read,write,erase}__start(offset, len), ...__done(offset, len, ret)
+ * image__block(offset, block type)
+ * {spt,cpb}__{load,writeback}__start(), ...__done(ret)
+ */
+#ifdef RSU_USDT
+
+#include <sys/sdt.h>
+
+#define RSU_PROBE0(name)	  DTRACE_PROBE(librsu, name)
+#define RSU_PROBE1(name, a)	  DTRACE_PROBE1(librsu, name, a)
+#define RSU_PROBE2(name, a, b)	  DTRACE_PROBE2(librsu, name, a, b)
+#define RSU_PROBE3(name, a, b, c) DTRACE_PROBE3(librsu, name, a, b, c)
+
+#else
+
+#define RSU_PROBE0(name)                                                                           \
+	do {                                                                                       \
+	} while (0)
+#define RSU_PROBE1(name, a)	  RSU_PROBE0(name)
+#define RSU_PROBE2(name, a, b)	  RSU_PROBE0(name)
+#define RSU_PROBE3(name, a, b, c) RSU_PROBE0(name)
+
+#endif
+
+#endif
@@ -0,0 +1,38 @@
+/*
+ * Copyright (C) 2023-2024 Intel Corporation
+ * SPDX-License-Identifier: MIT-0
+ */
+
+#ifndef __LIBRSU_SCRATCH_H__
+#define __LIBRSU_SCRATCH_H__
+
+#include <libRSU_OSAL.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* granule of the scratch arena, the size of an SPT, a CPB and an image block */
+#define RSU_SCRATCH_BLOCK_SZ 0x1000
+
+/* number of granules in the arena, enough for the deepest nesting of buffers */
+#ifndef RSU_SCRATCH_BLOCKS
+#define RSU_SCRATCH_BLOCKS 4
+#endif
+
+/*
+ * The scratch arena is allocated once by librsu_init() and lends short lived
+ * buffers to the library, so the flash access paths make no heap calls.
+ * Buffers are only used under the library mutex. A request that does not
+ * fit in the free part of the arena falls back to rsu_malloc().
+ */
+RSU_OSAL_INT librsu_scratch_init(RSU_OSAL_VOID);
+RSU_OSAL_VOID librsu_scratch_exit(RSU_OSAL_VOID);
+RSU_OSAL_VOID *librsu_scratch_get(RSU_OSAL_SIZE size);
+RSU_OSAL_VOID librsu_scratch_put(RSU_OSAL_VOID *ptr);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif
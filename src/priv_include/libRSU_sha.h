@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2023-2024 Intel Corporation
+ * SPDX-License-Identifier: MIT-0
+ */
+
+#ifndef __LIBRSU_SHA_H__
+#define __LIBRSU_SHA_H__
+
+#include <libRSU_OSAL.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+struct rsu_sha256_ctx {
+	RSU_OSAL_U32 state[8];
+	RSU_OSAL_U64 count;
+	RSU_OSAL_U8 buf[64];
+};
+
+struct rsu_sha512_ctx {
+	RSU_OSAL_U64 state[8];
+	RSU_OSAL_U64 count;
+	RSU_OSAL_U8 buf[128];
+};
+
+RSU_OSAL_VOID librsu_sha256_init(struct rsu_sha256_ctx *c);
+RSU_OSAL_VOID librsu_sha256_update(struct rsu_sha256_ctx *c, const RSU_OSAL_U8 *data,
+				   RSU_OSAL_SIZE len);
+RSU_OSAL_VOID librsu_sha256_final(struct rsu_sha256_ctx *c, RSU_OSAL_U8 *out);
+
+/* SHA-384 is SHA-512 with other initial values and a truncated output */
+RSU_OSAL_VOID librsu_sha384_init(struct rsu_sha512_ctx *c);
+RSU_OSAL_VOID librsu_sha512_update(struct rsu_sha512_ctx *c, const RSU_OSAL_U8 *data,
+				   RSU_OSAL_SIZE len);
+RSU_OSAL_VOID librsu_sha384_final(struct rsu_sha512_ctx *c, RSU_OSAL_U8 *out);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif
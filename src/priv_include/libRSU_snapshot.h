@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2023-2024 Intel Corporation
+ * SPDX-License-Identifier: MIT-0
+ */
+
+#ifndef __LIBRSU_SNAPSHOT_H__
+#define __LIBRSU_SNAPSHOT_H__
+
+#include <libRSU.h>
+#include <libRSU_OSAL.h>
+#include <libRSU_hl_intf.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define RSU_SNAPSHOT_MAGIC	  0x4E535352 /* "RSSN" */
+#define RSU_SNAPSHOT_VERSION	  2
+#define RSU_SNAPSHOT_BOOT_ID_LEN  40
+
+#ifndef RSU_BOOT_ID_FILE
+#define RSU_BOOT_ID_FILE "/proc/sys/kernel/random/boot_id"
+#endif
+
+/*
+ * Copy of the SPT and CPB as loaded by a clean full load, tagged with the boot
+ * it was taken in. The tables are the SPT0 and CPB pages as they were in
+ * flash, so they can be compared against flash without parsing.
+ */
+struct rsu_snapshot_header {
+	RSU_OSAL_U32 magic;
+	RSU_OSAL_U32 version;
+	RSU_OSAL_U32 size;
+	RSU_OSAL_CHAR boot_id[RSU_SNAPSHOT_BOOT_ID_LEN];
+	RSU_OSAL_U64 spt0_address;
+	RSU_OSAL_U64 spt1_address;
+	RSU_OSAL_U64 mtd_part_offset;
+	RSU_OSAL_U32 cpb0_part;
+	RSU_OSAL_U32 cpb1_part;
+	RSU_OSAL_U32 crc;
+} __attribute__((__packed__));
+
+struct rsu_snapshot {
+	struct rsu_snapshot_header hdr;
+	struct SUB_PARTITION_TABLE spt;
+	union CMF_POINTER_BLOCK cpb;
+} __attribute__((__packed__));
+
+RSU_OSAL_BOOL librsu_snapshot_enabled(RSU_OSAL_VOID);
+RSU_OSAL_INT librsu_snapshot_load(struct rsu_snapshot *snap);
+RSU_OSAL_INT librsu_snapshot_save(struct rsu_snapshot *snap);
+RSU_OSAL_VOID librsu_snapshot_invalidate(RSU_OSAL_VOID);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif
@@ -0,0 +1,28 @@
+/*
+ * Copyright (C) 2023-2024 Intel Corporation
+ * SPDX-License-Identifier: MIT-0
+ */
+
+#ifndef __LIBRSU_STATS_H__
+#define __LIBRSU_STATS_H__
+
+#include <libRSU.h>
+#include <libRSU_OSAL.h>
+#include <libRSU_ll_intf.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+RSU_OSAL_VOID librsu_stats_wrap(struct librsu_ll_intf *hal);
+RSU_OSAL_VOID librsu_stats_add(enum rsu_stats_op op, RSU_OSAL_U64 ns, RSU_OSAL_INT failed,
+			       RSU_OSAL_U64 bytes);
+RSU_OSAL_VOID librsu_stats_get(struct rsu_stats *result);
+RSU_OSAL_VOID librsu_stats_reset(RSU_OSAL_VOID);
+const RSU_OSAL_CHAR *librsu_stats_name(enum rsu_stats_op op);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif
@@ -0,0 +1,31 @@
+/*
+ * Copyright (C) 2023-2024 Intel Corporation
+ * SPDX-License-Identifier: MIT-0
+ */
+
+#ifndef __LIBRSU_STATUS_H__
+#define __LIBRSU_STATUS_H__
+
+#include <libRSU.h>
+#include <libRSU_OSAL.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * A single poller thread, started by the first waiter, sweeps the status with
+ * rsu_status_log() and wakes up every waiter when it differs from the last
+ * sweep. Between sweeps it sleeps in the mailbox wait_rsu_status() hook when
+ * the platform has one, so a notification ends the sleep early, or for the
+ * status-poll-interval otherwise.
+ */
+RSU_OSAL_INT librsu_status_watch_init(RSU_OSAL_VOID);
+RSU_OSAL_VOID librsu_status_watch_exit(RSU_OSAL_VOID);
+RSU_OSAL_INT librsu_status_wait(RSU_OSAL_U32 timeout, struct rsu_status_info *info);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif
@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2023-2024 Intel Corporation
+ * SPDX-License-Identifier: MIT-0
+ */
+
+#ifndef __LIBRSU_TRACE_H__
+#define __LIBRSU_TRACE_H__
+
+#include <libRSU_OSAL.h>
+#include <libRSU_ll_intf.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define RSU_TRACE_MAGIC	  0x54555352 /* "RSUT" */
+#define RSU_TRACE_VERSION 1
+
+/* header flags */
+#define RSU_TRACE_DATA	      (1 << 0) /* data read and written is in the trace */
+#define RSU_TRACE_WAIT_STATUS (1 << 1) /* the platform has mbox.wait_rsu_status */
+
+/*
+ * The trace file is the header followed by one record per platform call, in
+ * the order the calls returned. A record is followed by size bytes of payload:
+ * the data the call read or wrote, the file name of an open, or the structure
+ * a mailbox or misc call filled. The data of flash and file reads and writes
+ * is only there for a trace made with RSU_TRACE_DATA, its crc always is.
+ */
+struct rsu_trace_header {
+	RSU_OSAL_U32 magic;
+	RSU_OSAL_U16 version;
+	RSU_OSAL_U16 flags;
+} __attribute__((__packed__));
+
+enum rsu_trace_op {
+	RSU_TRACE_QSPI_READ = 1,
+	RSU_TRACE_QSPI_WRITE,
+	RSU_TRACE_QSPI_ERASE,
+	RSU_TRACE_MBOX_GET_STATUS,
+	RSU_TRACE_MBOX_SEND_UPDATE,
+	RSU_TRACE_MBOX_GET_SPT,
+	RSU_TRACE_MBOX_NOTIFY,
+	RSU_TRACE_MBOX_WAIT_STATUS,
+	RSU_TRACE_MISC_DCMF_STATUS,
+	RSU_TRACE_MISC_MAX_RETRY,
+	RSU_TRACE_MISC_DCMF_VERSION,
+	RSU_TRACE_FILE_OPEN,
+	RSU_TRACE_FILE_READ,
+	RSU_TRACE_FILE_WRITE,
+	RSU_TRACE_FILE_FGETS,
+	RSU_TRACE_FILE_FSEEK,
+	RSU_TRACE_FILE_FTRUNCATE,
+	RSU_TRACE_FILE_CLOSE,
+};
+
+/*
+ * arg is the offset, address, notify value, timeout, open flag or seek offset
+ * of the call, len its length or seek origin. handle numbers the open files
+ * from 1, start and ns are the time the call started, from the start of the
+ * trace, and how long it took.
+ */
+struct rsu_trace_record {
+	RSU_OSAL_U8 op;
+	RSU_OSAL_U8 reserved;
+	RSU_OSAL_U16 handle;
+	RSU_OSAL_S32 ret;
+	RSU_OSAL_U64 arg;
+	RSU_OSAL_U32 len;
+	RSU_OSAL_U32 crc;
+	RSU_OSAL_U64 start;
+	RSU_OSAL_U64 ns;
+	RSU_OSAL_U32 size;
+} __attribute__((__packed__));
+
+RSU_OSAL_INT librsu_trace_init(struct librsu_ll_intf *hal);
+RSU_OSAL_INT librsu_replay_init(struct librsu_ll_intf *hal);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif
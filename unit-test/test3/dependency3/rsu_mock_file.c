@@ -50,7 +50,7 @@ RSU_OSAL_INT plat_filesys_read_mock(RSU_OSAL_VOID *buf, RSU_OSAL_SIZE len, RSU_O
 		return -EINVAL;
 	}
 
-	RSU_OSAL_INT ret = fread(buf, len, 1, file);
+	RSU_OSAL_INT ret = fread(buf, 1, len, file);
 	if (ret < 0) {
 		RSU_LOG_ERR("error in reading the file %s", strerror(errno));
 	}
@@ -11,9 +11,49 @@
 #include <stdlib.h>
 #include <libRSU_OSAL.h>
 #include "mock_spt.h"
+#include "rsu_mock_utils.h"
 
 extern struct full mock_full;
 
+RSU_OSAL_CHAR mock_rsu_dev[256];
+
+static RSU_OSAL_INT mock_read_attr(const RSU_OSAL_CHAR *attr, RSU_OSAL_U64 *value)
+{
+	RSU_OSAL_CHAR buf[512];
+	RSU_OSAL_FILE *file;
+
+	snprintf(buf, sizeof(buf), "%s/%s", mock_rsu_dev, attr);
+	file = fopen(buf, "r");
+	if (!file) {
+		return -EBADF;
+	}
+
+	if (!fgets(buf, sizeof(buf), file)) {
+		fclose(file);
+		return -EACCES;
+	}
+
+	*value = strtoull(buf, NULL, 0);
+	fclose(file);
+	return 0;
+}
+
+/* stand-in for the sysfs attributes of the linux stratix10-rsu driver */
+static RSU_OSAL_INT mock_read_status_attrs(struct mbox_status_info *data)
+{
+	if (mock_read_attr("version", &data->version) ||
+	    mock_read_attr("state", &data->state) ||
+	    mock_read_attr("current_image", &data->current_image) ||
+	    mock_read_attr("fail_image", &data->fail_image) ||
+	    mock_read_attr("error_location", &data->error_location) ||
+	    mock_read_attr("error_details", &data->error_details) ||
+	    mock_read_attr("retry_counter", &data->retry_counter)) {
+		return -EACCES;
+	}
+
+	return 0;
+}
+
 /* Mocking function for get_rsu_status */
 RSU_OSAL_INT plat_mbox_get_rsu_status_mock(struct mbox_status_info *data)
 {
@@ -21,6 +61,10 @@ RSU_OSAL_INT plat_mbox_get_rsu_status_mock(struct mbox_status_info *data)
 		return -EINVAL;
 	}
 
+	if (mock_rsu_dev[0] != '\0') {
+		return mock_read_status_attrs(data);
+	}
+
 	data->version = 0x0808;
 	return 0;
 }
@@ -57,12 +101,12 @@ RSU_OSAL_INT plat_mbox_terminate_mock(RSU_OSAL_VOID)
 	return 0;
 }
 
-RSU_OSAL_INT plat_mbox_init(struct mbox_ll_intf *mbox, RSU_OSAL_CHAR *config_file)
+RSU_OSAL_INT plat_mbox_init(struct mbox_ll_intf *mbox, const struct rsu_config *config)
 {
-	if (!mbox || !config_file) {
+	if (!mbox || !config) {
 		return -EINVAL;
 	}
-	ARG_UNUSED(config_file);
+	ARG_UNUSED(config);
 	mbox->get_rsu_status = plat_mbox_get_rsu_status_mock;
 	mbox->send_rsu_update = plat_mbox_send_rsu_update_mock;
 	mbox->get_spt_addresses = plat_mbox_get_spt_addresses_mock;
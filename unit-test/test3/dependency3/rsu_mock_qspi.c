@@ -26,6 +26,8 @@
 #define CPB_HEADER_SIZE	 24
 
 struct full mock_full;
+RSU_OSAL_U32 mock_qspi_reads;
+RSU_OSAL_CHAR mock_qspi_dev[256];
 
 static uint8_t *g_arr = (uint8_t *)&mock_full;
 #define bufferlength (sizeof(mock_spt))
@@ -34,6 +36,7 @@ static uint8_t *g_arr = (uint8_t *)&mock_full;
 RSU_OSAL_INT plat_qspi_read_mock(RSU_OSAL_OFFSET offset, RSU_OSAL_VOID *data, RSU_OSAL_SIZE len)
 {
 	RSU_LOG_INF("received read qspi");
+	mock_qspi_reads++;
 	uint8_t *ret;
 	ret = (uint8_t *)data;
 	uint32_t i = 0;
@@ -76,12 +79,14 @@ RSU_OSAL_INT plat_qspi_terminate_mock(RSU_OSAL_VOID)
 }
 
 /* Init plat_qspi */
-RSU_OSAL_INT plat_qspi_init(struct qspi_ll_intf *qspi_intf, RSU_OSAL_CHAR *config_file)
+RSU_OSAL_INT plat_qspi_init(struct qspi_ll_intf *qspi_intf, const struct rsu_config *config)
 {
-	if (!qspi_intf || !config_file) {
+	if (!qspi_intf || !config) {
 		return -EINVAL;
 	}
 
+	snprintf(mock_qspi_dev, sizeof(mock_qspi_dev), "%s", config->qspi_dev);
+
 	qspi_intf->read = plat_qspi_read_mock;
 	qspi_intf->write = plat_qspi_write_mock;
 	qspi_intf->erase = plat_qspi_erase_mock;
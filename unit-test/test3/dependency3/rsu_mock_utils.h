@@ -15,6 +15,15 @@ extern "C" {
 RSU_OSAL_VOID swap_bits(RSU_OSAL_CHAR *data, RSU_OSAL_INT size);
 RSU_OSAL_U32 swap_endian32(RSU_OSAL_U32 val);
 
+/* when set, the mock mailbox reads the status attributes from files in this directory */
+extern RSU_OSAL_CHAR mock_rsu_dev[256];
+
+/* number of reads the mock qspi served */
+extern RSU_OSAL_U32 mock_qspi_reads;
+
+/* qspi device the configuration gave to the mock qspi */
+extern RSU_OSAL_CHAR mock_qspi_dev[256];
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -15,9 +15,15 @@
 #include <hal/RSU_plat_crc32.h>
 #include <hal/RSU_plat_misc.h>
 #include <string.h>
+#include <unistd.h>
+#include <zlib.h>
 
 #include <rsu_mock_utils.h>
 #include <mock_spt.h>
+#include <rsud_proto.h>
+#include <rsud_server.h>
+#include <rsu_nor_sim.h>
+#include <rsu_image_gen.h>
 
 #define SPT_CHECKSUM_OFFSET 0x0C
 #define SPT_MAGIC_NUMBER    0x57713427
@@ -27,6 +33,10 @@
 #define SPT_MAX_PARTITIONS  127
 #define CPB_MAGIC_NUMBER    0x57789609
 #define CPB_HEADER_SIZE	    24
+#define IMAGE_BLOCK_SZ	    0x1000
+#define SIG_BLOCK_PTR_OFFS  0x0F00
+#define SIG_BLOCK_CRC_OFFS  0x0FFC
+#define CMF_MAGIC	    0x62294895
 
 extern struct full mock_full;
 
@@ -216,3 +226,1846 @@ TEST(librsu_test3, test_one_slot)
 
 	memset(&mock_full, 0, sizeof(struct full));
 }
+
+/*
+ * lay out SPT1 and CPB1 with one application slot SLOT1 in use
+ * (same layout as test_one_slot)
+ */
+static void mock_one_slot_layout(void)
+{
+	mock_full.mock_spt_full[1].mock_spt.magic_number = SPT_MAGIC_NUMBER;
+	mock_full.mock_spt_full[1].mock_spt.version = (RSU_OSAL_U32)1;
+	char *spt_data;
+	spt_data = (char *)malloc(sizeof(struct SUB_PARTITION_TABLE));
+	mock_full.mock_spt_full[1].mock_spt.checksum = (RSU_OSAL_U32)0xFFFFFFFF;
+	memcpy(spt_data, &mock_full.mock_spt_full[1].mock_spt, sizeof(struct SUB_PARTITION_TABLE));
+	memset(spt_data + SPT_CHECKSUM_OFFSET, 0,
+	       sizeof(mock_full.mock_spt_full[1].mock_spt.checksum));
+	swap_bits(spt_data, sizeof(struct SUB_PARTITION_TABLE));
+	RSU_OSAL_U32 calc_crc =
+		rsu_crc32(0, (RSU_OSAL_U8 *)spt_data, sizeof(struct SUB_PARTITION_TABLE));
+	mock_full.mock_spt_full[1].mock_spt.checksum = swap_endian32(calc_crc);
+	swap_bits(spt_data, sizeof(struct SUB_PARTITION_TABLE));
+	mock_full.mock_spt_full[1].mock_spt.magic_number = SPT_MAGIC_NUMBER;
+	free(spt_data);
+
+	mock_full.mock_spt_full[1].mock_spt.partitions = (RSU_OSAL_U32)5;
+	strcpy(mock_full.mock_spt_full[1].mock_spt.partition[0].name, "SPT0");
+	mock_full.mock_spt_full[1].mock_spt.partition[0].offset =
+		(RSU_OSAL_U64)&mock_full.mock_spt_full[0].mock_spt;
+	mock_full.mock_spt_full[1].mock_spt.partition[0].length =
+		(RSU_OSAL_U32)sizeof(struct SUB_PARTITION_TABLE);
+
+	strcpy(mock_full.mock_spt_full[1].mock_spt.partition[1].name, "SPT1");
+	mock_full.mock_spt_full[1].mock_spt.partition[1].offset =
+		(RSU_OSAL_U64)&mock_full.mock_spt_full[1].mock_spt;
+	mock_full.mock_spt_full[1].mock_spt.partition[1].length =
+		(RSU_OSAL_U32)sizeof(struct SUB_PARTITION_TABLE);
+
+	strcpy(mock_full.mock_spt_full[1].mock_spt.partition[2].name, "CPB0");
+	mock_full.mock_spt_full[1].mock_spt.partition[2].offset =
+		(RSU_OSAL_U64)&mock_full.mock_cpb_full[0].mock_cpb;
+	mock_full.mock_spt_full[1].mock_spt.partition[2].length =
+		(RSU_OSAL_U32)sizeof(union CMF_POINTER_BLOCK);
+
+	strcpy(mock_full.mock_spt_full[1].mock_spt.partition[3].name, "CPB1");
+	mock_full.mock_spt_full[1].mock_spt.partition[3].offset =
+		(RSU_OSAL_U64)&mock_full.mock_cpb_full[1].mock_cpb;
+	mock_full.mock_spt_full[1].mock_spt.partition[3].length =
+		(RSU_OSAL_U32)sizeof(union CMF_POINTER_BLOCK);
+
+	strcpy(mock_full.mock_spt_full[1].mock_spt.partition[4].name, "SLOT1");
+	mock_full.mock_spt_full[1].mock_spt.partition[4].offset = (RSU_OSAL_U64)(&mock_full.slot1);
+	mock_full.mock_spt_full[1].mock_spt.partition[4].length =
+		(RSU_OSAL_U32)sizeof(mock_full.slot1);
+
+	mock_full.mock_cpb_full[1].mock_cpb.header.magic_number = CPB_MAGIC_NUMBER;
+	mock_full.mock_cpb_full[1].mock_cpb.header.header_size = CPB_HEADER_SIZE;
+	mock_full.mock_cpb_full[1].mock_cpb.header.cpb_size = (RSU_OSAL_S32)4096;
+	mock_full.mock_cpb_full[1].mock_cpb.header.image_ptr_offset = (RSU_OSAL_U64)0x20;
+	mock_full.mock_cpb_full[1].mock_cpb.image.imp_ptr[0] = (uint64_t)&mock_full.slot1;
+	mock_full.mock_cpb_full[1].mock_cpb.header.image_ptr_slots = (RSU_OSAL_U32)1;
+}
+
+/*
+ * test case to save a slot to a compressed archive and restore it:
+ * slot holds some data followed by erased space
+ * archive is expected to be smaller than the slot
+ * programming the archive back into the erased slot restores the data
+ * verifying against the archive succeeds, and fails once the archive is corrupted
+ */
+TEST(librsu_test3, test_compressed_copy)
+{
+	int ret = 0;
+	char image[sizeof(mock_full.slot1)];
+	const char *archive = "slot_backup.rsuz";
+	FILE *fp;
+	long archive_size;
+	int x;
+
+	mock_one_slot_layout();
+
+	memset(mock_full.slot1, 0xFF, sizeof(mock_full.slot1));
+	for (x = 0; x < 5000; x++) {
+		mock_full.slot1[x] = (char)(x % 7);
+	}
+	memcpy(image, mock_full.slot1, sizeof(image));
+
+	ret = librsu_init((RSU_OSAL_CHAR *)"librsu_config.rc");
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_copy_to_file_compressed(0, (RSU_OSAL_CHAR *)archive);
+	ASSERT_EQ(ret, 0);
+
+	fp = fopen(archive, "rb");
+	ASSERT_NE(fp, nullptr);
+	fseek(fp, 0, SEEK_END);
+	archive_size = ftell(fp);
+	fclose(fp);
+	ASSERT_LT(archive_size, 1024);
+
+	ret = rsu_slot_erase(0);
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_program_file_raw(0, (RSU_OSAL_CHAR *)archive);
+	ASSERT_EQ(ret, 0);
+	ASSERT_EQ(memcmp(mock_full.slot1, image, sizeof(image)), 0);
+
+	ret = rsu_slot_verify_file_raw(0, (RSU_OSAL_CHAR *)archive);
+	ASSERT_EQ(ret, 0);
+
+	fp = fopen(archive, "r+b");
+	ASSERT_NE(fp, nullptr);
+	fseek(fp, archive_size - 4, SEEK_SET);
+	fputc(0x5A, fp);
+	fclose(fp);
+
+	ret = rsu_slot_verify_file_raw(0, (RSU_OSAL_CHAR *)archive);
+	ASSERT_NE(ret, 0);
+
+	librsu_exit();
+
+	remove(archive);
+	memset(&mock_full, 0, sizeof(struct full));
+}
+
+/*
+ * test case to save a slot with erased gaps between its data to an archive:
+ * data is pseudo random so deflate can not shrink it
+ * archive is expected to leave out the erased gaps
+ * programming the archive back into the erased slot restores the data and the gaps
+ */
+TEST(librsu_test3, test_compressed_copy_gaps)
+{
+	int ret = 0;
+	char image[sizeof(mock_full.slot1)];
+	const char *archive = "slot_gaps.rsuz";
+	unsigned int seed = 12345;
+	FILE *fp;
+	long archive_size;
+	int x;
+
+	mock_one_slot_layout();
+
+	memset(mock_full.slot1, 0xFF, sizeof(mock_full.slot1));
+	for (x = 0; x < 24000; x++) {
+		if ((x >= 4096 && x < 12288) || (x >= 16384 && x < 20000)) {
+			continue;
+		}
+		seed = seed * 1103515245 + 12345;
+		mock_full.slot1[x] = (char)(seed >> 16);
+	}
+	memcpy(image, mock_full.slot1, sizeof(image));
+
+	ret = librsu_init((RSU_OSAL_CHAR *)"librsu_config.rc");
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_copy_to_file_compressed(0, (RSU_OSAL_CHAR *)archive);
+	ASSERT_EQ(ret, 0);
+
+	fp = fopen(archive, "rb");
+	ASSERT_NE(fp, nullptr);
+	fseek(fp, 0, SEEK_END);
+	archive_size = ftell(fp);
+	fclose(fp);
+	ASSERT_LT(archive_size, 24000 - 8192 - 3616 + 1024);
+
+	ret = rsu_slot_erase(0);
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_program_file_raw(0, (RSU_OSAL_CHAR *)archive);
+	ASSERT_EQ(ret, 0);
+	ASSERT_EQ(memcmp(mock_full.slot1, image, sizeof(image)), 0);
+
+	ret = rsu_slot_verify_file_raw(0, (RSU_OSAL_CHAR *)archive);
+	ASSERT_EQ(ret, 0);
+
+	librsu_exit();
+
+	remove(archive);
+	memset(&mock_full, 0, sizeof(struct full));
+}
+
+/*
+ * test case to verify a slot against gzip and zlib compressed files:
+ * both compressed forms of the slot content are expected to verify
+ * gzip file of different content is expected to fail
+ */
+TEST(librsu_test3, test_verify_compressed_file)
+{
+	int ret = 0;
+	const char *gz_name = "slot_image.gz";
+	const char *zlib_name = "slot_image.zlib";
+	unsigned char zbuf[16 * 1024];
+	uLongf zlen = sizeof(zbuf);
+	gzFile gz;
+	FILE *fp;
+	int x;
+
+	mock_one_slot_layout();
+
+	memset(mock_full.slot1, 0xFF, sizeof(mock_full.slot1));
+	for (x = 0; x < 8192; x++) {
+		mock_full.slot1[x] = (char)(x % 13);
+	}
+
+	gz = gzopen(gz_name, "wb");
+	ASSERT_NE(gz, nullptr);
+	ASSERT_EQ(gzwrite(gz, mock_full.slot1, 8192), 8192);
+	gzclose(gz);
+
+	ret = compress2(zbuf, &zlen, (unsigned char *)mock_full.slot1, 8192, Z_BEST_COMPRESSION);
+	ASSERT_EQ(ret, Z_OK);
+	fp = fopen(zlib_name, "wb");
+	ASSERT_NE(fp, nullptr);
+	ASSERT_EQ(fwrite(zbuf, 1, zlen, fp), zlen);
+	fclose(fp);
+
+	ret = librsu_init((RSU_OSAL_CHAR *)"librsu_config.rc");
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_verify_file(0, (RSU_OSAL_CHAR *)gz_name);
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_verify_file(0, (RSU_OSAL_CHAR *)zlib_name);
+	ASSERT_EQ(ret, 0);
+
+	mock_full.slot1[100] = 0x55;
+	ret = rsu_slot_verify_file(0, (RSU_OSAL_CHAR *)gz_name);
+	ASSERT_NE(ret, 0);
+
+	librsu_exit();
+
+	remove(gz_name);
+	remove(zlib_name);
+	memset(&mock_full, 0, sizeof(struct full));
+}
+
+struct read_sink_state {
+	char data[28 * 1024];
+	int len;
+	int calls;
+};
+
+static int read_sink(void *arg, const void *buf, int size)
+{
+	struct read_sink_state *st = (struct read_sink_state *)arg;
+
+	if (st->len + size > (int)sizeof(st->data)) {
+		return -1;
+	}
+
+	memcpy(st->data + st->len, buf, size);
+	st->len += size;
+	st->calls++;
+
+	return 0;
+}
+
+/*
+ * test case for partial and streaming slot reads:
+ * reading a range inside the slot returns the slot content
+ * reading into an unaligned buffer returns the same content
+ * reading past the end of the slot is expected to fail
+ * streaming the slot hands the whole slot content to the sink
+ */
+TEST(librsu_test3, test_slot_read)
+{
+	int ret = 0;
+	char buf[512];
+	struct read_sink_state *st;
+	int x;
+
+	mock_one_slot_layout();
+
+	for (x = 0; x < (int)sizeof(mock_full.slot1); x++) {
+		mock_full.slot1[x] = (char)(x % 251);
+	}
+
+	ret = librsu_init((RSU_OSAL_CHAR *)"librsu_config.rc");
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_read(0, 4000, sizeof(buf), buf);
+	ASSERT_EQ(ret, 0);
+	ASSERT_EQ(memcmp(buf, mock_full.slot1 + 4000, sizeof(buf)), 0);
+
+	ret = rsu_slot_read(0, 4001, sizeof(buf) - 6, buf + 3);
+	ASSERT_EQ(ret, 0);
+	ASSERT_EQ(memcmp(buf + 3, mock_full.slot1 + 4001, sizeof(buf) - 6), 0);
+
+	ret = rsu_slot_read(0, 7, 3, buf + 1);
+	ASSERT_EQ(ret, 0);
+	ASSERT_EQ(memcmp(buf + 1, mock_full.slot1 + 7, 3), 0);
+
+	ret = rsu_slot_read(0, sizeof(mock_full.slot1) - 100, sizeof(buf), buf);
+	ASSERT_NE(ret, 0);
+
+	ret = rsu_slot_read(1, 0, sizeof(buf), buf);
+	ASSERT_NE(ret, 0);
+
+	st = (struct read_sink_state *)calloc(1, sizeof(*st));
+	ASSERT_NE(st, nullptr);
+
+	ret = rsu_slot_read_callback(0, read_sink, st);
+	ASSERT_EQ(ret, 0);
+	ASSERT_EQ(st->len, (int)sizeof(mock_full.slot1));
+	ASSERT_EQ(memcmp(st->data, mock_full.slot1, sizeof(mock_full.slot1)), 0);
+	free(st);
+
+	librsu_exit();
+
+	memset(&mock_full, 0, sizeof(struct full));
+}
+
+static void digest_to_hex(const unsigned char *digest, int len, char *hex)
+{
+	int x;
+
+	for (x = 0; x < len; x++) {
+		sprintf(hex + 2 * x, "%02x", digest[x]);
+	}
+}
+
+/*
+ * test case for slot digests:
+ * SHA-256 and SHA-384 of the whole slot match reference values
+ * with RSU_DIGEST_TRIM_ERASED the erased tail is left out, but erased blocks
+ * in between programmed blocks are still hashed
+ * unknown algorithm is expected to fail
+ */
+TEST(librsu_test3, test_slot_digest)
+{
+	int ret = 0;
+	unsigned char digest[RSU_DIGEST_SHA384_SIZE];
+	char hex[2 * RSU_DIGEST_SHA384_SIZE + 1];
+	int x;
+
+	mock_one_slot_layout();
+
+	for (x = 0; x < (int)sizeof(mock_full.slot1); x++) {
+		mock_full.slot1[x] = (char)(x % 251);
+	}
+
+	ret = librsu_init((RSU_OSAL_CHAR *)"librsu_config.rc");
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_digest(0, RSU_DIGEST_SHA256, digest);
+	ASSERT_EQ(ret, 0);
+	digest_to_hex(digest, RSU_DIGEST_SHA256_SIZE, hex);
+	ASSERT_STREQ(hex, "afe9c4efce0f46dbe9aa703009016c1fa39f3bf02bd18a371c09c5d20c5e2c52");
+
+	ret = rsu_slot_digest(0, RSU_DIGEST_SHA384, digest);
+	ASSERT_EQ(ret, 0);
+	digest_to_hex(digest, RSU_DIGEST_SHA384_SIZE, hex);
+	ASSERT_STREQ(hex, "8d7c1aa0643a87ed6c5812c3078640061477f468d1083f543344f52690beceb1"
+			  "8d6b6722016c75c3debcc44515409860");
+
+	memset(mock_full.slot1, 0xFF, sizeof(mock_full.slot1));
+	for (x = 0; x < 5000; x++) {
+		mock_full.slot1[x] = (char)(x % 7);
+	}
+	mock_full.slot1[12300] = 0x11;
+
+	ret = rsu_slot_digest(0, RSU_DIGEST_SHA256, digest);
+	ASSERT_EQ(ret, 0);
+	digest_to_hex(digest, RSU_DIGEST_SHA256_SIZE, hex);
+	ASSERT_STREQ(hex, "90a75aeba696de0560c41d25c1d1729e27e600734e4f4f91ac3e229f0e837ea3");
+
+	ret = rsu_slot_digest(0, RSU_DIGEST_SHA384 | RSU_DIGEST_TRIM_ERASED, digest);
+	ASSERT_EQ(ret, 0);
+	digest_to_hex(digest, RSU_DIGEST_SHA384_SIZE, hex);
+	ASSERT_STREQ(hex, "8213b600b7555bc2607dfaac19177415cb018fe0ec3d3b4e042a486a4b1a572b"
+			  "f0196d873f9877fd8172f3707194541b");
+
+	ret = rsu_slot_digest(0, 7, digest);
+	ASSERT_NE(ret, 0);
+
+	librsu_exit();
+
+	memset(&mock_full, 0, sizeof(struct full));
+}
+
+/*
+ * test case for digests of slots larger than one read chunk:
+ * the slot is read by the reader thread while it is hashed, digests match
+ * reference values with and without RSU_DIGEST_TRIM_ERASED
+ */
+TEST(librsu_test3, test_slot_digest_large)
+{
+	const int size = 5 * RSU_SLOT_READ_CHUNK_SIZE + 0x3000;
+	unsigned char digest[RSU_DIGEST_SHA384_SIZE];
+	char hex[2 * RSU_DIGEST_SHA384_SIZE + 1];
+	char *slot;
+	int ret = 0;
+	int x;
+
+	slot = (char *)malloc(size);
+	ASSERT_NE(slot, nullptr);
+
+	for (x = 0; x < size; x++) {
+		slot[x] = (char)(x % 251);
+	}
+
+	mock_one_slot_layout();
+	mock_full.mock_spt_full[1].mock_spt.partition[4].offset = (RSU_OSAL_U64)slot;
+	mock_full.mock_spt_full[1].mock_spt.partition[4].length = (RSU_OSAL_U32)size;
+	mock_full.mock_cpb_full[1].mock_cpb.image.imp_ptr[0] = (uint64_t)slot;
+
+	ret = librsu_init((RSU_OSAL_CHAR *)"librsu_config.rc");
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_digest(0, RSU_DIGEST_SHA256, digest);
+	ASSERT_EQ(ret, 0);
+	digest_to_hex(digest, RSU_DIGEST_SHA256_SIZE, hex);
+	ASSERT_STREQ(hex, "2c3af4cccc84b422af097df3eba347678c5bc2a1836021f692d22f45d202fb5c");
+
+	memset(slot, 0xFF, size);
+	for (x = 0; x < 0x21000; x++) {
+		slot[x] = (char)(x % 7);
+	}
+	slot[0x30010] = 0x11;
+
+	ret = rsu_slot_digest(0, RSU_DIGEST_SHA384 | RSU_DIGEST_TRIM_ERASED, digest);
+	ASSERT_EQ(ret, 0);
+	digest_to_hex(digest, RSU_DIGEST_SHA384_SIZE, hex);
+	ASSERT_STREQ(hex, "a9b0548a562582b9758369f95abb3ccdac9406920c902514106363731560ccb7"
+			  "db74c5c25bf43b45b52f3300b837775e");
+
+	librsu_exit();
+
+	free(slot);
+	memset(&mock_full, 0, sizeof(struct full));
+}
+
+static void hex_to_digest(const char *hex, unsigned char *digest)
+{
+	unsigned int byte;
+	int x;
+
+	for (x = 0; hex[2 * x]; x++) {
+		sscanf(hex + 2 * x, "%2x", &byte);
+		digest[x] = (unsigned char)byte;
+	}
+}
+
+/*
+ * test case for the digest manifest:
+ * programming a slot records its digest, so the check needs no slot read
+ * a different digest does not match
+ * digest of another algorithm is only found with the fallback to reading the slot
+ * erasing the slot drops the recorded digest
+ */
+TEST(librsu_test3, test_slot_matches_digest)
+{
+	int ret = 0;
+	char image[sizeof(mock_full.slot1)];
+	unsigned char sha256[RSU_DIGEST_SHA256_SIZE];
+	unsigned char sha384[RSU_DIGEST_SHA384_SIZE];
+	const char *rc = "librsu_manifest.rc";
+	const char *manifest = "librsu_test3.manifest";
+	FILE *fp;
+	int x;
+
+	fp = fopen(rc, "w");
+	ASSERT_NE(fp, nullptr);
+	fprintf(fp, "rsu-spt-checksum 0\nlog DBG stderr\ndigest-manifest %s sha256\n", manifest);
+	fclose(fp);
+	remove(manifest);
+
+	hex_to_digest("afe9c4efce0f46dbe9aa703009016c1fa39f3bf02bd18a371c09c5d20c5e2c52", sha256);
+	hex_to_digest("8d7c1aa0643a87ed6c5812c3078640061477f468d1083f543344f52690beceb1"
+		      "8d6b6722016c75c3debcc44515409860",
+		      sha384);
+
+	mock_one_slot_layout();
+
+	for (x = 0; x < (int)sizeof(image); x++) {
+		image[x] = (char)(x % 251);
+	}
+
+	ret = librsu_init((RSU_OSAL_CHAR *)rc);
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_erase(0);
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_matches_digest(0, RSU_DIGEST_SHA256, sha256, 0);
+	ASSERT_EQ(ret, -ENODIGEST);
+
+	ret = rsu_slot_program_buf_raw(0, image, sizeof(image));
+	ASSERT_EQ(ret, 0);
+
+	/* the slot content is changed behind the library, the recorded digest still answers */
+	mock_full.slot1[0] ^= 0x01;
+	ret = rsu_slot_matches_digest(0, RSU_DIGEST_SHA256, sha256, 0);
+	ASSERT_EQ(ret, 1);
+	mock_full.slot1[0] ^= 0x01;
+
+	sha256[0] ^= 0x01;
+	ret = rsu_slot_matches_digest(0, RSU_DIGEST_SHA256, sha256, 0);
+	ASSERT_EQ(ret, 0);
+	sha256[0] ^= 0x01;
+
+	ret = rsu_slot_matches_digest(0, RSU_DIGEST_SHA384, sha384, 0);
+	ASSERT_EQ(ret, -ENODIGEST);
+
+	ret = rsu_slot_matches_digest(0, RSU_DIGEST_SHA384, sha384, RSU_MATCH_FALLBACK_VERIFY);
+	ASSERT_EQ(ret, 1);
+
+	ret = rsu_slot_erase(0);
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_matches_digest(0, RSU_DIGEST_SHA256, sha256, 0);
+	ASSERT_EQ(ret, -ENODIGEST);
+
+	ret = rsu_slot_matches_digest(0, RSU_DIGEST_SHA256, sha256, RSU_MATCH_FALLBACK_VERIFY);
+	ASSERT_EQ(ret, 0);
+
+	librsu_exit();
+
+	remove(manifest);
+	remove(rc);
+	memset(&mock_full, 0, sizeof(struct full));
+}
+
+/*
+ * test case for digests recorded while programming and verifying:
+ * an image shorter than the slot, ending inside a block, is recorded with the
+ * digest of the whole slot, erased tail left out
+ * verifying a slot with no entry records the same digest
+ */
+TEST(librsu_test3, test_manifest_record)
+{
+	int ret = 0;
+	char image[5000];
+	unsigned char actual[RSU_DIGEST_SHA384_SIZE];
+	const char *rc = "librsu_manifest.rc";
+	const char *manifest = "librsu_test3.manifest";
+	FILE *fp;
+	int x;
+
+	fp = fopen(rc, "w");
+	ASSERT_NE(fp, nullptr);
+	fprintf(fp, "rsu-spt-checksum 0\nlog DBG stderr\ndigest-manifest %s sha384 trim\n",
+		manifest);
+	fclose(fp);
+	remove(manifest);
+
+	mock_one_slot_layout();
+
+	for (x = 0; x < (int)sizeof(image); x++) {
+		image[x] = (char)(x % 7);
+	}
+	image[sizeof(image) - 1] = (char)0xFF;
+
+	ret = librsu_init((RSU_OSAL_CHAR *)rc);
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_erase(0);
+	ASSERT_EQ(ret, 0);
+	ret = rsu_slot_program_buf_raw(0, image, sizeof(image));
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_digest(0, RSU_DIGEST_SHA384 | RSU_DIGEST_TRIM_ERASED, actual);
+	ASSERT_EQ(ret, 0);
+	ret = rsu_slot_matches_digest(0, RSU_DIGEST_SHA384 | RSU_DIGEST_TRIM_ERASED, actual, 0);
+	ASSERT_EQ(ret, 1);
+
+	remove(manifest);
+	ret = rsu_slot_matches_digest(0, RSU_DIGEST_SHA384 | RSU_DIGEST_TRIM_ERASED, actual, 0);
+	ASSERT_EQ(ret, -ENODIGEST);
+
+	ret = rsu_slot_verify_buf_raw(0, image, sizeof(image));
+	ASSERT_EQ(ret, 0);
+	ret = rsu_slot_matches_digest(0, RSU_DIGEST_SHA384 | RSU_DIGEST_TRIM_ERASED, actual, 0);
+	ASSERT_EQ(ret, 1);
+
+	librsu_exit();
+
+	remove(manifest);
+	remove(rc);
+	memset(&mock_full, 0, sizeof(struct full));
+}
+
+/* signature block CRC, the way the bitstream tools compute it */
+static void sig_block_set_crc(char *block)
+{
+	RSU_OSAL_U32 crc;
+
+	swap_bits(block, IMAGE_BLOCK_SZ);
+	crc = rsu_crc32(0, (RSU_OSAL_U8 *)block, SIG_BLOCK_CRC_OFFS);
+	crc = swap_endian32(crc);
+	memcpy(block + SIG_BLOCK_CRC_OFFS, &crc, sizeof(crc));
+	swap_bits(block, IMAGE_BLOCK_SZ);
+}
+
+/* image with a CMF section at 0 whose signature block points to a section at 0x2000 */
+static void make_cmf_image(char *image, int size, RSU_OSAL_U64 ptr)
+{
+	RSU_OSAL_U32 magic = CMF_MAGIC;
+	int x;
+
+	for (x = 0; x < size; x++) {
+		image[x] = (char)(x % 13);
+	}
+	memcpy(image, &magic, sizeof(magic));
+	memset(image + IMAGE_BLOCK_SZ + SIG_BLOCK_PTR_OFFS + 8, 0, 4 * sizeof(ptr));
+	memcpy(image + IMAGE_BLOCK_SZ + SIG_BLOCK_PTR_OFFS + 8, &ptr, sizeof(ptr));
+	sig_block_set_crc(image + IMAGE_BLOCK_SZ);
+}
+
+/*
+ * test case for image pre-flight validation:
+ * good image validates without writing the slot
+ * bad signature block CRC, pointer outside the slot and image larger than the slot are reported
+ * with program-preflight enabled a bad image leaves the erased slot untouched
+ * good image is programmed with relocated pointers and a valid CRC, and verifies
+ */
+TEST(librsu_test3, test_image_validate)
+{
+	int ret = 0;
+	static char image[8 * IMAGE_BLOCK_SZ];
+	char block[IMAGE_BLOCK_SZ];
+	char erased[sizeof(mock_full.slot1)];
+	const char *rc = "librsu_preflight.rc";
+	const char *file = "librsu_image.rpd";
+	RSU_OSAL_U64 slot_offset = (RSU_OSAL_U64)&mock_full.slot1;
+	RSU_OSAL_U64 ptr;
+	FILE *fp;
+
+	fp = fopen(rc, "w");
+	ASSERT_NE(fp, nullptr);
+	fprintf(fp, "rsu-spt-checksum 0\nlog DBG stderr\nprogram-preflight 1\n");
+	fclose(fp);
+
+	mock_one_slot_layout();
+	memset(mock_full.slot1, 0xFF, sizeof(mock_full.slot1));
+	memset(erased, 0xFF, sizeof(erased));
+
+	ret = librsu_init((RSU_OSAL_CHAR *)rc);
+	ASSERT_EQ(ret, 0);
+
+	make_cmf_image(image, 4 * IMAGE_BLOCK_SZ, 0x2000);
+	ret = rsu_image_validate_buf(0, image, 4 * IMAGE_BLOCK_SZ);
+	ASSERT_EQ(ret, 0);
+	ASSERT_EQ(memcmp(mock_full.slot1, erased, sizeof(erased)), 0);
+
+	fp = fopen(file, "wb");
+	ASSERT_NE(fp, nullptr);
+	fwrite(image, 1, 4 * IMAGE_BLOCK_SZ, fp);
+	fclose(fp);
+	ret = rsu_image_validate_file(0, (RSU_OSAL_CHAR *)file);
+	ASSERT_EQ(ret, 0);
+
+	image[IMAGE_BLOCK_SZ + 0x10] ^= 0x01;
+	ret = rsu_image_validate_buf(0, image, 4 * IMAGE_BLOCK_SZ);
+	ASSERT_EQ(ret, -EFORMAT);
+
+	make_cmf_image(image, 4 * IMAGE_BLOCK_SZ, slot_offset + 0x100000);
+	ret = rsu_image_validate_buf(0, image, 4 * IMAGE_BLOCK_SZ);
+	ASSERT_EQ(ret, -EFORMAT);
+
+	make_cmf_image(image, sizeof(image), 0x2000);
+	ret = rsu_image_validate_buf(0, image, sizeof(image));
+	ASSERT_EQ(ret, -ESIZE);
+
+	ret = rsu_slot_erase(0);
+	ASSERT_EQ(ret, 0);
+
+	make_cmf_image(image, 4 * IMAGE_BLOCK_SZ, 0x2000);
+	image[IMAGE_BLOCK_SZ + 0x10] ^= 0x01;
+	ret = rsu_slot_program_buf(0, image, 4 * IMAGE_BLOCK_SZ);
+	ASSERT_EQ(ret, -EFORMAT);
+	ASSERT_EQ(memcmp(mock_full.slot1, erased, sizeof(erased)), 0);
+
+	make_cmf_image(image, 4 * IMAGE_BLOCK_SZ, 0x2000);
+	ret = rsu_slot_program_file(0, (RSU_OSAL_CHAR *)file);
+	ASSERT_EQ(ret, 0);
+
+	memcpy(&ptr, mock_full.slot1 + IMAGE_BLOCK_SZ + SIG_BLOCK_PTR_OFFS + 8, sizeof(ptr));
+	ASSERT_EQ(ptr, slot_offset + 0x2000);
+	memcpy(block, mock_full.slot1 + IMAGE_BLOCK_SZ, sizeof(block));
+	sig_block_set_crc(block);
+	ASSERT_EQ(memcmp(block, mock_full.slot1 + IMAGE_BLOCK_SZ, sizeof(block)), 0);
+
+	ret = rsu_slot_verify_buf(0, image, 4 * IMAGE_BLOCK_SZ);
+	ASSERT_EQ(ret, 0);
+
+	librsu_exit();
+
+	remove(file);
+	remove(rc);
+	memset(&mock_full, 0, sizeof(struct full));
+}
+
+static int alloc_calls;
+static int free_calls;
+
+static void *counting_malloc(size_t size)
+{
+	alloc_calls++;
+	return malloc(size);
+}
+
+static void counting_free(void *ptr)
+{
+	if (ptr) {
+		free_calls++;
+	}
+	free(ptr);
+}
+
+/*
+ * test case for the allocator hooks and the scratch arena:
+ * allocator can only be changed before initialization, and both hooks are needed
+ * all library allocations go through the hooks and are released by librsu_exit
+ * erasing, programming and verifying a slot make no heap calls
+ */
+TEST(librsu_test3, test_allocator)
+{
+	int ret = 0;
+	char image[sizeof(mock_full.slot1)];
+	int x;
+
+	mock_one_slot_layout();
+
+	for (x = 0; x < (int)sizeof(image); x++) {
+		image[x] = (char)(x % 251);
+	}
+
+	ret = librsu_set_allocator(counting_malloc, NULL);
+	ASSERT_EQ(ret, -EARGS);
+
+	ret = librsu_set_allocator(counting_malloc, counting_free);
+	ASSERT_EQ(ret, 0);
+
+	alloc_calls = 0;
+	free_calls = 0;
+
+	ret = librsu_init((RSU_OSAL_CHAR *)"librsu_config.rc");
+	ASSERT_EQ(ret, 0);
+	ASSERT_GT(alloc_calls, 0);
+
+	ret = librsu_set_allocator(NULL, NULL);
+	ASSERT_EQ(ret, -ELIB);
+
+	alloc_calls = 0;
+	free_calls = 0;
+
+	ret = rsu_slot_erase(0);
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_program_buf_raw(0, image, sizeof(image));
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_verify_buf_raw(0, image, sizeof(image));
+	ASSERT_EQ(ret, 0);
+
+	ASSERT_EQ(alloc_calls, 0);
+	ASSERT_EQ(free_calls, 0);
+
+	alloc_calls = 0;
+	free_calls = 0;
+
+	librsu_exit();
+
+	ASSERT_GT(free_calls, 0);
+
+	ret = librsu_set_allocator(NULL, NULL);
+	ASSERT_EQ(ret, 0);
+
+	memset(&mock_full, 0, sizeof(struct full));
+}
+
+struct osal_worker {
+	RSU_OSAL_MUTEX mutex;
+	RSU_OSAL_COND cond;
+	RSU_OSAL_RWLOCK lock;
+	RSU_OSAL_ATOMIC count;
+	int ready;
+};
+
+static void *osal_worker_entry(void *arg)
+{
+	struct osal_worker *w = (struct osal_worker *)arg;
+	int x;
+
+	for (x = 0; x < 1000; x++) {
+		rsu_atomic_add(&w->count, 1);
+	}
+
+	rsu_rwlock_rdlock(&w->lock);
+	rsu_rwlock_unlock(&w->lock);
+
+	rsu_mutex_timedlock(&w->mutex, RSU_TIME_FOREVER);
+	w->ready++;
+	rsu_cond_broadcast(&w->cond);
+	rsu_mutex_unlock(&w->mutex);
+
+	return arg;
+}
+
+/*
+ * test case for the OSAL threading primitives:
+ * threads can be started and joined, and hand back their return value
+ * atomic updates from several threads are not lost
+ * a condition variable wakes up the waiter, or times out after the given period
+ * the monotonic clock does not go backwards
+ */
+TEST(librsu_test3, test_osal_threads)
+{
+	struct osal_worker w;
+	RSU_OSAL_THREAD threads[4];
+	RSU_OSAL_U64 start, end;
+	void *res;
+	int ret;
+	int x;
+
+	memset(&w, 0, sizeof(w));
+	ASSERT_EQ(rsu_mutex_init(&w.mutex), 0);
+	ASSERT_EQ(rsu_cond_init(&w.cond), 0);
+	ASSERT_EQ(rsu_rwlock_init(&w.lock), 0);
+	rsu_atomic_store(&w.count, 0);
+
+	ASSERT_EQ(rsu_rwlock_wrlock(&w.lock), 0);
+	for (x = 0; x < 4; x++) {
+		ret = rsu_thread_create(&threads[x], osal_worker_entry, &w);
+		ASSERT_EQ(ret, 0);
+	}
+	ASSERT_EQ(rsu_rwlock_unlock(&w.lock), 0);
+
+	rsu_mutex_timedlock(&w.mutex, RSU_TIME_FOREVER);
+	while (w.ready < 4) {
+		ret = rsu_cond_timedwait(&w.cond, &w.mutex, 5000);
+		ASSERT_EQ(ret, 0);
+	}
+	rsu_mutex_unlock(&w.mutex);
+
+	for (x = 0; x < 4; x++) {
+		ret = rsu_thread_join(&threads[x], &res);
+		ASSERT_EQ(ret, 0);
+		ASSERT_EQ(res, (void *)&w);
+	}
+
+	ASSERT_EQ(rsu_atomic_load(&w.count), 4000);
+	ASSERT_FALSE(rsu_atomic_cas(&w.count, 0, 1));
+	ASSERT_TRUE(rsu_atomic_cas(&w.count, 4000, 1));
+	ASSERT_EQ(rsu_atomic_load(&w.count), 1);
+
+	start = rsu_time_ns();
+	rsu_mutex_timedlock(&w.mutex, RSU_TIME_FOREVER);
+	ret = rsu_cond_timedwait(&w.cond, &w.mutex, 20);
+	rsu_mutex_unlock(&w.mutex);
+	end = rsu_time_ns();
+	ASSERT_EQ(ret, -ETIMEDOUT);
+	ASSERT_GE(end - start, 20000000ULL);
+
+	ASSERT_EQ(rsu_thread_create(NULL, osal_worker_entry, &w), -EINVAL);
+
+	rsu_rwlock_destroy(&w.lock);
+	rsu_cond_destroy(&w.cond);
+	rsu_mutex_destroy(&w.mutex);
+}
+
+static void write_status_attr(const char *dir, const char *attr, unsigned long long value)
+{
+	char path[512];
+	FILE *fp;
+
+	snprintf(path, sizeof(path), "%s/%s", dir, attr);
+	fp = fopen(path, "w");
+	ASSERT_NE(fp, nullptr);
+	fprintf(fp, "0x%llx\n", value);
+	fclose(fp);
+}
+
+static void write_status_attrs(const char *dir, unsigned long long state)
+{
+	write_status_attr(dir, "version", 0x0202);
+	write_status_attr(dir, "state", state);
+	write_status_attr(dir, "current_image", 0x1000000);
+	write_status_attr(dir, "fail_image", 0);
+	write_status_attr(dir, "error_location", 0);
+	write_status_attr(dir, "error_details", 0);
+	write_status_attr(dir, "retry_counter", 0);
+}
+
+static void *status_waiter(void *arg)
+{
+	struct rsu_status_info *info = (struct rsu_status_info *)arg;
+
+	return (void *)(intptr_t)rsu_status_wait(5000, info);
+}
+
+/*
+ * test case for rsu_status_wait, with the status attribute files in a temp directory:
+ * a wait for an unchanged status times out
+ * a change of the attribute files wakes up every waiter with the new status
+ * the poller stops reading the status once no one waits
+ * waiters still blocked are released by librsu_exit
+ */
+TEST(librsu_test3, test_status_wait)
+{
+	int ret = 0;
+	char dir[] = "/tmp/librsu_statusXXXXXX";
+	const char *rc = "librsu_status.rc";
+	const char *attrs[] = {"version",	 "state",	  "current_image", "fail_image",
+			       "error_location", "error_details", "retry_counter"};
+	struct rsu_status_info base, infos[3];
+	struct rsu_stats stats;
+	RSU_OSAL_THREAD threads[3];
+	char path[512];
+	void *res;
+	FILE *fp;
+	int x;
+
+	ASSERT_NE(mkdtemp(dir), nullptr);
+	write_status_attrs(dir, 0);
+	snprintf(mock_rsu_dev, sizeof(mock_rsu_dev), "%s", dir);
+
+	fp = fopen(rc, "w");
+	ASSERT_NE(fp, nullptr);
+	fprintf(fp, "rsu-spt-checksum 0\nlog DBG stderr\nstatus-poll-interval 5\n");
+	fclose(fp);
+
+	ret = rsu_status_wait(10, &base);
+	ASSERT_EQ(ret, -ELIB);
+
+	ret = librsu_init((RSU_OSAL_CHAR *)rc);
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_status_wait(10, NULL);
+	ASSERT_EQ(ret, -EARGS);
+
+	ret = rsu_status_log(&base);
+	ASSERT_EQ(ret, 0);
+	ASSERT_EQ(base.state, 0U);
+
+	ret = rsu_status_wait(50, &base);
+	ASSERT_EQ(ret, -ETIMEDOUT);
+
+	for (x = 0; x < 3; x++) {
+		infos[x] = base;
+		ret = rsu_thread_create(&threads[x], status_waiter, &infos[x]);
+		ASSERT_EQ(ret, 0);
+	}
+
+	write_status_attrs(dir, 0xF004D003);
+
+	for (x = 0; x < 3; x++) {
+		ret = rsu_thread_join(&threads[x], &res);
+		ASSERT_EQ(ret, 0);
+		ASSERT_EQ((int)(intptr_t)res, 0);
+		ASSERT_EQ(infos[x].state, 0xF004D003U);
+		ASSERT_EQ(infos[x].current_image, 0x1000000U);
+	}
+
+	usleep(20000);
+	ret = rsu_reset_stats();
+	ASSERT_EQ(ret, 0);
+	usleep(50000);
+	ret = rsu_get_stats(&stats);
+	ASSERT_EQ(ret, 0);
+	ASSERT_EQ(stats.op[RSU_STATS_API].count, 0U);
+
+	infos[0] = infos[1];
+	ret = rsu_thread_create(&threads[0], status_waiter, &infos[0]);
+	ASSERT_EQ(ret, 0);
+	usleep(20000);
+
+	librsu_exit();
+
+	ret = rsu_thread_join(&threads[0], &res);
+	ASSERT_EQ(ret, 0);
+	ASSERT_EQ((int)(intptr_t)res, -ELIB);
+
+	mock_rsu_dev[0] = '\0';
+	for (x = 0; x < 7; x++) {
+		snprintf(path, sizeof(path), "%s/%s", dir, attrs[x]);
+		remove(path);
+	}
+	rmdir(dir);
+	remove(rc);
+}
+
+/*
+ * test case for a configuration file with bad lines:
+ * a bad line is skipped, the lines after it still apply
+ */
+TEST(librsu_test3, test_cfg_bad_line)
+{
+	int ret = 0;
+	const char *rc = "librsu_bad.rc";
+	FILE *fp;
+
+	fp = fopen(rc, "w");
+	ASSERT_NE(fp, nullptr);
+	fprintf(fp, "write-protect\ndigest-manifest m.bin md5\nroot qspi /dev/mtd7\n"
+		    "rsu-spt-checksum 0\nwrite-protect 0\n");
+	fclose(fp);
+
+	mock_one_slot_layout();
+
+	ret = librsu_init((RSU_OSAL_CHAR *)rc);
+	ASSERT_EQ(ret, 0);
+	ASSERT_STREQ(mock_qspi_dev, "/dev/mtd7");
+
+	ret = rsu_slot_erase(0);
+	ASSERT_EQ(ret, -EWRPROT);
+
+	librsu_exit();
+
+	remove(rc);
+	memset(&mock_full, 0, sizeof(struct full));
+}
+
+/*
+ * test case for librsu_init_with_config:
+ * a missing configuration is rejected
+ * the library initializes from the structure without a configuration file
+ * settings of the structure are applied, here write protection of slot 0
+ */
+TEST(librsu_test3, test_init_with_config)
+{
+	int ret = 0;
+	struct rsu_config config;
+
+	mock_one_slot_layout();
+
+	ret = librsu_init_with_config(NULL);
+	ASSERT_EQ(ret, -EARGS);
+
+	librsu_config_defaults(&config);
+	ASSERT_EQ(config.log_level, RSU_CONFIG_LOG_DEFAULT);
+	ASSERT_EQ(config.spt_checksum_enabled, 1U);
+
+	config.spt_checksum_enabled = 0;
+	config.writeprotect = 1 << 0;
+
+	ret = librsu_init_with_config(&config);
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_count();
+	ASSERT_EQ(ret, 1);
+
+	ret = rsu_slot_erase(0);
+	ASSERT_EQ(ret, -EWRPROT);
+
+	librsu_exit();
+
+	config.writeprotect = 0;
+	ret = librsu_init_with_config(&config);
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_erase(0);
+	ASSERT_EQ(ret, 0);
+
+	librsu_exit();
+	memset(&mock_full, 0, sizeof(struct full));
+}
+
+/*
+ * test case for the metadata snapshot:
+ * the first init does a full load and saves the snapshot
+ * the next init takes it with fewer flash reads
+ * erasing the slot changes the CPB, so the following init does not use the snapshot
+ * a snapshot whose tables differ from flash is not used, even with a valid file crc
+ * a damaged snapshot file falls back to the full load
+ */
+TEST(librsu_test3, test_metadata_cache)
+{
+	int ret = 0;
+	struct rsu_config config;
+	struct rsu_slot_info info;
+	const char *cache = "librsu_test3.cache";
+	RSU_OSAL_U32 full_reads, reads;
+	/* the file crc is the last field of the 88 byte snapshot header */
+	const long crc_offset = 84;
+	RSU_OSAL_U32 crc;
+	char *snap, *name;
+	long len;
+	FILE *fp;
+
+	mock_one_slot_layout();
+	remove(cache);
+
+	librsu_config_defaults(&config);
+	config.spt_checksum_enabled = 0;
+	snprintf(config.metadata_cache, sizeof(config.metadata_cache), "%s", cache);
+
+	reads = mock_qspi_reads;
+	ret = librsu_init_with_config(&config);
+	ASSERT_EQ(ret, 0);
+	full_reads = mock_qspi_reads - reads;
+	librsu_exit();
+
+	fp = fopen(cache, "r");
+	ASSERT_TRUE(fp != NULL);
+	fclose(fp);
+
+	reads = mock_qspi_reads;
+	ret = librsu_init_with_config(&config);
+	ASSERT_EQ(ret, 0);
+	ASSERT_LT(mock_qspi_reads - reads, full_reads);
+
+	ret = rsu_slot_count();
+	ASSERT_EQ(ret, 1);
+
+	ret = rsu_slot_priority(0);
+	ASSERT_GT(ret, 0);
+
+	ret = rsu_slot_erase(0);
+	ASSERT_EQ(ret, 0);
+	librsu_exit();
+
+	ret = librsu_init_with_config(&config);
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_priority(0);
+	ASSERT_EQ(ret, 0);
+	librsu_exit();
+
+	/* rename the slot in the snapshot only, and make the file consistent again */
+	fp = fopen(cache, "rb");
+	ASSERT_TRUE(fp != NULL);
+	fseek(fp, 0, SEEK_END);
+	len = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+	snap = (char *)malloc(len);
+	ASSERT_NE(snap, nullptr);
+	ASSERT_EQ(fread(snap, 1, len, fp), (size_t)len);
+	fclose(fp);
+
+	name = (char *)memmem(snap, len, "SLOT1", 5);
+	ASSERT_NE(name, nullptr);
+	name[4] = 'X';
+	memset(snap + crc_offset, 0, sizeof(crc));
+	crc = rsu_crc32(0, (RSU_OSAL_U8 *)snap, len);
+	memcpy(snap + crc_offset, &crc, sizeof(crc));
+
+	fp = fopen(cache, "wb");
+	ASSERT_TRUE(fp != NULL);
+	ASSERT_EQ(fwrite(snap, 1, len, fp), (size_t)len);
+	fclose(fp);
+	free(snap);
+
+	ret = librsu_init_with_config(&config);
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_get_info(0, &info);
+	ASSERT_EQ(ret, 0);
+	ASSERT_STREQ(info.name, "SLOT1");
+	librsu_exit();
+
+	fp = fopen(cache, "w");
+	ASSERT_TRUE(fp != NULL);
+	fprintf(fp, "not a snapshot");
+	fclose(fp);
+
+	reads = mock_qspi_reads;
+	ret = librsu_init_with_config(&config);
+	ASSERT_EQ(ret, 0);
+	ASSERT_GE(mock_qspi_reads - reads, full_reads);
+
+	ret = rsu_slot_count();
+	ASSERT_EQ(ret, 1);
+	librsu_exit();
+
+	remove(cache);
+	memset(&mock_full, 0, sizeof(struct full));
+}
+
+/*
+ * test case for the read-only mode:
+ * init and the status log make no flash access
+ * the first slot call loads the tables and leaves the bad SPT0 as it is, also when it is
+ * a copy to a file or a verify, which look up the slot before any corruption check
+ * erasing a slot fails
+ * a normal init then restores SPT0, at the latest by the exit
+ */
+TEST(librsu_test3, test_read_only)
+{
+	int ret = 0;
+	struct rsu_config config;
+	struct rsu_status_info info;
+	struct rsu_image_params params = {sizeof(mock_full.slot1), 3, 0, RSU_IMAGE_FILL_RANDOM, 7};
+	const char *name = "librsu_read_only.bin";
+	char file[sizeof(mock_full.slot1)];
+	RSU_OSAL_U32 reads;
+	FILE *fp;
+
+	mock_one_slot_layout();
+
+	params.base = (RSU_OSAL_U64)&mock_full.slot1;
+	ret = rsu_image_gen_buf(&params, mock_full.slot1);
+	ASSERT_EQ(ret, 0);
+	params.base = 0;
+
+	librsu_config_defaults(&config);
+	config.spt_checksum_enabled = 0;
+	config.read_only = 1;
+
+	reads = mock_qspi_reads;
+	ret = librsu_init_with_config(&config);
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_status_log(&info);
+	ASSERT_EQ(ret, 0);
+	ASSERT_EQ(mock_qspi_reads, reads);
+
+	ret = rsu_slot_copy_to_file(0, (RSU_OSAL_CHAR *)name);
+	ASSERT_EQ(ret, 0);
+	ASSERT_GT(mock_qspi_reads, reads);
+	ASSERT_NE(mock_full.mock_spt_full[0].mock_spt.magic_number, (RSU_OSAL_U32)SPT_MAGIC_NUMBER);
+
+	fp = fopen(name, "rb");
+	ASSERT_NE(fp, nullptr);
+	ASSERT_EQ(fread(file, 1, sizeof(file), fp), sizeof(file));
+	fclose(fp);
+	remove(name);
+	ASSERT_EQ(memcmp(file, mock_full.slot1, sizeof(file)), 0);
+
+	ret = rsu_slot_count();
+	ASSERT_EQ(ret, 1);
+
+	ret = rsu_slot_erase(0);
+	ASSERT_EQ(ret, -ELOWLEVEL);
+	librsu_exit();
+
+	ret = librsu_init_with_config(&config);
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_image_gen_stream_init(&params);
+	ASSERT_EQ(ret, 0);
+	ret = rsu_slot_verify_callback(0, rsu_image_gen_stream);
+	ASSERT_EQ(ret, 0);
+	librsu_exit();
+
+	config.read_only = 0;
+	ret = librsu_init_with_config(&config);
+	ASSERT_EQ(ret, 0);
+	librsu_exit();
+	ASSERT_EQ(mock_full.mock_spt_full[0].mock_spt.magic_number, (RSU_OSAL_U32)SPT_MAGIC_NUMBER);
+
+	memset(&mock_full, 0, sizeof(struct full));
+}
+
+/*
+ * test case for the deferred repair of a bad copy:
+ * with 'metadata-repair manual' the init leaves the bad SPT0 and CPB0 alone
+ * rsu_repair_metadata() rewrites them
+ * by default the background worker rewrites them, at the latest by the exit
+ * a pending repair is done before the next write to flash
+ */
+TEST(librsu_test3, test_repair_metadata)
+{
+	int ret = 0;
+	struct rsu_config config;
+
+	mock_one_slot_layout();
+	memset(&mock_full.mock_cpb_full[0], 0xFF, sizeof(mock_full.mock_cpb_full[0]));
+
+	librsu_config_defaults(&config);
+	config.spt_checksum_enabled = 0;
+	config.metadata_repair = RSU_REPAIR_MANUAL;
+
+	ret = librsu_init_with_config(&config);
+	ASSERT_EQ(ret, 0);
+	ASSERT_NE(mock_full.mock_spt_full[0].mock_spt.magic_number, (RSU_OSAL_U32)SPT_MAGIC_NUMBER);
+	ASSERT_NE(mock_full.mock_cpb_full[0].mock_cpb.header.magic_number, (RSU_OSAL_S32)CPB_MAGIC_NUMBER);
+
+	ret = rsu_slot_count();
+	ASSERT_EQ(ret, 1);
+
+	ret = rsu_repair_metadata();
+	ASSERT_EQ(ret, 0);
+	ASSERT_EQ(mock_full.mock_spt_full[0].mock_spt.magic_number, (RSU_OSAL_U32)SPT_MAGIC_NUMBER);
+	ASSERT_EQ(mock_full.mock_cpb_full[0].mock_cpb.header.magic_number, (RSU_OSAL_S32)CPB_MAGIC_NUMBER);
+	ASSERT_EQ(memcmp(&mock_full.mock_cpb_full[0].mock_cpb, &mock_full.mock_cpb_full[1].mock_cpb,
+			 sizeof(union CMF_POINTER_BLOCK)), 0);
+
+	ret = rsu_repair_metadata();
+	ASSERT_EQ(ret, 0);
+	librsu_exit();
+
+	mock_full.mock_spt_full[0].mock_spt.magic_number = 0;
+	config.metadata_repair = RSU_REPAIR_BACKGROUND;
+	ret = librsu_init_with_config(&config);
+	ASSERT_EQ(ret, 0);
+	librsu_exit();
+	ASSERT_EQ(mock_full.mock_spt_full[0].mock_spt.magic_number, (RSU_OSAL_U32)SPT_MAGIC_NUMBER);
+
+	mock_full.mock_spt_full[0].mock_spt.magic_number = 0;
+	config.metadata_repair = RSU_REPAIR_MANUAL;
+	ret = librsu_init_with_config(&config);
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_erase(0);
+	ASSERT_EQ(ret, 0);
+	ASSERT_EQ(mock_full.mock_spt_full[0].mock_spt.magic_number, (RSU_OSAL_U32)SPT_MAGIC_NUMBER);
+	librsu_exit();
+
+	memset(&mock_full, 0, sizeof(struct full));
+}
+
+static void count_progress(void *arg, const struct rsud_progress *progress)
+{
+	struct rsud_progress *last = (struct rsud_progress *)arg;
+
+	if (progress->total) {
+		last->queued++;
+		last->done = progress->done;
+		last->total = progress->total;
+	}
+}
+
+/*
+ * test case to serve the library over the rsud socket:
+ * queries are answered from the daemon's copy of the slot layout and SDM
+ * state, without calling the library
+ * erase and program go through the queue, and the copy follows them
+ * programming streams progress messages up to the size of the image
+ * unknown commands fail and the daemon keeps serving the client
+ */
+TEST(librsu_test3, test_rsud)
+{
+	int ret = 0;
+	const char *sock = "rsud_test.sock";
+	const char *file = "rsud_image.bin";
+	char image[sizeof(mock_full.slot1)];
+	struct rsud_progress progress;
+	struct rsud_request req;
+	struct rsu_slot_info info;
+	struct rsu_status_info status, daemon_status;
+	struct rsu_stats stats;
+	struct rsu_config config;
+	RSU_OSAL_U32 dcmf_version[4];
+	RSU_OSAL_INT dcmf_status[4];
+	RSU_OSAL_INT factory;
+	RSU_OSAL_U8 retry;
+	int lib_ret[4];
+	FILE *fp;
+	int fd0, fd1;
+	int x;
+
+	mock_one_slot_layout();
+
+	for (x = 0; x < (int)sizeof(image); x++) {
+		image[x] = (char)(x % 13);
+	}
+	fp = fopen(file, "wb");
+	ASSERT_NE(fp, nullptr);
+	fwrite(image, 1, sizeof(image), fp);
+	fclose(fp);
+
+	librsu_config_defaults(&config);
+	config.spt_checksum_enabled = 0;
+	config.metadata_repair = RSU_REPAIR_INLINE;
+
+	ret = librsu_init_with_config(&config);
+	ASSERT_EQ(ret, 0);
+
+	ret = rsud_server_start(sock);
+	ASSERT_EQ(ret, 0);
+
+	fd0 = rsud_connect(sock);
+	ASSERT_GE(fd0, 0);
+	fd1 = rsud_connect(sock);
+	ASSERT_GE(fd1, 0);
+
+	memset(&req, 0, sizeof(req));
+	req.command = RSUD_CMD_SLOT_COUNT;
+	ret = rsud_call(fd0, &req, NULL, NULL, 0, NULL, NULL);
+	ASSERT_EQ(ret, 1);
+
+	req.command = RSUD_CMD_SLOT_INFO;
+	req.slot = 0;
+	ret = rsud_call(fd1, &req, NULL, &info, sizeof(info), NULL, NULL);
+	ASSERT_EQ(ret, 0);
+	ASSERT_STREQ(info.name, "SLOT1");
+	ASSERT_EQ(info.size, (int)sizeof(mock_full.slot1));
+	ASSERT_EQ(info.priority, 1);
+
+	req.slot = 1;
+	ret = rsud_call(fd1, &req, NULL, &info, sizeof(info), NULL, NULL);
+	ASSERT_EQ(ret, -ESLOTNUM);
+
+	req.command = RSUD_CMD_SLOT_ERASE;
+	req.slot = 0;
+	ret = rsud_call(fd0, &req, NULL, NULL, 0, NULL, NULL);
+	ASSERT_EQ(ret, 0);
+
+	req.command = RSUD_CMD_SLOT_PRIORITY;
+	ret = rsud_call(fd1, &req, NULL, NULL, 0, NULL, NULL);
+	ASSERT_EQ(ret, 0);
+
+	memset(&progress, 0, sizeof(progress));
+	req.command = RSUD_CMD_PROGRAM_FILE_RAW;
+	ret = rsud_call(fd1, &req, file, NULL, 0, count_progress, &progress);
+	ASSERT_EQ(ret, 0);
+	ASSERT_GT(progress.queued, (RSU_OSAL_U32)1);
+	ASSERT_EQ(progress.done, (RSU_OSAL_U32)sizeof(image));
+	ASSERT_EQ(progress.total, (RSU_OSAL_U32)sizeof(mock_full.slot1));
+	ASSERT_EQ(memcmp(mock_full.slot1, image, sizeof(image)), 0);
+
+	/* the daemon answers as the library does, some of these fail on the mock */
+	ret = rsu_status_log(&status);
+	ASSERT_EQ(ret, 0);
+	lib_ret[0] = rsu_max_retry(&retry);
+	lib_ret[1] = rsu_running_factory(&factory);
+	lib_ret[2] = rsu_dcmf_version(dcmf_version);
+	lib_ret[3] = rsu_dcmf_status(dcmf_status);
+	ret = rsu_reset_stats();
+	ASSERT_EQ(ret, 0);
+
+	req.command = RSUD_CMD_STATUS_LOG;
+	ret = rsud_call(fd0, &req, NULL, &daemon_status, sizeof(daemon_status), NULL, NULL);
+	ASSERT_EQ(ret, 0);
+	ASSERT_EQ(daemon_status.version, status.version);
+
+	req.command = RSUD_CMD_MAX_RETRY;
+	ret = rsud_call(fd1, &req, NULL, &retry, sizeof(retry), NULL, NULL);
+	ASSERT_EQ(ret, lib_ret[0]);
+
+	req.command = RSUD_CMD_RUNNING_FACTORY;
+	ret = rsud_call(fd1, &req, NULL, &factory, sizeof(factory), NULL, NULL);
+	ASSERT_EQ(ret, lib_ret[1]);
+
+	req.command = RSUD_CMD_DCMF_VERSION;
+	ret = rsud_call(fd0, &req, NULL, dcmf_version, sizeof(dcmf_version), NULL, NULL);
+	ASSERT_EQ(ret, lib_ret[2]);
+
+	req.command = RSUD_CMD_DCMF_STATUS;
+	ret = rsud_call(fd0, &req, NULL, dcmf_status, sizeof(dcmf_status), NULL, NULL);
+	ASSERT_EQ(ret, lib_ret[3]);
+
+	ret = rsu_get_stats(&stats);
+	ASSERT_EQ(ret, 0);
+	ASSERT_EQ(stats.op[RSU_STATS_API].count, 0U);
+
+	req.command = 0xFFFF;
+	ret = rsud_call(fd0, &req, NULL, NULL, 0, NULL, NULL);
+	ASSERT_EQ(ret, -EARGS);
+
+	req.command = RSUD_CMD_SLOT_COUNT;
+	ret = rsud_call(fd0, &req, NULL, NULL, 0, NULL, NULL);
+	ASSERT_EQ(ret, 1);
+
+	close(fd0);
+	close(fd1);
+	rsud_server_stop();
+	librsu_exit();
+
+	ASSERT_NE(access(sock, F_OK), 0);
+
+	remove(file);
+	memset(&mock_full, 0, sizeof(struct full));
+}
+
+/*
+ * test case to measure the flash below the library:
+ * reads cover every partition of the SPT once, plus the random reads
+ * a slot in the CPB is refused as scratch slot
+ * a scratch slot smaller than an erase block skips the erase and program tests
+ * and keeps its contents
+ */
+TEST(librsu_test3, test_bench)
+{
+	int ret = 0;
+	char image[sizeof(mock_full.slot1)];
+	struct rsu_bench bench;
+	struct rsu_config config;
+	int x;
+
+	mock_one_slot_layout();
+
+	for (x = 0; x < (int)sizeof(image); x++) {
+		image[x] = (char)(x % 11);
+	}
+	memcpy(mock_full.slot1, image, sizeof(image));
+
+	librsu_config_defaults(&config);
+	config.spt_checksum_enabled = 0;
+	config.metadata_repair = RSU_REPAIR_INLINE;
+
+	ret = librsu_init_with_config(&config);
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_bench(-1, &bench);
+	ASSERT_EQ(ret, 0);
+	ASSERT_EQ(bench.seq_read_bytes, (RSU_OSAL_U64)(2 * sizeof(struct SUB_PARTITION_TABLE) +
+						       2 * sizeof(union CMF_POINTER_BLOCK) +
+						       sizeof(mock_full.slot1)));
+	ASSERT_EQ(bench.rand_reads, (RSU_OSAL_U32)RSU_BENCH_RANDOM_READS);
+	ASSERT_GT(bench.rand_read_bytes, (RSU_OSAL_U64)0);
+	ASSERT_EQ(bench.erase_blocks, (RSU_OSAL_U32)0);
+
+	ret = rsu_bench(0, &bench);
+	ASSERT_EQ(ret, -EPROGRAM);
+
+	ret = rsu_slot_disable(0);
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_bench(0, &bench);
+	ASSERT_EQ(ret, 0);
+	ASSERT_EQ(bench.erase_blocks, (RSU_OSAL_U32)0);
+	ASSERT_EQ(bench.program_bytes, (RSU_OSAL_U64)0);
+	ASSERT_EQ(memcmp(mock_full.slot1, image, sizeof(image)), 0);
+
+	ret = rsu_bench(0, NULL);
+	ASSERT_EQ(ret, -EARGS);
+
+	librsu_exit();
+
+	memset(&mock_full, 0, sizeof(struct full));
+}
+
+TEST(librsu_test3, test_stats)
+{
+	int ret = 0;
+	struct rsu_bench bench;
+	struct rsu_config config;
+	struct rsu_stats stats;
+	RSU_OSAL_U64 sum;
+	int x, y;
+
+	mock_one_slot_layout();
+
+	librsu_config_defaults(&config);
+	config.spt_checksum_enabled = 0;
+	config.metadata_repair = RSU_REPAIR_INLINE;
+
+	ret = librsu_init_with_config(&config);
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_reset_stats();
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_bench(-1, &bench);
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_get_stats(&stats);
+	ASSERT_EQ(ret, 0);
+	ASSERT_EQ(stats.op[RSU_STATS_FLASH_READ].bytes,
+		  bench.seq_read_bytes + bench.rand_read_bytes);
+	ASSERT_EQ(stats.op[RSU_STATS_FLASH_READ].errors, (RSU_OSAL_U64)0);
+	ASSERT_EQ(stats.op[RSU_STATS_FLASH_WRITE].count, (RSU_OSAL_U64)0);
+	ASSERT_EQ(stats.op[RSU_STATS_API].count, (RSU_OSAL_U64)1);
+	ASSERT_EQ(stats.op[RSU_STATS_LOCK_WAIT].count, (RSU_OSAL_U64)1);
+
+	ret = rsu_slot_disable(0);
+	ASSERT_EQ(ret, 0);
+	ret = rsu_slot_erase(0);
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_get_stats(&stats);
+	ASSERT_EQ(ret, 0);
+	ASSERT_GE(stats.op[RSU_STATS_FLASH_ERASE].bytes, (RSU_OSAL_U64)sizeof(mock_full.slot1));
+	ASSERT_GT(stats.op[RSU_STATS_FLASH_WRITE].count, (RSU_OSAL_U64)0);
+	ASSERT_EQ(stats.op[RSU_STATS_API].count, (RSU_OSAL_U64)3);
+
+	for (x = 0; x < RSU_STATS_OPS; x++) {
+		ASSERT_NE(rsu_stats_name(x), nullptr);
+		sum = 0;
+		for (y = 0; y < RSU_STATS_BUCKETS; y++) {
+			sum += stats.op[x].hist[y];
+		}
+		ASSERT_EQ(sum, stats.op[x].count);
+	}
+	ASSERT_EQ(rsu_stats_name(RSU_STATS_OPS), nullptr);
+	ASSERT_EQ(rsu_stats_name(-1), nullptr);
+
+	ret = rsu_reset_stats();
+	ASSERT_EQ(ret, 0);
+	ret = rsu_get_stats(&stats);
+	ASSERT_EQ(ret, 0);
+	ASSERT_EQ(stats.op[RSU_STATS_FLASH_READ].count, (RSU_OSAL_U64)0);
+	ASSERT_EQ(stats.op[RSU_STATS_FLASH_READ].hist[0] + stats.op[RSU_STATS_API].ns,
+		  (RSU_OSAL_U64)0);
+
+	ret = rsu_get_stats(NULL);
+	ASSERT_EQ(ret, -EARGS);
+
+	librsu_exit();
+
+	memset(&mock_full, 0, sizeof(struct full));
+}
+
+/*
+ * test case for the HAL trace and replay:
+ * a session traced with data replays against an empty flash with the same results
+ * a call which is not in the trace fails
+ */
+TEST(librsu_test3, test_trace)
+{
+	int ret = 0;
+	char trace[] = "/tmp/librsu_traceXXXXXX";
+	struct rsu_slot_info info, replayed;
+	struct rsu_config config;
+	int fd;
+
+	fd = mkstemp(trace);
+	ASSERT_GE(fd, 0);
+	close(fd);
+
+	mock_one_slot_layout();
+
+	librsu_config_defaults(&config);
+	config.spt_checksum_enabled = 0;
+	config.metadata_repair = RSU_REPAIR_INLINE;
+	snprintf(config.hal_trace, sizeof(config.hal_trace), "%s", trace);
+	config.hal_trace_data = 1;
+
+	ret = librsu_init_with_config(&config);
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_count();
+	ASSERT_EQ(ret, 1);
+	ret = rsu_slot_get_info(0, &info);
+	ASSERT_EQ(ret, 0);
+	ret = rsu_slot_disable(0);
+	ASSERT_EQ(ret, 0);
+
+	librsu_exit();
+
+	memset(&mock_full, 0, sizeof(struct full));
+
+	snprintf(config.hal_replay, sizeof(config.hal_replay), "%s", trace);
+
+	/* trace and replay together are refused */
+	snprintf(config.hal_trace, sizeof(config.hal_trace), "%s", trace);
+	ret = librsu_init_with_config(&config);
+	ASSERT_NE(ret, 0);
+	config.hal_trace[0] = '\0';
+
+	ret = librsu_init_with_config(&config);
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_count();
+	ASSERT_EQ(ret, 1);
+	ret = rsu_slot_get_info(0, &replayed);
+	ASSERT_EQ(ret, 0);
+	ASSERT_EQ(memcmp(&info, &replayed, sizeof(info)), 0);
+	ret = rsu_slot_disable(0);
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_erase(0);
+	ASSERT_NE(ret, 0);
+
+	librsu_exit();
+
+	unlink(trace);
+	memset(&mock_full, 0, sizeof(struct full));
+}
+
+TEST(librsu_test3, test_nor_sim)
+{
+	struct rsu_nor_geometry geometry = {0x40000, 0x1000, 256, 0, 0};
+	struct rsu_nor_counters counters;
+	struct qspi_ll_intf nor;
+	RSU_OSAL_U8 buf[600];
+	RSU_OSAL_U64 start;
+	int ret;
+
+	/* sizes must be powers of 2 and the flash whole erase blocks */
+	geometry.erase_size = 0x1800;
+	ASSERT_NE(rsu_nor_sim_init(&geometry), 0);
+	geometry.erase_size = 0x1000;
+	geometry.size = 0x40800;
+	ASSERT_NE(rsu_nor_sim_init(&geometry), 0);
+	geometry.size = 0x40000;
+
+	ret = rsu_nor_sim_init(&geometry);
+	ASSERT_EQ(ret, 0);
+	ret = rsu_nor_sim_qspi(&nor);
+	ASSERT_EQ(ret, 0);
+
+	/* an erased flash reads all 1s */
+	ret = nor.read(0x3FE00, buf, 0x200);
+	ASSERT_EQ(ret, 0);
+	for (unsigned int x = 0; x < 0x200; x++) {
+		ASSERT_EQ(buf[x], 0xFF);
+	}
+	ASSERT_NE(nor.read(0x3FE00, buf, 0x201), 0);
+
+	/* a write crossing pages is split into page programs */
+	memset(buf, 0xF0, sizeof(buf));
+	ret = nor.write(0x1F0, buf, sizeof(buf));
+	ASSERT_EQ(ret, 0);
+	rsu_nor_sim_counters(&counters);
+	ASSERT_EQ(counters.pages, 4U);
+	ASSERT_EQ(counters.conflicts, 0U);
+
+	/* programming only clears bits, a 1 over a 0 is a conflict */
+	memset(buf, 0x0F, sizeof(buf));
+	ret = nor.write(0x1F0, buf, 16);
+	ASSERT_EQ(ret, 0);
+	ret = nor.read(0x1F0, buf, 16);
+	ASSERT_EQ(ret, 0);
+	for (unsigned int x = 0; x < 16; x++) {
+		ASSERT_EQ(buf[x], 0x00);
+	}
+	rsu_nor_sim_counters(&counters);
+	ASSERT_EQ(counters.conflicts, 16U);
+
+	buf[0] = 0x00;
+	ret = nor.write(0x1F0, buf, 1);
+	ASSERT_EQ(ret, 0);
+	rsu_nor_sim_counters(&counters);
+	ASSERT_EQ(counters.conflicts, 16U);
+	ASSERT_EQ(rsu_nor_sim_data()[0x1F0], 0x00);
+
+	/* erases must cover whole blocks */
+	ASSERT_NE(nor.erase(0x800, 0x1000), 0);
+	ASSERT_NE(nor.erase(0, 0x800), 0);
+	rsu_nor_sim_counters(&counters);
+	ASSERT_EQ(counters.errors, 3U);
+
+	ret = nor.erase(0, 0x2000);
+	ASSERT_EQ(ret, 0);
+	ret = nor.erase(0x1000, 0x1000);
+	ASSERT_EQ(ret, 0);
+	ASSERT_EQ(rsu_nor_sim_erase_count(0), 1U);
+	ASSERT_EQ(rsu_nor_sim_erase_count(1), 2U);
+	ASSERT_EQ(rsu_nor_sim_erase_count(2), 0U);
+	ASSERT_EQ(rsu_nor_sim_data()[0x1F0], 0xFF);
+	ASSERT_EQ(rsu_nor_sim_data()[0x3EF], 0xFF);
+
+	/* the flash keeps its contents across terminate */
+	buf[0] = 0x5A;
+	ret = nor.write(0x2000, buf, 1);
+	ASSERT_EQ(ret, 0);
+	ret = nor.terminate();
+	ASSERT_EQ(ret, 0);
+	ASSERT_EQ(rsu_nor_sim_data()[0x2000], 0x5A);
+
+	/* program and erase latencies are spent */
+	geometry.page_program_us = 500;
+	geometry.block_erase_us = 2000;
+	ret = rsu_nor_sim_init(&geometry);
+	ASSERT_EQ(ret, 0);
+	start = rsu_time_ns();
+	ret = nor.write(0, buf, 512);
+	ASSERT_EQ(ret, 0);
+	ret = nor.erase(0, 0x1000);
+	ASSERT_EQ(ret, 0);
+	ASSERT_GE(rsu_time_ns() - start, 3000000U);
+
+	rsu_nor_sim_exit();
+	ASSERT_EQ(rsu_nor_sim_data(), nullptr);
+}
+
+/*
+ * test case for the synthetic image generator:
+ * a relative image is relocated into the slot as the absolute image of the slot
+ * an absolute image is programmed as it is, and a streamed image like a buffer
+ * a signature block with a bad CRC is refused
+ * an image file is written bit-swapped on request
+ */
+TEST(librsu_test3, test_image_gen)
+{
+	struct rsu_image_params relative = {sizeof(mock_full.slot1), 3, 0, RSU_IMAGE_FILL_RANDOM,
+					    7};
+	struct rsu_image_params params;
+	char image[sizeof(mock_full.slot1)];
+	char flash[sizeof(mock_full.slot1)];
+	char file[sizeof(mock_full.slot1)];
+	const char *name = "gen_image.rpd";
+	FILE *fp;
+	int ret;
+
+	/* images are whole blocks with at least two blocks per section */
+	params = relative;
+	params.size = 0x1800;
+	ASSERT_NE(rsu_image_gen_check(&params), 0);
+	params = relative;
+	params.sections = 4;
+	ASSERT_NE(rsu_image_gen_check(&params), 0);
+	ASSERT_EQ(rsu_image_gen_check(&relative), 0);
+
+	mock_one_slot_layout();
+
+	ret = rsu_image_gen_buf(&relative, image);
+	ASSERT_EQ(ret, 0);
+	params = relative;
+	params.base = (RSU_OSAL_U64)&mock_full.slot1;
+	ret = rsu_image_gen_buf(&params, flash);
+	ASSERT_EQ(ret, 0);
+	ASSERT_NE(memcmp(image, flash, sizeof(image)), 0);
+
+	ret = librsu_init((RSU_OSAL_CHAR *)"librsu_config.rc");
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_erase(0);
+	ASSERT_EQ(ret, 0);
+	ret = rsu_slot_program_buf(0, image, sizeof(image));
+	ASSERT_EQ(ret, 0);
+	ASSERT_EQ(memcmp(mock_full.slot1, flash, sizeof(flash)), 0);
+	ret = rsu_image_gen_buf(&relative, image);
+	ASSERT_EQ(ret, 0);
+	ret = rsu_slot_verify_buf(0, image, sizeof(image));
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_erase(0);
+	ASSERT_EQ(ret, 0);
+	ret = rsu_slot_program_buf(0, flash, sizeof(flash));
+	ASSERT_EQ(ret, 0);
+	ASSERT_EQ(memcmp(mock_full.slot1, flash, sizeof(flash)), 0);
+	ret = rsu_slot_verify_buf(0, flash, sizeof(flash));
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_erase(0);
+	ASSERT_EQ(ret, 0);
+	ret = rsu_image_gen_stream_init(&relative);
+	ASSERT_EQ(ret, 0);
+	ret = rsu_slot_program_callback(0, rsu_image_gen_stream);
+	ASSERT_EQ(ret, 0);
+	ASSERT_EQ(memcmp(mock_full.slot1, flash, sizeof(flash)), 0);
+	ret = rsu_image_gen_stream_init(&relative);
+	ASSERT_EQ(ret, 0);
+	ret = rsu_slot_verify_callback(0, rsu_image_gen_stream);
+	ASSERT_EQ(ret, 0);
+
+	image[RSU_IMAGE_GEN_BLOCK * 3 + 0x10] ^= 1;
+	ret = rsu_slot_erase(0);
+	ASSERT_EQ(ret, 0);
+	ret = rsu_slot_program_buf(0, image, sizeof(image));
+	ASSERT_NE(ret, 0);
+
+	librsu_exit();
+
+	ret = rsu_image_gen_file(&relative, name, 1);
+	ASSERT_EQ(ret, 0);
+	fp = fopen(name, "rb");
+	ASSERT_NE(fp, nullptr);
+	ASSERT_EQ(fread(file, 1, sizeof(file), fp), sizeof(file));
+	ASSERT_EQ(fgetc(fp), EOF);
+	fclose(fp);
+	swap_bits(file, sizeof(file));
+	ret = rsu_image_gen_buf(&relative, image);
+	ASSERT_EQ(ret, 0);
+	ASSERT_EQ(memcmp(file, image, sizeof(image)), 0);
+
+	remove(name);
+	memset(&mock_full, 0, sizeof(struct full));
+}
@@ -40,13 +40,13 @@ RSU_OSAL_INT terminate(RSU_OSAL_VOID)
 	return 0;
 }
 
-RSU_OSAL_INT plat_rsu_misc_init(struct rsu_ll_misc *misc_intf, RSU_OSAL_CHAR *config_file)
+RSU_OSAL_INT plat_rsu_misc_init(struct rsu_ll_misc *misc_intf, const struct rsu_config *config)
 {
-	if (!misc_intf || !config_file) {
+	if (!misc_intf || !config) {
 		return -EINVAL;
 	}
 
-	ARG_UNUSED(config_file);
+	ARG_UNUSED(config);
 	misc_intf->rsu_get_dcmf_status = rsu_get_dcmf_status;
 	misc_intf->rsu_get_dcmf_version = rsu_get_dcmf_version;
 	misc_intf->rsu_get_max_retry_count = rsu_get_max_retry_count;
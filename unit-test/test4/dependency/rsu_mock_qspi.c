@@ -107,9 +107,9 @@ RSU_OSAL_INT plat_qspi_terminate_mock(RSU_OSAL_VOID)
 }
 
 /* Init plat_qspi */
-RSU_OSAL_INT plat_qspi_init(struct qspi_ll_intf *qspi_intf, RSU_OSAL_CHAR *config_file)
+RSU_OSAL_INT plat_qspi_init(struct qspi_ll_intf *qspi_intf, const struct rsu_config *config)
 {
-    if (!qspi_intf || !config_file) {
+    if (!qspi_intf || !config) {
         return -EINVAL;
     }
 
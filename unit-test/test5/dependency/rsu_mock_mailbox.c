@@ -54,12 +54,12 @@ RSU_OSAL_INT plat_mbox_terminate_mock(RSU_OSAL_VOID)
 	return 0;
 }
 
-RSU_OSAL_INT plat_mbox_init(struct mbox_ll_intf *mbox, RSU_OSAL_CHAR *config_file)
+RSU_OSAL_INT plat_mbox_init(struct mbox_ll_intf *mbox, const struct rsu_config *config)
 {
-	if (!mbox || !config_file) {
+	if (!mbox || !config) {
 		return -EINVAL;
 	}
-	ARG_UNUSED(config_file);
+	ARG_UNUSED(config);
 	mbox->get_rsu_status = plat_mbox_get_rsu_status_mock;
 	mbox->send_rsu_update = plat_mbox_send_rsu_update_mock;
 	mbox->get_spt_addresses = plat_mbox_get_spt_addresses_mock;
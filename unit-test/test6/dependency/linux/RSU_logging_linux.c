@@ -14,12 +14,10 @@ typedef enum {
 	RSU_FILE
 }rsu_log_type_t;
 
-rsu_loglevel_t rsu_curr_loglevel = L_LOG_LVL;
+rsu_loglevel_t rsu_curr_loglevel = L_LOG_DEFAULT;
 rsu_log_type_t rsu_log_type = RSU_STDERR;
 RSU_OSAL_FILE *RSU_log_file = NULL;
 
-#define NUM_ARGS    (16U)
-
 RSU_OSAL_INT RSU_set_logging(rsu_loglevel_t level)
 {
     if (level >= L_LOG_MAX ) {
@@ -30,66 +28,32 @@ RSU_OSAL_INT RSU_set_logging(rsu_loglevel_t level)
     return 0;
 }
 
-RSU_OSAL_INT RSU_logging_init(RSU_OSAL_CHAR* cfg_file)
+RSU_OSAL_INT RSU_logging_init(const struct rsu_config *config)
 {
-    if (cfg_file == NULL) {
+    if (config == NULL) {
         return -EINVAL;
     }
 
-    RSU_OSAL_FILE *file;
-    RSU_OSAL_CHAR line[128], *argv[NUM_ARGS] = {0};
-    RSU_OSAL_INT argc;
-    RSU_OSAL_U32 linenum;
+    if (config->log_level == RSU_CONFIG_LOG_DEFAULT) {
+        return 0;
+    }
 
-    file = fopen(cfg_file,"r");
-    if (!file) {
-        return -ENOENT;
+    if (RSU_set_logging((rsu_loglevel_t)config->log_level) != 0) {
+        return -EINVAL;
     }
 
-    linenum=0;
-    while(fgets(line, 128, file) != NULL ) {
-        linenum++;
-        argc = split_line(line,argv,NUM_ARGS);
-        if (argc != 3) {
-            continue;
-        }
-/*TODO:check if we need to check the return from RSU_set_logging()*/
-        if (strcmp(argv[0],"log") == 0) {
-            if (strcmp(argv[1],"OFF") == 0) {
-                RSU_set_logging(L_LOG_OFF);
-                fclose(file);
-                return 0;
-            } else if (strcmp(argv[1],"ERR") == 0) {
-                RSU_set_logging(L_LOG_ERR);
-            } else if (strcmp(argv[1],"WRN") == 0) {
-                RSU_set_logging(L_LOG_WRN);
-            } else if (strcmp(argv[1],"INF") == 0) {
-                RSU_set_logging(L_LOG_INF);
-            } else if (strcmp(argv[1],"DBG") == 0) {
-                RSU_set_logging(L_LOG_DBG);
-            } else {
-                RSU_LOG_ERR("Error in getting logging configuration at line number %u",linenum);
-                fclose(file);
-                return -EINVAL;
-            }
+    if (config->log_level == L_LOG_OFF || config->log_file[0] == '\0') {
+        rsu_log_type = RSU_STDERR;
+        return 0;
+    }
 
-            if (strcmp(argv[2],"stderr") == 0) {
-                rsu_log_type = RSU_STDERR;
-            } else {
-                RSU_OSAL_FILE *tfile = fopen(argv[2],"w");
-                if (tfile == NULL) {
-                    RSU_LOG_ERR("Error in opening logfile, defined ar %u",linenum);
-                    fclose(file);
-                    return -EINVAL;
-                }
-                rsu_log_type = RSU_FILE;
-                RSU_log_file = tfile;
-            }
-            fclose(file);
-            return 0;
-        }
+    RSU_OSAL_FILE *tfile = fopen(config->log_file,"w");
+    if (tfile == NULL) {
+        RSU_LOG_ERR("Error in opening logfile '%s'",config->log_file);
+        return -EINVAL;
     }
-    fclose(file);
+    rsu_log_type = RSU_FILE;
+    RSU_log_file = tfile;
     return 0;
 }
 
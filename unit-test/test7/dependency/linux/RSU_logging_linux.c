@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2023-2024 Intel Corporation
+ * SPDX-License-Identifier: MIT-0
+ */
+
+#include <libRSU_OSAL.h>
+#include <utils/RSU_logging.h>
+#include <utils/RSU_utils.h>
+#include <string.h>
+#include <stdarg.h>
+
+typedef enum {
+	RSU_STDERR,
+	RSU_FILE
+}rsu_log_type_t;
+
+rsu_loglevel_t rsu_curr_loglevel = L_LOG_DEFAULT;
+rsu_log_type_t rsu_log_type = RSU_STDERR;
+RSU_OSAL_FILE *RSU_log_file = NULL;
+
+RSU_OSAL_INT RSU_set_logging(rsu_loglevel_t level)
+{
+    if (level >= L_LOG_MAX ) {
+        RSU_LOG_ERR("wrong log level provided : %d",level);
+        return -EINVAL;
+    }
+    rsu_curr_loglevel = level;
+    return 0;
+}
+
+RSU_OSAL_INT RSU_logging_init(const struct rsu_config *config)
+{
+    if (config == NULL) {
+        return -EINVAL;
+    }
+
+    if (config->log_level == RSU_CONFIG_LOG_DEFAULT) {
+        return 0;
+    }
+
+    if (RSU_set_logging((rsu_loglevel_t)config->log_level) != 0) {
+        return -EINVAL;
+    }
+
+    if (config->log_level == L_LOG_OFF || config->log_file[0] == '\0') {
+        rsu_log_type = RSU_STDERR;
+        return 0;
+    }
+
+    RSU_OSAL_FILE *tfile = fopen(config->log_file,"w");
+    if (tfile == NULL) {
+        RSU_LOG_ERR("Error in opening logfile '%s'",config->log_file);
+        return -EINVAL;
+    }
+    rsu_log_type = RSU_FILE;
+    RSU_log_file = tfile;
+    return 0;
+}
+
+RSU_OSAL_VOID RSU_logging_exit(RSU_OSAL_VOID)
+{
+    if(rsu_log_type == RSU_FILE) {
+        fflush(RSU_log_file);
+        fclose(RSU_log_file);
+        RSU_log_file = NULL;
+    }
+}
+
+RSU_OSAL_VOID RSU_logger(rsu_loglevel_t level, const RSU_OSAL_CHAR *format, ...)
+{
+    const RSU_OSAL_CHAR *l_log[] ={"","E:","W:","I:","D:"};
+    va_list arg;
+
+    if (level == L_LOG_OFF || level > rsu_curr_loglevel)
+        return;
+
+    if (rsu_log_type == RSU_STDERR) {
+        fprintf(stderr, "\n[%s]", l_log[level]);
+        fflush(stderr);
+        va_start(arg, format);
+        vfprintf(stderr, format, arg);
+        va_end(arg);
+        fflush(stderr);
+    } else if (rsu_log_type == RSU_FILE) {
+        if (!RSU_log_file) {
+            return;
+        }
+        fprintf(RSU_log_file, "\n[%s]", l_log[level]);
+        fflush(RSU_log_file);
+        va_start(arg, format);
+        vfprintf(RSU_log_file, format, arg);
+        va_end(arg);
+        fflush(RSU_log_file);
+    }
+}
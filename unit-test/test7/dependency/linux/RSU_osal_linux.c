@@ -0,0 +1,285 @@
+/*
+ * Copyright (C) 2023-2024 Intel Corporation
+ * SPDX-License-Identifier: MIT-0
+ */
+
+#include <libRSU_OSAL.h>
+#include <stdlib.h>
+/*Predefined header file for mutex and semaphore and time*/
+#include <time.h>
+#include <string.h>
+
+static rsu_malloc_hook malloc_hook;
+static rsu_free_hook free_hook;
+
+RSU_OSAL_VOID rsu_set_allocator(rsu_malloc_hook alloc, rsu_free_hook release)
+{
+	malloc_hook = alloc;
+	free_hook = release;
+}
+
+RSU_OSAL_VOID *rsu_malloc(RSU_OSAL_SIZE size)
+{
+	if (malloc_hook) {
+		return malloc_hook(size);
+	}
+
+	return (RSU_OSAL_VOID *)malloc(size);
+}
+
+RSU_OSAL_VOID rsu_free(RSU_OSAL_VOID *ptr)
+{
+	if (free_hook) {
+		free_hook(ptr);
+		return;
+	}
+
+	free(ptr);
+}
+
+RSU_OSAL_VOID *rsu_memset(RSU_OSAL_VOID *s, RSU_OSAL_U8 c, RSU_OSAL_SIZE n)
+{
+	return memset(s, c, n);
+}
+
+RSU_OSAL_VOID *rsu_memcpy(RSU_OSAL_VOID *d, RSU_OSAL_VOID *s, RSU_OSAL_SIZE n)
+{
+	return memcpy(d, s, n);
+}
+/* Mutex initialization */
+RSU_OSAL_INT rsu_mutex_init(RSU_OSAL_MUTEX *mutex)
+{
+	if (mutex == NULL) {
+		return -EINVAL;
+	}
+
+	RSU_OSAL_INT ret = pthread_mutex_init(mutex, NULL);
+	return ret;
+}
+
+/* To lock if available else wait based on time */
+RSU_OSAL_INT rsu_mutex_timedlock(RSU_OSAL_MUTEX *mutex, RSU_OSAL_U32 const time)
+{
+	if (mutex == NULL) {
+		return -EINVAL;
+	}
+
+	if (time == RSU_TIME_FOREVER) {
+		return pthread_mutex_lock(mutex);
+	} else if (time == RSU_TIME_NOWAIT) {
+		return pthread_mutex_trylock(mutex);
+	} else {
+		struct timespec wait;
+		wait.tv_sec = (time / 1000);
+		wait.tv_nsec = (time % 1000) * 1000000;
+		return pthread_mutex_timedlock(mutex, &wait);
+	}
+}
+
+/* To release a mutex */
+RSU_OSAL_INT rsu_mutex_unlock(RSU_OSAL_MUTEX *mutex)
+{
+	if (mutex == NULL) {
+		return -EINVAL;
+	}
+
+	RSU_OSAL_INT ret = pthread_mutex_unlock(mutex);
+	return ret;
+}
+
+/* Using pthread destroy fucntion */
+RSU_OSAL_INT rsu_mutex_destroy(RSU_OSAL_MUTEX *mutex)
+{
+	if (mutex == NULL) {
+		return -EINVAL;
+	}
+
+	RSU_OSAL_INT ret = pthread_mutex_destroy(mutex);
+	return ret;
+}
+
+/* Thread runs entry(arg) until it returns */
+RSU_OSAL_INT rsu_thread_create(RSU_OSAL_THREAD *thread, rsu_thread_entry entry,
+			       RSU_OSAL_VOID *arg)
+{
+	if (thread == NULL || entry == NULL) {
+		return -EINVAL;
+	}
+
+	return -pthread_create(thread, NULL, entry, arg);
+}
+
+RSU_OSAL_INT rsu_thread_join(RSU_OSAL_THREAD *thread, RSU_OSAL_VOID **ret)
+{
+	if (thread == NULL) {
+		return -EINVAL;
+	}
+
+	return -pthread_join(*thread, ret);
+}
+
+/* Condition variables wait against CLOCK_MONOTONIC, see rsu_cond_timedwait */
+RSU_OSAL_INT rsu_cond_init(RSU_OSAL_COND *cond)
+{
+	pthread_condattr_t attr;
+	RSU_OSAL_INT ret;
+
+	if (cond == NULL) {
+		return -EINVAL;
+	}
+
+	ret = pthread_condattr_init(&attr);
+	if (ret) {
+		return -ret;
+	}
+
+	ret = pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	if (ret == 0) {
+		ret = pthread_cond_init(cond, &attr);
+	}
+
+	pthread_condattr_destroy(&attr);
+	return -ret;
+}
+
+RSU_OSAL_INT rsu_cond_timedwait(RSU_OSAL_COND *cond, RSU_OSAL_MUTEX *mutex,
+				RSU_OSAL_U32 const time)
+{
+	struct timespec wait;
+
+	if (cond == NULL || mutex == NULL) {
+		return -EINVAL;
+	}
+
+	if (time == RSU_TIME_FOREVER) {
+		return -pthread_cond_wait(cond, mutex);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &wait);
+	wait.tv_sec += (time / 1000);
+	wait.tv_nsec += (time % 1000) * 1000000;
+	if (wait.tv_nsec >= 1000000000) {
+		wait.tv_sec++;
+		wait.tv_nsec -= 1000000000;
+	}
+
+	return -pthread_cond_timedwait(cond, mutex, &wait);
+}
+
+RSU_OSAL_INT rsu_cond_signal(RSU_OSAL_COND *cond)
+{
+	if (cond == NULL) {
+		return -EINVAL;
+	}
+
+	return -pthread_cond_signal(cond);
+}
+
+RSU_OSAL_INT rsu_cond_broadcast(RSU_OSAL_COND *cond)
+{
+	if (cond == NULL) {
+		return -EINVAL;
+	}
+
+	return -pthread_cond_broadcast(cond);
+}
+
+RSU_OSAL_INT rsu_cond_destroy(RSU_OSAL_COND *cond)
+{
+	if (cond == NULL) {
+		return -EINVAL;
+	}
+
+	return -pthread_cond_destroy(cond);
+}
+
+RSU_OSAL_INT rsu_rwlock_init(RSU_OSAL_RWLOCK *lock)
+{
+	if (lock == NULL) {
+		return -EINVAL;
+	}
+
+	return -pthread_rwlock_init(lock, NULL);
+}
+
+RSU_OSAL_INT rsu_rwlock_rdlock(RSU_OSAL_RWLOCK *lock)
+{
+	if (lock == NULL) {
+		return -EINVAL;
+	}
+
+	return -pthread_rwlock_rdlock(lock);
+}
+
+RSU_OSAL_INT rsu_rwlock_wrlock(RSU_OSAL_RWLOCK *lock)
+{
+	if (lock == NULL) {
+		return -EINVAL;
+	}
+
+	return -pthread_rwlock_wrlock(lock);
+}
+
+RSU_OSAL_INT rsu_rwlock_unlock(RSU_OSAL_RWLOCK *lock)
+{
+	if (lock == NULL) {
+		return -EINVAL;
+	}
+
+	return -pthread_rwlock_unlock(lock);
+}
+
+RSU_OSAL_INT rsu_rwlock_destroy(RSU_OSAL_RWLOCK *lock)
+{
+	if (lock == NULL) {
+		return -EINVAL;
+	}
+
+	return -pthread_rwlock_destroy(lock);
+}
+
+/* Atomics use the compiler builtins, all sequentially consistent */
+RSU_OSAL_INT rsu_atomic_load(RSU_OSAL_ATOMIC *atomic)
+{
+	return __atomic_load_n(atomic, __ATOMIC_SEQ_CST);
+}
+
+RSU_OSAL_VOID rsu_atomic_store(RSU_OSAL_ATOMIC *atomic, RSU_OSAL_INT val)
+{
+	__atomic_store_n(atomic, val, __ATOMIC_SEQ_CST);
+}
+
+RSU_OSAL_INT rsu_atomic_add(RSU_OSAL_ATOMIC *atomic, RSU_OSAL_INT val)
+{
+	return __atomic_add_fetch(atomic, val, __ATOMIC_SEQ_CST);
+}
+
+RSU_OSAL_BOOL rsu_atomic_cas(RSU_OSAL_ATOMIC *atomic, RSU_OSAL_INT expected, RSU_OSAL_INT val)
+{
+	return __atomic_compare_exchange_n(atomic, &expected, val, false, __ATOMIC_SEQ_CST,
+					   __ATOMIC_SEQ_CST);
+}
+
+/* 64 bit counters only count, relaxed ordering is enough */
+RSU_OSAL_U64 rsu_atomic64_load(RSU_OSAL_ATOMIC64 *atomic)
+{
+	return __atomic_load_n(atomic, __ATOMIC_RELAXED);
+}
+
+RSU_OSAL_VOID rsu_atomic64_store(RSU_OSAL_ATOMIC64 *atomic, RSU_OSAL_U64 val)
+{
+	__atomic_store_n(atomic, val, __ATOMIC_RELAXED);
+}
+
+RSU_OSAL_VOID rsu_atomic64_add(RSU_OSAL_ATOMIC64 *atomic, RSU_OSAL_U64 val)
+{
+	__atomic_add_fetch(atomic, val, __ATOMIC_RELAXED);
+}
+
+RSU_OSAL_U64 rsu_time_ns(RSU_OSAL_VOID)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (RSU_OSAL_U64)now.tv_sec * 1000000000ULL + (RSU_OSAL_U64)now.tv_nsec;
+}
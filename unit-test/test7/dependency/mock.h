@@ -0,0 +1,23 @@
+/*
+ * Copyright (C) 2023-2024 Intel Corporation
+ * SPDX-License-Identifier: MIT-0
+ */
+
+#ifndef __MOCK_H_
+#define __MOCK_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+#include <hal/RSU_plat_mailbox.h>
+
+/* 64MB flash with 4KB sectors, the layout is written by rsu_image_gen_flash() */
+#define NOR_SIM_GEOMETRY	{0x4000000, 0x1000, 256, 0, 0}
+
+extern struct mbox_status_info gdata;
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif
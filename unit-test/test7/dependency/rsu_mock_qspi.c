@@ -0,0 +1,20 @@
+/*
+ * Copyright (C) 2023-2024 Intel Corporation
+ * SPDX-License-Identifier: MIT-0
+ */
+
+#include <hal/RSU_plat_qspi.h>
+#include <utils/RSU_logging.h>
+#include <utils/RSU_utils.h>
+#include <rsu_nor_sim.h>
+
+/* Init plat_qspi, the test creates the simulated flash before librsu_init */
+RSU_OSAL_INT plat_qspi_init(struct qspi_ll_intf *qspi_intf, const struct rsu_config *config)
+{
+	if (!qspi_intf || !config) {
+		return -EINVAL;
+	}
+
+	RSU_LOG_DBG("qspi on the NOR flash simulator");
+	return rsu_nor_sim_qspi(qspi_intf);
+}
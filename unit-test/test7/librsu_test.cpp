@@ -0,0 +1,675 @@
+/*
+ * Copyright (C) 2023-2024 Intel Corporation
+ * SPDX-License-Identifier: MIT-0
+ */
+
+#include <gtest/gtest.h>
+#include <libRSU.h>
+#include <mock.h>
+#include <rsu_image_gen.h>
+#include <rsu_nor_sim.h>
+
+/*
+ * test4, test5 and test6 cases run on the NOR flash simulator, with the flash and the images
+ * generated here instead of by quartus_pfg.
+ */
+
+#define STATE_CPB0_CORRUPTED	  (0xF004D010UL)
+#define STATE_CPB0_CPB1_CORRUPTED (0xF004D011UL)
+
+#define SLOT_SIZE   0x100000
+#define SLOT_COUNT  4
+#define NEW_SLOT    0x640000
+
+static const RSU_OSAL_CHAR *const slot_names[SLOT_COUNT] = {"P1", "P2", "P3", "fip"};
+static const RSU_OSAL_U64 slot_sizes[SLOT_COUNT] = {SLOT_SIZE, SLOT_SIZE, SLOT_SIZE, SLOT_SIZE};
+
+static void corrupt_qspi(uint64_t offset)
+{
+	uint32_t random = 0x12345678;
+	ASSERT_EQ(rsu_nor_sim_load(offset, &random, sizeof(random)), 0);
+}
+
+/* P1, P2, P3 and fip programmed and in the CPB, P1 with the highest priority */
+static void create_initial_qspi_image(void)
+{
+	const struct rsu_nor_geometry geometry = NOR_SIM_GEOMETRY;
+	const struct rsu_flash_params params = {slot_sizes, slot_names, SLOT_COUNT, 2,
+						RSU_IMAGE_FILL_COUNTER, true};
+
+	memset(&gdata, 0, sizeof(gdata));
+	ASSERT_EQ(rsu_nor_sim_init(&geometry), 0);
+	ASSERT_GT(rsu_image_gen_flash(&params), 0);
+}
+
+static void expect_no_conflicts(void)
+{
+	struct rsu_nor_counters counters;
+
+	rsu_nor_sim_counters(&counters);
+	ASSERT_EQ(counters.conflicts, 0U);
+	ASSERT_EQ(counters.errors, 0U);
+}
+
+TEST(librsu_test7, test_init_slot_copy_verify)
+{
+	create_initial_qspi_image();
+	int ret = 0;
+	ret = librsu_init((RSU_OSAL_CHAR *)"librsu_config.rc");
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_count();
+	ASSERT_EQ(ret, 4);
+
+	ret = rsu_slot_by_name((RSU_OSAL_CHAR *)"fip");
+	ASSERT_EQ(ret, 3);
+
+	ret = rsu_slot_by_name((RSU_OSAL_CHAR *)"P3");
+	ASSERT_EQ(ret, 2);
+
+	ret = rsu_slot_copy_to_file(2, (RSU_OSAL_CHAR *)"copy_verify.rpd");
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_verify_file(2, (RSU_OSAL_CHAR *)"copy_verify.rpd");
+	ASSERT_EQ(ret, 0);
+
+	librsu_exit();
+}
+
+TEST(librsu_test7, test_init_slot_create_program)
+{
+	create_initial_qspi_image();
+	int ret = 0;
+	ret = librsu_init((RSU_OSAL_CHAR *)"librsu_config.rc");
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_copy_to_file(2, (RSU_OSAL_CHAR *)"create_program.rpd");
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_delete(2);
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_count();
+	ASSERT_EQ(ret, 3);
+
+	ret = rsu_slot_create((RSU_OSAL_CHAR *)"P4", NEW_SLOT, SLOT_SIZE);
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_by_name((RSU_OSAL_CHAR *)"P4");
+	ASSERT_EQ(ret, 3);
+
+	ret = rsu_slot_erase(3);
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_program_file(3, (RSU_OSAL_CHAR *)"create_program.rpd");
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_verify_file(3, (RSU_OSAL_CHAR *)"create_program.rpd");
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_count();
+	ASSERT_EQ(ret, 4);
+
+	librsu_exit();
+
+	/* the table survives a restart, and nothing was programmed over unerased flash */
+	ret = librsu_init((RSU_OSAL_CHAR *)"librsu_config.rc");
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_by_name((RSU_OSAL_CHAR *)"P4");
+	ASSERT_EQ(ret, 3);
+
+	ret = rsu_slot_verify_file(3, (RSU_OSAL_CHAR *)"create_program.rpd");
+	ASSERT_EQ(ret, 0);
+
+	librsu_exit();
+
+	expect_no_conflicts();
+}
+
+TEST(librsu_test7, test_init_slot_rename)
+{
+	create_initial_qspi_image();
+	int ret = 0;
+	ret = librsu_init((RSU_OSAL_CHAR *)"librsu_config.rc");
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_rename(2, (RSU_OSAL_CHAR *)"P5");
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_by_name((RSU_OSAL_CHAR *)"P5");
+	ASSERT_EQ(ret, 2);
+
+	librsu_exit();
+}
+
+TEST(librsu_test7, test_init_slot_parameters)
+{
+	create_initial_qspi_image();
+	int ret = 0, slot;
+	struct rsu_slot_info info;
+	ret = librsu_init((RSU_OSAL_CHAR *)"librsu_config.rc");
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_by_name((RSU_OSAL_CHAR *)"P3");
+	ASSERT_EQ(ret, 2);
+
+	slot = ret;
+
+	ret = rsu_slot_priority(slot);
+	ASSERT_EQ(ret, 3);
+
+	ret = rsu_slot_size(slot);
+	ASSERT_EQ(ret, SLOT_SIZE);
+
+	ret = rsu_slot_get_info(slot, &info);
+	ASSERT_EQ(ret, 0);
+	ASSERT_STREQ(info.name, "P3");
+	ASSERT_EQ(info.offset, (RSU_OSAL_U64)(4 * RSU_IMAGE_GEN_REGION + 2 * SLOT_SIZE));
+	ASSERT_EQ(info.priority, 3);
+	ASSERT_EQ(info.size, SLOT_SIZE);
+
+	librsu_exit();
+}
+
+TEST(librsu_test7, test_init_slot_raw_program_verify)
+{
+	create_initial_qspi_image();
+	int ret = 0, slot;
+	ret = librsu_init((RSU_OSAL_CHAR *)"librsu_config.rc");
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_copy_to_file(2, (RSU_OSAL_CHAR *)"raw_program.bin");
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_create((RSU_OSAL_CHAR *)"raw4", NEW_SLOT, SLOT_SIZE);
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_by_name((RSU_OSAL_CHAR *)"raw4");
+	ASSERT_EQ(ret, 4);
+
+	slot = 4;
+
+	ret = rsu_slot_erase(slot);
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_program_file_raw(slot, (RSU_OSAL_CHAR *)"raw_program.bin");
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_verify_file_raw(slot, (RSU_OSAL_CHAR *)"raw_program.bin");
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_count();
+	ASSERT_EQ(ret, 5);
+
+	librsu_exit();
+
+	expect_no_conflicts();
+}
+
+TEST(librsu_test7, test_init_slot_priority)
+{
+	create_initial_qspi_image();
+	int ret = 0, slot2, slot3;
+	ret = librsu_init((RSU_OSAL_CHAR *)"librsu_config.rc");
+	ASSERT_EQ(ret, 0);
+
+	slot2 = rsu_slot_by_name((RSU_OSAL_CHAR *)"P2");
+	ASSERT_EQ(slot2, 1);
+
+	slot3 = rsu_slot_by_name((RSU_OSAL_CHAR *)"P3");
+	ASSERT_EQ(slot3, 2);
+
+	ret = rsu_slot_priority(slot2);
+	ASSERT_EQ(ret, 2);
+
+	ret = rsu_slot_priority(slot3);
+	ASSERT_EQ(ret, 3);
+
+	ret = rsu_slot_disable(slot2);
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_priority(slot3);
+	ASSERT_EQ(ret, 2);
+
+	ret = rsu_slot_enable(slot2);
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_priority(slot2);
+	ASSERT_EQ(ret, 1);
+
+	ret = rsu_slot_priority(slot3);
+	ASSERT_EQ(ret, 3);
+
+	librsu_exit();
+
+	/* the priorities were written to the CPB */
+	ret = librsu_init((RSU_OSAL_CHAR *)"librsu_config.rc");
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_priority(slot2);
+	ASSERT_EQ(ret, 1);
+
+	ret = rsu_slot_priority(slot3);
+	ASSERT_EQ(ret, 3);
+
+	librsu_exit();
+
+	expect_no_conflicts();
+}
+
+/* relative image, as quartus_pfg -o start_address=0x00000 makes app1 */
+TEST(librsu_test7, test_init_slot_app_relative)
+{
+	create_initial_qspi_image();
+	const struct rsu_image_params params = {SLOT_SIZE, 3, 0, RSU_IMAGE_FILL_RANDOM, 1};
+	int ret = 0;
+
+	ret = rsu_image_gen_file(&params, "app_relative.rpd", false);
+	ASSERT_EQ(ret, 0);
+
+	ret = librsu_init((RSU_OSAL_CHAR *)"librsu_config.rc");
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_create((RSU_OSAL_CHAR *)"P4", NEW_SLOT, SLOT_SIZE);
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_by_name((RSU_OSAL_CHAR *)"P4");
+	ASSERT_EQ(ret, 4);
+
+	ret = rsu_slot_erase(4);
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_program_file(4, (RSU_OSAL_CHAR *)"app_relative.rpd");
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_verify_file(4, (RSU_OSAL_CHAR *)"app_relative.rpd");
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_count();
+	ASSERT_EQ(ret, 5);
+
+	librsu_exit();
+
+	expect_no_conflicts();
+}
+
+/* absolute image for the slot, as quartus_pfg -o start_address=<slot> makes app2 */
+TEST(librsu_test7, test_init_slot_app_absolute)
+{
+	create_initial_qspi_image();
+	const struct rsu_image_params params = {SLOT_SIZE, 3, NEW_SLOT, RSU_IMAGE_FILL_RANDOM, 2};
+	int ret = 0;
+
+	ret = rsu_image_gen_file(&params, "app_absolute.rpd", false);
+	ASSERT_EQ(ret, 0);
+
+	ret = librsu_init((RSU_OSAL_CHAR *)"librsu_config.rc");
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_create((RSU_OSAL_CHAR *)"P4", NEW_SLOT, SLOT_SIZE);
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_erase(4);
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_program_file(4, (RSU_OSAL_CHAR *)"app_absolute.rpd");
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_verify_file(4, (RSU_OSAL_CHAR *)"app_absolute.rpd");
+	ASSERT_EQ(ret, 0);
+
+	librsu_exit();
+
+	expect_no_conflicts();
+}
+
+TEST(librsu_test7, test_init_slot_create_program_buf)
+{
+	create_initial_qspi_image();
+	int ret = 0;
+	ret = librsu_init((RSU_OSAL_CHAR *)"librsu_config.rc");
+	ASSERT_EQ(ret, 0);
+
+	int slot = rsu_slot_by_name((RSU_OSAL_CHAR *)"P3");
+	ASSERT_EQ(slot, 2);
+
+	RSU_OSAL_SIZE size = rsu_slot_size(slot);
+	ASSERT_EQ(size, (RSU_OSAL_SIZE)SLOT_SIZE);
+
+	RSU_OSAL_U8 *buffer = (RSU_OSAL_U8 *)malloc(size);
+	ASSERT_NE(buffer, (RSU_OSAL_U8 *)NULL);
+
+	ret = rsu_slot_copy_to_buf(slot, buffer, size);
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_delete(slot);
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_count();
+	ASSERT_EQ(ret, 3);
+
+	ret = rsu_slot_create((RSU_OSAL_CHAR *)"P4", NEW_SLOT, SLOT_SIZE);
+	ASSERT_EQ(ret, 0);
+
+	slot = rsu_slot_by_name((RSU_OSAL_CHAR *)"P4");
+	ASSERT_EQ(slot, 3);
+
+	ret = rsu_slot_erase(slot);
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_program_buf(slot, buffer, size);
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_verify_buf(slot, buffer, size);
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_count();
+	ASSERT_EQ(ret, 4);
+
+	free(buffer);
+
+	librsu_exit();
+
+	expect_no_conflicts();
+}
+
+TEST(librsu_test7, test_init_slot_create_program_raw_buf)
+{
+	create_initial_qspi_image();
+	const struct rsu_image_params params = {SLOT_SIZE / 2, 1, 0, RSU_IMAGE_FILL_RANDOM, 3};
+	int ret = 0;
+
+	RSU_OSAL_U8 *buffer = (RSU_OSAL_U8 *)malloc(params.size);
+	ASSERT_NE(buffer, (RSU_OSAL_U8 *)NULL);
+
+	/* raw data does not need to be an image */
+	ret = rsu_image_gen_buf(&params, buffer);
+	ASSERT_EQ(ret, 0);
+	buffer[0] ^= 0xFF;
+
+	ret = librsu_init((RSU_OSAL_CHAR *)"librsu_config.rc");
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_by_name((RSU_OSAL_CHAR *)"fip");
+	ASSERT_EQ(ret, 3);
+
+	ret = rsu_slot_erase(3);
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_program_buf_raw(3, buffer, params.size);
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_verify_buf_raw(3, buffer, params.size);
+	ASSERT_EQ(ret, 0);
+
+	buffer[params.size - 1] ^= 1;
+	ret = rsu_slot_verify_buf_raw(3, buffer, params.size);
+	ASSERT_NE(ret, 0);
+
+	ret = rsu_slot_count();
+	ASSERT_EQ(ret, 4);
+
+	free(buffer);
+
+	librsu_exit();
+
+	expect_no_conflicts();
+}
+
+TEST(librsu_test7, test_callback_program_verify)
+{
+	create_initial_qspi_image();
+	const struct rsu_image_params params = {SLOT_SIZE, 2, 0, RSU_IMAGE_FILL_COUNTER, 0};
+	int ret = 0;
+	ret = librsu_init((RSU_OSAL_CHAR *)"librsu_config.rc");
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_create((RSU_OSAL_CHAR *)"P4", NEW_SLOT, SLOT_SIZE);
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_by_name((RSU_OSAL_CHAR *)"P4");
+	ASSERT_EQ(ret, 4);
+
+	ret = rsu_slot_erase(4);
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_image_gen_stream_init(&params);
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_program_callback(4, rsu_image_gen_stream);
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_image_gen_stream_init(&params);
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_verify_callback(4, rsu_image_gen_stream);
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_count();
+	ASSERT_EQ(ret, 5);
+
+	librsu_exit();
+
+	expect_no_conflicts();
+}
+
+TEST(librsu_test7, no_spt_corruption)
+{
+	create_initial_qspi_image();
+
+	int ret = 0;
+	ret = librsu_init((RSU_OSAL_CHAR *)"librsu_config.rc");
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_count();
+	ASSERT_EQ(ret, 4);
+
+	librsu_exit();
+}
+
+TEST(librsu_test7, corrupt_spt1)
+{
+	create_initial_qspi_image();
+	corrupt_qspi(RSU_IMAGE_GEN_REGION);
+	int ret = 0;
+	ret = librsu_init((RSU_OSAL_CHAR *)"librsu_config.rc");
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_count();
+	ASSERT_EQ(ret, 4);
+
+	librsu_exit();
+}
+
+TEST(librsu_test7, corrupt_spt0)
+{
+	create_initial_qspi_image();
+	corrupt_qspi(0);
+	int ret = 0;
+	ret = librsu_init((RSU_OSAL_CHAR *)"librsu_config.rc");
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_count();
+	ASSERT_EQ(ret, 4);
+
+	librsu_exit();
+}
+
+TEST(librsu_test7, corrupt_spt0_spt1)
+{
+	create_initial_qspi_image();
+	corrupt_qspi(0);
+	corrupt_qspi(RSU_IMAGE_GEN_REGION);
+	int ret = 0;
+	ret = librsu_init((RSU_OSAL_CHAR *)"librsu_config.rc");
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_count();
+	ASSERT_NE(ret, 4);
+
+	librsu_exit();
+}
+
+TEST(librsu_test7, save_restore_spt)
+{
+	create_initial_qspi_image();
+	int ret = 0;
+	ret = librsu_init((RSU_OSAL_CHAR *)"librsu_config.rc");
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_count();
+	ASSERT_EQ(ret, 4);
+
+	ret = rsu_save_spt((RSU_OSAL_CHAR *)"save_restore.spt");
+	ASSERT_EQ(ret, 0);
+
+	librsu_exit();
+
+	corrupt_qspi(0);
+	corrupt_qspi(RSU_IMAGE_GEN_REGION);
+
+	ret = librsu_init((RSU_OSAL_CHAR *)"librsu_config.rc");
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_count();
+	ASSERT_NE(ret, 4);
+
+	ret = rsu_restore_spt((RSU_OSAL_CHAR *)"save_restore.spt");
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_count();
+	ASSERT_EQ(ret, 4);
+
+	librsu_exit();
+
+	/* both copies were rewritten */
+	ret = librsu_init((RSU_OSAL_CHAR *)"librsu_config.rc");
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_count();
+	ASSERT_EQ(ret, 4);
+
+	librsu_exit();
+
+	expect_no_conflicts();
+}
+
+TEST(librsu_test7, save_restore_empty_cpb)
+{
+	create_initial_qspi_image();
+	int ret = 0;
+	ret = librsu_init((RSU_OSAL_CHAR *)"librsu_config.rc");
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_save_cpb((RSU_OSAL_CHAR *)"save_restore.cpb");
+	ASSERT_EQ(ret, 0);
+
+	struct rsu_slot_info info;
+	ret = rsu_slot_get_info(1, &info);
+	ASSERT_EQ(ret, 0);
+	ASSERT_STREQ(info.name, "P2");
+	ASSERT_EQ(info.priority, 2);
+
+	ret = rsu_create_empty_cpb();
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_get_info(1, &info);
+	ASSERT_EQ(ret, 0);
+	ASSERT_STREQ(info.name, "P2");
+	ASSERT_EQ(info.priority, 0);
+
+	librsu_exit();
+
+	gdata.state = STATE_CPB0_CPB1_CORRUPTED;
+
+	ret = librsu_init((RSU_OSAL_CHAR *)"librsu_config.rc");
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_get_info(3, &info);
+	ASSERT_NE(ret, 0);
+
+	ret = rsu_restore_cpb((RSU_OSAL_CHAR *)"save_restore.cpb");
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_get_info(1, &info);
+	ASSERT_EQ(ret, 0);
+	ASSERT_STREQ(info.name, "P2");
+	ASSERT_EQ(info.priority, 2);
+
+	librsu_exit();
+}
+
+TEST(librsu_test7, save_restore_spt_buf)
+{
+	create_initial_qspi_image();
+	int ret = 0;
+	ret = librsu_init((RSU_OSAL_CHAR *)"librsu_config.rc");
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_count();
+	ASSERT_EQ(ret, 4);
+
+	RSU_OSAL_SIZE size = (4096 + 4);
+	RSU_OSAL_U8 *spt = (RSU_OSAL_U8 *)malloc(size);
+	ASSERT_NE(spt, (RSU_OSAL_U8 *)NULL);
+
+	ret = rsu_save_spt_to_buf(spt, size);
+	ASSERT_EQ(ret, 0);
+
+	librsu_exit();
+
+	corrupt_qspi(0);
+	corrupt_qspi(RSU_IMAGE_GEN_REGION);
+
+	ret = librsu_init((RSU_OSAL_CHAR *)"librsu_config.rc");
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_count();
+	ASSERT_NE(ret, 4);
+
+	ret = rsu_restore_spt_from_buf(spt, size);
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_count();
+	ASSERT_EQ(ret, 4);
+
+	free(spt);
+
+	librsu_exit();
+}
+
+TEST(librsu_test7, save_restore_empty_cpb_buf)
+{
+	create_initial_qspi_image();
+	int ret = 0;
+	ret = librsu_init((RSU_OSAL_CHAR *)"librsu_config.rc");
+	ASSERT_EQ(ret, 0);
+
+	RSU_OSAL_SIZE size = (4096 + 4);
+	RSU_OSAL_U8 *cpb = (RSU_OSAL_U8 *)malloc(size);
+	ASSERT_NE(cpb, (RSU_OSAL_U8 *)NULL);
+
+	ret = rsu_save_cpb_to_buf(cpb, size);
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_create_empty_cpb();
+	ASSERT_EQ(ret, 0);
+
+	librsu_exit();
+
+	gdata.state = STATE_CPB0_CORRUPTED;
+
+	ret = librsu_init((RSU_OSAL_CHAR *)"librsu_config.rc");
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_restore_cpb_from_buf(cpb, size);
+	ASSERT_EQ(ret, 0);
+
+	ret = rsu_slot_priority(2);
+	ASSERT_EQ(ret, 3);
+
+	free(cpb);
+
+	librsu_exit();
+}